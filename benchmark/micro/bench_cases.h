@@ -0,0 +1,25 @@
+#pragma once
+
+#include "microbench.h"
+
+// Each suite lives in its own bench_*.c file and is listed in main.c.
+extern const microbench_case math_cases[];
+extern const u32 math_case_count;
+extern const microbench_case container_cases[];
+extern const u32 container_case_count;
+extern const microbench_case memory_cases[];
+extern const u32 memory_case_count;
+extern const microbench_case core_cases[];
+extern const u32 core_case_count;
+extern const microbench_case thread_cases[];
+extern const u32 thread_case_count;
+extern const microbench_case job_cases[];
+extern const u32 job_case_count;
+extern const microbench_case parallel_cases[];
+extern const u32 parallel_case_count;
+
+/**
+ * @brief Restarts the job system with thread_count workers, 0 for the default of one per physical core.
+ * @return TRUE on success.
+ */
+b8 bench_set_job_threads (u32 thread_count);
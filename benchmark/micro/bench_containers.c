@@ -0,0 +1,78 @@
+#include "bench_cases.h"
+#include "containers/vector.h"
+
+#define PUSH_CLEAR_AT 4096
+#define MIDDLE_LENGTH 256
+
+typedef struct vector_bench {
+	u64 *values;
+} vector_bench;
+
+static vector_bench bench;
+
+static b8 setup_empty (void **out_user_data) {
+	bench.values   = vector_create (u64);
+	*out_user_data = &bench;
+	return TRUE;
+}
+
+// A vector holding MIDDLE_LENGTH values, so insertions and removals in the
+// middle move half of it.
+static b8 setup_filled (void **out_user_data) {
+	bench.values = vector_reserve (u64, MIDDLE_LENGTH + 1);
+	for (u64 i = 0; i < MIDDLE_LENGTH; ++i) { vector_push (bench.values, i); }
+	*out_user_data = &bench;
+	return TRUE;
+}
+
+static void teardown (void *user_data) {
+	vector_bench *data = user_data;
+	vector_destroy (data->values);
+	data->values = SF_NULL;
+}
+
+// Clearing keeps the capacity, so past the first batch this measures pushes
+// into reserved memory plus the occasional clear.
+static void run_push (void *user_data, u64 iterations) {
+	vector_bench *data = user_data;
+	for (u64 i = 0; i < iterations; ++i) {
+		vector_push (data->values, i);
+		if (vector_len (data->values) == PUSH_CLEAR_AT) {
+			vector_clear (data->values);
+		}
+	}
+	microbench_escape (data->values);
+}
+
+// Every operation is one insert in the middle and one pop from the back.
+static void run_insert_at (void *user_data, u64 iterations) {
+	vector_bench *data = user_data;
+	u64 popped		   = 0;
+	for (u64 i = 0; i < iterations; ++i) {
+		vector_insert_at (data->values, MIDDLE_LENGTH / 2, i);
+		vector_pop (data->values, &popped);
+	}
+	microbench_escape (&popped);
+}
+
+// Every operation is one pop from the middle and one push to the back.
+static void run_pop_at (void *user_data, u64 iterations) {
+	vector_bench *data = user_data;
+	u64 popped		   = 0;
+	for (u64 i = 0; i < iterations; ++i) {
+		data->values =
+			vector_pop_at (data->values, MIDDLE_LENGTH / 2, &popped);
+		vector_push (data->values, popped);
+	}
+	microbench_escape (&popped);
+}
+
+const microbench_case container_cases[] = {
+	{"vector", "push", setup_empty, run_push, teardown, sizeof (u64)},
+	{"vector", "insert_at_middle", setup_filled, run_insert_at, teardown,
+	 sizeof (u64)},
+	{"vector", "pop_at_middle", setup_filled, run_pop_at, teardown,
+	 sizeof (u64)},
+};
+const u32 container_case_count =
+	sizeof (container_cases) / sizeof (container_cases[0]);
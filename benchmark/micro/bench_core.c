@@ -0,0 +1,117 @@
+#include "bench_cases.h"
+#include "core/event.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "platform/filesystem.h"
+#include <stdio.h>
+
+#define EVENT_CODE_BENCH_SINGLE 0x200
+#define EVENT_CODE_BENCH_MANY	0x201
+#define MANY_LISTENER_COUNT		8
+#define READ_FILE_PATH			"microbench_read.bin"
+#define READ_FILE_SIZE			(64 * 1024)
+
+static void run_sfstrfmt (void *user_data, u64 iterations) {
+	char buffer[128];
+	for (u64 i = 0; i < iterations; ++i) {
+		sfstrfmt (buffer, "frame %llu: %.3f ms, %s", i, i * 0.001, "vulkan");
+		microbench_escape (buffer);
+	}
+}
+
+typedef struct event_bench {
+	u16 code;
+	u32 listener_count;
+	u64 listeners[MANY_LISTENER_COUNT];
+} event_bench;
+
+static event_bench single_event = {EVENT_CODE_BENCH_SINGLE, 1};
+static event_bench many_events	= {EVENT_CODE_BENCH_MANY, MANY_LISTENER_COUNT};
+
+// Never consumes the event, so every listener is called.
+static b8 on_bench_event (u16 code, void *sender, void *listener_inst,
+						  event_context context) {
+	*(u64 *)listener_inst += context.data.u64[0];
+	return FALSE;
+}
+
+static b8 setup_event (event_bench *bench, void **out_user_data) {
+	for (u32 i = 0; i < bench->listener_count; ++i) {
+		if (!event_register (bench->code, &bench->listeners[i],
+							 on_bench_event)) {
+			return FALSE;
+		}
+	}
+	*out_user_data = bench;
+	return TRUE;
+}
+
+static b8 setup_single_event (void **out_user_data) {
+	return setup_event (&single_event, out_user_data);
+}
+
+static b8 setup_many_events (void **out_user_data) {
+	return setup_event (&many_events, out_user_data);
+}
+
+static void teardown_event (void *user_data) {
+	event_bench *bench = user_data;
+	for (u32 i = 0; i < bench->listener_count; ++i) {
+		event_unregister (bench->code, &bench->listeners[i], on_bench_event);
+	}
+}
+
+static void run_event_fire (void *user_data, u64 iterations) {
+	event_bench *bench	  = user_data;
+	event_context context = {0};
+	for (u64 i = 0; i < iterations; ++i) {
+		context.data.u64[0] = i;
+		event_fire (bench->code, SF_NULL, context);
+	}
+	microbench_escape (bench->listeners);
+}
+
+static b8 setup_read_file (void **out_user_data) {
+	file_handle handle;
+	if (!filesystem_open (READ_FILE_PATH, FILE_MODE_WRITE, TRUE, &handle)) {
+		return FALSE;
+	}
+	u8 *data = sfalloc (READ_FILE_SIZE, MEMORY_TAG_GAME);
+	for (u32 i = 0; i < READ_FILE_SIZE; ++i) { data[i] = (u8)(i * 31); }
+	u64 written = 0;
+	b8 success	= filesystem_write (&handle, READ_FILE_SIZE, data, &written);
+	filesystem_close (&handle);
+	sffree (data, READ_FILE_SIZE, MEMORY_TAG_GAME);
+	return success && written == READ_FILE_SIZE;
+}
+
+static void teardown_read_file (void *user_data) { remove (READ_FILE_PATH); }
+
+// Open, read and close, the way resources are loaded. The file stays in the
+// page cache, so this is the engine's overhead rather than the disk's.
+static void run_read_file (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; ++i) {
+		file_handle handle;
+		if (!filesystem_open (READ_FILE_PATH, FILE_MODE_READ, TRUE,
+							  &handle)) {
+			return;
+		}
+		u8 *bytes = SF_NULL;
+		u64 size  = 0;
+		filesystem_read_all_bytes (&handle, &bytes, &size);
+		microbench_escape (bytes);
+		filesystem_close (&handle);
+		sffree (bytes, size, MEMORY_TAG_STRING);
+	}
+}
+
+const microbench_case core_cases[] = {
+	{"string", "sfstrfmt", SF_NULL, run_sfstrfmt, SF_NULL, 0},
+	{"event", "event_fire_1_listener", setup_single_event, run_event_fire,
+	 teardown_event, 0},
+	{"event", "event_fire_8_listeners", setup_many_events, run_event_fire,
+	 teardown_event, 0},
+	{"filesystem", "read_all_bytes_64k", setup_read_file, run_read_file,
+	 teardown_read_file, READ_FILE_SIZE},
+};
+const u32 core_case_count = sizeof (core_cases) / sizeof (core_cases[0]);
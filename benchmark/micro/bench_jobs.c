@@ -0,0 +1,94 @@
+#include "bench_cases.h"
+#include "core/job_system.h"
+#include "core/task_graph.h"
+
+#define BATCH_SIZE 64
+// Tasks in the graph cases, every one runs once per op.
+#define GRAPH_TASKS 16
+
+static void empty_job (void *params) { microbench_escape (params); }
+
+static job_decl batch[BATCH_SIZE];
+static job_decl waitable_batch[BATCH_SIZE];
+
+static b8 setup_batch (void **out_user_data) {
+	for (u32 i = 0; i < BATCH_SIZE; ++i) {
+		batch[i].entry	= empty_job;
+		batch[i].params = SF_NULL;
+		batch[i].name	= "bench_empty";
+	}
+	*out_user_data = batch;
+	return TRUE;
+}
+
+// Same jobs on fibers, the difference is the cost of the two switches.
+static b8 setup_waitable_batch (void **out_user_data) {
+	for (u32 i = 0; i < BATCH_SIZE; ++i) {
+		waitable_batch[i].entry	   = empty_job;
+		waitable_batch[i].params   = SF_NULL;
+		waitable_batch[i].name	   = "bench_empty";
+		waitable_batch[i].waitable = TRUE;
+	}
+	*out_user_data = waitable_batch;
+	return TRUE;
+}
+
+// Kick to wait of a single job, the latency floor of going through a queue.
+static void run_single (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; ++i) {
+		job_counter counter = {0};
+		job_run (user_data, 1, &counter);
+		job_wait_for_counter (&counter, 0);
+	}
+}
+
+// One op is one job of a batch, so ns/op is the scheduling overhead per job
+// with every worker stealing.
+static void run_batch (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; i += BATCH_SIZE) {
+		job_counter counter = {0};
+		job_run (user_data, BATCH_SIZE, &counter);
+		job_wait_for_counter (&counter, 0);
+	}
+}
+
+static task_graph graph;
+
+static void empty_task (void *params) { microbench_escape (params); }
+
+// Every task writes the same resource for the chain and a resource of its
+// own for the fan out, the graph then has no edges.
+static b8 setup_graph (b8 chain, void **out_user_data) {
+	task_graph_create (&graph);
+	for (u32 i = 0; i < GRAPH_TASKS; ++i) {
+		task_desc desc = {"bench_task", empty_task, SF_NULL, 0,
+						  chain ? TASK_RESOURCE (0) : TASK_RESOURCE (i),
+						  FALSE};
+		task_graph_add (&graph, &desc);
+	}
+	*out_user_data = &graph;
+	return TRUE;
+}
+
+static b8 setup_chain (void **out_user_data) {
+	return setup_graph (TRUE, out_user_data);
+}
+
+static b8 setup_fan_out (void **out_user_data) {
+	return setup_graph (FALSE, out_user_data);
+}
+
+// One op is one run of the whole graph, including its critical path.
+static void run_graph (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; ++i) { task_graph_run (user_data); }
+}
+
+const microbench_case job_cases[] = {
+	{"jobs", "run_wait_single", setup_batch, run_single, SF_NULL, 0},
+	{"jobs", "run_wait_batch_64", setup_batch, run_batch, SF_NULL, 0},
+	{"jobs", "run_wait_waitable_batch_64", setup_waitable_batch, run_batch,
+	 SF_NULL, 0},
+	{"jobs", "task_graph_chain_16", setup_chain, run_graph, SF_NULL, 0},
+	{"jobs", "task_graph_fan_out_16", setup_fan_out, run_graph, SF_NULL, 0},
+};
+const u32 job_case_count = sizeof (job_cases) / sizeof (job_cases[0]);
@@ -0,0 +1,75 @@
+#include "bench_cases.h"
+#include "math/sfmath.h"
+
+// The operations cycle through a small table of inputs so the compiler can't
+// fold them into constants and the branchy paths (slerp) see varied data.
+#define INPUT_COUNT 64
+
+typedef struct math_inputs {
+	mat4 matrices[INPUT_COUNT];
+	quat quats[INPUT_COUNT];
+	vec3 vectors[INPUT_COUNT];
+} math_inputs;
+
+static math_inputs inputs;
+
+static b8 setup (void **out_user_data) {
+	for (u32 i = 0; i < INPUT_COUNT; ++i) {
+		f32 t			   = i * 0.37f;
+		vec3 position	   = {sfsin (t), sfcos (t) * 2.0f, t};
+		vec3 axis		   = vec3_normalized ((vec3){1.0f, t, 0.5f});
+		mat4 rotation	   = mat4_euler_xyz (t, t * 0.5f, -t);
+		inputs.matrices[i] = mat4_mul (rotation, mat4_translation (position));
+		inputs.quats[i]	   = quat_from_axis_angle (axis, t, TRUE);
+		inputs.vectors[i]  = position;
+	}
+	*out_user_data = &inputs;
+	return TRUE;
+}
+
+static void run_mat4_mul (void *user_data, u64 iterations) {
+	math_inputs *in	= user_data;
+	mat4 result		= in->matrices[0];
+	for (u64 i = 0; i < iterations; ++i) {
+		result = mat4_mul (result, in->matrices[i % INPUT_COUNT]);
+		microbench_escape (&result);
+	}
+}
+
+static void run_mat4_inverse (void *user_data, u64 iterations) {
+	math_inputs *in = user_data;
+	for (u64 i = 0; i < iterations; ++i) {
+		mat4 result = mat4_inverse (in->matrices[i % INPUT_COUNT]);
+		microbench_escape (&result);
+	}
+}
+
+static void run_quat_slerp (void *user_data, u64 iterations) {
+	math_inputs *in = user_data;
+	for (u64 i = 0; i < iterations; ++i) {
+		quat result = quat_slerp (in->quats[i % INPUT_COUNT],
+								  in->quats[(i + 7) % INPUT_COUNT],
+								  (i % 100) * 0.01f);
+		microbench_escape (&result);
+	}
+}
+
+static void run_vec3_ops (void *user_data, u64 iterations) {
+	math_inputs *in = user_data;
+	for (u64 i = 0; i < iterations; ++i) {
+		vec3 a		= in->vectors[i % INPUT_COUNT];
+		vec3 b		= in->vectors[(i + 3) % INPUT_COUNT];
+		vec3 result	= vec3_normalized (vec3_add (vec3_cross (a, b), a));
+		f32 dot		= vec3_dot (result, b);
+		microbench_escape (&result);
+		microbench_escape (&dot);
+	}
+}
+
+const microbench_case math_cases[] = {
+	{"math", "mat4_mul", setup, run_mat4_mul, SF_NULL, 0},
+	{"math", "mat4_inverse", setup, run_mat4_inverse, SF_NULL, 0},
+	{"math", "quat_slerp", setup, run_quat_slerp, SF_NULL, 0},
+	{"math", "vec3_cross_add_normalize_dot", setup, run_vec3_ops, SF_NULL, 0},
+};
+const u32 math_case_count = sizeof (math_cases) / sizeof (math_cases[0]);
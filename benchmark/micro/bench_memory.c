@@ -0,0 +1,60 @@
+#include "bench_cases.h"
+#include "core/sfmemory.h"
+#include "memory/lin_alloc.h"
+
+#define SMALL_SIZE		 64
+#define LARGE_SIZE		 4096
+#define LINEAR_POOL_SIZE (SMALL_SIZE * 4096)
+
+static linear_allocator allocator;
+
+static b8 setup_linear (void **out_user_data) {
+	linear_allocator_create (LINEAR_POOL_SIZE, SF_NULL, &allocator);
+	*out_user_data = &allocator;
+	return allocator.mem_block != SF_NULL;
+}
+
+static void teardown_linear (void *user_data) {
+	linear_allocator_destroy (user_data);
+}
+
+// Clearing once the pool is full is part of the cost, the same way a frame
+// allocator is cleared once per frame.
+static void run_linear_alloc (void *user_data, u64 iterations) {
+	linear_allocator *linear = user_data;
+	for (u64 i = 0; i < iterations; ++i) {
+		if (linear->allocated + SMALL_SIZE > linear->total_size) {
+			linear_allocator_clear (linear);
+		}
+		void *block = linear_allocator_alloc (linear, SMALL_SIZE);
+		microbench_escape (block);
+	}
+}
+
+// sfalloc zeroes every block, so it is paired with the free to keep the
+// process footprint flat.
+static void run_sfalloc_small (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; ++i) {
+		void *block = sfalloc (SMALL_SIZE, MEMORY_TAG_GAME);
+		microbench_escape (block);
+		sffree (block, SMALL_SIZE, MEMORY_TAG_GAME);
+	}
+}
+
+static void run_sfalloc_large (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; ++i) {
+		void *block = sfalloc (LARGE_SIZE, MEMORY_TAG_GAME);
+		microbench_escape (block);
+		sffree (block, LARGE_SIZE, MEMORY_TAG_GAME);
+	}
+}
+
+const microbench_case memory_cases[] = {
+	{"memory", "linear_allocator_alloc_64", setup_linear, run_linear_alloc,
+	 teardown_linear, SMALL_SIZE},
+	{"memory", "sfalloc_sffree_64", SF_NULL, run_sfalloc_small, SF_NULL,
+	 SMALL_SIZE},
+	{"memory", "sfalloc_sffree_4096", SF_NULL, run_sfalloc_large, SF_NULL,
+	 LARGE_SIZE},
+};
+const u32 memory_case_count = sizeof (memory_cases) / sizeof (memory_cases[0]);
@@ -0,0 +1,94 @@
+#include "bench_cases.h"
+#include "core/parallel.h"
+#include "core/sfmemory.h"
+#include "platform/thread.h"
+
+// Scaling of parallel_for and parallel_reduce from 1 to N threads. Each case
+// restarts the job system with its thread count; counts above the logical
+// processor count are skipped. One op is a pass over the whole array.
+
+#define ELEMENT_COUNT (4 * 1024 * 1024)
+// Polynomial steps per element, enough to make the loop compute bound.
+#define TRANSFORM_STEPS 16
+
+static f32 *elements;
+
+static b8 setup_threads (u32 thread_count, void **out_user_data) {
+	if (thread_count > platform_processor_count ()) { return FALSE; }
+	if (!bench_set_job_threads (thread_count)) { return FALSE; }
+	elements = sfalloc (sizeof (f32) * ELEMENT_COUNT, MEMORY_TAG_GAME);
+	for (u32 i = 0; i < ELEMENT_COUNT; ++i) {
+		elements[i] = (i & 1023) * 1e-3f;
+	}
+	*out_user_data = elements;
+	return TRUE;
+}
+
+static void teardown_threads (void *user_data) {
+	sffree (user_data, sizeof (f32) * ELEMENT_COUNT, MEMORY_TAG_GAME);
+	bench_set_job_threads (0);
+}
+
+#define DEFINE_SETUP(count)                                                    \
+	static b8 setup_t##count (void **out_user_data) {                          \
+		return setup_threads (count, out_user_data);                           \
+	}
+DEFINE_SETUP (1)
+DEFINE_SETUP (2)
+DEFINE_SETUP (4)
+DEFINE_SETUP (8)
+DEFINE_SETUP (16)
+DEFINE_SETUP (32)
+
+static void reduce_sum (u64 begin, u64 end, void *context, void *out_partial) {
+	const f32 *values = context;
+	f64 sum			  = 0;
+	for (u64 i = begin; i < end; ++i) { sum += values[i]; }
+	*(f64 *)out_partial += sum;
+}
+
+static void combine_sum (void *accumulator, const void *partial,
+						 void *context) {
+	*(f64 *)accumulator += *(const f64 *)partial;
+}
+
+static void run_reduce (void *user_data, u64 iterations) {
+	const f64 zero = 0;
+	for (u64 i = 0; i < iterations; ++i) {
+		f64 sum;
+		parallel_reduce (ELEMENT_COUNT, 0, reduce_sum, combine_sum, user_data,
+						 sizeof (f64), &zero, &sum);
+		microbench_escape (&sum);
+	}
+}
+
+static void transform (u64 begin, u64 end, void *context) {
+	f32 *values = context;
+	for (u64 i = begin; i < end; ++i) {
+		f32 x = values[i];
+		for (u32 step = 0; step < TRANSFORM_STEPS; ++step) {
+			x = x * 0.999f + 0.001f;
+		}
+		values[i] = x;
+	}
+}
+
+static void run_transform (void *user_data, u64 iterations) {
+	for (u64 i = 0; i < iterations; ++i) {
+		parallel_for (ELEMENT_COUNT, 0, transform, user_data);
+		microbench_escape (user_data);
+	}
+}
+
+#define SCALING_CASES(count)                                                   \
+	{"parallel", "reduce_sum_t" #count, setup_t##count, run_reduce,            \
+	 teardown_threads, sizeof (f32) * ELEMENT_COUNT},                          \
+	{"parallel", "for_transform_t" #count, setup_t##count, run_transform,      \
+	 teardown_threads, sizeof (f32) * ELEMENT_COUNT}
+
+const microbench_case parallel_cases[] = {
+	SCALING_CASES (1),	SCALING_CASES (2),	SCALING_CASES (4),
+	SCALING_CASES (8),	SCALING_CASES (16), SCALING_CASES (32),
+};
+const u32 parallel_case_count =
+	sizeof (parallel_cases) / sizeof (parallel_cases[0]);
@@ -0,0 +1,175 @@
+#include "bench_cases.h"
+#include "platform/atomic.h"
+#include "platform/thread.h"
+#include <pthread.h>
+
+// Background threads hammering the same lock as the timed thread.
+#define MAX_CONTENDERS 3
+
+typedef enum contention_mode {
+	CONTENTION_SF_MUTEX,
+	CONTENTION_PTHREAD_MUTEX,
+	CONTENTION_ATOMIC_ADD,
+} contention_mode;
+
+typedef struct contention_bench {
+	contention_mode mode;
+	sf_mutex mutex;
+	pthread_mutex_t pthread_mutex;
+	sf_atomic_u32 stop;
+	sf_atomic_u64 atomic_counter;
+	// Guarded by whichever lock the mode uses.
+	u64 counter;
+	sf_thread threads[MAX_CONTENDERS];
+	u32 thread_count;
+} contention_bench;
+
+static contention_bench contention;
+
+static void contend_once (contention_bench *bench) {
+	switch (bench->mode) {
+	case CONTENTION_SF_MUTEX:
+		platform_mutex_lock (&bench->mutex);
+		++bench->counter;
+		platform_mutex_unlock (&bench->mutex);
+		break;
+	case CONTENTION_PTHREAD_MUTEX:
+		pthread_mutex_lock (&bench->pthread_mutex);
+		++bench->counter;
+		pthread_mutex_unlock (&bench->pthread_mutex);
+		break;
+	case CONTENTION_ATOMIC_ADD:
+		sf_atomic_fetch_add_u64 (&bench->atomic_counter, 1);
+		break;
+	}
+}
+
+static u32 contender_main (void *params) {
+	contention_bench *bench = params;
+	while (!sf_atomic_load_u32_relaxed (&bench->stop)) { contend_once (bench); }
+	return 0;
+}
+
+// One core stays free for the timed thread, with a single core the cases
+// measure the uncontended path.
+static b8 setup_contention (contention_mode mode, u32 thread_count,
+							void **out_user_data) {
+	contention_bench *bench = &contention;
+	bench->mode				= mode;
+	bench->counter			= 0;
+	bench->thread_count		= 0;
+	platform_mutex_create (&bench->mutex);
+	pthread_mutex_init (&bench->pthread_mutex, SF_NULL);
+	sf_atomic_init_u32 (&bench->stop, 0);
+	sf_atomic_init_u64 (&bench->atomic_counter, 0);
+	u32 cpus = platform_processor_count ();
+	if (thread_count > cpus - 1) { thread_count = cpus - 1; }
+	for (u32 i = 0; i < thread_count; ++i) {
+		if (!platform_thread_create_named (contender_main, bench,
+										   "bench_contend",
+										   &bench->threads[i])) {
+			break;
+		}
+		++bench->thread_count;
+	}
+	*out_user_data = bench;
+	return TRUE;
+}
+
+static b8 setup_mutex_uncontended (void **out_user_data) {
+	return setup_contention (CONTENTION_SF_MUTEX, 0, out_user_data);
+}
+
+static b8 setup_mutex_contended (void **out_user_data) {
+	return setup_contention (CONTENTION_SF_MUTEX, MAX_CONTENDERS,
+							 out_user_data);
+}
+
+static b8 setup_pthread_mutex_contended (void **out_user_data) {
+	return setup_contention (CONTENTION_PTHREAD_MUTEX, MAX_CONTENDERS,
+							 out_user_data);
+}
+
+static b8 setup_atomic_contended (void **out_user_data) {
+	return setup_contention (CONTENTION_ATOMIC_ADD, MAX_CONTENDERS,
+							 out_user_data);
+}
+
+static void teardown_contention (void *user_data) {
+	contention_bench *bench = user_data;
+	sf_atomic_store_u32 (&bench->stop, 1);
+	for (u32 i = 0; i < bench->thread_count; ++i) {
+		platform_thread_join (&bench->threads[i]);
+	}
+	pthread_mutex_destroy (&bench->pthread_mutex);
+	platform_mutex_destroy (&bench->mutex);
+}
+
+static void run_contention (void *user_data, u64 iterations) {
+	contention_bench *bench = user_data;
+	for (u64 i = 0; i < iterations; ++i) { contend_once (bench); }
+}
+
+typedef struct ping_pong_bench {
+	sf_semaphore ping;
+	sf_semaphore pong;
+	sf_atomic_u32 stop;
+	sf_thread thread;
+} ping_pong_bench;
+
+static ping_pong_bench ping_pong;
+
+static u32 ponger_main (void *params) {
+	ping_pong_bench *bench = params;
+	for (;;) {
+		platform_semaphore_wait (&bench->ping);
+		if (sf_atomic_load_u32 (&bench->stop)) { return 0; }
+		platform_semaphore_signal (&bench->pong);
+	}
+}
+
+static b8 setup_ping_pong (void **out_user_data) {
+	ping_pong_bench *bench = &ping_pong;
+	platform_semaphore_create (0, &bench->ping);
+	platform_semaphore_create (0, &bench->pong);
+	sf_atomic_init_u32 (&bench->stop, 0);
+	if (!platform_thread_create_named (ponger_main, bench, "bench_pong",
+									   &bench->thread)) {
+		return FALSE;
+	}
+	*out_user_data = bench;
+	return TRUE;
+}
+
+static void teardown_ping_pong (void *user_data) {
+	ping_pong_bench *bench = user_data;
+	sf_atomic_store_u32 (&bench->stop, 1);
+	platform_semaphore_signal (&bench->ping);
+	platform_thread_join (&bench->thread);
+	platform_semaphore_destroy (&bench->ping);
+	platform_semaphore_destroy (&bench->pong);
+}
+
+// A round trip through both semaphores, two wakeups of a sleeping thread
+// when the partner is idle.
+static void run_ping_pong (void *user_data, u64 iterations) {
+	ping_pong_bench *bench = user_data;
+	for (u64 i = 0; i < iterations; ++i) {
+		platform_semaphore_signal (&bench->ping);
+		platform_semaphore_wait (&bench->pong);
+	}
+}
+
+const microbench_case thread_cases[] = {
+	{"threads", "mutex_uncontended", setup_mutex_uncontended, run_contention,
+	 teardown_contention, 0},
+	{"threads", "mutex_contended", setup_mutex_contended, run_contention,
+	 teardown_contention, 0},
+	{"threads", "pthread_mutex_contended", setup_pthread_mutex_contended,
+	 run_contention, teardown_contention, 0},
+	{"threads", "atomic_add_contended", setup_atomic_contended, run_contention,
+	 teardown_contention, 0},
+	{"threads", "semaphore_ping_pong", setup_ping_pong, run_ping_pong,
+	 teardown_ping_pong, 0},
+};
+const u32 thread_case_count = sizeof (thread_cases) / sizeof (thread_cases[0]);
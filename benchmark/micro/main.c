@@ -0,0 +1,116 @@
+#include "bench_cases.h"
+#include "core/event.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Runs the engine's hot helpers in isolation. Results are printed as a table
+// and, with --json, written in a stable order so reports from two commits can
+// be diffed.
+//
+// Usage: SapfireMicrobench [--filter text] [--repetitions n] [--warmup-ms n]
+//                          [--json path] [--label text]
+
+typedef struct suite {
+	const microbench_case *cases;
+	const u32 *count;
+} suite;
+
+static u64 job_memory_size;
+static void *job_memory;
+
+b8 bench_set_job_threads (u32 thread_count) {
+	if (job_memory) {
+		job_system_shutdown (job_memory);
+		sffree (job_memory, job_memory_size, MEMORY_TAG_APPLICATION);
+	}
+	job_system_initialize (&job_memory_size, SF_NULL, thread_count);
+	job_memory = sfalloc (job_memory_size, MEMORY_TAG_APPLICATION);
+	return job_system_initialize (&job_memory_size, job_memory, thread_count);
+}
+
+static const suite suites[] = {
+	{math_cases, &math_case_count},
+	{container_cases, &container_case_count},
+	{memory_cases, &memory_case_count},
+	{core_cases, &core_case_count},
+	{thread_cases, &thread_case_count},
+	{job_cases, &job_case_count},
+	{parallel_cases, &parallel_case_count},
+};
+
+static void print_usage () {
+	printf ("Usage: SapfireMicrobench [--filter text] [--repetitions n] "
+			"[--warmup-ms n] [--json path] [--label text]\n");
+}
+
+int main (int argc, char **argv) {
+	microbench_config config;
+	microbench_default_config (&config);
+	const char *json_path = SF_NULL;
+	const char *label	  = SF_NULL;
+	for (int i = 1; i < argc; ++i) {
+		b8 has_value = i + 1 < argc;
+		if (has_value && strcmp (argv[i], "--filter") == 0) {
+			config.filter = argv[++i];
+		} else if (has_value && strcmp (argv[i], "--repetitions") == 0) {
+			config.repetitions = (u32)strtoul (argv[++i], SF_NULL, 10);
+		} else if (has_value && strcmp (argv[i], "--warmup-ms") == 0) {
+			config.warmup_ns = strtoull (argv[++i], SF_NULL, 10) * 1000000;
+		} else if (has_value && strcmp (argv[i], "--json") == 0) {
+			json_path = argv[++i];
+		} else if (has_value && strcmp (argv[i], "--label") == 0) {
+			label = argv[++i];
+		} else {
+			print_usage ();
+			return 1;
+		}
+	}
+
+	// Only the subsystems the cases touch, without a window or renderer.
+	memory_initialize ();
+	u64 event_memory_size = 0;
+	event_initialize (&event_memory_size, SF_NULL);
+	void *event_memory = sfalloc (event_memory_size, MEMORY_TAG_APPLICATION);
+	event_initialize (&event_memory_size, event_memory);
+	bench_set_job_threads (0);
+
+	u32 case_count = 0;
+	for (u32 i = 0; i < sizeof (suites) / sizeof (suites[0]); ++i) {
+		case_count += *suites[i].count;
+	}
+	microbench_result *results =
+		sfalloc (sizeof (microbench_result) * case_count, MEMORY_TAG_GAME);
+	u32 result_count = 0;
+	microbench_print_header ();
+	for (u32 i = 0; i < sizeof (suites) / sizeof (suites[0]); ++i) {
+		for (u32 j = 0; j < *suites[i].count; ++j) {
+			microbench_result *result = &results[result_count];
+			if (microbench_run (&suites[i].cases[j], &config, result)) {
+				microbench_print_result (result);
+				++result_count;
+			}
+		}
+	}
+
+	int exit_code = 0;
+	if (json_path) {
+		if (microbench_write_json (json_path, label, &config, results,
+								   result_count)) {
+			printf ("Wrote %u results to %s.\n", result_count, json_path);
+		} else {
+			exit_code = 1;
+		}
+	}
+
+	sffree (results, sizeof (microbench_result) * case_count, MEMORY_TAG_GAME);
+	job_system_shutdown (job_memory);
+	sffree (job_memory, job_memory_size, MEMORY_TAG_APPLICATION);
+	event_shutdown (event_memory);
+	sffree (event_memory, event_memory_size, MEMORY_TAG_APPLICATION);
+	memory_shutdown ();
+	return exit_code;
+}
@@ -0,0 +1,174 @@
+#include "microbench.h"
+#include "core/sfmemory.h"
+#include "platform/platform.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom.
+static const f64 t_table[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201,	2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080,	2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+static f64 t_quantile (u32 degrees_of_freedom) {
+	if (degrees_of_freedom == 0) { return 0; }
+	if (degrees_of_freedom <= 30) { return t_table[degrees_of_freedom - 1]; }
+	return 1.960;
+}
+
+static int compare_f64 (const void *a, const void *b) {
+	f64 lhs = *(const f64 *)a;
+	f64 rhs = *(const f64 *)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+static u64 time_batch (const microbench_case *bench, void *user_data,
+					   u64 iterations) {
+	microbench_clobber ();
+	u64 start = platform_get_absolute_time_ns ();
+	bench->run (user_data, iterations);
+	microbench_clobber ();
+	return platform_get_absolute_time_ns () - start;
+}
+
+void microbench_default_config (microbench_config *out_config) {
+	out_config->warmup_ns	 = 50 * 1000 * 1000;
+	out_config->min_batch_ns = 5 * 1000 * 1000;
+	out_config->repetitions	 = 20;
+	out_config->filter		 = SF_NULL;
+}
+
+b8 microbench_run (const microbench_case *bench,
+				   const microbench_config *config,
+				   microbench_result *out_result) {
+	if (config->filter) {
+		char full_name[256];
+		snprintf (full_name, sizeof (full_name), "%s/%s", bench->group,
+				  bench->name);
+		if (!strstr (full_name, config->filter)) { return FALSE; }
+	}
+	void *user_data = SF_NULL;
+	if (bench->setup && !bench->setup (&user_data)) {
+		fprintf (stderr, "Setup of %s/%s failed, skipping.\n", bench->group,
+				 bench->name);
+		return FALSE;
+	}
+
+	// Grow the batch until it is long enough for the clock to resolve.
+	u64 iterations = 1;
+	u64 elapsed	   = time_batch (bench, user_data, iterations);
+	while (elapsed < config->min_batch_ns && iterations < (1ull << 40)) {
+		u64 scale = elapsed ? config->min_batch_ns / elapsed + 1 : 10;
+		if (scale > 10) { scale = 10; }
+		if (scale < 2) { scale = 2; }
+		iterations *= scale;
+		elapsed = time_batch (bench, user_data, iterations);
+	}
+
+	// Warm caches, branch predictors and the allocator.
+	u64 warmup_start = platform_get_absolute_time_ns ();
+	while (platform_get_absolute_time_ns () - warmup_start <
+		   config->warmup_ns) {
+		time_batch (bench, user_data, iterations);
+	}
+
+	u32 repetitions = config->repetitions;
+	if (repetitions < 2) { repetitions = 2; }
+	if (repetitions > MICROBENCH_MAX_REPETITIONS) {
+		repetitions = MICROBENCH_MAX_REPETITIONS;
+	}
+	f64 samples[MICROBENCH_MAX_REPETITIONS];
+	f64 total = 0;
+	for (u32 i = 0; i < repetitions; ++i) {
+		samples[i] =
+			(f64)time_batch (bench, user_data, iterations) / iterations;
+		total += samples[i];
+	}
+	if (bench->teardown) { bench->teardown (user_data); }
+
+	f64 mean	 = total / repetitions;
+	f64 variance = 0;
+	for (u32 i = 0; i < repetitions; ++i) {
+		variance += (samples[i] - mean) * (samples[i] - mean);
+	}
+	variance /= repetitions - 1;
+	qsort (samples, repetitions, sizeof (f64), compare_f64);
+
+	sfmemset (out_result, 0, sizeof (microbench_result));
+	out_result->group		= bench->group;
+	out_result->name		= bench->name;
+	out_result->iterations	= iterations;
+	out_result->repetitions = repetitions;
+	out_result->mean_ns		= mean;
+	out_result->min_ns		= samples[0];
+	out_result->median_ns	= repetitions % 2
+								  ? samples[repetitions / 2]
+								  : (samples[repetitions / 2 - 1] +
+									 samples[repetitions / 2]) /
+										2;
+	out_result->stddev_ns = sqrt (variance);
+	out_result->ci95_ns =
+		t_quantile (repetitions - 1) * out_result->stddev_ns /
+		sqrt ((f64)repetitions);
+	out_result->ops_per_second = mean > 0 ? 1e9 / mean : 0;
+	out_result->bytes_per_second =
+		out_result->ops_per_second * bench->bytes_per_op;
+	return TRUE;
+}
+
+void microbench_print_header () {
+	printf ("%-40s %12s %12s %10s %14s %12s\n", "benchmark", "mean ns/op",
+			"median", "+/- 95%", "ops/s", "MiB/s");
+}
+
+void microbench_print_result (const microbench_result *result) {
+	char full_name[256];
+	snprintf (full_name, sizeof (full_name), "%s/%s", result->group,
+			  result->name);
+	char throughput[32] = "-";
+	if (result->bytes_per_second > 0) {
+		snprintf (throughput, sizeof (throughput), "%.1f",
+				  result->bytes_per_second / (1024.0 * 1024.0));
+	}
+	f64 ci_percent =
+		result->mean_ns > 0 ? 100.0 * result->ci95_ns / result->mean_ns : 0;
+	printf ("%-40s %12.2f %12.2f %9.1f%% %14.0f %12s\n", full_name,
+			result->mean_ns, result->median_ns, ci_percent,
+			result->ops_per_second, throughput);
+}
+
+b8 microbench_write_json (const char *path, const char *label,
+						  const microbench_config *config,
+						  const microbench_result *results, u32 count) {
+	FILE *file = fopen (path, "w");
+	if (!file) {
+		fprintf (stderr, "Failed to open %s for writing.\n", path);
+		return FALSE;
+	}
+	fprintf (file, "{\n");
+	fprintf (file, "  \"label\": \"%s\",\n", label ? label : "");
+	fprintf (file,
+			 "  \"config\": {\"warmup_ns\": %llu, \"min_batch_ns\": %llu, "
+			 "\"repetitions\": %u},\n",
+			 config->warmup_ns, config->min_batch_ns, config->repetitions);
+	fprintf (file, "  \"results\": [");
+	for (u32 i = 0; i < count; ++i) {
+		const microbench_result *r = &results[i];
+		fprintf (file,
+				 "%s\n    {\"group\": \"%s\", \"name\": \"%s\", "
+				 "\"iterations\": %llu, \"repetitions\": %u, "
+				 "\"mean_ns\": %.4f, \"median_ns\": %.4f, \"min_ns\": %.4f, "
+				 "\"stddev_ns\": %.4f, \"ci95_ns\": %.4f, "
+				 "\"ops_per_second\": %.2f, \"bytes_per_second\": %.2f}",
+				 i ? "," : "", r->group, r->name, r->iterations,
+				 r->repetitions, r->mean_ns, r->median_ns, r->min_ns,
+				 r->stddev_ns, r->ci95_ns, r->ops_per_second,
+				 r->bytes_per_second);
+	}
+	fprintf (file, "%s]\n}\n", count ? "\n  " : "");
+	b8 success = !ferror (file);
+	fclose (file);
+	return success;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "defines.h"
+
+// Minimal microbenchmark harness. Every case is calibrated until one batch
+// of iterations takes at least min_batch_ns, warmed up, then timed for a
+// number of repetitions. Results are per operation, with a 95% confidence
+// interval over the repetitions.
+
+typedef struct microbench_case {
+	const char* group;
+	const char* name;
+	// Optional. Prepares the data run works on, kept out of the timing.
+	b8 (*setup) (void** out_user_data);
+	// Performs the operation iterations times.
+	void (*run) (void* user_data, u64 iterations);
+	// Optional. Releases what setup created.
+	void (*teardown) (void* user_data);
+	// Bytes processed by one operation, 0 to only report ops/s.
+	u64 bytes_per_op;
+} microbench_case;
+
+typedef struct microbench_config {
+	u64 warmup_ns;
+	u64 min_batch_ns;
+	u32 repetitions;
+	// Only cases whose "group/name" contains this run, NULL for all.
+	const char* filter;
+} microbench_config;
+
+typedef struct microbench_result {
+	const char* group;
+	const char* name;
+	u64 iterations;
+	u32 repetitions;
+	f64 mean_ns;
+	f64 median_ns;
+	f64 min_ns;
+	f64 stddev_ns;
+	// Half-width of the 95% confidence interval of mean_ns.
+	f64 ci95_ns;
+	f64 ops_per_second;
+	f64 bytes_per_second;
+} microbench_result;
+
+#define MICROBENCH_MAX_REPETITIONS 256
+
+/**
+ * @brief Fills config with the defaults: 50ms warmup, 5ms batches, 20 repetitions.
+ */
+void microbench_default_config (microbench_config* out_config);
+
+/**
+ * @brief Runs a case.
+ * @return FALSE if the case was skipped by the filter or its setup failed.
+ */
+b8 microbench_run (const microbench_case* bench,
+				   const microbench_config* config,
+				   microbench_result* out_result);
+
+void microbench_print_header ();
+void microbench_print_result (const microbench_result* result);
+
+/**
+ * @brief Writes the results as JSON, one object per case, in run order so two runs can be diffed.
+ * @return TRUE on success.
+ */
+b8 microbench_write_json (const char* path, const char* label,
+						  const microbench_config* config,
+						  const microbench_result* results, u32 count);
+
+// Makes the compiler assume the memory behind p is read and written, so
+// results of a benchmarked operation can't be optimized away.
+static inline void microbench_escape (const void* p) {
+	__asm__ volatile ("" : : "g"(p) : "memory");
+}
+
+// Keeps the compiler from caching memory across this point.
+static inline void microbench_clobber () {
+	__asm__ volatile ("" : : : "memory");
+}
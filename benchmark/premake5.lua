@@ -0,0 +1,47 @@
+project "SapfireBenchmark"
+   kind "ConsoleApp"
+   language "C"
+   cdialect "gnu11"
+   targetdir "bin/%{cfg.buildcfg}"
+   toolset "clang"
+
+   files { "src/**.h", "src/**.c" }
+
+   includedirs { "../sapfire/src" }
+   links { "Sapfire" }
+
+   filter "system:linux"
+      libdirs { "%{VULKAN_SDK}/lib" }
+      links { "SDL2", "vulkan", "m", "pthread" }
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
+
+project "SapfireMicrobench"
+   kind "ConsoleApp"
+   language "C"
+   cdialect "gnu11"
+   targetdir "bin/%{cfg.buildcfg}"
+   toolset "clang"
+
+   files { "micro/**.h", "micro/**.c" }
+
+   includedirs { "../sapfire/src" }
+   links { "Sapfire" }
+
+   filter "system:linux"
+      libdirs { "%{VULKAN_SDK}/lib" }
+      links { "SDL2", "vulkan", "m", "pthread" }
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
@@ -0,0 +1,324 @@
+#include "baseline.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "json.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct compare_state {
+	const json_document *baseline;
+	const json_document *current;
+	const baseline_options *options;
+	i32 regressions;
+} compare_state;
+
+typedef struct ranked_sample {
+	f64 value;
+	b8 is_current;
+} ranked_sample;
+
+void baseline_default_options (baseline_options *out_options) {
+	out_options->tolerance_percent = 5.0;
+	out_options->significance_z	   = 2.33;
+}
+
+static f64 percent_change (f64 baseline, f64 current) {
+	if (baseline <= 0) { return current > 0 ? INFINITY : 0; }
+	return (current - baseline) / baseline * 100.0;
+}
+
+// Logs one metric and counts it if it regressed. Higher is worse for every
+// metric in the report.
+static void report (compare_state *state, const char *name, f64 baseline,
+					f64 current, b8 significant, f64 score) {
+	f64 change	  = percent_change (baseline, current);
+	f64 tolerance = state->options->tolerance_percent;
+	// Deterministic metrics have no score to show.
+	char detail[32] = "";
+	if (score != 0) {
+		snprintf (detail, sizeof (detail), ", score %.2f", score);
+	}
+	if (significant && change > tolerance) {
+		++state->regressions;
+		SF_WARNING ("REGRESSED %-40s %12.4f -> %12.4f (%+.1f%%%s)", name,
+					baseline, current, change, detail);
+	} else if (significant && change < -tolerance) {
+		SF_INFO ("improved  %-40s %12.4f -> %12.4f (%+.1f%%%s)", name,
+				 baseline, current, change, detail);
+	} else {
+		SF_INFO ("ok        %-40s %12.4f -> %12.4f (%+.1f%%)", name, baseline,
+				 current, change);
+	}
+}
+
+static int compare_ranked (const void *a, const void *b) {
+	f64 lhs	= ((const ranked_sample *)a)->value;
+	f64 rhs	= ((const ranked_sample *)b)->value;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+static u32 collect_samples (const json_document *document,
+							const json_value *array, b8 is_current,
+							ranked_sample *out_samples) {
+	u32 count = 0;
+	for (const json_value *value = json_first (document, array); value;
+		 value = json_next (document, value)) {
+		if (value->type != JSON_NUMBER) { continue; }
+		out_samples[count].value	  = value->number;
+		out_samples[count].is_current = is_current;
+		++count;
+	}
+	return count;
+}
+
+// Mann-Whitney U of current against baseline as a z score, with the tie
+// correction. Positive when current tends to be larger. Makes no assumption
+// about the shape of the distribution, frame times are anything but normal.
+static f64 mann_whitney_z (const json_document *baseline,
+						   const json_value *baseline_samples,
+						   const json_document *current,
+						   const json_value *current_samples) {
+	u32 capacity = baseline_samples->child_count + current_samples->child_count;
+	if (capacity == 0) { return 0; }
+	ranked_sample *samples =
+		sfalloc (sizeof (ranked_sample) * capacity, MEMORY_TAG_GAME);
+	u32 n1 = collect_samples (baseline, baseline_samples, FALSE, samples);
+	u32 n2 = collect_samples (current, current_samples, TRUE, samples + n1);
+	u32 n  = n1 + n2;
+	qsort (samples, n, sizeof (ranked_sample), compare_ranked);
+
+	f64 current_rank_sum = 0;
+	f64 tie_sum			 = 0;
+	for (u32 i = 0; i < n;) {
+		u32 j = i;
+		while (j < n && samples[j].value == samples[i].value) { ++j; }
+		// Tied samples share the average of their ranks, which are 1-based.
+		f64 rank = (i + 1 + j) / 2.0;
+		for (u32 k = i; k < j; ++k) {
+			if (samples[k].is_current) { current_rank_sum += rank; }
+		}
+		f64 ties = j - i;
+		tie_sum += ties * ties * ties - ties;
+		i = j;
+	}
+	sffree (samples, sizeof (ranked_sample) * capacity, MEMORY_TAG_GAME);
+	if (n1 == 0 || n2 == 0) { return 0; }
+
+	f64 u	 = current_rank_sum - n2 * (n2 + 1.0) / 2.0;
+	f64 mean = n1 * (f64)n2 / 2.0;
+	f64 variance =
+		n1 * (f64)n2 / 12.0 * ((n + 1.0) - tie_sum / (n * (n - 1.0)));
+	return variance > 0 ? (u - mean) / sqrt (variance) : 0;
+}
+
+static void compare_distribution (compare_state *state, const char *summary_key,
+								  const char *samples_key) {
+	const json_value *baseline_root	= json_root (state->baseline);
+	const json_value *current_root	= json_root (state->current);
+	const json_value *baseline_summary =
+		json_get (state->baseline, baseline_root, summary_key);
+	const json_value *current_summary =
+		json_get (state->current, current_root, summary_key);
+	if (!baseline_summary || !current_summary) {
+		SF_WARNING ("'%s' is missing from a report, skipped.", summary_key);
+		return;
+	}
+	const json_value *baseline_samples =
+		json_get (state->baseline, baseline_root, samples_key);
+	const json_value *current_samples =
+		json_get (state->current, current_root, samples_key);
+
+	b8 significant = TRUE;
+	f64 z		   = 0;
+	if (baseline_samples && current_samples &&
+		baseline_samples->type == JSON_ARRAY &&
+		current_samples->type == JSON_ARRAY) {
+		z = mann_whitney_z (state->baseline, baseline_samples, state->current,
+							current_samples);
+		significant = z > state->options->significance_z;
+	} else {
+		SF_WARNING ("'%s' has no samples, it is only checked against the "
+					"tolerance.",
+					summary_key);
+	}
+
+	static const char *stats[] = {"p50", "p95", "p99"};
+	for (u32 i = 0; i < sizeof (stats) / sizeof (stats[0]); ++i) {
+		char name[64];
+		snprintf (name, sizeof (name), "%s.%s", summary_key, stats[i]);
+		f64 base = json_get_number (state->baseline, baseline_summary,
+									stats[i], 0);
+		f64 cur =
+			json_get_number (state->current, current_summary, stats[i], 0);
+		report (state, name, base, cur, significant, z);
+	}
+}
+
+static const json_value *find_named (const json_document *document,
+									 const json_value *array,
+									 const char *name) {
+	for (const json_value *entry = json_first (document, array); entry;
+		 entry = json_next (document, entry)) {
+		const json_value *entry_name = json_get (document, entry, "name");
+		if (entry_name && entry_name->type == JSON_STRING &&
+			sfstreq (entry_name->string, name)) {
+			return entry;
+		}
+	}
+	return SF_NULL;
+}
+
+// CPU zones and GPU scopes: mean, standard deviation and count per name.
+static void compare_timed_list (compare_state *state, const char *key) {
+	const json_document *base	= state->baseline;
+	const json_document *cur	= state->current;
+	const json_value *base_list	= json_get (base, json_root (base), key);
+	const json_value *cur_list	= json_get (cur, json_root (cur), key);
+	for (const json_value *entry = json_first (base, base_list); entry;
+		 entry = json_next (base, entry)) {
+		const json_value *entry_name = json_get (base, entry, "name");
+		if (!entry_name || entry_name->type != JSON_STRING) { continue; }
+		char name[128];
+		snprintf (name, sizeof (name), "%s.%s", key, entry_name->string);
+		const json_value *match =
+			find_named (cur, cur_list, entry_name->string);
+		if (!match) {
+			SF_WARNING ("missing   %s", name);
+			continue;
+		}
+		f64 base_mean  = json_get_number (base, entry, "avg_ms", 0);
+		f64 base_sd	   = json_get_number (base, entry, "stddev_ms", 0);
+		f64 base_count = json_get_number (base, entry, "count", 0);
+		f64 cur_mean   = json_get_number (cur, match, "avg_ms", 0);
+		f64 cur_sd	   = json_get_number (cur, match, "stddev_ms", 0);
+		f64 cur_count  = json_get_number (cur, match, "count", 0);
+
+		// Welch's t, the counts are large enough to read it as a z score.
+		// Zones that ran once or never varied only get the tolerance.
+		f64 t		   = 0;
+		b8 significant = TRUE;
+		if (base_count > 1 && cur_count > 1) {
+			f64 error = sqrt (base_sd * base_sd / base_count +
+							  cur_sd * cur_sd / cur_count);
+			if (error > 0) {
+				t			= (cur_mean - base_mean) / error;
+				significant	= fabs (t) > state->options->significance_z;
+			}
+		}
+		report (state, name, base_mean, cur_mean, significant, t);
+	}
+}
+
+static void compare_counts (compare_state *state, const char *name,
+							const json_value *baseline,
+							const json_value *current, const char *key) {
+	char full_name[128];
+	snprintf (full_name, sizeof (full_name), "%s.%s", name, key);
+	f64 base = json_get_number (state->baseline, baseline, key, 0);
+	f64 cur	 = json_get_number (state->current, current, key, 0);
+	report (state, full_name, base, cur, TRUE, 0);
+}
+
+static void compare_memory (compare_state *state, b8 compare_allocations) {
+	const json_value *baseline_memory =
+		json_get (state->baseline, json_root (state->baseline), "memory");
+	const json_value *current_memory =
+		json_get (state->current, json_root (state->current), "memory");
+	if (!baseline_memory || !current_memory) {
+		SF_WARNING ("'memory' is missing from a report, skipped.");
+		return;
+	}
+	compare_counts (state, "memory", baseline_memory, current_memory,
+					"peak_bytes");
+	if (compare_allocations) {
+		compare_counts (state, "memory", baseline_memory, current_memory,
+						"allocations");
+	}
+	const json_value *baseline_tags =
+		json_get (state->baseline, baseline_memory, "tags");
+	const json_value *current_tags =
+		json_get (state->current, current_memory, "tags");
+	for (const json_value *tag = json_first (state->baseline, baseline_tags);
+		 tag; tag = json_next (state->baseline, tag)) {
+		const json_value *tag_name = json_get (state->baseline, tag, "name");
+		if (!tag_name || tag_name->type != JSON_STRING) { continue; }
+		const json_value *match =
+			find_named (state->current, current_tags, tag_name->string);
+		if (!match) { continue; }
+		char name[64];
+		snprintf (name, sizeof (name), "memory.%s", tag_name->string);
+		compare_counts (state, name, tag, match, "peak_bytes");
+		if (compare_allocations) {
+			compare_counts (state, name, tag, match, "allocations");
+		}
+	}
+}
+
+static void compare_uploads (compare_state *state) {
+	const json_value *baseline_uploads =
+		json_get (state->baseline, json_root (state->baseline), "gpu_uploads");
+	const json_value *current_uploads =
+		json_get (state->current, json_root (state->current), "gpu_uploads");
+	f64 baseline_count =
+		json_get_number (state->baseline, baseline_uploads, "count", 0);
+	f64 current_count =
+		json_get_number (state->current, current_uploads, "count", 0);
+	if (baseline_count == 0 || current_count == 0) { return; }
+	// Only a handful of uploads per run, too few for a test.
+	report (state, "gpu_uploads.avg_ms",
+			json_get_number (state->baseline, baseline_uploads, "total_ms", 0) /
+				baseline_count,
+			json_get_number (state->current, current_uploads, "total_ms", 0) /
+				current_count,
+			TRUE, 0);
+}
+
+i32 baseline_compare (const char *baseline_path, const char *current_path,
+					  const baseline_options *options) {
+	json_document baseline;
+	json_document current;
+	if (!json_parse_file (baseline_path, &baseline)) { return -1; }
+	if (!json_parse_file (current_path, &current)) {
+		json_document_destroy (&baseline);
+		return -1;
+	}
+	compare_state state = {&baseline, &current, options, 0};
+	SF_INFO ("Comparing '%s' against the baseline '%s' (tolerance %.1f%%).",
+			 current_path, baseline_path, options->tolerance_percent);
+
+	// Allocation counts scale with the number of frames, the rest are per
+	// frame or peaks.
+	const char *run_keys[] = {"frames", "warmup_frames"};
+	b8 same_run			   = TRUE;
+	for (u32 i = 0; i < 2; ++i) {
+		f64 base = json_get_number (&baseline, json_root (&baseline),
+									run_keys[i], 0);
+		f64 cur =
+			json_get_number (&current, json_root (&current), run_keys[i], 0);
+		if (base != cur) {
+			SF_WARNING ("The reports differ in %s (%.0f vs %.0f), allocation "
+						"counts are not compared.",
+						run_keys[i], base, cur);
+			same_run = FALSE;
+		}
+	}
+
+	compare_distribution (&state, "frame_time_ms", "frame_time_samples_ms");
+	compare_distribution (&state, "cpu_render_ms", "cpu_render_samples_ms");
+	compare_timed_list (&state, "cpu_zones");
+	compare_timed_list (&state, "gpu_scopes");
+	compare_uploads (&state);
+	compare_memory (&state, same_run);
+
+	if (state.regressions) {
+		SF_ERROR ("%d metrics regressed against the baseline.",
+				  state.regressions);
+	} else {
+		SF_INFO ("No regressions against the baseline.");
+	}
+	json_document_destroy (&baseline);
+	json_document_destroy (&current);
+	return state.regressions;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "defines.h"
+
+typedef struct baseline_options {
+	// Relative change, in percent, that a metric may regress by before it
+	// counts. Keeps tiny but significant shifts from failing a run.
+	f64 tolerance_percent;
+	// One-sided z (or t) score a timing shift needs to be significant.
+	f64 significance_z;
+} baseline_options;
+
+/**
+ * @brief Fills options with the defaults: 5% tolerance, z > 2.33 (p < 0.01).
+ */
+void baseline_default_options (baseline_options* out_options);
+
+/**
+ * @brief Compares two benchmark reports and logs every metric.
+ *
+ * Frame and render times are compared with a Mann-Whitney U test over the
+ * per-frame samples, CPU zones and GPU scopes with Welch's t-test. A timing
+ * regresses when it is both significant and beyond the tolerance. Memory
+ * peaks and allocation counts are deterministic, they, GPU uploads and zones
+ * that ran only once are checked against the tolerance alone.
+ * @return The number of regressions, -1 if a report couldn't be read.
+ */
+i32 baseline_compare (const char* baseline_path, const char* current_path,
+					  const baseline_options* options);
@@ -0,0 +1,455 @@
+#include "baseline.h"
+#include "core/application.h"
+#include "core/logger.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "game_definitions.h"
+#include "math/sfmath.h"
+#include "renderer/renderer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Renders a scripted scene for a fixed number of frames with no frame
+// limiter and writes a JSON report, meant to be run on build machines
+// without a display (SDL offscreen driver + VK_EXT_headless_surface,
+// lavapipe is fine). CPU zones are only reported when built with --profile.
+//
+// Environment:
+//   SF_BENCH_FRAMES    Measured frames, 1000 by default.
+//   SF_BENCH_WARMUP    Frames rendered before measuring, 60 by default.
+//   SF_BENCH_DRAWS     Quads drawn every frame, 4096 by default. Large
+//                      lists are recorded into secondary buffers by jobs.
+//   SF_BENCH_FRAMES_IN_FLIGHT
+//                      Frames recorded ahead of the GPU, 1 to 3, 2 by
+//                      default.
+//   SF_BENCH_REPORT    Report path, benchmark_report.json by default.
+//   SF_BENCH_WINDOWED  Set to render into a visible window instead.
+//   SF_BENCH_BASELINE  Report of an earlier run to compare against. The
+//                      process exits with 2 if any metric regressed.
+//   SF_BENCH_TOLERANCE Percent a metric may regress by, 5 by default.
+
+#define BENCH_MAX_ZONES		 64
+#define BENCH_MAX_GPU_SCOPES 32
+
+typedef struct sample_summary {
+	f64 min, avg, p50, p95, p99, max;
+} sample_summary;
+
+typedef struct gpu_scope_totals {
+	const char *name;
+	u64 count;
+	f64 total_ms;
+	f64 sum_squares_ms;
+	f64 min_ms;
+	f64 max_ms;
+} gpu_scope_totals;
+
+typedef struct benchmark_state {
+	u32 warmup_frames;
+	u32 measured_frames;
+	const char *report_path;
+	const char *baseline_path;
+	u64 frame_index;
+	u32 sample_count;
+	f64 *frame_ms;
+	f64 *render_ms;
+	// Part of render_ms the render thread was blocked on a frame fence.
+	f64 *wait_ms;
+	// Fixed grid of quads submitted every frame.
+	u32 draw_count;
+	mesh_data *draws;
+	u64 last_gpu_frame;
+	u32 gpu_scope_count;
+	gpu_scope_totals gpu_scopes[BENCH_MAX_GPU_SCOPES];
+	renderer_gpu_timings last_gpu;
+} benchmark_state;
+
+static u32 env_u32 (const char *name, u32 fallback) {
+	const char *value = getenv (name);
+	if (!value || !*value) { return fallback; }
+	long parsed = strtol (value, SF_NULL, 10);
+	return parsed > 0 ? (u32)parsed : fallback;
+}
+
+static int compare_f64 (const void *a, const void *b) {
+	f64 lhs = *(const f64 *)a;
+	f64 rhs = *(const f64 *)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+// Nearest-rank percentiles, same as frame_history_compute.
+static void summarize (f64 *samples, u32 count, sample_summary *out) {
+	sfmemset (out, 0, sizeof (sample_summary));
+	if (count == 0) { return; }
+	qsort (samples, count, sizeof (f64), compare_f64);
+	f64 total = 0;
+	for (u32 i = 0; i < count; ++i) { total += samples[i]; }
+	out->min = samples[0];
+	out->max = samples[count - 1];
+	out->avg = total / count;
+	out->p50 = samples[(count * 50 + 99) / 100 - 1];
+	out->p95 = samples[(count * 95 + 99) / 100 - 1];
+	out->p99 = samples[(count * 99 + 99) / 100 - 1];
+}
+
+static void accumulate_gpu (benchmark_state *state,
+							const renderer_gpu_timings *gpu) {
+	// Readback lags a few frames, only count each GPU frame once.
+	if (!gpu->supported || gpu->frame_number == state->last_gpu_frame) {
+		return;
+	}
+	state->last_gpu_frame = gpu->frame_number;
+	for (u32 i = 0; i < gpu->scope_count; ++i) {
+		const renderer_gpu_scope *scope = &gpu->scopes[i];
+		gpu_scope_totals *totals		= SF_NULL;
+		for (u32 j = 0; j < state->gpu_scope_count; ++j) {
+			if (sfstreq (state->gpu_scopes[j].name, scope->name)) {
+				totals = &state->gpu_scopes[j];
+				break;
+			}
+		}
+		if (!totals) {
+			if (state->gpu_scope_count == BENCH_MAX_GPU_SCOPES) { continue; }
+			totals		   = &state->gpu_scopes[state->gpu_scope_count++];
+			totals->name   = scope->name;
+			totals->min_ms = scope->duration_ms;
+			totals->max_ms = scope->duration_ms;
+		}
+		++totals->count;
+		totals->total_ms += scope->duration_ms;
+		totals->sum_squares_ms += scope->duration_ms * scope->duration_ms;
+		if (scope->duration_ms < totals->min_ms) {
+			totals->min_ms = scope->duration_ms;
+		}
+		if (scope->duration_ms > totals->max_ms) {
+			totals->max_ms = scope->duration_ms;
+		}
+	}
+}
+
+// Sample standard deviation from the running sums.
+static f64 stddev (u64 count, f64 total, f64 sum_squares) {
+	if (count < 2) { return 0; }
+	f64 mean	 = total / count;
+	f64 variance = (sum_squares - count * mean * mean) / (count - 1);
+	return variance > 0 ? sqrt (variance) : 0;
+}
+
+static void write_samples (FILE *file, const char *name, const f64 *samples,
+						   u32 count) {
+	fprintf (file, "  \"%s\": [", name);
+	for (u32 i = 0; i < count; ++i) {
+		fprintf (file, "%s%.4f", i ? ", " : "", samples[i]);
+	}
+	fprintf (file, "],\n");
+}
+
+static void write_summary (FILE *file, const char *name,
+						   const sample_summary *summary) {
+	fprintf (file,
+			 "  \"%s\": {\"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, "
+			 "\"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+			 name, summary->min, summary->avg, summary->p50, summary->p95,
+			 summary->p99, summary->max);
+}
+
+static f64 ratio (f64 numerator, f64 denominator) {
+	return denominator > 0 ? numerator / denominator : 0;
+}
+
+// Hardware counters per SF_PROFILE_COUNTERS zone, averaged over the frames
+// the zone ran in. Misses are per thousand instructions.
+static void write_counters (FILE *file) {
+	profiler_counter_stats counters[PROFILER_MAX_COUNTER_ZONES];
+	u32 count =
+		profiler_get_counter_stats (counters, PROFILER_MAX_COUNTER_ZONES);
+	u32 available = profiler_counters_available ();
+	fprintf (file, "  \"cpu_counters_available\": [");
+	b8 first = TRUE;
+	for (u32 i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (!(available & (1u << i))) { continue; }
+		fprintf (file, "%s\"%s\"", first ? "" : ", ",
+				 platform_perf_counter_name (i));
+		first = FALSE;
+	}
+	fprintf (file, "],\n  \"cpu_counters\": [");
+	for (u32 i = 0; i < count; ++i) {
+		const profiler_counter_stats *zone = &counters[i];
+		const u64 *totals				   = zone->totals;
+		f64 kilo_instructions = totals[PERF_COUNTER_INSTRUCTIONS] / 1000.0;
+		fprintf (
+			file,
+			"%s\n    {\"name\": \"%s\", \"frames\": %llu, "
+			"\"calls_per_frame\": %.2f, \"cycles_per_frame\": %.0f, "
+			"\"instructions_per_frame\": %.0f, \"ipc\": %.3f, "
+			"\"cache_misses_per_kinstr\": %.3f, "
+			"\"branch_misses_per_kinstr\": %.3f}",
+			i ? "," : "", zone->name, zone->frames,
+			ratio (zone->calls, zone->frames),
+			ratio (totals[PERF_COUNTER_CYCLES], zone->frames),
+			ratio (totals[PERF_COUNTER_INSTRUCTIONS], zone->frames),
+			ratio (totals[PERF_COUNTER_INSTRUCTIONS],
+				   totals[PERF_COUNTER_CYCLES]),
+			ratio (totals[PERF_COUNTER_CACHE_MISSES], kilo_instructions),
+			ratio (totals[PERF_COUNTER_BRANCH_MISSES], kilo_instructions));
+	}
+	fprintf (file, "%s],\n", count ? "\n  " : "");
+}
+
+// Engine metrics over the last METRICS_HISTORY_FRAMES frames.
+static void write_metrics (FILE *file) {
+	static const char *type_names[METRIC_TYPE_MAX] = {"counter", "gauge",
+													   "histogram"};
+	u32 count = metrics_count ();
+	fprintf (file, "  \"metrics\": [");
+	for (u32 i = 0; i < count; ++i) {
+		metric_summary metric;
+		metrics_get_summary (i, &metric);
+		fprintf (file,
+				 "%s\n    {\"name\": \"%s\", \"type\": \"%s\", "
+				 "\"frames\": %u, \"min\": %.2f, \"avg\": %.2f, "
+				 "\"max\": %.2f, \"total\": %.2f",
+				 i ? "," : "", metric.name, type_names[metric.type],
+				 metric.frame_count, metric.min, metric.avg, metric.max,
+				 metric.total);
+		if (metric.type == METRIC_TYPE_HISTOGRAM) {
+			fprintf (file,
+					 ", \"samples\": %llu, \"p50\": %llu, \"p95\": %llu, "
+					 "\"p99\": %llu",
+					 metric.sample_count, metric.p50, metric.p95, metric.p99);
+		}
+		fprintf (file, "}");
+	}
+	fprintf (file, "%s],\n", count ? "\n  " : "");
+}
+
+static b8 write_report (game *game_instance, benchmark_state *state) {
+	FILE *file = fopen (state->report_path, "w");
+	if (!file) {
+		SF_ERROR ("Failed to open '%s' for the benchmark report.",
+				  state->report_path);
+		return FALSE;
+	}
+	sample_summary frame_summary;
+	sample_summary render_summary;
+	sample_summary wait_summary;
+	summarize (state->frame_ms, state->sample_count, &frame_summary);
+	summarize (state->render_ms, state->sample_count, &render_summary);
+	summarize (state->wait_ms, state->sample_count, &wait_summary);
+
+	fprintf (file, "{\n");
+	fprintf (file, "  \"frames\": %u,\n", state->sample_count);
+	fprintf (file, "  \"warmup_frames\": %u,\n", state->warmup_frames);
+	fprintf (file, "  \"headless\": %s,\n",
+			 game_instance->app_config.headless ? "true" : "false");
+	fprintf (file, "  \"frames_in_flight\": %u,\n",
+			 game_instance->app_config.frames_in_flight);
+	fprintf (file, "  \"draws\": %u,\n", state->draw_count);
+	write_summary (file, "frame_time_ms", &frame_summary);
+	write_summary (file, "cpu_render_ms", &render_summary);
+	write_summary (file, "cpu_fence_wait_ms", &wait_summary);
+	// Kept for baseline comparisons, summarize leaves them sorted.
+	write_samples (file, "frame_time_samples_ms", state->frame_ms,
+				   state->sample_count);
+	write_samples (file, "cpu_render_samples_ms", state->render_ms,
+				   state->sample_count);
+
+	profiler_zone_stats zones[BENCH_MAX_ZONES];
+	u32 zone_count = profiler_get_zone_stats (zones, BENCH_MAX_ZONES);
+	fprintf (file, "  \"cpu_zones\": [");
+	for (u32 i = 0; i < zone_count; ++i) {
+		fprintf (file,
+				 "%s\n    {\"name\": \"%s\", \"count\": %llu, "
+				 "\"total_ms\": %.4f, \"avg_ms\": %.4f, \"min_ms\": %.4f, "
+				 "\"max_ms\": %.4f, \"stddev_ms\": %.4f}",
+				 i ? "," : "", zones[i].name, zones[i].count,
+				 zones[i].total_ns / 1e6,
+				 zones[i].total_ns / 1e6 / zones[i].count,
+				 zones[i].min_ns / 1e6, zones[i].max_ns / 1e6,
+				 stddev (zones[i].count, (f64)zones[i].total_ns,
+						 zones[i].sum_squares_ns) /
+					 1e6);
+	}
+	fprintf (file, "%s],\n", zone_count ? "\n  " : "");
+	write_counters (file);
+	write_metrics (file);
+
+	fprintf (file, "  \"gpu_supported\": %s,\n",
+			 state->last_gpu.supported ? "true" : "false");
+	fprintf (file, "  \"gpu_scopes\": [");
+	for (u32 i = 0; i < state->gpu_scope_count; ++i) {
+		const gpu_scope_totals *scope = &state->gpu_scopes[i];
+		fprintf (file,
+				 "%s\n    {\"name\": \"%s\", \"count\": %llu, "
+				 "\"avg_ms\": %.4f, \"min_ms\": %.4f, \"max_ms\": %.4f, "
+				 "\"stddev_ms\": %.4f}",
+				 i ? "," : "", scope->name, scope->count,
+				 scope->total_ms / scope->count, scope->min_ms, scope->max_ms,
+				 stddev (scope->count, scope->total_ms,
+						 scope->sum_squares_ms));
+	}
+	fprintf (file, "%s],\n", state->gpu_scope_count ? "\n  " : "");
+	fprintf (file,
+			 "  \"gpu_uploads\": {\"count\": %llu, \"total_ms\": %.4f},\n",
+			 state->last_gpu.upload_count, state->last_gpu.total_upload_ms);
+
+	memory_stats memory;
+	memory_get_stats (&memory);
+	fprintf (file,
+			 "  \"memory\": {\"peak_bytes\": %llu, \"allocations\": %llu, "
+			 "\"frees\": %llu, \"tags\": [",
+			 memory.peak_total, memory.allocation_count, memory.free_count);
+	for (u32 i = 0; i < MEMORY_TAG_MAX; ++i) {
+		fprintf (file,
+				 "%s\n    {\"name\": \"%s\", \"current_bytes\": %llu, "
+				 "\"peak_bytes\": %llu, \"allocations\": %llu}",
+				 i ? "," : "", memory_tag_name (i), memory.tagged[i],
+				 memory.tagged_peak[i], memory.tagged_allocation_count[i]);
+	}
+	fprintf (file, "\n  ]}\n}\n");
+
+	b8 success = !ferror (file);
+	fclose (file);
+	if (success) {
+		SF_INFO ("Benchmark: %u frames, avg %.3f ms, p99 %.3f ms. Report "
+				 "written to '%s'.",
+				 state->sample_count, frame_summary.avg, frame_summary.p99,
+				 state->report_path);
+	}
+	return success;
+}
+
+// Lays the quads out on a square grid around the origin. Ids wrap around, so
+// lists longer than RENDER_MAX_MESHES draw some meshes more than once.
+static void build_draws (benchmark_state *state) {
+	u32 side = 1;
+	while (side * side < state->draw_count) { ++side; }
+	f32 spacing = 2.5f;
+	f32 origin	= -(f32)(side - 1) * spacing * 0.5f;
+	for (u32 i = 0; i < state->draw_count; ++i) {
+		mesh_data *draw = &state->draws[i];
+		sfmemset (draw, 0, sizeof (mesh_data));
+		draw->id	= i % RENDER_MAX_MESHES;
+		vec3 offset = {origin + (i % side) * spacing,
+					   origin + (i / side) * spacing, 0};
+		draw->model = mat4_translation (offset);
+	}
+}
+
+static b8 benchmark_initialize (game *game_instance) { return TRUE; }
+
+static b8 benchmark_update (game *game_instance, f32 delta_time) {
+	return TRUE;
+}
+
+static b8 benchmark_render (game *game_instance, render_bundle *bundle) {
+	SF_PROFILE_ZONE ("benchmark_render");
+	benchmark_state *state		 = game_instance->state;
+	application_state *app_state = game_instance->application_state;
+	renderer *renderer			 = &app_state->renderer;
+
+	// The frame that just finished, skip the first one since it only
+	// covers startup.
+	if (state->frame_index > state->warmup_frames) {
+		renderer_frame_timings timings;
+		renderer_get_frame_timings (renderer, &timings);
+		state->frame_ms[state->sample_count]  = bundle->deltaTime * 1000.0;
+		state->render_ms[state->sample_count] = timings.cpu_render_ms;
+		state->wait_ms[state->sample_count]	  = timings.cpu_wait_ms;
+		++state->sample_count;
+		accumulate_gpu (state, &timings.gpu);
+		state->last_gpu = timings.gpu;
+		if (state->sample_count == state->measured_frames) {
+			application_request_quit (game_instance, 0);
+		}
+	}
+
+	// Scripted camera, driven by the frame index so every run renders the
+	// same frames regardless of how long they take.
+	f32 t		= state->frame_index * 0.01f;
+	vec3 eye	= {10.0f * sfsin (t), 2.0f * sfsin (t * 0.5f),
+				   30.0f + 5.0f * sfcos (t)};
+	vec3 target = {0, 0, 0};
+	vec3 up		= {0, 1, 0};
+	renderer_set_view (renderer, mat4_look_at (eye, target, up));
+	for (u32 i = 0; i < state->draw_count; ++i) {
+		if (!render_bundle_add_draw (bundle, &state->draws[i])) { break; }
+	}
+	++state->frame_index;
+	return TRUE;
+}
+
+b8 create_game (game *out_game) {
+	sfmemset (out_game, 0, sizeof (game));
+	out_game->app_config.x			  = 100;
+	out_game->app_config.y			  = 100;
+	out_game->app_config.width		  = 1280;
+	out_game->app_config.height		  = 720;
+	out_game->app_config.name		  = "Sapfire Benchmark";
+	out_game->app_config.log_mode	  = LOG_MODE_ASYNC;
+	out_game->app_config.frame_pacing = FRAME_PACING_UNCAPPED;
+	out_game->app_config.headless	  = getenv ("SF_BENCH_WINDOWED") == SF_NULL;
+	out_game->app_config.frames_in_flight =
+		env_u32 ("SF_BENCH_FRAMES_IN_FLIGHT", 2);
+	out_game->initialize			  = benchmark_initialize;
+	out_game->update				  = benchmark_update;
+	out_game->render				  = benchmark_render;
+
+	out_game->state = sfalloc (sizeof (benchmark_state), MEMORY_TAG_GAME);
+	benchmark_state *state = out_game->state;
+	state->warmup_frames   = env_u32 ("SF_BENCH_WARMUP", 60);
+	state->measured_frames = env_u32 ("SF_BENCH_FRAMES", 1000);
+	state->draw_count	   = env_u32 ("SF_BENCH_DRAWS", 4096);
+	if (state->draw_count > RENDER_MAX_DRAWS) {
+		state->draw_count = RENDER_MAX_DRAWS;
+	}
+	state->report_path	   = getenv ("SF_BENCH_REPORT");
+	if (!state->report_path) { state->report_path = "benchmark_report.json"; }
+	state->baseline_path = getenv ("SF_BENCH_BASELINE");
+	state->frame_ms =
+		sfalloc (sizeof (f64) * state->measured_frames, MEMORY_TAG_GAME);
+	state->render_ms =
+		sfalloc (sizeof (f64) * state->measured_frames, MEMORY_TAG_GAME);
+	state->wait_ms =
+		sfalloc (sizeof (f64) * state->measured_frames, MEMORY_TAG_GAME);
+	state->draws =
+		sfalloc (sizeof (mesh_data) * state->draw_count, MEMORY_TAG_GAME);
+	build_draws (state);
+	return TRUE;
+}
+
+void game_shutdown (game *game_instance) {
+	benchmark_state *state = game_instance->state;
+	if (state->sample_count < state->measured_frames) {
+		SF_ERROR ("Benchmark stopped after %u of %u frames.",
+				  state->sample_count, state->measured_frames);
+		application_request_quit (game_instance, 1);
+	} else if (!write_report (game_instance, state)) {
+		application_request_quit (game_instance, 1);
+	} else if (state->baseline_path) {
+		baseline_options options;
+		baseline_default_options (&options);
+		const char *tolerance = getenv ("SF_BENCH_TOLERANCE");
+		if (tolerance && *tolerance) {
+			options.tolerance_percent = strtod (tolerance, SF_NULL);
+		}
+		i32 regressions = baseline_compare (state->baseline_path,
+											state->report_path, &options);
+		if (regressions != 0) {
+			application_request_quit (game_instance, regressions < 0 ? 1 : 2);
+		}
+	}
+	sffree (state->frame_ms, sizeof (f64) * state->measured_frames,
+			MEMORY_TAG_GAME);
+	sffree (state->render_ms, sizeof (f64) * state->measured_frames,
+			MEMORY_TAG_GAME);
+	sffree (state->wait_ms, sizeof (f64) * state->measured_frames,
+			MEMORY_TAG_GAME);
+	sffree (state->draws, sizeof (mesh_data) * state->draw_count,
+			MEMORY_TAG_GAME);
+	sffree (state, sizeof (benchmark_state), MEMORY_TAG_GAME);
+	game_instance->state = SF_NULL;
+}
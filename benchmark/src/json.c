@@ -0,0 +1,257 @@
+#include "json.h"
+#include "containers/vector.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "platform/filesystem.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_MAX_DEPTH 64
+
+typedef struct json_parser {
+	char *cursor;
+	json_value *nodes;
+	b8 failed;
+} json_parser;
+
+static void skip_whitespace (json_parser *parser) {
+	while (*parser->cursor == ' ' || *parser->cursor == '\t' ||
+		   *parser->cursor == '\n' || *parser->cursor == '\r') {
+		++parser->cursor;
+	}
+}
+
+static u32 add_node (json_parser *parser, json_type type) {
+	json_value node	  = {0};
+	node.type		  = type;
+	node.first_child  = INVALID_ID;
+	node.next_sibling = INVALID_ID;
+	vector_push (parser->nodes, node);
+	return (u32)vector_len (parser->nodes) - 1;
+}
+
+static b8 fail (json_parser *parser, const char *what) {
+	if (!parser->failed) {
+		SF_ERROR ("JSON: %s near '%.16s'.", what, parser->cursor);
+	}
+	parser->failed = TRUE;
+	return FALSE;
+}
+
+// Unescapes in place. The output never outruns the input, so the closing
+// quote can become the terminator.
+static const char *parse_string (json_parser *parser) {
+	if (*parser->cursor != '"') {
+		fail (parser, "expected a string");
+		return SF_NULL;
+	}
+	char *start	= ++parser->cursor;
+	char *out	= start;
+	while (*parser->cursor != '"') {
+		char c = *parser->cursor++;
+		if (c == 0) {
+			fail (parser, "unterminated string");
+			return SF_NULL;
+		}
+		if (c != '\\') {
+			*out++ = c;
+			continue;
+		}
+		c = *parser->cursor++;
+		switch (c) {
+			case 'n': *out++ = '\n'; break;
+			case 't': *out++ = '\t'; break;
+			case 'r': *out++ = '\r'; break;
+			case 'b': *out++ = '\b'; break;
+			case 'f': *out++ = '\f'; break;
+			case 'u': {
+				char hex[5] = {0};
+				for (u32 i = 0; i < 4 && *parser->cursor; ++i) {
+					hex[i] = *parser->cursor++;
+				}
+				long code = strtol (hex, SF_NULL, 16);
+				*out++	  = code > 0 && code < 0x80 ? (char)code : '?';
+				break;
+			}
+			case '"':
+			case '\\':
+			case '/': *out++ = c; break;
+			default: fail (parser, "invalid escape"); return SF_NULL;
+		}
+	}
+	++parser->cursor;
+	*out = 0;
+	return start;
+}
+
+static u32 parse_value (json_parser *parser, u32 depth);
+
+static void append_child (json_parser *parser, u32 parent, u32 *last,
+						  u32 child) {
+	if (*last == INVALID_ID) {
+		parser->nodes[parent].first_child = child;
+	} else {
+		parser->nodes[*last].next_sibling = child;
+	}
+	*last = child;
+	++parser->nodes[parent].child_count;
+}
+
+static u32 parse_container (json_parser *parser, json_type type, u32 depth) {
+	char close = type == JSON_ARRAY ? ']' : '}';
+	u32 node   = add_node (parser, type);
+	u32 last   = INVALID_ID;
+	++parser->cursor;
+	skip_whitespace (parser);
+	if (*parser->cursor == close) {
+		++parser->cursor;
+		return node;
+	}
+	while (!parser->failed) {
+		skip_whitespace (parser);
+		const char *key = SF_NULL;
+		if (type == JSON_OBJECT) {
+			key = parse_string (parser);
+			skip_whitespace (parser);
+			if (!key || *parser->cursor != ':') {
+				fail (parser, "expected ':'");
+				break;
+			}
+			++parser->cursor;
+		}
+		u32 child = parse_value (parser, depth + 1);
+		if (child == INVALID_ID) { break; }
+		// parse_value may have grown the vector, index again.
+		parser->nodes[child].key = key;
+		append_child (parser, node, &last, child);
+		skip_whitespace (parser);
+		if (*parser->cursor == ',') {
+			++parser->cursor;
+		} else if (*parser->cursor == close) {
+			++parser->cursor;
+			return node;
+		} else {
+			fail (parser, "expected ',' or a closing bracket");
+		}
+	}
+	return INVALID_ID;
+}
+
+static u32 parse_value (json_parser *parser, u32 depth) {
+	if (depth > JSON_MAX_DEPTH) {
+		fail (parser, "nested too deeply");
+		return INVALID_ID;
+	}
+	skip_whitespace (parser);
+	char c = *parser->cursor;
+	if (c == '{') { return parse_container (parser, JSON_OBJECT, depth); }
+	if (c == '[') { return parse_container (parser, JSON_ARRAY, depth); }
+	if (c == '"') {
+		const char *string = parse_string (parser);
+		if (!string) { return INVALID_ID; }
+		u32 node				   = add_node (parser, JSON_STRING);
+		parser->nodes[node].string = string;
+		return node;
+	}
+	if (strncmp (parser->cursor, "true", 4) == 0 ||
+		strncmp (parser->cursor, "false", 5) == 0) {
+		b8 value = c == 't';
+		parser->cursor += value ? 4 : 5;
+		u32 node					= add_node (parser, JSON_BOOL);
+		parser->nodes[node].boolean	= value;
+		return node;
+	}
+	if (strncmp (parser->cursor, "null", 4) == 0) {
+		parser->cursor += 4;
+		return add_node (parser, JSON_NULL);
+	}
+	char *end  = SF_NULL;
+	f64 number = strtod (parser->cursor, &end);
+	if (end == parser->cursor) {
+		fail (parser, "unexpected character");
+		return INVALID_ID;
+	}
+	parser->cursor			   = end;
+	u32 node				   = add_node (parser, JSON_NUMBER);
+	parser->nodes[node].number = number;
+	return node;
+}
+
+b8 json_parse_file (const char *path, json_document *out_document) {
+	sfmemset (out_document, 0, sizeof (json_document));
+	file_handle handle;
+	if (!filesystem_open (path, FILE_MODE_READ, TRUE, &handle)) {
+		SF_ERROR ("Failed to open '%s'.", path);
+		return FALSE;
+	}
+	u8 *bytes = SF_NULL;
+	u64 size  = 0;
+	b8 read	  = filesystem_read_all_bytes (&handle, &bytes, &size);
+	filesystem_close (&handle);
+	if (!read) {
+		SF_ERROR ("Failed to read '%s'.", path);
+		return FALSE;
+	}
+	out_document->text_size = size + 1;
+	out_document->text =
+		sfalloc (out_document->text_size, MEMORY_TAG_STRING);
+	sfmemcpy (out_document->text, bytes, size);
+	sffree (bytes, size, MEMORY_TAG_STRING);
+
+	json_parser parser = {0};
+	parser.cursor	   = out_document->text;
+	parser.nodes	   = vector_create (json_value);
+	u32 root		   = parse_value (&parser, 0);
+	skip_whitespace (&parser);
+	if (root != INVALID_ID && *parser.cursor != 0) {
+		fail (&parser, "trailing characters");
+	}
+	out_document->nodes = parser.nodes;
+	if (root == INVALID_ID || parser.failed) {
+		SF_ERROR ("'%s' is not valid JSON.", path);
+		json_document_destroy (out_document);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void json_document_destroy (json_document *document) {
+	if (document->nodes) { vector_destroy (document->nodes); }
+	if (document->text) {
+		sffree (document->text, document->text_size, MEMORY_TAG_STRING);
+	}
+	sfmemset (document, 0, sizeof (json_document));
+}
+
+const json_value *json_root (const json_document *document) {
+	return document->nodes ? &document->nodes[0] : SF_NULL;
+}
+
+const json_value *json_first (const json_document *document,
+							  const json_value *value) {
+	if (!value || value->first_child == INVALID_ID) { return SF_NULL; }
+	return &document->nodes[value->first_child];
+}
+
+const json_value *json_next (const json_document *document,
+							 const json_value *value) {
+	if (value->next_sibling == INVALID_ID) { return SF_NULL; }
+	return &document->nodes[value->next_sibling];
+}
+
+const json_value *json_get (const json_document *document,
+							const json_value *value, const char *key) {
+	if (!value || value->type != JSON_OBJECT) { return SF_NULL; }
+	const json_value *child = json_first (document, value);
+	while (child && !sfstreq (child->key, key)) {
+		child = json_next (document, child);
+	}
+	return child;
+}
+
+f64 json_get_number (const json_document *document, const json_value *value,
+					 const char *key, f64 fallback) {
+	const json_value *member = json_get (document, value, key);
+	return member && member->type == JSON_NUMBER ? member->number : fallback;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+
+// Just enough JSON to read benchmark reports back. The document owns a copy
+// of the text, strings point into it. \u escapes outside ASCII are replaced
+// with '?'.
+
+typedef enum json_type {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT
+} json_type;
+
+typedef struct json_value {
+	json_type type;
+	// Set on members of an object.
+	const char* key;
+	f64 number;
+	b8 boolean;
+	const char* string;
+	u32 child_count;
+	// Node indices, INVALID_ID when there is none.
+	u32 first_child;
+	u32 next_sibling;
+} json_value;
+
+typedef struct json_document {
+	char* text;
+	u64 text_size;
+	// vector of json_value, the root is the first one.
+	json_value* nodes;
+} json_document;
+
+/**
+ * @brief Reads and parses the file at path.
+ * @return FALSE if it can't be read or isn't valid JSON, out_document is left empty.
+ */
+b8 json_parse_file (const char* path, json_document* out_document);
+void json_document_destroy (json_document* document);
+
+const json_value* json_root (const json_document* document);
+
+/**
+ * @brief Looks up a member of an object.
+ * @return NULL if value isn't an object or has no such member.
+ */
+const json_value* json_get (const json_document* document,
+							const json_value* value, const char* key);
+
+// Iterates the elements of an array or the members of an object:
+// for (child = json_first (doc, value); child; child = json_next (doc, child))
+const json_value* json_first (const json_document* document,
+							  const json_value* value);
+const json_value* json_next (const json_document* document,
+							 const json_value* value);
+
+// The number of a member, or fallback if it is missing or not a number.
+f64 json_get_number (const json_document* document, const json_value* value,
+					 const char* key, f64 fallback);
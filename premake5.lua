@@ -1,5 +1,10 @@
 include "Dependencies.lua"
 
+newoption {
+   trigger = "profile",
+   description = "Compile in CPU profiler zones (SF_PROFILING_ENABLED)"
+}
+
 workspace "Sapfire"
    configurations { "Debug", "Release" }
 
@@ -8,6 +13,14 @@ workspace "Sapfire"
    targetdir "bin/%{cfg.buildcfg}"
    toolset "clang"
 
+   filter "options:profile"
+      defines { "SF_PROFILING_ENABLED" }
+   filter {}
+
    group "Core"
    include "sapfire"
+   group "Tools"
+   include "tools"
+   group "Benchmarks"
+   include "benchmark"
    group ""
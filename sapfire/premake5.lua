@@ -18,3 +18,6 @@ project "Sapfire"
    filter "configurations:Release"
       defines { "NDEBUG" }
       optimize "On"
+
+   filter "system:linux"
+      links { "pthread" }
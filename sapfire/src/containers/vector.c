@@ -31,10 +31,13 @@ void _vector_field_set (void *vector, u64 field, u64 val) {
 }
 
 void *_vector_resize (void *vector) {
-	u64 length = vector_len (vector);
-	u64 stride = vector_stride (vector);
+	u64 length	 = vector_len (vector);
+	u64 stride	 = vector_stride (vector);
+	u64 capacity = vector_capacity (vector);
+	// A vector reserved with 0 capacity would never grow otherwise.
 	void *temp = _vector_create (
-		(VECTOR_RESIZE_FACTOR * vector_capacity (vector)), stride);
+		capacity ? VECTOR_RESIZE_FACTOR * capacity : VECTOR_DEFAULT_CAPACITY,
+		stride);
 	sfmemcpy (temp, vector, length * stride);
 	_vector_field_set (temp, VECTOR_LENGTH, length);
 	_vector_destroy (vector);
@@ -63,15 +66,16 @@ void *_vector_pop_at (void *vector, u64 index, void *dest) {
 	u64 len	   = vector_len (vector);
 	u64 stride = vector_stride (vector);
 	if (index >= len) {
-		SF_ERROR ("Index out of range! Length: %i, index: %i", len, index);
+		SF_ERROR ("Index out of range! Length: %llu, index: %llu", len, index);
 		return vector;
 	}
 	u64 addr = (u64)vector;
 	sfmemcpy (dest, (void *)(addr + (index * stride)), stride);
+	// Shift the elements after index down by one.
 	if (index != len - 1) {
-		sfmemcpy ((void *)(addr + (index * stride)),
-				  (void *)(addr + ((index + 1) * stride)),
-				  (len - index) * stride);
+		sfmemmove ((void *)(addr + (index * stride)),
+				   (void *)(addr + ((index + 1) * stride)),
+				   (len - index - 1) * stride);
 	}
 	_vector_field_set (vector, VECTOR_LENGTH, len - 1);
 	return vector;
@@ -80,15 +84,17 @@ void *_vector_pop_at (void *vector, u64 index, void *dest) {
 void *_vector_insert_at (void *vector, u64 index, const void *val_ptr) {
 	u64 len	   = vector_len (vector);
 	u64 stride = vector_stride (vector);
-	if (index >= len) {
-		SF_ERROR ("Index out of range! Length: %i, index: %i", len, index);
+	// index == len appends.
+	if (index > len) {
+		SF_ERROR ("Index out of range! Length: %llu, index: %llu", len, index);
 		return vector;
 	}
-	if (len >= vector_capacity (vector)) { _vector_resize (vector); }
+	if (len >= vector_capacity (vector)) { vector = _vector_resize (vector); }
 	u64 addr = (u64)vector;
-	if (index != len - 1) {
-		sfmemcpy ((void *)(addr + ((index + 1) * stride)),
-				  (void *)(addr + (index * stride)), (len - index) * stride);
+	// Shift the elements from index on up by one.
+	if (index != len) {
+		sfmemmove ((void *)(addr + ((index + 1) * stride)),
+				   (void *)(addr + (index * stride)), (len - index) * stride);
 	}
 	sfmemcpy ((void *)(addr + (index * stride)), val_ptr, stride);
 	_vector_field_set (vector, VECTOR_LENGTH, len + 1);
@@ -2,14 +2,155 @@
 #include "core/clock.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "core/input_actions.h"
+#include "core/job_system.h"
 #include "core/logger.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "core/profiler_server.h"
 #include "core/sfmemory.h"
+#include "core/startup_timer.h"
+#include "core/thread_pinning.h"
 #include "entry.h"
 #include "game_definitions.h"
 #include "memory/lin_alloc.h"
 #include "platform/platform.h"
 #include "renderer/renderer.h"
 #include "renderer/renderer_types.h"
+#include <stdlib.h>
+
+// Longer frames (debugger breaks, window drags) are treated as this long.
+#define APPLICATION_MAX_FRAME_DELTA 0.25
+
+#ifdef SF_PROFILING_ENABLED
+// Puts the work counts of the last frame and the memory in use next to the
+// zones, as counter tracks in the trace and the live stream.
+static void record_frame_values () {
+	for (u32 i = 0; i < metrics_count (); ++i) {
+		f64 value;
+		if (metrics_get_history (i, &value, 1)) {
+			SF_PROFILE_VALUE (metrics_get_name (i), value);
+		}
+	}
+	memory_stats stats;
+	memory_get_stats (&stats);
+	SF_PROFILE_VALUE ("memory_bytes", (f64)stats.total);
+	SF_PROFILE_VALUE ("allocations", (f64)stats.allocation_count);
+}
+#endif
+
+// Frame tasks. Each gets the game instance and runs once per frame, in the
+// order build_frame_graph declares unless the resources allow overlap.
+static void pump_platform_task (void *params) {
+	application_state *app_state = ((game *)params)->application_state;
+	if (!platform_update_internal_state (&app_state->plat_state)) {
+		app_state->is_running = FALSE;
+	}
+}
+
+static void update_input_actions_task (void *params) {
+	input_actions_update ();
+}
+
+static void fixed_update_task (void *params) {
+	game *game_instance			 = params;
+	application_state *app_state = game_instance->application_state;
+	const f64 fixed_delta		 = app_state->fixed_delta_time;
+	const f64 delta				 = app_state->frame_delta;
+	app_state->update_accumulator +=
+		delta < APPLICATION_MAX_FRAME_DELTA ? delta
+											: APPLICATION_MAX_FRAME_DELTA;
+	u32 update_count = 0;
+	while (app_state->update_accumulator >= fixed_delta) {
+		if (update_count == app_state->max_updates_per_frame) {
+			// Can't keep up, drop the backlog but keep the phase.
+			u64 behind = (u64)(app_state->update_accumulator / fixed_delta);
+			app_state->update_accumulator -= behind * fixed_delta;
+			break;
+		}
+		if (!game_instance->update (game_instance, (f32)fixed_delta)) {
+			SF_FATAL ("Game update failed, shutting down.");
+			application_request_quit (game_instance, 1);
+			break;
+		}
+		app_state->update_accumulator -= fixed_delta;
+		++update_count;
+	}
+}
+
+static void build_render_packet_task (void *params) {
+	game *game_instance			 = params;
+	application_state *app_state = game_instance->application_state;
+	// Waits here if the render thread is still behind on older frames,
+	// the fixed updates already overlapped with it.
+	render_bundle *bundle = renderer_acquire_bundle (&app_state->renderer);
+
+	bundle->deltaTime = app_state->frame_delta;
+	bundle->alpha =
+		(f32)(app_state->update_accumulator / app_state->fixed_delta_time);
+	if (!game_instance->render (game_instance, bundle)) {
+		SF_FATAL ("Game render failed, shutting down.");
+		application_request_quit (game_instance, 1);
+	}
+	app_state->frame_bundle = bundle;
+}
+
+static void submit_render_packet_task (void *params) {
+	application_state *app_state = ((game *)params)->application_state;
+	renderer_draw_frame (&app_state->renderer, app_state->frame_bundle);
+	app_state->frame_bundle = SF_NULL;
+}
+
+static void update_input_task (void *params) {
+	application_state *app_state = ((game *)params)->application_state;
+	input_update (app_state->frame_delta);
+}
+
+static void add_frame_task (game *game_instance, const char *name,
+							PFN_task entry, u64 reads, u64 writes,
+							b8 main_thread) {
+	application_state *app_state = game_instance->application_state;
+	task_desc desc;
+	desc.name		 = name;
+	desc.entry		 = entry;
+	desc.params		 = game_instance;
+	desc.reads		 = reads;
+	desc.writes		 = writes;
+	desc.main_thread = main_thread;
+	task_graph_add (&app_state->frame_graph, &desc);
+}
+
+// Declared in the order the frame used to run them serially. The game and
+// renderer callbacks are documented to run on the main thread, so they stay
+// there; the input bookkeeping may go to workers.
+static void build_frame_graph (game *game_instance) {
+	application_state *app_state = game_instance->application_state;
+	task_graph_create (&app_state->frame_graph);
+	const u64 platform		= TASK_RESOURCE (FRAME_RESOURCE_PLATFORM);
+	const u64 input			= TASK_RESOURCE (FRAME_RESOURCE_INPUT);
+	const u64 input_actions = TASK_RESOURCE (FRAME_RESOURCE_INPUT_ACTIONS);
+	const u64 game_state	= TASK_RESOURCE (FRAME_RESOURCE_GAME_STATE);
+	const u64 render_bundle = TASK_RESOURCE (FRAME_RESOURCE_RENDER_BUNDLE);
+	add_frame_task (game_instance, "pump_platform", pump_platform_task, 0,
+					platform | input, TRUE);
+	add_frame_task (game_instance, "update_input_actions",
+					update_input_actions_task, input, input_actions, FALSE);
+	add_frame_task (game_instance, "fixed_update", fixed_update_task,
+					input | input_actions, game_state, TRUE);
+	if (game_instance->register_frame_tasks) {
+		game_instance->register_frame_tasks (game_instance,
+											 &app_state->frame_graph);
+	}
+	add_frame_task (game_instance, "build_render_packet",
+					build_render_packet_task,
+					input | input_actions | game_state, render_bundle, TRUE);
+	add_frame_task (game_instance, "submit_render_packet",
+					submit_render_packet_task, 0, render_bundle, TRUE);
+	// Copies this frame's input into the previous state, so it goes after
+	// every reader and overlaps with the submit.
+	add_frame_task (game_instance, "update_input", update_input_task, 0, input,
+					FALSE);
+}
 
 b8 application_create (game *game_instance) {
 	// Called more than once.
@@ -22,6 +163,9 @@ b8 application_create (game *game_instance) {
 		sfalloc (sizeof (application_state), MEMORY_TAG_APPLICATION);
 	application_state *app_state = game_instance->application_state;
 
+	u32 startup = startup_timer_begin ("application_create");
+	u32 phase	= startup_timer_begin ("core_systems");
+
 	u64 systems_alloc_total_size = 64 * 1024 * 1024;
 	linear_allocator_create (systems_alloc_total_size, SF_NULL,
 							 &app_state->systems_allocator);
@@ -46,6 +190,48 @@ b8 application_create (game *game_instance) {
 		SF_FATAL ("Failed to initialize logging.")
 		return FALSE;
 	}
+	thread_pinning_initialize (&app_state->thread_pinning_system_memory_size,
+							   SF_NULL, SF_NULL);
+	app_state->thread_pinning_system =
+		linear_allocator_alloc (&app_state->systems_allocator,
+								app_state->thread_pinning_system_memory_size);
+	// Plan thread placement before the log writer, the first thread started.
+	if (!thread_pinning_initialize (
+			&app_state->thread_pinning_system_memory_size,
+			app_state->thread_pinning_system,
+			&game_instance->app_config.thread_pinning)) {
+		SF_FATAL ("Failed to initialize thread pinning.");
+		return FALSE;
+	}
+	thread_pinning_apply (THREAD_ROLE_MAIN, 0);
+	if (!logging_set_mode (game_instance->app_config.log_mode)) {
+		SF_WARNING ("Failed to switch logging mode, staying synchronous.");
+	}
+
+	metrics_initialize (&app_state->metrics_system_memory_size, SF_NULL);
+	app_state->metrics_system = linear_allocator_alloc (
+		&app_state->systems_allocator, app_state->metrics_system_memory_size);
+	// Initialize the metrics registry.
+	if (!metrics_initialize (&app_state->metrics_system_memory_size,
+							 app_state->metrics_system)) {
+		SF_FATAL ("Failed to initialize metrics.");
+		return FALSE;
+	}
+
+#ifdef SF_PROFILING_ENABLED
+	profiler_initialize (&app_state->profiler_system_memory_size, SF_NULL);
+	app_state->profiler_system =
+		linear_allocator_alloc (&app_state->systems_allocator,
+								app_state->profiler_system_memory_size);
+	if (!profiler_initialize (&app_state->profiler_system_memory_size,
+							  app_state->profiler_system)) {
+		SF_FATAL ("Failed to initialize the profiler.");
+		return FALSE;
+	}
+	// Optional, a failure only costs the live view.
+	const char *server_port = getenv ("SF_PROFILE_SERVER");
+	if (server_port) { profiler_server_start ((u16)atoi (server_port)); }
+#endif
 
 	input_initialize (&app_state->input_system_memory_size, SF_NULL);
 	app_state->input_system = linear_allocator_alloc (
@@ -57,70 +243,185 @@ b8 application_create (game *game_instance) {
 		return FALSE;
 	}
 
+	input_actions_initialize (&app_state->input_actions_system_memory_size,
+							  SF_NULL);
+	app_state->input_actions_system =
+		linear_allocator_alloc (&app_state->systems_allocator,
+								app_state->input_actions_system_memory_size);
+	// Initialize the action mapping layer on top of input.
+	if (!input_actions_initialize (&app_state->input_actions_system_memory_size,
+								   app_state->input_actions_system)) {
+		SF_FATAL ("Failed to initialize input action system.");
+		return FALSE;
+	}
+	startup_timer_end (phase);
+
+	phase				 = startup_timer_begin ("job_system");
+	u32 job_thread_count = game_instance->app_config.job_thread_count;
+	// One worker per core pinning planned for, fewer if a core went to the
+	// render thread.
+	if (job_thread_count == 0) {
+		job_thread_count = thread_pinning_worker_core_count ();
+	}
+	job_system_initialize (&app_state->job_system_memory_size, SF_NULL,
+						   job_thread_count);
+	app_state->job_system = linear_allocator_alloc (
+		&app_state->systems_allocator, app_state->job_system_memory_size);
+	// Start the workers, game->update can kick jobs from here on.
+	if (!job_system_initialize (&app_state->job_system_memory_size,
+								app_state->job_system, job_thread_count)) {
+		SF_FATAL ("Failed to initialize the job system.");
+		return FALSE;
+	}
+	startup_timer_end (phase);
+
 	// Creates a new app.
+	phase = startup_timer_begin ("platform");
 	if (!platform_init (&app_state->plat_state, game_instance->app_config.name,
 						game_instance->app_config.x,
 						game_instance->app_config.y,
 						game_instance->app_config.width,
-						game_instance->app_config.height, 0)) {
+						game_instance->app_config.height, 0,
+						game_instance->app_config.headless)) {
 		SF_FATAL ("FAILED TO CREATE APP!");
 		return FALSE;
 	}
+	startup_timer_end (phase);
+	const application_config *config = &game_instance->app_config;
+	app_state->fixed_delta_time =
+		1.0 / (config->fixed_update_rate > 0 ? config->fixed_update_rate : 60);
+	app_state->max_updates_per_frame =
+		config->max_updates_per_frame ? config->max_updates_per_frame : 8;
+
+	frame_pacer_initialize (&app_state->frame_pacer,
+							game_instance->app_config.frame_pacing,
+							game_instance->app_config.target_frame_rate);
+	renderer_present_mode present_mode = RENDERER_PRESENT_MODE_DEFAULT;
+	if (game_instance->app_config.frame_pacing == FRAME_PACING_VSYNC) {
+		present_mode = RENDERER_PRESENT_MODE_VSYNC;
+	} else if (game_instance->app_config.frame_pacing ==
+			   FRAME_PACING_UNCAPPED) {
+		present_mode = RENDERER_PRESENT_MODE_IMMEDIATE;
+	}
 	// Initialize the renderer
+	phase = startup_timer_begin ("renderer");
 	if (!renderer_initialize (&app_state->renderer, RENDERER_API_VULKAN,
 							  game_instance->app_config.name,
-							  &app_state->plat_state)) {
+							  &app_state->plat_state, present_mode,
+							  game_instance->app_config.render_packet_count,
+							  game_instance->app_config.frames_in_flight,
+							  game_instance->app_config.latency_mode)) {
 		SF_FATAL ("Failed to initialize renderer");
 		return FALSE;
 	}
+	startup_timer_end (phase);
+
+	phase = startup_timer_begin ("game_initialize");
+	if (!game_instance->initialize (game_instance)) {
+		SF_FATAL ("Game failed to initialize.");
+		return FALSE;
+	}
+	startup_timer_end (phase);
+	build_frame_graph (game_instance);
+	startup_timer_end (startup);
+	startup_timer_log_report ();
 	SF_INFO ("Application initialized sucessfully.")
 	return TRUE;
 }
 
-void application_run (game *game_instance) {
+i32 application_run (game *game_instance) {
 	application_state *app_state = game_instance->application_state;
 	app_state->is_running		 = TRUE;
+	app_state->exit_code		 = 0;
+	sfmemset (&app_state->frame_history, 0, sizeof (frame_history));
 	clock_start (&app_state->main_clock);
 	clock_tick (&app_state->main_clock);
-	app_state->last_time = (float)app_state->main_clock.elapsed_ticks / 1000;
-	f64 running_time	 = 0;
-	const f64 target_frame_time = 1.0f / 60;
+	app_state->last_time_ns = app_state->main_clock.elapsed_ns;
+	app_state->update_accumulator = 0;
+	b8 first_frame				  = TRUE;
+	frame_pacer_start (&app_state->frame_pacer);
 	while (app_state->is_running) {
+		SF_PROFILE_FRAME_MARK ();
 		clock_tick (&app_state->main_clock);
-		f64 current_time = (float)app_state->main_clock.elapsed_ticks / 1000;
-		f64 delta		 = current_time - app_state->last_time;
-		f64 frame_start_time = (float)platform_get_absolute_time () / 1000;
-		if (!platform_update_internal_state (&app_state->plat_state)) {
-			app_state->is_running = FALSE;
-		}
-		/* game_instance->update (game_instance, (f32)delta); */
-
-		// TODO: rework this awfulness
-		render_bundle bundle;
-		bundle.deltaTime = delta;
-		renderer_draw_frame (&app_state->renderer, &bundle);
-
-		f64 frame_end_time	   = (float)platform_get_absolute_time () / 1000;
-		f64 frame_elapsed_time = frame_end_time - frame_start_time;
-		running_time += frame_elapsed_time;
-		f64 remaining_seconds = target_frame_time - frame_elapsed_time;
-		if (remaining_seconds > 0) {
-			u32 remaining_ms = remaining_seconds * 1000;
-			platform_sleep (remaining_ms - 1);
+		u64 current_time_ns = app_state->main_clock.elapsed_ns;
+		u64 frame_time_ns	= current_time_ns - app_state->last_time_ns;
+		f64 delta			= frame_time_ns * 1e-9;
+		// The first delta only covers the time since clock_start.
+		if (!first_frame) {
+			frame_history_push (&app_state->frame_history, frame_time_ns);
 		}
-		app_state->last_time = current_time;
+		first_frame			   = FALSE;
+		app_state->frame_delta = delta;
+
+		task_graph_run (&app_state->frame_graph);
+		const task_graph_path *path = &app_state->frame_graph.critical_path;
+		SF_METRIC_GAUGE ("frame_critical_path_ms", path->duration_ns / 1e6);
+		SF_METRIC_GAUGE ("frame_tasks_ms", path->run_ns / 1e6);
+
+		frame_pacer_wait (&app_state->frame_pacer);
+		metrics_frame_end ();
+#ifdef SF_PROFILING_ENABLED
+		record_frame_values ();
+#endif
+		app_state->last_time_ns = current_time_ns;
 	}
 	app_state->is_running = FALSE;
 
 	// Cleanup
+	// Joins the render thread, which queues draw recording jobs and writes
+	// uploaded textures back into game memory, before the game frees it.
+	renderer_shutdown (&app_state->renderer);
 	game_shutdown (game_instance);
-	application_shutdown (game_instance);
+	job_system_shutdown (app_state->job_system);
+#ifdef SF_PROFILING_ENABLED
+	const char *profile_output = getenv ("SF_PROFILE_OUTPUT");
+	if (profile_output) { profiler_export_chrome_trace (profile_output); }
+	profiler_server_stop ();
+	profiler_shutdown (app_state->profiler_system);
+#endif
+	const char *metrics_output = getenv ("SF_METRICS_OUTPUT");
+	if (metrics_output) { metrics_write_csv (metrics_output); }
+	metrics_shutdown (app_state->metrics_system);
+	input_actions_shutdown (app_state->input_actions_system);
 	input_shutdown (app_state->input_system);
 	logging_shutdown (app_state->logging_system);
-	renderer_shutdown (&app_state->renderer);
+	thread_pinning_shutdown (app_state->thread_pinning_system);
 	event_shutdown (app_state->event_system);
 	linear_allocator_destroy (&app_state->systems_allocator);
+	i32 exit_code = app_state->exit_code;
+	// Frees app_state, must come last.
+	application_shutdown (game_instance);
 	memory_shutdown ();
+	return exit_code;
+}
+
+void application_request_quit (game *game_instance, i32 exit_code) {
+	application_state *app_state = game_instance->application_state;
+	app_state->is_running		 = FALSE;
+	app_state->exit_code		 = exit_code;
+}
+
+void application_get_frame_stats (game *game_instance,
+								  frame_stats *out_stats) {
+	application_state *app_state = game_instance->application_state;
+	frame_history_compute (&app_state->frame_history, out_stats);
+}
+
+void application_get_pacing_stats (game *game_instance,
+								   frame_pacing_stats *out_stats) {
+	application_state *app_state = game_instance->application_state;
+	frame_pacer_get_stats (&app_state->frame_pacer, out_stats);
+}
+
+void application_get_critical_path (game *game_instance,
+									task_graph_path *out_path) {
+	application_state *app_state = game_instance->application_state;
+	task_graph_get_critical_path (&app_state->frame_graph, out_path);
+}
+
+const task_graph *application_get_frame_graph (game *game_instance) {
+	application_state *app_state = game_instance->application_state;
+	return &app_state->frame_graph;
 }
 
 void application_shutdown (game *game) {
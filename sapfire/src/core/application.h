@@ -1,14 +1,60 @@
 #pragma once
 #include "core/clock.h"
+#include "core/frame_pacer.h"
+#include "core/frame_stats.h"
+#include "core/task_graph.h"
+#include "core/thread_pinning.h"
 #include "defines.h"
 #include "logger.h"
 #include "memory/lin_alloc.h"
 #include "platform/platform.h"
 #include "renderer/renderer_types.h"
 struct game;
+
+// Frame state the engine's frame tasks read and write, as bit indices for
+// TASK_RESOURCE. Tasks a game adds declare these, and bits from
+// FRAME_RESOURCE_GAME_FIRST up for state of its own.
+typedef enum frame_resource {
+	// The window, OS messages and the events they fire.
+	FRAME_RESOURCE_PLATFORM,
+	// Device state, see input.h.
+	FRAME_RESOURCE_INPUT,
+	FRAME_RESOURCE_INPUT_ACTIONS,
+	// Whatever game->update simulates.
+	FRAME_RESOURCE_GAME_STATE,
+	// The bundle of the frame being built.
+	FRAME_RESOURCE_RENDER_BUNDLE,
+	FRAME_RESOURCE_GAME_FIRST
+} frame_resource;
+
 typedef struct application_config {
 	i32 x, y, width, height;
 	const char* name;
+	log_mode log_mode;
+	frame_pacing_mode frame_pacing;
+	// Frames per second when frame_pacing is FRAME_PACING_CAPPED, 60 if 0.
+	f32 target_frame_rate;
+	// Rate of game->update calls in Hz, 60 if 0.
+	f32 fixed_update_rate;
+	// Updates run at most this many times per frame, 8 if 0. Time beyond
+	// that is dropped so a slow frame can't snowball.
+	u32 max_updates_per_frame;
+	// Render without a visible window, for benchmarks and CI machines.
+	b8 headless;
+	// Job system workers including the main thread, one per physical core
+	// if 0.
+	u32 job_thread_count;
+	// Frames buffered between the game and the render thread, 2 or 3; 2 if
+	// 0. Each one more lets the game run a frame further ahead.
+	u32 render_packet_count;
+	// Frames the render thread records while the GPU still works on earlier
+	// ones, 1 to 3; 2 if 0. 1 has the lowest latency, more keep CPU and GPU
+	// time spikes from stalling each other.
+	u32 frames_in_flight;
+	// Whether the render thread draws every packet or only the newest.
+	renderer_latency_mode latency_mode;
+	// Where engine threads run, zeroed leaves it to the OS.
+	thread_pinning_config thread_pinning;
 } application_config;
 
 typedef struct application_state {
@@ -18,16 +64,40 @@ typedef struct application_state {
 	struct game* game_instance;
 	renderer renderer;
 	clock main_clock;
-	f64 last_time;
+	u64 last_time_ns;
+	frame_history frame_history;
+	frame_pacer frame_pacer;
+	f64 fixed_delta_time;
+	u32 max_updates_per_frame;
+	// Frame time not yet consumed by fixed updates.
+	f64 update_accumulator;
+	// Everything a frame does between the clock tick and the pacer, run
+	// once per frame.
+	task_graph frame_graph;
+	// Handed from task to task within a frame.
+	f64 frame_delta;
+	struct render_bundle* frame_bundle;
 	b8 is_running;
+	// Returned by application_run.
+	i32 exit_code;
 	linear_allocator systems_allocator;
 
 	u64 logging_system_memory_size;
 	void* logging_system;
+	u64 thread_pinning_system_memory_size;
+	void* thread_pinning_system;
 	u64 event_system_memory_size;
 	void* event_system;
 	u64 input_system_memory_size;
 	void* input_system;
+	u64 input_actions_system_memory_size;
+	void* input_actions_system;
+	u64 job_system_memory_size;
+	void* job_system;
+	u64 metrics_system_memory_size;
+	void* metrics_system;
+	u64 profiler_system_memory_size;
+	void* profiler_system;
 } application_state;
 
 /**
@@ -40,8 +110,45 @@ SAPI b8 application_create (struct game* game_instance);
 /**
 * @brief The function called by the game loop to start the application. This is where the game logic is executed
 * @param game_instance * Pointer to the game
+* @return The exit code passed to application_request_quit, 0 if the window was closed.
+*/
+SAPI i32 application_run (struct game* game_instance);
+
+/**
+* @brief Stops the game loop after the current frame. Shutdown runs as usual, game_shutdown may still change the exit code by calling this again.
+* @param game_instance * Pointer to the game.
+* @param exit_code The value application_run returns.
+*/
+SAPI void application_request_quit (struct game* game_instance, i32 exit_code);
+
+/**
+* @brief Computes statistics over the most recent frame times (frame start to frame start, FRAME_STATS_HISTORY_SIZE frames).
+* @param game_instance * Pointer to the game.
+* @param out_stats Receives the statistics.
+*/
+SAPI void application_get_frame_stats (struct game* game_instance,
+									   frame_stats* out_stats);
+
+/**
+* @brief Reports how precisely the frame pacer hit its deadlines. Only meaningful with FRAME_PACING_CAPPED.
+* @param game_instance * Pointer to the game.
+* @param out_stats Receives the statistics.
+*/
+SAPI void application_get_pacing_stats (struct game* game_instance,
+										frame_pacing_stats* out_stats);
+
+/**
+* @brief Reports the longest chain of dependent frame tasks of the last frame, the one to shorten for a shorter frame.
+* @param game_instance * Pointer to the game.
+* @param out_path Receives the path; task names come from task_graph_get_name on application_get_frame_graph.
+*/
+SAPI void application_get_critical_path (struct game* game_instance,
+										 task_graph_path* out_path);
+
+/**
+* @return The frame's task graph, to look up task names. Don't add tasks to it outside game->register_frame_tasks.
 */
-SAPI void application_run (struct game* game_instance);
+SAPI const task_graph* application_get_frame_graph (struct game* game_instance);
 
 /**
 * @brief Shut down the application. This is called at the end of each game to free memory allocated for the application state.
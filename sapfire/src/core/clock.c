@@ -2,14 +2,16 @@
 #include "platform/platform.h"
 
 void clock_tick (clock *c) {
-	if (c->start_tick != 0) {
-		c->elapsed_ticks = platform_get_absolute_time () - c->start_tick;
+	if (c->start_time_ns != 0) {
+		c->elapsed_ns = platform_get_absolute_time_ns () - c->start_time_ns;
 	}
 }
 
 void clock_start (clock *c) {
-	c->start_tick	 = platform_get_absolute_time ();
-	c->elapsed_ticks = 0;
+	c->start_time_ns = platform_get_absolute_time_ns ();
+	c->elapsed_ns	 = 0;
 }
 
-void clock_stop (clock *c) { c->start_tick = 0; }
+void clock_stop (clock *c) { c->start_time_ns = 0; }
+
+f64 clock_elapsed_seconds (const clock *c) { return c->elapsed_ns * 1e-9; }
@@ -4,10 +4,16 @@
 #include "platform/platform.h"
 
 typedef struct clock {
-	u64 start_tick;
-	u64 elapsed_ticks;
+	// Nanosecond timestamp of clock_start, 0 while stopped.
+	u64 start_time_ns;
+	u64 elapsed_ns;
 } clock;
 
 void clock_tick (clock* c);
 void clock_start (clock* c);
-void clock_stop (clock* c);
\ No newline at end of file
+void clock_stop (clock* c);
+
+/**
+* @return The time between clock_start and the last clock_tick in seconds.
+*/
+f64 clock_elapsed_seconds (const clock* c);
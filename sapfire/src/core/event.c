@@ -1,6 +1,7 @@
 #include "event.h"
 #include "containers/vector.h"
 #include "core/logger.h"
+#include "core/metrics.h"
 #include "core/sfmemory.h"
 
 // Should be enough, if not expand
@@ -114,6 +115,7 @@ b8 event_fire (u16 code, void *sender, event_context context) {
 			"initialized.");
 		return FALSE;
 	}
+	SF_METRIC_COUNT ("event_dispatches", 1);
 	if (!pState->registered[code].events) { return FALSE; }
 	u64 registered_count = vector_len (pState->registered[code].events);
 	for (u64 i = 0; i < registered_count; ++i) {
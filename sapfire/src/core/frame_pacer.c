@@ -0,0 +1,61 @@
+#include "frame_pacer.h"
+#include "core/sfmemory.h"
+#include "platform/platform.h"
+
+#define FRAME_PACER_DEFAULT_RATE 60.0f
+// Bounds of the adaptive spin threshold.
+#define FRAME_PACER_MIN_SPIN_NS 50000ull
+#define FRAME_PACER_MAX_SPIN_NS 4000000ull
+
+void frame_pacer_initialize (frame_pacer *pacer, frame_pacing_mode mode,
+							 f32 target_frame_rate) {
+	sfmemset (pacer, 0, sizeof (frame_pacer));
+	if (target_frame_rate <= 0.0f) {
+		target_frame_rate = FRAME_PACER_DEFAULT_RATE;
+	}
+	pacer->mode				 = mode;
+	pacer->target_frame_ns	 = (u64)(1000000000.0 / target_frame_rate);
+	pacer->spin_threshold_ns = 1000000ull;
+}
+
+void frame_pacer_start (frame_pacer *pacer) {
+	pacer->next_deadline_ns =
+		platform_get_absolute_time_ns () + pacer->target_frame_ns;
+}
+
+void frame_pacer_wait (frame_pacer *pacer) {
+	if (pacer->mode != FRAME_PACING_CAPPED) { return; }
+	u64 deadline = pacer->next_deadline_ns;
+	u64 now		 = platform_get_absolute_time_ns ();
+	if (now >= deadline) {
+		pacer->missed_deadlines++;
+		pacer->next_deadline_ns = now + pacer->target_frame_ns;
+		return;
+	}
+
+	if (deadline - now > pacer->spin_threshold_ns) {
+		u64 wake_time = deadline - pacer->spin_threshold_ns;
+		platform_sleep_ns (wake_time - now);
+		now			  = platform_get_absolute_time_ns ();
+		u64 oversleep = now > wake_time ? now - wake_time : 0;
+		// Grow right away so the next frame doesn't miss too, shrink slowly.
+		u64 spin = pacer->spin_threshold_ns;
+		if (oversleep > spin) {
+			spin = oversleep;
+		} else {
+			spin -= (spin - oversleep) / 16;
+		}
+		pacer->spin_threshold_ns =
+			CLAMP (spin, FRAME_PACER_MIN_SPIN_NS, FRAME_PACER_MAX_SPIN_NS);
+	}
+	while (now < deadline) { now = platform_get_absolute_time_ns (); }
+
+	frame_history_push (&pacer->jitter, now - deadline);
+	pacer->next_deadline_ns = deadline + pacer->target_frame_ns;
+}
+
+void frame_pacer_get_stats (const frame_pacer *pacer,
+							frame_pacing_stats *out_stats) {
+	frame_history_compute (&pacer->jitter, &out_stats->jitter);
+	out_stats->missed_deadlines = pacer->missed_deadlines;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/frame_stats.h"
+#include "defines.h"
+
+typedef enum frame_pacing_mode {
+	// Frames start at a fixed rate, the pacer sleeps and spins up to the
+	// next deadline.
+	FRAME_PACING_CAPPED = 0,
+	// No waiting on the CPU and no vsync, for benchmarks.
+	FRAME_PACING_UNCAPPED = 1,
+	// The pacer stays out of the way and presentation waits for vblank.
+	FRAME_PACING_VSYNC = 2
+} frame_pacing_mode;
+
+typedef struct frame_pacing_stats {
+	// How late the pacer woke up relative to its deadline, per paced frame.
+	frame_stats jitter;
+	// Frames that were already past their deadline when the pacer was reached.
+	u64 missed_deadlines;
+} frame_pacing_stats;
+
+typedef struct frame_pacer {
+	frame_pacing_mode mode;
+	u64 target_frame_ns;
+	u64 next_deadline_ns;
+	// The pacer stops sleeping this long before the deadline and spins for
+	// the rest. Follows the worst recent oversleep of platform_sleep_ns.
+	u64 spin_threshold_ns;
+	u64 missed_deadlines;
+	frame_history jitter;
+} frame_pacer;
+
+/**
+* @brief Sets up a pacer. Call frame_pacer_start right before the first frame.
+* @param pacer The pacer to initialize.
+* @param mode The pacing mode.
+* @param target_frame_rate Frames per second in FRAME_PACING_CAPPED, 60 if 0.
+*/
+void frame_pacer_initialize (frame_pacer* pacer, frame_pacing_mode mode,
+							 f32 target_frame_rate);
+
+/**
+* @brief Places the first deadline one frame from now.
+*/
+void frame_pacer_start (frame_pacer* pacer);
+
+/**
+* @brief Blocks until the current frame's deadline and moves it one frame ahead. Deadlines advance by a fixed step so they do not drift; after a missed deadline the schedule restarts from now instead of catching up. No-op unless capped.
+*/
+void frame_pacer_wait (frame_pacer* pacer);
+
+/**
+* @brief Computes jitter statistics over the most recent paced frames.
+*/
+void frame_pacer_get_stats (const frame_pacer* pacer,
+							frame_pacing_stats* out_stats);
@@ -0,0 +1,46 @@
+#include "frame_stats.h"
+#include "core/sfmemory.h"
+#include <stdlib.h>
+
+void frame_history_push (frame_history *history, u64 frame_time_ns) {
+	history->samples_ns[history->head] = frame_time_ns;
+	history->head = (history->head + 1) % FRAME_STATS_HISTORY_SIZE;
+	if (history->count < FRAME_STATS_HISTORY_SIZE) { history->count++; }
+	history->total_frames++;
+}
+
+static i32 compare_u64 (const void *a, const void *b) {
+	u64 lhs = *(const u64 *)a;
+	u64 rhs = *(const u64 *)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+// Nearest-rank percentile of an ascending array, in milliseconds.
+static f64 percentile_ms (const u64 *sorted, u32 count, u32 percent) {
+	u32 rank = (count * percent + 99) / 100;
+	if (rank == 0) { rank = 1; }
+	return sorted[rank - 1] * 1e-6;
+}
+
+void frame_history_compute (const frame_history *history,
+							frame_stats *out_stats) {
+	sfmemset (out_stats, 0, sizeof (frame_stats));
+	out_stats->total_frames = history->total_frames;
+	u32 count				= history->count;
+	if (count == 0) { return; }
+
+	u64 sorted[FRAME_STATS_HISTORY_SIZE];
+	sfmemcpy (sorted, history->samples_ns, sizeof (u64) * count);
+	qsort (sorted, count, sizeof (u64), compare_u64);
+
+	u64 total = 0;
+	for (u32 i = 0; i < count; ++i) { total += sorted[i]; }
+
+	out_stats->sample_count = count;
+	out_stats->min_ms		= sorted[0] * 1e-6;
+	out_stats->max_ms		= sorted[count - 1] * 1e-6;
+	out_stats->avg_ms		= (f64)total / count * 1e-6;
+	out_stats->p50_ms		= percentile_ms (sorted, count, 50);
+	out_stats->p95_ms		= percentile_ms (sorted, count, 95);
+	out_stats->p99_ms		= percentile_ms (sorted, count, 99);
+}
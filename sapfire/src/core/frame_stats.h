@@ -0,0 +1,42 @@
+#pragma once
+
+#include "defines.h"
+
+// Number of most recent frames the statistics are computed over.
+#define FRAME_STATS_HISTORY_SIZE 256
+
+// Rolling window of frame durations.
+typedef struct frame_history {
+	u64 samples_ns[FRAME_STATS_HISTORY_SIZE];
+	u32 head;
+	u32 count;
+	u64 total_frames;
+} frame_history;
+
+typedef struct frame_stats {
+	// Number of frames the values below were computed from.
+	u32 sample_count;
+	// Frames recorded since startup.
+	u64 total_frames;
+	f64 min_ms;
+	f64 avg_ms;
+	f64 max_ms;
+	f64 p50_ms;
+	f64 p95_ms;
+	f64 p99_ms;
+} frame_stats;
+
+/**
+* @brief Records the duration of one frame, overwriting the oldest sample once the window is full.
+* @param history The history to record into.
+* @param frame_time_ns Duration of the frame in nanoseconds.
+*/
+SAPI void frame_history_push (frame_history* history, u64 frame_time_ns);
+
+/**
+* @brief Computes min/avg/max and percentiles over the recorded window. Sorts a copy of the window, so call it when needed rather than every frame.
+* @param history The history to compute from.
+* @param out_stats Receives the statistics, zeroed if no frame was recorded yet.
+*/
+SAPI void frame_history_compute (const frame_history* history,
+								 frame_stats* out_stats);
@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_INPUT
+
 #include "core/event.h"
 #include "core/logger.h"
 #include "core/sfmemory.h"
@@ -10,6 +12,7 @@ typedef struct keyboard_state {
 
 typedef struct mouse_state {
 	i32 x, y;
+	i32 wheel;
 	u8 buttons[MB_MAX_BUTTONS];
 } mouse_state;
 
@@ -42,6 +45,8 @@ void input_update (f64 deltaTime) {
 			  sizeof (keyboard_state));
 	sfmemcpy (&pState->mouse_last, &pState->mouse_current,
 			  sizeof (mouse_state));
+	// Wheel is a per-frame delta, not a held state.
+	pState->mouse_current.wheel = 0;
 }
 
 // keyboard
@@ -141,7 +146,19 @@ void input_process_mouse_move (i32 x, i32 y) {
 }
 
 void input_process_mouse_wheel (i32 z) {
+	pState->mouse_current.wheel += z;
 	event_context context;
 	context.data.u32[2] = z;
 	event_fire (EVENT_CODE_MOUSE_WHEEL, SF_NULL, context);
 }
+
+i32 input_get_mouse_wheel_delta () {
+	if (!pState->initialized) { return 0; }
+	return pState->mouse_current.wheel;
+}
+
+const b8 *input_get_key_states () { return pState->keyboard_current.keys; }
+
+const u8 *input_get_mouse_button_states () {
+	return pState->mouse_current.buttons;
+}
@@ -434,7 +434,13 @@ SAPI b8 input_was_mouse_button_down (mouse_button button);
 SAPI b8 input_was_mouse_button_down (mouse_button button);
 SAPI void input_get_mouse_position (i32 *x, i32 *y);
 SAPI void input_get_last_mouse_position (i32 *x, i32 *y);
+SAPI i32 input_get_mouse_wheel_delta ();
 
 void input_process_mouse_button (mouse_button button, b8 pressed);
 void input_process_mouse_move (i32 x, i32 y);
 void input_process_mouse_wheel (i32 z);
+
+// Raw state arrays for the action layer (see core/input_actions.h). Only valid
+// after input_initialize.
+const b8 *input_get_key_states ();
+const u8 *input_get_mouse_button_states ();
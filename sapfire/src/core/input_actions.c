@@ -0,0 +1,214 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_INPUT
+
+#include "input_actions.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include <string.h>
+
+typedef struct input_binding {
+	input_binding_source source;
+	u16 code;
+	input_action action;
+	f32 scale;
+} input_binding;
+
+// Flat per-source tables built by input_actions_compile. Stored as SoA so the
+// per-frame evaluation is a straight loop with no branching per binding.
+typedef struct input_binding_table {
+	u16 count;
+	u16 codes[INPUT_MAX_BINDINGS];
+	input_action actions[INPUT_MAX_BINDINGS];
+	f32 scales[INPUT_MAX_BINDINGS];
+} input_binding_table;
+
+typedef struct input_actions_state {
+	u16 action_count;
+	char names[INPUT_MAX_ACTIONS][INPUT_ACTION_NAME_MAX];
+	u8 types[INPUT_MAX_ACTIONS];
+
+	u16 binding_count;
+	input_binding bindings[INPUT_MAX_BINDINGS];
+	b8 dirty;
+
+	input_binding_table tables[INPUT_BINDING_SOURCE_MAX];
+
+	f32 values[INPUT_MAX_ACTIONS];
+	input_action_state states[INPUT_MAX_ACTIONS];
+} input_actions_state;
+
+static input_actions_state *pState;
+
+b8 input_actions_initialize (u64 *mem_size, void *memory) {
+	*mem_size = sizeof (input_actions_state);
+	if (memory == SF_NULL) { return FALSE; }
+	pState = memory;
+	sfmemset (pState, 0, sizeof (input_actions_state));
+	SF_INFO ("Input action subsystem initialized successfully.");
+	return TRUE;
+}
+
+void input_actions_shutdown (void *memory) { pState = SF_NULL; }
+
+input_action input_action_register (const char *name, input_action_type type) {
+	input_action existing = input_action_find (name);
+	if (existing != INPUT_ACTION_INVALID) { return existing; }
+	if (pState->action_count >= INPUT_MAX_ACTIONS) {
+		SF_ERROR ("Cannot register action '%s', limit of %d reached.", name,
+				  INPUT_MAX_ACTIONS);
+		return INPUT_ACTION_INVALID;
+	}
+	input_action action = pState->action_count++;
+	strncpy (pState->names[action], name, INPUT_ACTION_NAME_MAX - 1);
+	pState->names[action][INPUT_ACTION_NAME_MAX - 1] = 0;
+	pState->types[action]							 = (u8)type;
+	sfmemset (&pState->states[action], 0, sizeof (input_action_state));
+	return action;
+}
+
+input_action input_action_find (const char *name) {
+	for (u16 i = 0; i < pState->action_count; ++i) {
+		if (strncmp (pState->names[i], name, INPUT_ACTION_NAME_MAX - 1) == 0) {
+			return i;
+		}
+	}
+	return INPUT_ACTION_INVALID;
+}
+
+static b8 add_binding (input_action action, input_binding_source source,
+					   u16 code, f32 scale) {
+	if (action >= pState->action_count) {
+		SF_ERROR ("Attempted to bind an unregistered action %d.", action);
+		return FALSE;
+	}
+	if (pState->binding_count >= INPUT_MAX_BINDINGS) {
+		SF_ERROR ("Cannot bind action '%s', limit of %d bindings reached.",
+				  pState->names[action], INPUT_MAX_BINDINGS);
+		return FALSE;
+	}
+	input_binding *binding = &pState->bindings[pState->binding_count++];
+	binding->source		   = source;
+	binding->code		   = code;
+	binding->action		   = action;
+	binding->scale		   = scale;
+	pState->dirty		   = TRUE;
+	return TRUE;
+}
+
+b8 input_action_bind_key (input_action action, keys key, f32 scale) {
+	if (key <= KEY_UNKNOWN || key >= KEYS_MAX) {
+		SF_ERROR ("Attempted to bind invalid key %d.", key);
+		return FALSE;
+	}
+	return add_binding (action, INPUT_BINDING_SOURCE_KEY, (u16)key, scale);
+}
+
+b8 input_action_bind_mouse_button (input_action action, mouse_button button,
+								   f32 scale) {
+	if (button >= MB_MAX_BUTTONS) {
+		SF_ERROR ("Attempted to bind invalid mouse button %d.", button);
+		return FALSE;
+	}
+	return add_binding (action, INPUT_BINDING_SOURCE_MOUSE_BUTTON, (u16)button,
+						scale);
+}
+
+b8 input_action_bind_mouse_wheel (input_action action, f32 scale) {
+	return add_binding (action, INPUT_BINDING_SOURCE_MOUSE_WHEEL, 0, scale);
+}
+
+void input_action_unbind_all (input_action action) {
+	u16 kept = 0;
+	for (u16 i = 0; i < pState->binding_count; ++i) {
+		if (pState->bindings[i].action != action) {
+			pState->bindings[kept++] = pState->bindings[i];
+		}
+	}
+	pState->binding_count = kept;
+	pState->dirty		  = TRUE;
+}
+
+void input_actions_compile () {
+	for (u32 s = 0; s < INPUT_BINDING_SOURCE_MAX; ++s) {
+		pState->tables[s].count = 0;
+	}
+	for (u16 i = 0; i < pState->binding_count; ++i) {
+		input_binding *binding		= &pState->bindings[i];
+		input_binding_table *table	= &pState->tables[binding->source];
+		u16 slot					= table->count++;
+		table->codes[slot]			= binding->code;
+		table->actions[slot]		= binding->action;
+		table->scales[slot]			= binding->scale;
+	}
+	pState->dirty = FALSE;
+}
+
+void input_actions_update () {
+	if (!pState) { return; }
+	if (pState->dirty) { input_actions_compile (); }
+
+	u16 action_count = pState->action_count;
+	f32 *values		 = pState->values;
+	sfmemset (values, 0, sizeof (f32) * action_count);
+
+	const b8 *key_states = input_get_key_states ();
+	const input_binding_table *keys =
+		&pState->tables[INPUT_BINDING_SOURCE_KEY];
+	for (u16 i = 0; i < keys->count; ++i) {
+		values[keys->actions[i]] += (f32)key_states[keys->codes[i]] *
+									keys->scales[i];
+	}
+
+	const u8 *button_states = input_get_mouse_button_states ();
+	const input_binding_table *buttons =
+		&pState->tables[INPUT_BINDING_SOURCE_MOUSE_BUTTON];
+	for (u16 i = 0; i < buttons->count; ++i) {
+		values[buttons->actions[i]] += (f32)button_states[buttons->codes[i]] *
+									   buttons->scales[i];
+	}
+
+	f32 wheel = (f32)input_get_mouse_wheel_delta ();
+	const input_binding_table *wheels =
+		&pState->tables[INPUT_BINDING_SOURCE_MOUSE_WHEEL];
+	for (u16 i = 0; i < wheels->count; ++i) {
+		values[wheels->actions[i]] += wheel * wheels->scales[i];
+	}
+
+	for (u16 i = 0; i < action_count; ++i) {
+		f32 min	 = pState->types[i] == INPUT_ACTION_TYPE_AXIS ? -1.0f : 0.0f;
+		f32 v	 = CLAMP (values[i], min, 1.0f);
+		b8 down	 = v > INPUT_ACTION_AXIS_DEADZONE ||
+				  v < -INPUT_ACTION_AXIS_DEADZONE;
+		input_action_state *state = &pState->states[i];
+		state->pressed			  = down && !state->down;
+		state->released			  = !down && state->down;
+		state->down				  = down;
+		state->value			  = v;
+	}
+}
+
+const input_action_state *input_actions_get_states (u16 *out_count) {
+	if (out_count) { *out_count = pState->action_count; }
+	return pState->states;
+}
+
+// Unknown actions, INPUT_ACTION_INVALID included, read as idle.
+f32 input_action_value (input_action action) {
+	if (action >= pState->action_count) { return 0.0f; }
+	return pState->states[action].value;
+}
+
+b8 input_action_down (input_action action) {
+	if (action >= pState->action_count) { return FALSE; }
+	return pState->states[action].down;
+}
+
+b8 input_action_pressed (input_action action) {
+	if (action >= pState->action_count) { return FALSE; }
+	return pState->states[action].pressed;
+}
+
+b8 input_action_released (input_action action) {
+	if (action >= pState->action_count) { return FALSE; }
+	return pState->states[action].released;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "core/input.h"
+#include "defines.h"
+
+#define INPUT_MAX_ACTIONS		   256
+#define INPUT_MAX_BINDINGS		   1024
+#define INPUT_ACTION_NAME_MAX	   64
+#define INPUT_ACTION_INVALID	   0xFFFF
+#define INPUT_ACTION_AXIS_DEADZONE 0.001f
+
+typedef u16 input_action;
+
+typedef enum input_action_type {
+	// Digital action, value clamped to [0, 1].
+	INPUT_ACTION_TYPE_BUTTON,
+	// Analog action, value clamped to [-1, 1].
+	INPUT_ACTION_TYPE_AXIS,
+} input_action_type;
+
+typedef enum input_binding_source {
+	INPUT_BINDING_SOURCE_KEY,
+	INPUT_BINDING_SOURCE_MOUSE_BUTTON,
+	INPUT_BINDING_SOURCE_MOUSE_WHEEL,
+	INPUT_BINDING_SOURCE_MAX
+} input_binding_source;
+
+// Evaluated once per frame by input_actions_update. Gameplay code reads these
+// instead of polling individual keys.
+typedef struct input_action_state {
+	f32 value;
+	b8 down;
+	b8 pressed;
+	b8 released;
+} input_action_state;
+
+/**
+ * @brief Initializes the action mapping layer. If memory is NULL, will populate mem_size.
+ *
+ * @param mem_size Holds the required memory size of the internal state.
+ * @param memory NULL if requesting memory size, otherwise allocated block of memory.
+ * @return TRUE on success; otherwise FALSE.
+ */
+b8 input_actions_initialize (u64 *mem_size, void *memory);
+
+/**
+ * @brief Shuts down the action mapping layer. Does not free passed memory, it is the owner's responsibility.
+ * @param memory Pointer to the memory
+ */
+void input_actions_shutdown (void *memory);
+
+/**
+ * @brief Evaluates all compiled bindings into the dense action state array. Called once per frame by the application after platform events were pumped.
+ */
+void input_actions_update ();
+
+/**
+ * @brief Registers a named action. Registering an existing name returns the existing action.
+ * @param name Name of the action, truncated to INPUT_ACTION_NAME_MAX - 1 characters.
+ * @param type Whether the action is a button or an axis.
+ * @return The action handle, or INPUT_ACTION_INVALID if the action table is full.
+ */
+SAPI input_action input_action_register (const char *name,
+										 input_action_type type);
+
+/**
+ * @brief Finds a previously registered action by name. This is a linear search, cache the result.
+ * @param name Name of the action.
+ * @return The action handle, or INPUT_ACTION_INVALID if not found.
+ */
+SAPI input_action input_action_find (const char *name);
+
+/**
+ * @brief Binds a key to an action. Bindings take effect on the next input_actions_compile ().
+ * @param action The action to bind to.
+ * @param key The key to bind.
+ * @param scale Value contributed when the key is held, e.g. -1.0f for the negative side of an axis.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 input_action_bind_key (input_action action, keys key, f32 scale);
+
+/**
+ * @brief Binds a mouse button to an action. Bindings take effect on the next input_actions_compile ().
+ * @param action The action to bind to.
+ * @param button The mouse button to bind.
+ * @param scale Value contributed when the button is held.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 input_action_bind_mouse_button (input_action action,
+										mouse_button button, f32 scale);
+
+/**
+ * @brief Binds the mouse wheel to an action. The per-frame wheel delta is multiplied by scale.
+ * @param action The action to bind to.
+ * @param scale Multiplier applied to the wheel delta.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 input_action_bind_mouse_wheel (input_action action, f32 scale);
+
+/**
+ * @brief Removes all bindings of an action. Takes effect on the next input_actions_compile ().
+ * @param action The action to unbind.
+ */
+SAPI void input_action_unbind_all (input_action action);
+
+/**
+ * @brief Compiles registered bindings into flat per-source lookup tables used by input_actions_update. Call after changing bindings.
+ */
+SAPI void input_actions_compile ();
+
+/**
+ * @brief Returns the dense action state array, indexed by input_action. Valid until the next input_actions_update.
+ * @param out_count Optional, receives the number of registered actions.
+ */
+SAPI const input_action_state *input_actions_get_states (u16 *out_count);
+
+SAPI f32 input_action_value (input_action action);
+SAPI b8 input_action_down (input_action action);
+SAPI b8 input_action_pressed (input_action action);
+SAPI b8 input_action_released (input_action action);
@@ -0,0 +1,534 @@
+#include "job_system.h"
+#include "core/logger.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "core/thread_pinning.h"
+#include "platform/fiber.h"
+#include "platform/platform.h"
+#include "platform/thread.h"
+
+#define JOB_QUEUE_MASK	  (JOB_QUEUE_CAPACITY - 1)
+#define CACHE_LINE_SIZE	  64
+// Failed attempts to find a job before an idle worker goes to sleep.
+#define IDLE_SPIN_COUNT	  256
+// Failed attempts before a waiting thread yields its time slice.
+#define WAIT_SPIN_COUNT	  64
+#define WORKER_NAME_SIZE  16
+// How long an idle worker sleeps before polling parked fibers again.
+#define PARKED_POLL_MS	  1
+// How long shutdown waits on parked fibers without any job making progress.
+#define DRAIN_TIMEOUT_MS  2000
+
+STATIC_ASSERT ((JOB_QUEUE_CAPACITY & JOB_QUEUE_MASK) == 0,
+			   "JOB_QUEUE_CAPACITY must be a power of 2.");
+
+typedef struct job {
+	PFN_job_entry entry;
+	void *params;
+	const char *name;
+	job_counter *counter;
+	b8 waitable;
+	// Set while the job is queued, the owner reuses the slot once it's clear.
+	sf_atomic_u32 in_use;
+} job;
+
+typedef enum job_fiber_state {
+	JOB_FIBER_STATE_RUNNING,
+	JOB_FIBER_STATE_PARKED,
+	JOB_FIBER_STATE_DONE
+} job_fiber_state;
+
+typedef struct job_fiber {
+	sf_fiber_context context;
+	// The scheduler that switched to the fiber, it returns there when the
+	// job parks or ends. Set anew on every resume.
+	sf_fiber_context *return_context;
+	PFN_job_entry entry;
+	void *params;
+	const char *name;
+	job_counter *counter;
+	job_fiber_state state;
+	// The condition a parked fiber waits for.
+	PFN_job_ready ready;
+	void *ready_data;
+	// In the free or the parked list.
+	struct job_fiber *next;
+} job_fiber;
+
+typedef struct job_worker {
+	// Stealers take from the top, the owner pushes and pops at the bottom.
+	// Both live on their own cache line so stealing doesn't slow the owner.
+	sf_atomic_u64 top;
+	u8 top_padding[CACHE_LINE_SIZE - sizeof (sf_atomic_u64)];
+	sf_atomic_u64 bottom;
+	u8 bottom_padding[CACHE_LINE_SIZE - sizeof (sf_atomic_u64)];
+	sf_atomic_ptr queue[JOB_QUEUE_CAPACITY];
+	// Jobs are stored here and the queue points at them. Only the owner
+	// allocates, in ring order.
+	job pool[JOB_QUEUE_CAPACITY];
+	u32 pool_cursor;
+	sf_thread thread;
+} job_worker;
+
+typedef struct job_system_state {
+	u32 worker_count;
+	// Deques, the workers' followed by JOB_EXTERNAL_SLOTS for registered
+	// threads. Stealing looks at all of them.
+	u32 slot_count;
+	sf_atomic_u32 registered_count;
+	sf_atomic_u32 running;
+	// Workers asleep on wake, job_run signals it only when there are any.
+	sf_atomic_u32 sleeping;
+	sf_semaphore wake;
+	job_worker *workers;
+
+	// Empty if the platform has no fibers, waitable jobs then run as usual.
+	job_fiber *fibers;
+	u32 fiber_count;
+	void *fiber_stacks[JOB_FIBER_COUNT];
+	// Guards both lists.
+	sf_mutex fiber_lock;
+	job_fiber *free_fibers;
+	job_fiber *parked_fibers;
+	// Lets workers skip the lock when nothing is parked.
+	sf_atomic_u32 parked_count;
+} job_system_state;
+
+static job_system_state *pState;
+static _Thread_local u32 current_worker = INVALID_ID;
+static _Thread_local job_fiber *current_fiber;
+static _Thread_local u32 steal_seed;
+
+static u32 resolve_thread_count (u32 thread_count) {
+	if (thread_count == 0) { thread_count = platform_physical_core_count (); }
+	if (thread_count > JOB_MAX_WORKERS) { thread_count = JOB_MAX_WORKERS; }
+	return thread_count ? thread_count : 1;
+}
+
+// Chase-Lev deque, "Correct and Efficient Work-Stealing for Weak Memory
+// Models" (Le et al., 2013). Indices only grow, signed compares handle the
+// owner briefly moving bottom below top in pop.
+static b8 queue_push (job_worker *worker, job *j) {
+	u64 bottom = sf_atomic_load_u64_relaxed (&worker->bottom);
+	u64 top	   = sf_atomic_load_u64 (&worker->top);
+	if (bottom - top >= JOB_QUEUE_CAPACITY) { return FALSE; }
+	sf_atomic_store_ptr (&worker->queue[bottom & JOB_QUEUE_MASK], j);
+	sf_atomic_store_u64 (&worker->bottom, bottom + 1);
+	return TRUE;
+}
+
+static job *queue_pop (job_worker *worker) {
+	u64 bottom = sf_atomic_load_u64_relaxed (&worker->bottom) - 1;
+	sf_atomic_store_u64 (&worker->bottom, bottom);
+	sf_atomic_thread_fence ();
+	u64 top = sf_atomic_load_u64_relaxed (&worker->top);
+	if ((i64)top > (i64)bottom) {
+		sf_atomic_store_u64 (&worker->bottom, bottom + 1);
+		return SF_NULL;
+	}
+	job *j = sf_atomic_load_ptr (&worker->queue[bottom & JOB_QUEUE_MASK]);
+	if (top == bottom) {
+		// The last job, a stealer may be taking it right now.
+		if (!sf_atomic_compare_exchange_u64 (&worker->top, &top, top + 1)) {
+			j = SF_NULL;
+		}
+		sf_atomic_store_u64 (&worker->bottom, bottom + 1);
+	}
+	return j;
+}
+
+static job *queue_steal (job_worker *worker) {
+	u64 top = sf_atomic_load_u64 (&worker->top);
+	sf_atomic_thread_fence ();
+	u64 bottom = sf_atomic_load_u64 (&worker->bottom);
+	if ((i64)top >= (i64)bottom) { return SF_NULL; }
+	// The owner can't overwrite this slot before top moves past it.
+	job *j = sf_atomic_load_ptr (&worker->queue[top & JOB_QUEUE_MASK]);
+	if (!sf_atomic_compare_exchange_u64 (&worker->top, &top, top + 1)) {
+		return SF_NULL;
+	}
+	return j;
+}
+
+static b8 queue_is_empty (job_worker *worker) {
+	u64 top	   = sf_atomic_load_u64_relaxed (&worker->top);
+	u64 bottom = sf_atomic_load_u64_relaxed (&worker->bottom);
+	return (i64)top >= (i64)bottom;
+}
+
+// Code on a fiber may resume on another thread, so it reaches thread-locals
+// only through calls the compiler can't fold into the caller; otherwise it
+// could keep using the address computed on the previous thread.
+#define JOB_NOINLINE __attribute__ ((noinline))
+
+static JOB_NOINLINE void finish_job (job_counter *counter) {
+	SF_METRIC_COUNT ("jobs_run", 1);
+	if (counter) { sf_atomic_fetch_sub_u32 (&counter->value, 1); }
+}
+
+static void execute_job (job *j) {
+	PFN_job_entry entry	 = j->entry;
+	void *params		 = j->params;
+	job_counter *counter = j->counter;
+	const char *name	 = j->name ? j->name : "job";
+	(void)name; // Only read by the profiler.
+	// Everything is copied out first, the slot can be reused from here on.
+	sf_atomic_store_u32 (&j->in_use, 0);
+	SF_PROFILE_BEGIN (name);
+	entry (params);
+	SF_PROFILE_END ();
+	finish_job (counter);
+}
+
+static void run_inline (const job_decl *decl, job_counter *counter) {
+	SF_PROFILE_BEGIN (decl->name ? decl->name : "job");
+	decl->entry (decl->params);
+	SF_PROFILE_END ();
+	finish_job (counter);
+}
+
+static JOB_NOINLINE job_fiber *get_current_fiber () { return current_fiber; }
+
+static void fiber_main (void *params) {
+	job_fiber *fiber = params;
+	for (;;) {
+		SF_PROFILE_BEGIN (fiber->name);
+		fiber->entry (fiber->params);
+		SF_PROFILE_END ();
+		finish_job (fiber->counter);
+		fiber->state = JOB_FIBER_STATE_DONE;
+		// Switched back to with the next job already filled in.
+		platform_fiber_switch (&fiber->context, fiber->return_context);
+	}
+}
+
+// Runs the fiber until its job parks or ends. Always returns on the calling
+// thread, only then is it safe to hand the fiber to other workers.
+static void switch_to_fiber (job_fiber *fiber) {
+	sf_fiber_context scheduler;
+	job_fiber *previous	  = current_fiber;
+	current_fiber		  = fiber;
+	fiber->state		  = JOB_FIBER_STATE_RUNNING;
+	fiber->return_context = &scheduler;
+	platform_fiber_switch (&scheduler, &fiber->context);
+	current_fiber = previous;
+
+	platform_mutex_lock (&pState->fiber_lock);
+	if (fiber->state == JOB_FIBER_STATE_DONE) {
+		fiber->next			= pState->free_fibers;
+		pState->free_fibers = fiber;
+	} else {
+		fiber->next			  = pState->parked_fibers;
+		pState->parked_fibers = fiber;
+		sf_atomic_fetch_add_u32 (&pState->parked_count, 1);
+	}
+	platform_mutex_unlock (&pState->fiber_lock);
+}
+
+// Takes a free fiber for the job, FALSE if there is none.
+static b8 start_fiber (job *j) {
+	platform_mutex_lock (&pState->fiber_lock);
+	job_fiber *fiber = pState->free_fibers;
+	if (fiber) { pState->free_fibers = fiber->next; }
+	platform_mutex_unlock (&pState->fiber_lock);
+	if (!fiber) { return FALSE; }
+	fiber->entry   = j->entry;
+	fiber->params  = j->params;
+	fiber->name	   = j->name ? j->name : "job";
+	fiber->counter = j->counter;
+	sf_atomic_store_u32 (&j->in_use, 0);
+	switch_to_fiber (fiber);
+	return TRUE;
+}
+
+static b8 resume_parked_fiber () {
+	if (!sf_atomic_load_u32_relaxed (&pState->parked_count)) { return FALSE; }
+	job_fiber *fiber = SF_NULL;
+	platform_mutex_lock (&pState->fiber_lock);
+	job_fiber **link = &pState->parked_fibers;
+	while (*link && !(*link)->ready ((*link)->ready_data)) {
+		link = &(*link)->next;
+	}
+	if (*link) {
+		fiber = *link;
+		*link = fiber->next;
+		sf_atomic_fetch_sub_u32 (&pState->parked_count, 1);
+	}
+	platform_mutex_unlock (&pState->fiber_lock);
+	if (!fiber) { return FALSE; }
+	SF_METRIC_COUNT ("fibers_resumed", 1);
+	switch_to_fiber (fiber);
+	return TRUE;
+}
+
+static u32 next_victim () {
+	// xorshift32, any spread will do.
+	u32 x = steal_seed ? steal_seed : (u32)platform_thread_current_id () | 1;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	steal_seed = x;
+	return x % pState->slot_count;
+}
+
+// Resumes a parked fiber that can continue, otherwise pops from the calling
+// worker's own deque, then steals from the others starting at a random one.
+// Threads outside the job system only steal.
+static b8 run_one_job () {
+	if (resume_parked_fiber ()) { return TRUE; }
+	job *j = SF_NULL;
+	if (current_worker != INVALID_ID) {
+		j = queue_pop (&pState->workers[current_worker]);
+	}
+	if (!j) {
+		u32 start = next_victim ();
+		for (u32 i = 0; i < pState->slot_count && !j; ++i) {
+			u32 victim = (start + i) % pState->slot_count;
+			if (victim == current_worker) { continue; }
+			j = queue_steal (&pState->workers[victim]);
+		}
+		if (j) { SF_METRIC_COUNT ("jobs_stolen", 1); }
+	}
+	if (!j) { return FALSE; }
+	if (!j->waitable || !start_fiber (j)) { execute_job (j); }
+	return TRUE;
+}
+
+static b8 any_queued () {
+	for (u32 i = 0; i < pState->slot_count; ++i) {
+		if (!queue_is_empty (&pState->workers[i])) { return TRUE; }
+	}
+	return FALSE;
+}
+
+static void worker_sleep () {
+	sf_atomic_fetch_add_u32 (&pState->sleeping, 1);
+	// Pairs with the fence in wake_workers: either job_run sees this worker
+	// asleep and signals, or the check below sees its jobs.
+	sf_atomic_thread_fence ();
+	if (!any_queued () && sf_atomic_load_u32 (&pState->running)) {
+		// Nothing signals when a parked fiber's condition comes true.
+		if (sf_atomic_load_u32 (&pState->parked_count)) {
+			platform_semaphore_wait_timeout (&pState->wake, PARKED_POLL_MS);
+		} else {
+			platform_semaphore_wait (&pState->wake);
+		}
+	}
+	sf_atomic_fetch_sub_u32 (&pState->sleeping, 1);
+}
+
+static void wake_workers (u32 job_count) {
+	sf_atomic_thread_fence ();
+	u32 sleeping = sf_atomic_load_u32 (&pState->sleeping);
+	for (u32 i = 0; i < sleeping && i < job_count; ++i) {
+		platform_semaphore_signal (&pState->wake);
+	}
+}
+
+static u32 worker_main (void *params) {
+	current_worker = (u32)(u64)params;
+	thread_pinning_apply (THREAD_ROLE_WORKER, current_worker);
+	u32 idle = 0;
+	while (sf_atomic_load_u32 (&pState->running)) {
+		if (run_one_job ()) {
+			idle = 0;
+		} else if (++idle < IDLE_SPIN_COUNT) {
+			sf_cpu_relax ();
+		} else {
+			worker_sleep ();
+			idle = 0;
+		}
+	}
+	return 0;
+}
+
+b8 job_system_initialize (u64 *mem_size, void *memory, u32 thread_count) {
+	thread_count   = resolve_thread_count (thread_count);
+	u32 slot_count = thread_count + JOB_EXTERNAL_SLOTS;
+	*mem_size = sizeof (job_system_state) + sizeof (job_worker) * slot_count +
+				sizeof (job_fiber) * JOB_FIBER_COUNT;
+	if (memory == SF_NULL) { return FALSE; }
+	job_system_state *state = memory;
+	sfmemset (state, 0, *mem_size);
+	state->workers		= (job_worker *)(state + 1);
+	state->worker_count = thread_count;
+	state->slot_count	= slot_count;
+	sf_atomic_init_u32 (&state->registered_count, 0);
+	sf_atomic_init_u32 (&state->running, 1);
+	sf_atomic_init_u32 (&state->sleeping, 0);
+	sf_atomic_init_u32 (&state->parked_count, 0);
+	if (!platform_semaphore_create (0, &state->wake) ||
+		!platform_mutex_create (&state->fiber_lock)) {
+		SF_ERROR ("Failed to create the job system synchronization objects.");
+		return FALSE;
+	}
+	state->fibers = (job_fiber *)(state->workers + slot_count);
+	if (platform_fiber_supported () &&
+		platform_fiber_stacks_allocate (JOB_FIBER_COUNT, JOB_FIBER_STACK_SIZE,
+										state->fiber_stacks)) {
+		state->fiber_count = JOB_FIBER_COUNT;
+		for (u32 i = 0; i < JOB_FIBER_COUNT; ++i) {
+			job_fiber *fiber = &state->fibers[i];
+			platform_fiber_context_init (state->fiber_stacks[i],
+										 JOB_FIBER_STACK_SIZE, fiber_main,
+										 fiber, &fiber->context);
+			fiber->next		   = state->free_fibers;
+			state->free_fibers = fiber;
+		}
+	} else {
+		SF_WARNING ("No fibers, waitable jobs will block their worker.");
+	}
+	pState		   = state;
+	current_worker = 0;
+	for (u32 i = 1; i < thread_count; ++i) {
+		char name[WORKER_NAME_SIZE];
+		sfstrfmt (name, "sf_worker_%u", i);
+		if (!platform_thread_create_named (worker_main, (void *)(u64)i, name,
+										   &state->workers[i].thread)) {
+			// The slot stays without a thread, its deque is just never used.
+			SF_WARNING ("Failed to start job worker %u.", i);
+		}
+	}
+	SF_INFO ("Job system initialized with %u workers and %u fibers.",
+			 thread_count, state->fiber_count);
+	return TRUE;
+}
+
+// Runs jobs until the queues and parked fibers are empty. A fiber waiting on
+// a condition that never comes true is left parked once the timeout passes,
+// its stack is freed with the rest.
+static void drain_jobs () {
+	u64 timeout_ns = DRAIN_TIMEOUT_MS * 1000000ull;
+	u64 last_run   = platform_get_absolute_time_ns ();
+	for (;;) {
+		if (run_one_job ()) {
+			last_run = platform_get_absolute_time_ns ();
+			continue;
+		}
+		if (!sf_atomic_load_u32 (&pState->parked_count)) { return; }
+		if (platform_get_absolute_time_ns () - last_run < timeout_ns) {
+			sf_cpu_relax ();
+			continue;
+		}
+		platform_mutex_lock (&pState->fiber_lock);
+		job_fiber *fiber = pState->parked_fibers;
+		while (fiber) {
+			SF_WARNING ("Abandoning parked job '%s' at shutdown.", fiber->name);
+			fiber = fiber->next;
+		}
+		pState->parked_fibers = SF_NULL;
+		sf_atomic_store_u32 (&pState->parked_count, 0);
+		platform_mutex_unlock (&pState->fiber_lock);
+		return;
+	}
+}
+
+void job_system_shutdown (void *memory) {
+	if (!pState) { return; }
+	drain_jobs ();
+	sf_atomic_store_u32 (&pState->running, 0);
+	for (u32 i = 1; i < pState->worker_count; ++i) {
+		platform_semaphore_signal (&pState->wake);
+	}
+	for (u32 i = 1; i < pState->worker_count; ++i) {
+		platform_thread_join (&pState->workers[i].thread);
+	}
+	// Jobs queued by jobs that ran while the workers were stopping.
+	drain_jobs ();
+	platform_fiber_stacks_free (pState->fiber_stacks, pState->fiber_count,
+								JOB_FIBER_STACK_SIZE);
+	platform_mutex_destroy (&pState->fiber_lock);
+	platform_semaphore_destroy (&pState->wake);
+	pState		   = SF_NULL;
+	current_worker = INVALID_ID;
+}
+
+b8 job_register_thread () {
+	if (!pState) { return FALSE; }
+	if (current_worker != INVALID_ID) { return TRUE; }
+	u32 index = sf_atomic_fetch_add_u32 (&pState->registered_count, 1);
+	if (index >= JOB_EXTERNAL_SLOTS) {
+		sf_atomic_fetch_sub_u32 (&pState->registered_count, 1);
+		SF_WARNING ("No job slot left for thread %llu, its jobs run inline.",
+					platform_thread_current_id ());
+		return FALSE;
+	}
+	current_worker = pState->worker_count + index;
+	return TRUE;
+}
+
+void job_run (const job_decl *jobs, u32 count, job_counter *counter) {
+	if (counter) { sf_atomic_fetch_add_u32 (&counter->value, count); }
+	if (!pState || current_worker == INVALID_ID) {
+		for (u32 i = 0; i < count; ++i) { run_inline (&jobs[i], counter); }
+		return;
+	}
+	job_worker *worker = &pState->workers[current_worker];
+	u32 queued		   = 0;
+	for (u32 i = 0; i < count; ++i) {
+		job *slot = &worker->pool[worker->pool_cursor & JOB_QUEUE_MASK];
+		if (!sf_atomic_load_u32 (&slot->in_use)) {
+			++worker->pool_cursor;
+			slot->entry	   = jobs[i].entry;
+			slot->params   = jobs[i].params;
+			slot->name	   = jobs[i].name;
+			slot->counter  = counter;
+			slot->waitable = jobs[i].waitable;
+			sf_atomic_store_u32 (&slot->in_use, 1);
+			if (queue_push (worker, slot)) {
+				++queued;
+				continue;
+			}
+			sf_atomic_store_u32 (&slot->in_use, 0);
+		}
+		// Every slot is taken, running it here also drains the backlog.
+		run_inline (&jobs[i], counter);
+	}
+	if (queued) { wake_workers (queued); }
+}
+
+typedef struct counter_wait {
+	job_counter *counter;
+	u32 value;
+} counter_wait;
+
+static b8 counter_reached (void *data) {
+	counter_wait *wait = data;
+	return sf_atomic_load_u32 (&wait->counter->value) <= wait->value;
+}
+
+void job_wait_for_counter (job_counter *counter, u32 value) {
+	counter_wait wait = {counter, value};
+	job_yield_until (counter_reached, &wait);
+}
+
+void job_yield_until (PFN_job_ready ready, void *data) {
+	if (ready (data)) { return; }
+	job_fiber *fiber = get_current_fiber ();
+	if (fiber) {
+		fiber->ready	  = ready;
+		fiber->ready_data = data;
+		fiber->state	  = JOB_FIBER_STATE_PARKED;
+		SF_PROFILE_END ();
+		platform_fiber_switch (&fiber->context, fiber->return_context);
+		// Resumed by whichever worker saw ready return TRUE.
+		SF_PROFILE_BEGIN (fiber->name);
+		return;
+	}
+	u32 spins = 0;
+	while (!ready (data)) {
+		if (pState && run_one_job ()) {
+			spins = 0;
+		} else if (++spins < WAIT_SPIN_COUNT) {
+			sf_cpu_relax ();
+		} else {
+			platform_thread_yield ();
+		}
+	}
+}
+
+u32 job_worker_count () { return pState ? pState->worker_count : 1; }
+
+u32 job_current_worker () { return current_worker; }
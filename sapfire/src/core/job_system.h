@@ -0,0 +1,99 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/atomic.h"
+
+// Work-stealing job system. Every worker thread, and the main thread as
+// worker 0, owns a Chase-Lev deque: the owner pushes and pops at the bottom,
+// idle workers steal from the top. Jobs are kicked in batches that share a
+// counter, waiting on the counter runs other jobs instead of blocking.
+//
+// Waitable jobs run on a fiber of their own. When one waits, on a counter
+// or anything job_yield_until can poll, its fiber is parked and the worker
+// moves on to other jobs; a worker that finds the condition met later resumes
+// it, possibly on another thread. Zones must not be open across a wait and
+// thread-local state may change across it.
+
+// Worker threads at most, including the main thread.
+#define JOB_MAX_WORKERS 64
+// Jobs a worker's deque holds. A full deque runs further jobs inline.
+#define JOB_QUEUE_CAPACITY 4096
+// Deques for threads the job system didn't start, see job_register_thread.
+#define JOB_EXTERNAL_SLOTS 4
+// Fibers for waitable jobs, shared by all workers. Waitable jobs that find
+// none free run on the worker's stack and wait by helping.
+#define JOB_FIBER_COUNT		 128
+#define JOB_FIBER_STACK_SIZE (64 * 1024)
+
+typedef void (*PFN_job_entry) (void* params);
+
+typedef struct job_decl {
+	PFN_job_entry entry;
+	// Passed as-is to entry, must stay valid until the job ran.
+	void* params;
+	// A string literal for the profiler, NULL for "job".
+	const char* name;
+	// Run on a fiber so that waiting suspends the job instead of the worker.
+	b8 waitable;
+} job_decl;
+
+// Jobs of a batch still to finish. Zero it before the first job_run, it can
+// be reused once it is back to zero.
+typedef struct job_counter {
+	sf_atomic_u32 value;
+} job_counter;
+
+/**
+* @brief Initializes the job system and starts its worker threads. If memory is NULL, will populate mem_size.
+* @param mem_size Holds the required memory size of the internal state.
+* @param memory NULL if requesting memory size, otherwise allocated block of memory.
+* @param thread_count Workers including the calling thread, 0 for one per physical core. Must be the same in both calls.
+* @return TRUE on success; otherwise FALSE.
+*/
+b8 job_system_initialize (u64* mem_size, void* memory, u32 thread_count);
+
+/**
+* @brief Runs the jobs still queued, then stops and joins the worker threads. Parked jobs still blocked after two seconds without progress are logged and abandoned. Must be called on the thread that initialized it.
+* @param memory Pointer to the memory
+*/
+void job_system_shutdown (void* memory);
+
+/**
+* @brief Gives the calling thread, one the job system didn't start such as the render thread, a deque of its own so that job_run queues its jobs for the workers instead of running them inline. The thread keeps it until job_system_shutdown and mustn't use the job system after that.
+* @return TRUE if the thread can queue jobs; FALSE if all JOB_EXTERNAL_SLOTS are taken or the job system isn't running.
+*/
+SAPI b8 job_register_thread ();
+
+/**
+* @brief Queues count jobs, adding count to counter first. Callable from the main thread, from jobs and from registered threads; other threads run the jobs inline.
+* @param jobs The jobs, copied before this returns.
+* @param count Number of jobs.
+* @param counter Decremented as each job finishes, may be NULL.
+*/
+SAPI void job_run (const job_decl* jobs, u32 count, job_counter* counter);
+
+/**
+* @brief Waits until counter drops to value or below. Inside a waitable job the job is suspended; elsewhere the calling thread runs queued jobs in the meantime and never sleeps.
+* @param counter The counter to wait on.
+* @param value Usually 0, for the whole batch.
+*/
+SAPI void job_wait_for_counter (job_counter* counter, u32 value);
+
+typedef b8 (*PFN_job_ready) (void* data);
+
+/**
+* @brief Suspends the calling waitable job until ready (data) returns TRUE, e.g. an I/O request completed or a GPU fence signalled. Workers poll ready while looking for work, keep it cheap. Outside a fiber this runs other jobs until ready instead.
+* @param ready Polled from any worker thread.
+* @param data Passed as-is to ready, must stay valid until this returns.
+*/
+SAPI void job_yield_until (PFN_job_ready ready, void* data);
+
+/**
+* @return Workers including the main thread, 1 if the job system isn't running.
+*/
+SAPI u32 job_worker_count ();
+
+/**
+* @return The index of the calling worker below job_worker_count, 0 on the main thread, job_worker_count or above on registered threads, INVALID_ID on other threads.
+*/
+SAPI u32 job_current_worker ();
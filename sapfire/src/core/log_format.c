@@ -0,0 +1,249 @@
+#include "log_format.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_FORMAT_SPEC_MAX	  32
+#define LOG_FORMAT_STRING_MAX 512
+
+typedef struct format_spec {
+	const char *start;
+	u32 length;
+	u32 star_count;
+	// log_arg_type of the converted value, -1 for "%%".
+	i32 type;
+	b8 valid;
+} format_spec;
+
+// Parses the conversion starting at p (which points at '%') into spec and
+// returns the first character after it.
+static const char *parse_spec (const char *p, format_spec *spec) {
+	spec->start		 = p;
+	spec->star_count = 0;
+	spec->type		 = -1;
+	spec->valid		 = TRUE;
+	++p;
+	if (*p == '%') {
+		spec->length = 2;
+		return p + 1;
+	}
+	while (*p && strchr ("-+ #0'", *p)) { ++p; }
+	if (*p == '*') {
+		spec->star_count++;
+		++p;
+	} else {
+		while (*p >= '0' && *p <= '9') { ++p; }
+	}
+	if (*p == '.') {
+		++p;
+		if (*p == '*') {
+			spec->star_count++;
+			++p;
+		} else {
+			while (*p >= '0' && *p <= '9') { ++p; }
+		}
+	}
+	b8 wide		   = FALSE;
+	b8 long_double = FALSE;
+	if (*p == 'h') {
+		++p;
+		if (*p == 'h') { ++p; }
+	} else if (*p == 'l') {
+		wide = TRUE;
+		++p;
+		if (*p == 'l') { ++p; }
+	} else if (*p == 'L') {
+		long_double = TRUE;
+		++p;
+	} else if (*p == 'z' || *p == 'j' || *p == 't' || *p == 'q') {
+		wide = TRUE;
+		++p;
+	}
+	switch (*p) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		case 'c': spec->type = wide ? LOG_ARG_I64 : LOG_ARG_I32; break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			spec->type	= LOG_ARG_F64;
+			spec->valid = !long_double;
+			break;
+		case 's':
+			spec->type	= LOG_ARG_STRING;
+			spec->valid = !wide;
+			break;
+		case 'p': spec->type = LOG_ARG_PTR; break;
+		default: spec->valid = FALSE; break;
+	}
+	if (*p) { ++p; }
+	spec->length = (u32)(p - spec->start);
+	if (spec->length >= LOG_FORMAT_SPEC_MAX) { spec->valid = FALSE; }
+	return p;
+}
+
+i32 log_format_parse (const char *format, u8 *out_types) {
+	i32 count = 0;
+	for (const char *p = format; *p;) {
+		if (*p != '%') {
+			++p;
+			continue;
+		}
+		format_spec spec;
+		p = parse_spec (p, &spec);
+		if (!spec.valid) { return -1; }
+		if (spec.type < 0) { continue; }
+		if (count + spec.star_count + 1 > LOG_FORMAT_MAX_ARGS) { return -1; }
+		for (u32 i = 0; i < spec.star_count; ++i) {
+			out_types[count++] = LOG_ARG_I32;
+		}
+		out_types[count++] = (u8)spec.type;
+	}
+	return count;
+}
+
+u32 log_format_encode (const u8 *types, u32 count, va_list args,
+					   u8 *out_payload, u32 capacity) {
+	u32 offset = 0;
+	for (u32 i = 0; i < count; ++i) {
+		switch (types[i]) {
+			case LOG_ARG_I32: {
+				i32 value = va_arg (args, i32);
+				if (offset + sizeof (value) > capacity) { return offset; }
+				memcpy (out_payload + offset, &value, sizeof (value));
+				offset += sizeof (value);
+			} break;
+			case LOG_ARG_I64: {
+				i64 value = va_arg (args, i64);
+				if (offset + sizeof (value) > capacity) { return offset; }
+				memcpy (out_payload + offset, &value, sizeof (value));
+				offset += sizeof (value);
+			} break;
+			case LOG_ARG_F64: {
+				f64 value = va_arg (args, f64);
+				if (offset + sizeof (value) > capacity) { return offset; }
+				memcpy (out_payload + offset, &value, sizeof (value));
+				offset += sizeof (value);
+			} break;
+			case LOG_ARG_PTR: {
+				u64 value = (u64)va_arg (args, void *);
+				if (offset + sizeof (value) > capacity) { return offset; }
+				memcpy (out_payload + offset, &value, sizeof (value));
+				offset += sizeof (value);
+			} break;
+			case LOG_ARG_STRING: {
+				const char *value = va_arg (args, const char *);
+				if (!value) { value = "(null)"; }
+				if (offset + sizeof (u16) > capacity) { return offset; }
+				u64 length	  = strlen (value);
+				u64 available = capacity - offset - sizeof (u16);
+				if (length > available) { length = available; }
+				u16 stored = (u16)length;
+				memcpy (out_payload + offset, &stored, sizeof (stored));
+				offset += sizeof (stored);
+				memcpy (out_payload + offset, value, stored);
+				offset += stored;
+			} break;
+		}
+	}
+	return offset;
+}
+
+#define FORMAT_VALUE(value)                                                    \
+	(spec.star_count == 2	? snprintf (out, room, spec_text, stars[0],        \
+										stars[1], value)                       \
+	 : spec.star_count == 1 ? snprintf (out, room, spec_text, stars[0], value) \
+							: snprintf (out, room, spec_text, value))
+
+u32 log_format_decode (const char *format, const u8 *payload, u32 payload_size,
+					   char *out_text, u32 capacity) {
+	if (capacity == 0) { return 0; }
+	u32 written = 0;
+	u32 offset	= 0;
+	for (const char *p = format; *p && written + 1 < capacity;) {
+		if (*p != '%') {
+			out_text[written++] = *p++;
+			continue;
+		}
+		format_spec spec;
+		p = parse_spec (p, &spec);
+		if (spec.type < 0) {
+			out_text[written++] = '%';
+			continue;
+		}
+		if (!spec.valid) { break; }
+
+		char spec_text[LOG_FORMAT_SPEC_MAX];
+		memcpy (spec_text, spec.start, spec.length);
+		spec_text[spec.length] = 0;
+
+		i32 stars[2] = {0, 0};
+		for (u32 i = 0; i < spec.star_count; ++i) {
+			if (offset + sizeof (i32) > payload_size) { goto done; }
+			memcpy (&stars[i], payload + offset, sizeof (i32));
+			offset += sizeof (i32);
+		}
+
+		char *out = out_text + written;
+		u32 room  = capacity - written;
+		i32 count = 0;
+		switch (spec.type) {
+			case LOG_ARG_I32: {
+				i32 value;
+				if (offset + sizeof (value) > payload_size) { goto done; }
+				memcpy (&value, payload + offset, sizeof (value));
+				offset += sizeof (value);
+				count = FORMAT_VALUE (value);
+			} break;
+			case LOG_ARG_I64: {
+				i64 value;
+				if (offset + sizeof (value) > payload_size) { goto done; }
+				memcpy (&value, payload + offset, sizeof (value));
+				offset += sizeof (value);
+				count = FORMAT_VALUE (value);
+			} break;
+			case LOG_ARG_F64: {
+				f64 value;
+				if (offset + sizeof (value) > payload_size) { goto done; }
+				memcpy (&value, payload + offset, sizeof (value));
+				offset += sizeof (value);
+				count = FORMAT_VALUE (value);
+			} break;
+			case LOG_ARG_PTR: {
+				u64 value;
+				if (offset + sizeof (value) > payload_size) { goto done; }
+				memcpy (&value, payload + offset, sizeof (value));
+				offset += sizeof (value);
+				count = FORMAT_VALUE ((void *)value);
+			} break;
+			case LOG_ARG_STRING: {
+				u16 length;
+				if (offset + sizeof (length) > payload_size) { goto done; }
+				memcpy (&length, payload + offset, sizeof (length));
+				offset += sizeof (length);
+				if (offset + length > payload_size) { goto done; }
+				char value[LOG_FORMAT_STRING_MAX];
+				u16 copied = length < LOG_FORMAT_STRING_MAX
+								 ? length
+								 : LOG_FORMAT_STRING_MAX - 1;
+				memcpy (value, payload + offset, copied);
+				value[copied] = 0;
+				offset += length;
+				count = FORMAT_VALUE (value);
+			} break;
+		}
+		if (count < 0) { break; }
+		written += (u32)count < room ? (u32)count : room - 1;
+	}
+done:
+	out_text[written] = 0;
+	return written;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "defines.h"
+#include <stdarg.h>
+
+// Shared between the logger and the offline decoder (tools/log_decoder), so
+// this must not depend on anything but defines.h and libc.
+
+#define LOG_FORMAT_MAX_ARGS 16
+
+#define LOG_BINARY_MAGIC   0x474F4C46u // "FLOG"
+#define LOG_BINARY_VERSION 1
+
+typedef enum log_arg_type {
+	LOG_ARG_I32,
+	LOG_ARG_I64,
+	LOG_ARG_F64,
+	LOG_ARG_PTR,
+	LOG_ARG_STRING
+} log_arg_type;
+
+typedef enum log_binary_entry_type {
+	// u32 format id, u16 length, length bytes of the format string.
+	LOG_BINARY_ENTRY_FORMAT = 1,
+	// u32 format id, u8 level, u64 timestamp, u16 payload size, payload.
+	LOG_BINARY_ENTRY_MESSAGE = 2
+} log_binary_entry_type;
+
+// Written once at the start of a binary log file.
+typedef struct log_binary_header {
+	u32 magic;
+	u32 version;
+	// Timestamp units per second.
+	u64 timestamp_frequency;
+} log_binary_header;
+
+/**
+ * @brief Extracts the argument types consumed by a printf-style format string, including '*' width and precision.
+ * @param format The format string.
+ * @param out_types Receives up to LOG_FORMAT_MAX_ARGS argument types.
+ * @return The number of arguments, or -1 if the format uses something that can't be captured (%n, long double, too many arguments).
+ */
+i32 log_format_parse (const char *format, u8 *out_types);
+
+/**
+ * @brief Copies the raw argument bytes described by types out of args. Strings are stored as u16 length followed by the characters and are truncated to fit.
+ * @return The number of bytes written to out_payload.
+ */
+u32 log_format_encode (const u8 *types, u32 count, va_list args,
+					   u8 *out_payload, u32 capacity);
+
+/**
+ * @brief Formats a captured payload back into text using the original format string.
+ * @return The number of characters written, excluding the terminator.
+ */
+u32 log_format_decode (const char *format, const u8 *payload, u32 payload_size,
+					   char *out_text, u32 capacity);
@@ -1,23 +1,125 @@
 #include "logger.h"
 #include "core/asserts.h"
+#include "core/log_format.h"
+#include "core/metrics.h"
 #include "core/sfmemory.h"
 #include "core/sfstring.h"
+#include "core/thread_pinning.h"
 #include "platform/filesystem.h"
 #include "platform/platform.h"
+#include "platform/thread.h"
 // NOTE: temp
+#include <ctype.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#define LOG_MESSAGE_MAX_LENGTH 32000
+// Must be a power of 2.
+#define LOG_QUEUE_CAPACITY	   2048
+#define LOG_RECORD_TEXT_SIZE   496
+#define LOG_BATCH_SIZE		   (64 * 1024)
+#define LOG_WRITER_INTERVAL_MS 5
+// Must be a power of 2.
+#define LOG_FORMAT_CACHE_SIZE  1024
+// Binary records at or below this level are also decoded for the console.
+#define LOG_BINARY_CONSOLE_LEVEL LOG_LEVEL_INFO
+#define LOG_CONSOLE_BUFFER_SIZE	 4096
+
+#define LOG_FORMAT_PENDING -2
+
+// One slot of the bounded multi-producer/single-consumer queue. sequence tells
+// producers and the writer whose turn it is to touch the slot.
+typedef struct log_record {
+	_Atomic u64 sequence;
+	log_level level;
+	// 0 if text holds a formatted message, otherwise the format cache index
+	// plus one and text holds the encoded arguments.
+	u32 format_id;
+	u64 timestamp;
+	u32 length;
+	char text[LOG_RECORD_TEXT_SIZE];
+} log_record;
+
+// Format strings seen in binary mode, keyed by pointer. Slots are claimed once
+// and never released, so the index doubles as the id written to logs.bin.
+typedef struct log_format_entry {
+	_Atomic(const char *) format;
+	// Argument count once parsed, -1 if the format can't be captured.
+	_Atomic i32 arg_count;
+	u8 types[LOG_FORMAT_MAX_ARGS];
+} log_format_entry;
+
 typedef struct logger_state {
 	file_handle file_handle;
+	file_handle binary_file_handle;
+	log_mode mode;
+	sf_thread writer_thread;
+	sf_semaphore writer_semaphore;
+	atomic_bool writer_running;
+	// Broadcast by the writer whenever written_pos moves, logging_flush
+	// waits on it.
+	sf_mutex flush_lock;
+	sf_condition flushed;
+	// Producer and consumer cursors live on separate cache lines.
+	u8 _pad0[64];
+	_Atomic u64 enqueue_pos;
+	u8 _pad1[56];
+	_Atomic u64 dequeue_pos;
+	_Atomic u64 written_pos;
+	u8 _pad2[48];
+	char batch[LOG_BATCH_SIZE];
+	char binary_batch[LOG_BATCH_SIZE];
+	// Writer-only: which format ids were already written to logs.bin.
+	u8 formats_written[LOG_FORMAT_CACHE_SIZE / 8];
+	char console_buffer[LOG_CONSOLE_BUFFER_SIZE];
+	log_format_entry formats[LOG_FORMAT_CACHE_SIZE];
+	log_record queue[LOG_QUEUE_CAPACITY];
 } logger_state;
 
 static logger_state *pState;
 
-void write_to_log_file (const char *msg) {
+// Release builds that keep debug and trace with LOG_BINARY_IN_RELEASE still
+// start with them off until enabled through SF_LOG_LEVELS.
+#ifdef NDEBUG
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_TRACE
+#endif
+
+// Not part of logger_state so the macros work before logging is initialized.
+u8 log_category_levels[LOG_CATEGORY_MAX] = {
+	[LOG_CATEGORY_CORE]		= LOG_DEFAULT_LEVEL,
+	[LOG_CATEGORY_RENDERER] = LOG_DEFAULT_LEVEL,
+	[LOG_CATEGORY_VULKAN]	= LOG_DEFAULT_LEVEL,
+	[LOG_CATEGORY_MEMORY]	= LOG_DEFAULT_LEVEL,
+	[LOG_CATEGORY_INPUT]	= LOG_DEFAULT_LEVEL,
+	[LOG_CATEGORY_GAME]		= LOG_DEFAULT_LEVEL};
+
+// Categories moved off the default, through SF_LOG_LEVELS or at runtime.
+static b8 category_level_set[LOG_CATEGORY_MAX];
+
+static const char *category_names[LOG_CATEGORY_MAX] = {
+	"core", "renderer", "vulkan", "memory", "input", "game"};
+
+static const char *level_names[6] = {"fatal", "error", "warning",
+									 "info",  "debug", "trace"};
+
+// Formatting scratch, one per thread so producers never share it.
+static _Thread_local char format_buffer[LOG_MESSAGE_MAX_LENGTH];
+
+const char *level_string[6] = {"[FATAL]:	", "[ERROR]:	", "[WARNING]:	",
+							   "[INFO]:	",	   "[DEBUG]:	", "[TRACE]:	"};
+
+const char *level_color[6] = {COLOR_FATAL, COLOR_RED,	COLOR_YELLOW,
+							  COLOR_GREEN, COLOR_WHITE, COLOR_GREY};
+
+static const char reset[] = "\033[0m\n";
+
+void write_to_log_file (const char *msg, u64 len) {
 	if (pState && pState->file_handle.is_valid) {
-		u64 len		= sfstrlen (msg);
 		u64 written = 0;
 		if (!filesystem_write (&pState->file_handle, len, msg, &written)) {
 			platform_console_write_error ("Unable to write to logs.log", TRUE);
@@ -25,10 +127,275 @@ void write_to_log_file (const char *msg) {
 	}
 }
 
+static void write_to_binary_file (const char *data, u64 len) {
+	if (pState && pState->binary_file_handle.is_valid) {
+		u64 written = 0;
+		if (!filesystem_write (&pState->binary_file_handle, len, data,
+							   &written)) {
+			platform_console_write_error ("Unable to write to logs.bin", TRUE);
+		}
+	}
+}
+
+// Appends to the binary batch, flushing it to logs.bin first if it is full.
+static void binary_batch_append (u64 *batch_length, const void *data, u64 len) {
+	if (*batch_length + len > LOG_BATCH_SIZE) {
+		write_to_binary_file (pState->binary_batch, *batch_length);
+		*batch_length = 0;
+	}
+	sfmemcpy (pState->binary_batch + *batch_length, data, len);
+	*batch_length += len;
+}
+
+static void write_binary_record (log_record *record, u64 *batch_length) {
+	u32 id			   = record->format_id - 1;
+	const char *format = atomic_load_explicit (&pState->formats[id].format,
+											   memory_order_relaxed);
+	u8 *written_mask   = &pState->formats_written[id / 8];
+	u8 written_bit	   = 1 << (id % 8);
+	u8 header[16];
+	if (!(*written_mask & written_bit)) {
+		u16 format_length = (u16)strlen (format);
+		header[0]		  = LOG_BINARY_ENTRY_FORMAT;
+		sfmemcpy (header + 1, &id, sizeof (id));
+		sfmemcpy (header + 5, &format_length, sizeof (format_length));
+		binary_batch_append (batch_length, header, 7);
+		binary_batch_append (batch_length, format, format_length);
+		*written_mask |= written_bit;
+	}
+
+	u8 level  = (u8)record->level;
+	u16 size  = (u16)record->length;
+	header[0] = LOG_BINARY_ENTRY_MESSAGE;
+	sfmemcpy (header + 1, &id, sizeof (id));
+	header[5] = level;
+	sfmemcpy (header + 6, &record->timestamp, sizeof (record->timestamp));
+	sfmemcpy (header + 14, &size, sizeof (size));
+	binary_batch_append (batch_length, header, 16);
+	binary_batch_append (batch_length, record->text, size);
+
+	if (record->level <= LOG_BINARY_CONSOLE_LEVEL) {
+		char *out  = pState->console_buffer;
+		u32 room   = LOG_CONSOLE_BUFFER_SIZE - sizeof (reset);
+		i32 prefix = snprintf (out, room, "%s%s", level_color[level],
+							   level_string[level]);
+		u32 length = prefix + log_format_decode (format, (u8 *)record->text,
+												 size, out + prefix,
+												 room - prefix);
+		sfmemcpy (out + length, reset, sizeof (reset));
+		platform_console_write (out, record->level);
+	}
+}
+
+// Writes everything the producers published so far. Only ever called from one
+// thread at a time: the writer thread, or the owner after it was joined.
+static void drain_queue () {
+	u64 batch_length		= 0;
+	u64 binary_batch_length = 0;
+	u64 pos			 = atomic_load_explicit (&pState->dequeue_pos,
+											 memory_order_relaxed);
+	u64 start = pos;
+	for (;;) {
+		log_record *record = &pState->queue[pos & (LOG_QUEUE_CAPACITY - 1)];
+		u64 sequence =
+			atomic_load_explicit (&record->sequence, memory_order_acquire);
+		if (sequence != pos + 1) { break; }
+		if (record->format_id) {
+			write_binary_record (record, &binary_batch_length);
+		} else {
+			platform_console_write (record->text, record->level);
+			if (batch_length + record->length > LOG_BATCH_SIZE) {
+				write_to_log_file (pState->batch, batch_length);
+				batch_length = 0;
+			}
+			sfmemcpy (pState->batch + batch_length, record->text,
+					  record->length);
+			batch_length += record->length;
+		}
+		// Hand the slot back to producers for the next lap.
+		atomic_store_explicit (&record->sequence, pos + LOG_QUEUE_CAPACITY,
+							   memory_order_release);
+		++pos;
+		atomic_store_explicit (&pState->dequeue_pos, pos,
+							   memory_order_release);
+	}
+	if (batch_length > 0) { write_to_log_file (pState->batch, batch_length); }
+	if (binary_batch_length > 0) {
+		write_to_binary_file (pState->binary_batch, binary_batch_length);
+	}
+	atomic_store_explicit (&pState->written_pos, pos, memory_order_release);
+	if (pos != start) {
+		platform_mutex_lock (&pState->flush_lock);
+		platform_condition_broadcast (&pState->flushed);
+		platform_mutex_unlock (&pState->flush_lock);
+	}
+}
+
+static u32 log_writer_thread (void *params) {
+	thread_pinning_apply (THREAD_ROLE_IO, 0);
+	while (atomic_load_explicit (&pState->writer_running,
+								 memory_order_acquire)) {
+		platform_semaphore_wait_timeout (&pState->writer_semaphore,
+										 LOG_WRITER_INTERVAL_MS);
+		drain_queue ();
+	}
+	drain_queue ();
+	return 0;
+}
+
+// Claims the next free slot. Returns NULL if the queue is full.
+static log_record *reserve_record (u64 *out_pos) {
+	u64 pos =
+		atomic_load_explicit (&pState->enqueue_pos, memory_order_relaxed);
+	log_record *record;
+	for (;;) {
+		record		 = &pState->queue[pos & (LOG_QUEUE_CAPACITY - 1)];
+		u64 sequence = atomic_load_explicit (&record->sequence,
+											 memory_order_acquire);
+		i64 diff	 = (i64)sequence - (i64)pos;
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit (
+					&pState->enqueue_pos, &pos, pos + 1, memory_order_relaxed,
+					memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// Full.
+			return SF_NULL;
+		} else {
+			pos = atomic_load_explicit (&pState->enqueue_pos,
+										memory_order_relaxed);
+		}
+	}
+	*out_pos = pos;
+	return record;
+}
+
+// Hands a filled slot over to the writer.
+static void publish_record (log_record *record, u64 pos) {
+	atomic_store_explicit (&record->sequence, pos + 1, memory_order_release);
+
+	// The writer wakes up on its own every LOG_WRITER_INTERVAL_MS, only poke
+	// it when the queue is filling up.
+	u64 consumed =
+		atomic_load_explicit (&pState->dequeue_pos, memory_order_relaxed);
+	if (pos - consumed >= LOG_QUEUE_CAPACITY / 2) {
+		platform_semaphore_signal (&pState->writer_semaphore);
+	}
+}
+
+static b8 enqueue_record (log_level level, const char *text, u32 length) {
+	if (length + 1 > LOG_RECORD_TEXT_SIZE) { return FALSE; }
+	u64 pos;
+	log_record *record = reserve_record (&pos);
+	if (!record) { return FALSE; }
+	record->level	  = level;
+	record->format_id = 0;
+	record->length	  = length;
+	sfmemcpy (record->text, text, length + 1);
+	publish_record (record, pos);
+	return TRUE;
+}
+
+// Finds or adds format in the cache. Returns NULL if the cache is full or
+// another thread is still parsing the same format.
+static log_format_entry *find_format (const char *format, u32 *out_id) {
+	u64 hash = ((u64)format >> 3) * 0x9E3779B97F4A7C15ull;
+	u32 slot = (u32)(hash >> 32) & (LOG_FORMAT_CACHE_SIZE - 1);
+	for (u32 probe = 0; probe < LOG_FORMAT_CACHE_SIZE; ++probe) {
+		log_format_entry *entry = &pState->formats[slot];
+		const char *key =
+			atomic_load_explicit (&entry->format, memory_order_acquire);
+		if (!key) {
+			const char *expected = SF_NULL;
+			if (atomic_compare_exchange_strong (&entry->format, &expected,
+												format)) {
+				i32 count = log_format_parse (format, entry->types);
+				atomic_store_explicit (&entry->arg_count, count,
+									   memory_order_release);
+				*out_id = slot;
+				return entry;
+			}
+			key = expected;
+		}
+		if (key == format) {
+			if (atomic_load_explicit (&entry->arg_count,
+									  memory_order_acquire) ==
+				LOG_FORMAT_PENDING) {
+				return SF_NULL;
+			}
+			*out_id = slot;
+			return entry;
+		}
+		slot = (slot + 1) & (LOG_FORMAT_CACHE_SIZE - 1);
+	}
+	return SF_NULL;
+}
+
+// Formats that can't be captured are formatted here and logged as a "%s"
+// argument instead.
+static const char text_format[] = "%s";
+
+static b8 enqueue_binary (log_level level, const char *format, va_list args) {
+	u32 id;
+	log_format_entry *entry = find_format (format, &id);
+	if (!entry) { return FALSE; }
+	i32 arg_count = atomic_load_explicit (&entry->arg_count,
+										  memory_order_relaxed);
+	const char *text = SF_NULL;
+	if (arg_count < 0) {
+		if (vsnprintf (format_buffer, LOG_MESSAGE_MAX_LENGTH, format, args) <
+			0) {
+			return FALSE;
+		}
+		text  = format_buffer;
+		entry = find_format (text_format, &id);
+		if (!entry) { return FALSE; }
+		arg_count = 1;
+	}
+
+	u64 pos;
+	log_record *record = reserve_record (&pos);
+	if (!record) { return FALSE; }
+	record->level	  = level;
+	record->format_id = id + 1;
+	record->timestamp = platform_get_absolute_time_ns ();
+	if (text) {
+		u64 length = strlen (text);
+		if (length > LOG_RECORD_TEXT_SIZE - sizeof (u16)) {
+			length = LOG_RECORD_TEXT_SIZE - sizeof (u16);
+		}
+		u16 stored = (u16)length;
+		sfmemcpy (record->text, &stored, sizeof (stored));
+		sfmemcpy (record->text + sizeof (stored), text, stored);
+		record->length = sizeof (stored) + stored;
+	} else {
+		record->length =
+			log_format_encode (entry->types, (u32)arg_count, args,
+							   (u8 *)record->text, LOG_RECORD_TEXT_SIZE);
+	}
+	publish_record (record, pos);
+	return TRUE;
+}
+
 b8 logging_initialize (u64 *mem_size, void *memory) {
 	*mem_size = sizeof (logger_state);
 	if (memory == SF_NULL) { return FALSE; }
-	pState = memory;
+	pState		 = memory;
+	pState->mode = LOG_MODE_SYNC;
+	atomic_init (&pState->writer_running, FALSE);
+	atomic_init (&pState->enqueue_pos, 0);
+	atomic_init (&pState->dequeue_pos, 0);
+	atomic_init (&pState->written_pos, 0);
+	for (u64 i = 0; i < LOG_QUEUE_CAPACITY; ++i) {
+		atomic_init (&pState->queue[i].sequence, i);
+	}
+	for (u64 i = 0; i < LOG_FORMAT_CACHE_SIZE; ++i) {
+		atomic_init (&pState->formats[i].format, SF_NULL);
+		atomic_init (&pState->formats[i].arg_count, LOG_FORMAT_PENDING);
+	}
+	sfmemset (pState->formats_written, 0, sizeof (pState->formats_written));
+	pState->binary_file_handle.is_valid = FALSE;
 	if (!filesystem_open ("logs.log", FILE_MODE_WRITE, FALSE,
 						  &pState->file_handle)) {
 		platform_console_write_error ("Failed to open logs.log for writing",
@@ -36,46 +403,212 @@ b8 logging_initialize (u64 *mem_size, void *memory) {
 		return FALSE;
 	}
 	SF_INFO ("Logging subsystem initialized sucessfully.");
+	const char *levels = getenv ("SF_LOG_LEVELS");
+	if (levels && !logging_configure_categories (levels)) {
+		SF_WARNING ("Ignored invalid entries in SF_LOG_LEVELS='%s'.", levels);
+	}
 	return TRUE;
 }
 
+void logging_set_category_level (log_category category, log_level level) {
+	if (category >= LOG_CATEGORY_MAX || level > LOG_LEVEL_TRACE) { return; }
+	// Plain byte stores, readers pick the new value up on their next check.
+	log_category_levels[category] = (u8)level;
+	category_level_set[category]  = TRUE;
+}
+
+log_level logging_get_category_level (log_category category) {
+	if (category >= LOG_CATEGORY_MAX) { return LOG_LEVEL_FATAL; }
+	return (log_level)log_category_levels[category];
+}
+
+b8 logging_category_level_set (log_category category) {
+	if (category >= LOG_CATEGORY_MAX) { return FALSE; }
+	return category_level_set[category];
+}
+
+// Case-insensitive compare of [begin, end) against a null terminated name.
+static b8 token_equals (const char *begin, const char *end, const char *name) {
+	for (; begin < end && *name; ++begin, ++name) {
+		if (tolower ((u8)*begin) != *name) { return FALSE; }
+	}
+	return begin == end && *name == 0;
+}
+
+static const char *trim (const char *begin, const char **end) {
+	while (begin < *end && isspace ((u8)*begin)) { ++begin; }
+	while (*end > begin && isspace ((u8)(*end)[-1])) { --*end; }
+	return begin;
+}
+
+b8 logging_configure_categories (const char *levels) {
+	b8 valid = TRUE;
+	for (const char *entry = levels; *entry;) {
+		const char *entry_end = strchr (entry, ',');
+		if (!entry_end) { entry_end = entry + strlen (entry); }
+		const char *equals = memchr (entry, '=', entry_end - entry);
+		if (!equals) {
+			valid = FALSE;
+		} else {
+			const char *name_end  = equals;
+			const char *name	  = trim (entry, &name_end);
+			const char *level_end = entry_end;
+			const char *level	  = trim (equals + 1, &level_end);
+
+			i32 level_index = -1;
+			for (i32 i = 0; i < 6; ++i) {
+				if (token_equals (level, level_end, level_names[i])) {
+					level_index = i;
+				}
+			}
+			if (token_equals (level, level_end, "warn")) {
+				level_index = LOG_LEVEL_WARNING;
+			}
+
+			b8 all	   = token_equals (name, name_end, "*") ||
+					 token_equals (name, name_end, "all");
+			b8 matched = all;
+			for (u32 i = 0; i < LOG_CATEGORY_MAX && level_index >= 0; ++i) {
+				if (all || token_equals (name, name_end, category_names[i])) {
+					logging_set_category_level (i, level_index);
+					matched = TRUE;
+				}
+			}
+			if (level_index < 0 || !matched) { valid = FALSE; }
+		}
+		entry = *entry_end ? entry_end + 1 : entry_end;
+	}
+	return valid;
+}
+
 void logging_shutdown (void *memory) {
-	// TODO: cleanup write queue
+	logging_set_mode (LOG_MODE_SYNC);
 	filesystem_close (&pState->file_handle);
+	if (pState->binary_file_handle.is_valid) {
+		filesystem_close (&pState->binary_file_handle);
+	}
 	pState = SF_NULL;
 }
 
-const char *level_string[6] = {"[FATAL]:	", "[ERROR]:	", "[WARNING]:	",
-							   "[INFO]:	",	   "[DEBUG]:	", "[TRACE]:	"};
+static b8 open_binary_log () {
+	if (pState->binary_file_handle.is_valid) { return TRUE; }
+	if (!filesystem_open ("logs.bin", FILE_MODE_WRITE, TRUE,
+						  &pState->binary_file_handle)) {
+		platform_console_write_error ("Failed to open logs.bin for writing",
+									  FALSE);
+		return FALSE;
+	}
+	log_binary_header header = {.magic				 = LOG_BINARY_MAGIC,
+								.version			 = LOG_BINARY_VERSION,
+								.timestamp_frequency = 1000000000};
+	write_to_binary_file ((const char *)&header, sizeof (header));
+	return TRUE;
+}
 
-void log_output (log_level level, const char *message, ...) {
-	// NOTE: I hope nobody goes over 32k bytes
-	char formatted_message[32000];
-	sfmemset (formatted_message, 0, sizeof (formatted_message));
+static void destroy_writer_objects () {
+	platform_condition_destroy (&pState->flushed);
+	platform_mutex_destroy (&pState->flush_lock);
+	platform_semaphore_destroy (&pState->writer_semaphore);
+}
+
+b8 logging_set_mode (log_mode mode) {
+	if (!pState) { return FALSE; }
+	if (pState->mode == mode) { return TRUE; }
+	if (mode == LOG_MODE_BINARY && !open_binary_log ()) { return FALSE; }
+	if (pState->mode != LOG_MODE_SYNC && mode != LOG_MODE_SYNC) {
+		// The writer keeps running, it handles both kinds of records.
+		logging_flush ();
+		pState->mode = mode;
+	} else if (mode != LOG_MODE_SYNC) {
+		if (!platform_semaphore_create (0, &pState->writer_semaphore) ||
+			!platform_mutex_create (&pState->flush_lock) ||
+			!platform_condition_create (&pState->flushed)) {
+			return FALSE;
+		}
+		atomic_store (&pState->writer_running, TRUE);
+		pState->mode = mode;
+		if (!platform_thread_create (log_writer_thread, SF_NULL,
+									 &pState->writer_thread)) {
+			pState->mode = LOG_MODE_SYNC;
+			atomic_store (&pState->writer_running, FALSE);
+			drain_queue ();
+			destroy_writer_objects ();
+			return FALSE;
+		}
+	} else {
+		logging_flush ();
+		pState->mode = LOG_MODE_SYNC;
+		atomic_store (&pState->writer_running, FALSE);
+		platform_semaphore_signal (&pState->writer_semaphore);
+		platform_thread_join (&pState->writer_thread);
+		drain_queue ();
+		destroy_writer_objects ();
+		return TRUE;
+	}
+	SF_INFO ("%s logging enabled.",
+			 mode == LOG_MODE_BINARY ? "Binary" : "Asynchronous");
+	return TRUE;
+}
 
-	char color_code[11];
-	sfmemset (color_code, 0, sizeof (color_code));
-	switch (level) {
-		case LOG_LEVEL_DEBUG: strcpy (color_code, COLOR_WHITE); break;
-		case LOG_LEVEL_TRACE: strcpy (color_code, COLOR_GREY); break;
-		case LOG_LEVEL_INFO: strcpy (color_code, COLOR_GREEN); break;
-		case LOG_LEVEL_WARNING: strcpy (color_code, COLOR_YELLOW); break;
-		case LOG_LEVEL_ERROR: strcpy (color_code, COLOR_RED); break;
-		case LOG_LEVEL_FATAL: strcpy (color_code, COLOR_FATAL); break;
+void logging_flush () {
+	if (!pState || pState->mode == LOG_MODE_SYNC) { return; }
+	u64 target = atomic_load (&pState->enqueue_pos);
+	if (atomic_load (&pState->written_pos) >= target) { return; }
+	platform_semaphore_signal (&pState->writer_semaphore);
+	// A record claimed but not yet published stops the drain short, the
+	// writer picks it up on its next interval and broadcasts again.
+	platform_mutex_lock (&pState->flush_lock);
+	while (atomic_load (&pState->written_pos) < target) {
+		platform_condition_wait (&pState->flushed, &pState->flush_lock);
 	}
+	platform_mutex_unlock (&pState->flush_lock);
+}
+
+void log_output (log_level level, const char *message, ...) {
+	SF_METRIC_COUNT ("log_lines", 1);
+	if (pState && pState->mode == LOG_MODE_BINARY) {
+		va_list arg_ptr;
+		va_start (arg_ptr, message);
+		b8 queued = enqueue_binary (level, message, arg_ptr);
+		va_end (arg_ptr);
+		if (queued) {
+			// Make sure a fatal message is on disk before whatever comes next.
+			if (level == LOG_LEVEL_FATAL) { logging_flush (); }
+			return;
+		}
+		logging_flush ();
+	}
+
+	char *out_message	 = format_buffer;
+	const u64 max_length	  = LOG_MESSAGE_MAX_LENGTH - sizeof (reset);
+	i32 prefix_length = snprintf (out_message, max_length, "%s%s",
+								  level_color[level], level_string[level]);
 
 	// NOTE: apparently MS headers override Clang's va_list with <typedef
 	// char* va_list>, so this is a workaround
 	va_list arg_ptr;
 	va_start (arg_ptr, message);
-	vsnprintf (formatted_message, 32000, message, arg_ptr);
+	i32 message_length = vsnprintf (out_message + prefix_length,
+									max_length - prefix_length, message,
+									arg_ptr);
 	va_end (arg_ptr);
+	if (message_length < 0) { message_length = 0; }
+	u64 length = prefix_length + message_length;
+	if (length > max_length - 1) { length = max_length - 1; }
+	sfmemcpy (out_message + length, reset, sizeof (reset));
+	length += sizeof (reset) - 1;
 
-	char out_message[32000];
-	sprintf (out_message, "%s%s%s\033[0m\n", color_code, level_string[level],
-			 formatted_message);
+	if (pState && pState->mode == LOG_MODE_ASYNC) {
+		if (level != LOG_LEVEL_FATAL &&
+			enqueue_record (level, out_message, (u32)length)) {
+			return;
+		}
+		// Fatal, oversized or the queue is full: keep ordering by draining
+		// what is queued first, then write on this thread.
+		logging_flush ();
+	}
 	platform_console_write (out_message, level);
-	write_to_log_file (out_message);
+	write_to_log_file (out_message, length);
 }
 
 void report_assertion_failure (const char *expression, const char *message,
@@ -2,13 +2,20 @@
 
 #include "defines.h"
 
-#define LOG_WARN_ENABLED  1
-#define LOG_INFO_ENABLED  1
-#define LOG_DEBUG_ENABLED 1
-#define LOG_TRACE_ENABLED 1
-#if SAPRELEASE
+// Release builds compile debug and trace messages out. Define as 1 to keep
+// them for a build that logs through the cheap binary mode.
+#ifndef LOG_BINARY_IN_RELEASE
+#define LOG_BINARY_IN_RELEASE 0
+#endif
+
+#define LOG_WARN_ENABLED 1
+#define LOG_INFO_ENABLED 1
+#if defined(NDEBUG) && !LOG_BINARY_IN_RELEASE
 #define LOG_DEBUG_ENABLED 0
 #define LOG_TRACE_ENABLED 0
+#else
+#define LOG_DEBUG_ENABLED 1
+#define LOG_TRACE_ENABLED 1
 #endif
 
 typedef enum log_level {
@@ -20,6 +27,42 @@ typedef enum log_level {
 	LOG_LEVEL_TRACE	  = 5
 } log_level;
 
+typedef enum log_category {
+	LOG_CATEGORY_CORE,
+	LOG_CATEGORY_RENDERER,
+	LOG_CATEGORY_VULKAN,
+	LOG_CATEGORY_MEMORY,
+	LOG_CATEGORY_INPUT,
+	LOG_CATEGORY_GAME,
+	LOG_CATEGORY_MAX
+} log_category;
+
+// Category used by the SF_* macros in the including file. Engine sources
+// define it before their first include, everything else defaults to GAME.
+#ifndef SF_LOG_CATEGORY
+#ifdef SAPEXPORT
+#define SF_LOG_CATEGORY LOG_CATEGORY_CORE
+#else
+#define SF_LOG_CATEGORY LOG_CATEGORY_GAME
+#endif
+#endif
+
+// Most verbose level logged per category. Read by the SF_* macros, use
+// logging_set_category_level to change it.
+SAPI extern u8 log_category_levels[LOG_CATEGORY_MAX];
+
+typedef enum log_mode {
+	// Formats and writes every message on the calling thread.
+	LOG_MODE_SYNC = 0,
+	// Formats on the calling thread, a background thread batches the writes.
+	LOG_MODE_ASYNC = 1,
+	// Captures the format pointer, a timestamp and the raw arguments; the
+	// background thread writes them to logs.bin for tools/log_decoder and only
+	// formats messages up to LOG_LEVEL_INFO for the console. Format strings
+	// must be string literals in this mode.
+	LOG_MODE_BINARY = 2
+} log_mode;
+
 /**
 * @brief Initializes logging. If memory is NULL, will populate mem_size.
 *
@@ -35,6 +78,43 @@ b8 logging_initialize (u64* mem_size, void* memory);
 */
 void logging_shutdown (void* memory);
 
+/**
+* @brief Switches between output modes. Leaving LOG_MODE_SYNC starts the writer thread, switching back flushes and joins it.
+* @param mode The mode to switch to.
+* @return TRUE on success; otherwise FALSE, in which case the mode is unchanged.
+*/
+SAPI b8 logging_set_mode (log_mode mode);
+
+/**
+* @brief Blocks until every message queued so far has been written out. No-op in LOG_MODE_SYNC.
+*/
+SAPI void logging_flush ();
+
+/**
+* @brief Sets the most verbose level logged for a category. Takes effect immediately on all threads.
+* @param category The category to change.
+* @param level Messages above this level are discarded before their arguments are evaluated.
+*/
+SAPI void logging_set_category_level (log_category category, log_level level);
+
+/**
+* @return The most verbose level currently logged for category.
+*/
+SAPI log_level logging_get_category_level (log_category category);
+
+/**
+* @return TRUE if the level of category was set explicitly, through SF_LOG_LEVELS or logging_set_category_level; FALSE while it is at the build default.
+*/
+SAPI b8 logging_category_level_set (log_category category);
+
+/**
+* @brief Applies a comma separated list of category=level pairs, e.g. "vulkan=trace,memory=warning". "*" matches all categories.
+* Called with the SF_LOG_LEVELS environment variable during initialization.
+* @param levels The list to apply.
+* @return TRUE if every entry was understood; otherwise FALSE. Valid entries are applied either way.
+*/
+SAPI b8 logging_configure_categories (const char* levels);
+
 /**
 * @brief Logs a message to the log file. This is the entry point for the logging system. It takes care of coloring the message based on the level and message.
 * @param level The level of the message to be logged.
@@ -50,18 +130,27 @@ SAPI void log_output (log_level level, const char* message, ...);
 #define COLOR_WHITE	 "\033[0;97m"
 #define COLOR_GREY	 "\033[0;37m"
 
+// A single compare and branch; arguments are not evaluated when disabled.
+#define SF_LOG_ENABLED(level) ((level) <= log_category_levels[SF_LOG_CATEGORY])
+
+#define SF_LOG(level, message, ...)                                            \
+	do {                                                                       \
+		if (SF_LOG_ENABLED (level)) {                                          \
+			log_output (level, message, ##__VA_ARGS__);                        \
+		}                                                                      \
+	} while (0);
+
 #define SF_FATAL(message, ...)                                                 \
 	log_output (LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
 
 #ifndef SF_ERROR
-#define SF_ERROR(message, ...)                                                 \
-	log_output (LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
+#define SF_ERROR(message, ...) SF_LOG (LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
 #endif
 
 #if LOG_WARN_ENABLED == 1
 #ifndef SF_WARNING
 #define SF_WARNING(message, ...)                                               \
-	log_output (LOG_LEVEL_WARNING, message, ##__VA_ARGS__);
+	SF_LOG (LOG_LEVEL_WARNING, message, ##__VA_ARGS__)
 #endif
 #else
 #define SF_WARNING(message, ...)
@@ -69,8 +158,7 @@ SAPI void log_output (log_level level, const char* message, ...);
 
 #if LOG_INFO_ENABLED == 1
 #ifndef SF_INFO
-#define SF_INFO(message, ...)                                                  \
-	log_output (LOG_LEVEL_INFO, message, ##__VA_ARGS__);
+#define SF_INFO(message, ...) SF_LOG (LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 #endif
 #else
 #define SF_INFO(message, ...)
@@ -78,8 +166,7 @@ SAPI void log_output (log_level level, const char* message, ...);
 
 #if LOG_DEBUG_ENABLED == 1
 #ifndef SF_DEBUG
-#define SF_DEBUG(message, ...)                                                 \
-	log_output (LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
+#define SF_DEBUG(message, ...) SF_LOG (LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
 #endif
 #else
 #define SF_DEBUG(message, ...)
@@ -87,8 +174,7 @@ SAPI void log_output (log_level level, const char* message, ...);
 
 #if LOG_TRACE_ENABLED == 1
 #ifndef SF_TRACE
-#define SF_TRACE(message, ...)                                                 \
-	log_output (LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
+#define SF_TRACE(message, ...) SF_LOG (LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 #endif
 #else
 #define SF_TRACE(message, ...)
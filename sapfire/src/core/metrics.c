@@ -0,0 +1,368 @@
+#include "metrics.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "platform/atomic.h"
+#include "platform/filesystem.h"
+#include "platform/thread.h"
+#include <stdio.h>
+
+#define METRICS_CSV_LINE_LENGTH 4096
+
+typedef struct metric {
+	const char *name;
+	metric_type type;
+	// Frame the metric was registered in, history before it is empty.
+	u64 first_frame;
+	// Value of the frame in progress. Counters and histograms are swapped
+	// with 0 at the end of the frame, gauges hold the bits of an f64.
+	sf_atomic_u64 current;
+	sf_atomic_u64 buckets[METRICS_HISTOGRAM_BUCKETS];
+	// Only touched by metrics_frame_end and the queries.
+	f64 total;
+	f64 history[METRICS_HISTORY_FRAMES];
+} metric;
+
+// Running counter totals of one thread. Only the owner writes them, so an add
+// is a plain load and store instead of a locked add on a shared line.
+typedef struct metrics_thread_slots {
+	sf_atomic_u64 values[METRICS_MAX];
+} metrics_thread_slots;
+
+typedef struct metrics_state {
+	// Bumped on every initialize so slots cached by threads from an earlier
+	// run are not reused.
+	u32 generation;
+	// Entries below count are fully written, it is published with release.
+	sf_atomic_u32 count;
+	// Serializes registration, updates never take it.
+	sf_mutex register_lock;
+	b8 warned_full;
+	sf_atomic_u64 frame_number;
+	u32 history_head;
+	u32 history_count;
+	metric metrics[METRICS_MAX];
+	// Slots handed out so far, may run past METRICS_MAX_THREADS.
+	sf_atomic_u32 thread_count;
+	// Totals already moved into the history, only touched by
+	// metrics_frame_end.
+	u64 thread_seen[METRICS_MAX_THREADS][METRICS_MAX];
+	metrics_thread_slots threads[METRICS_MAX_THREADS];
+} metrics_state;
+
+static metrics_state *pState;
+static u32 next_generation = 1;
+
+// NULL with a current generation means the thread got no slot.
+static _Thread_local metrics_thread_slots *thread_slots;
+static _Thread_local u32 thread_slots_generation;
+
+static metrics_thread_slots *get_thread_slots () {
+	if (thread_slots_generation == pState->generation) { return thread_slots; }
+	u32 index = sf_atomic_fetch_add_u32 (&pState->thread_count, 1);
+	thread_slots =
+		index < METRICS_MAX_THREADS ? &pState->threads[index] : SF_NULL;
+	thread_slots_generation = pState->generation;
+	return thread_slots;
+}
+
+static f64 bits_to_f64 (u64 bits) {
+	union {
+		u64 bits;
+		f64 value;
+	} convert = {.bits = bits};
+	return convert.value;
+}
+
+static u64 f64_to_bits (f64 value) {
+	union {
+		f64 value;
+		u64 bits;
+	} convert = {.value = value};
+	return convert.bits;
+}
+
+b8 metrics_initialize (u64 *mem_size, void *memory) {
+	*mem_size = sizeof (metrics_state);
+	if (memory == SF_NULL) { return FALSE; }
+	metrics_state *state = memory;
+	sfmemset (state, 0, sizeof (metrics_state));
+	state->generation = next_generation++;
+	sf_atomic_init_u32 (&state->count, 0);
+	sf_atomic_init_u32 (&state->thread_count, 0);
+	sf_atomic_init_u64 (&state->frame_number, 0);
+	if (!platform_mutex_create (&state->register_lock)) {
+		SF_ERROR ("Failed to create the metrics registration lock.");
+		return FALSE;
+	}
+	pState = state;
+	SF_INFO ("Metrics initialized successfully.");
+	return TRUE;
+}
+
+void metrics_shutdown (void *memory) {
+	if (!pState) { return; }
+	platform_mutex_destroy (&pState->register_lock);
+	pState = SF_NULL;
+}
+
+u32 metrics_find (const char *name) {
+	if (!pState) { return INVALID_ID; }
+	u32 count = sf_atomic_load_u32 (&pState->count);
+	for (u32 i = 0; i < count; ++i) {
+		const char *metric_name = pState->metrics[i].name;
+		if (metric_name == name || sfstreq (metric_name, name)) { return i; }
+	}
+	return INVALID_ID;
+}
+
+u32 metrics_register (const char *name, metric_type type) {
+	if (!pState || !name || type >= METRIC_TYPE_MAX) { return INVALID_ID; }
+	u32 id = metrics_find (name);
+	if (id == INVALID_ID) {
+		platform_mutex_lock (&pState->register_lock);
+		// Another thread may have registered it while we waited.
+		id		  = metrics_find (name);
+		u32 count = sf_atomic_load_u32_relaxed (&pState->count);
+		if (id == INVALID_ID && count < METRICS_MAX) {
+			metric *entry	   = &pState->metrics[count];
+			entry->name		   = name;
+			entry->type		   = type;
+			entry->first_frame = sf_atomic_load_u64 (&pState->frame_number);
+			id				   = count;
+			sf_atomic_store_u32 (&pState->count, count + 1);
+		}
+		platform_mutex_unlock (&pState->register_lock);
+	}
+	if (id == INVALID_ID) {
+		// Logging counts its lines through here, warn only once so a full
+		// registry can't recurse.
+		if (!pState->warned_full) {
+			pState->warned_full = TRUE;
+			SF_WARNING ("Metrics registry is full, '%s' and later metrics "
+						"are not recorded.",
+						name);
+		}
+		return INVALID_ID;
+	}
+	if (pState->metrics[id].type != type) {
+		SF_WARNING ("Metric '%s' is already registered with another type.",
+					name);
+		return INVALID_ID;
+	}
+	return id;
+}
+
+static metric *get_metric (u32 id) {
+	if (!pState ||
+		id >= sf_atomic_load_u32 (&pState->count)) {
+		return SF_NULL;
+	}
+	return &pState->metrics[id];
+}
+
+void metrics_add (u32 id, u64 amount) {
+	metric *entry = get_metric (id);
+	if (!entry) { return; }
+	metrics_thread_slots *slots = get_thread_slots ();
+	if (!slots) {
+		sf_atomic_fetch_add_u64_relaxed (&entry->current, amount);
+		return;
+	}
+	sf_atomic_u64 *value = &slots->values[id];
+	sf_atomic_store_u64_relaxed (value,
+								 sf_atomic_load_u64_relaxed (value) + amount);
+}
+
+void metrics_set (u32 id, f64 value) {
+	metric *entry = get_metric (id);
+	if (!entry) { return; }
+	sf_atomic_store_u64_relaxed (&entry->current, f64_to_bits (value));
+}
+
+static u32 bucket_index (u64 value) {
+	return value ? 64 - __builtin_clzll (value) : 0;
+}
+
+static u64 bucket_upper_bound (u32 bucket) {
+	if (bucket == 0) { return 0; }
+	return bucket >= 64 ? ~0ull : (1ull << bucket) - 1;
+}
+
+void metrics_observe (u32 id, u64 value) {
+	metric *entry = get_metric (id);
+	if (!entry) { return; }
+	sf_atomic_fetch_add_u64_relaxed (&entry->buckets[bucket_index (value)], 1);
+	sf_atomic_fetch_add_u64_relaxed (&entry->current, value);
+}
+
+// Moves what each thread added since the last frame into the counters.
+static void collect_thread_slots (u32 count) {
+	u32 thread_count = sf_atomic_load_u32 (&pState->thread_count);
+	if (thread_count > METRICS_MAX_THREADS) {
+		thread_count = METRICS_MAX_THREADS;
+	}
+	for (u32 t = 0; t < thread_count; ++t) {
+		metrics_thread_slots *slots = &pState->threads[t];
+		u64 *seen					= pState->thread_seen[t];
+		for (u32 i = 0; i < count; ++i) {
+			u64 total = sf_atomic_load_u64_relaxed (&slots->values[i]);
+			if (total == seen[i]) { continue; }
+			if (pState->metrics[i].type != METRIC_TYPE_GAUGE) {
+				sf_atomic_fetch_add_u64_relaxed (&pState->metrics[i].current,
+												 total - seen[i]);
+			}
+			seen[i] = total;
+		}
+	}
+}
+
+void metrics_frame_end () {
+	if (!pState) { return; }
+	u32 count = sf_atomic_load_u32 (&pState->count);
+	u32 head  = pState->history_head;
+	collect_thread_slots (count);
+	for (u32 i = 0; i < count; ++i) {
+		metric *entry = &pState->metrics[i];
+		f64 value	  = 0;
+		if (entry->type == METRIC_TYPE_GAUGE) {
+			value =
+				bits_to_f64 (sf_atomic_load_u64_relaxed (&entry->current));
+			entry->total = value;
+		} else {
+			value = (f64)sf_atomic_exchange_u64_relaxed (&entry->current, 0);
+			entry->total += value;
+		}
+		entry->history[head] = value;
+	}
+	pState->history_head = (head + 1) % METRICS_HISTORY_FRAMES;
+	if (pState->history_count < METRICS_HISTORY_FRAMES) {
+		++pState->history_count;
+	}
+	sf_atomic_fetch_add_u64 (&pState->frame_number, 1);
+}
+
+u32 metrics_count () {
+	if (!pState) { return 0; }
+	return sf_atomic_load_u32 (&pState->count);
+}
+
+const char *metrics_get_name (u32 id) {
+	metric *entry = get_metric (id);
+	return entry ? entry->name : SF_NULL;
+}
+
+// Frames of history that were recorded after the metric was registered.
+static u32 history_frames (const metric *entry) {
+	u64 frames =
+		sf_atomic_load_u64 (&pState->frame_number) - entry->first_frame;
+	return frames < pState->history_count ? (u32)frames
+										  : pState->history_count;
+}
+
+static f64 history_value (const metric *entry, u32 frames, u32 index) {
+	u32 oldest = (pState->history_head + METRICS_HISTORY_FRAMES - frames) %
+				 METRICS_HISTORY_FRAMES;
+	return entry->history[(oldest + index) % METRICS_HISTORY_FRAMES];
+}
+
+static u64 histogram_percentile (const u64 *buckets, u64 total,
+								 u32 percent) {
+	u64 rank = (total * percent + 99) / 100;
+	if (rank == 0) { rank = 1; }
+	u64 seen = 0;
+	for (u32 i = 0; i < METRICS_HISTOGRAM_BUCKETS; ++i) {
+		seen += buckets[i];
+		if (seen >= rank) { return bucket_upper_bound (i); }
+	}
+	return bucket_upper_bound (METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+b8 metrics_get_summary (u32 id, metric_summary *out_summary) {
+	sfmemset (out_summary, 0, sizeof (metric_summary));
+	metric *entry = get_metric (id);
+	if (!entry) { return FALSE; }
+	out_summary->name		 = entry->name;
+	out_summary->type		 = entry->type;
+	out_summary->total		 = entry->total;
+	u32 frames				 = history_frames (entry);
+	out_summary->frame_count = frames;
+	if (frames) {
+		f64 sum			 = 0;
+		out_summary->min = history_value (entry, frames, 0);
+		out_summary->max = out_summary->min;
+		for (u32 i = 0; i < frames; ++i) {
+			f64 value = history_value (entry, frames, i);
+			if (value < out_summary->min) { out_summary->min = value; }
+			if (value > out_summary->max) { out_summary->max = value; }
+			sum += value;
+		}
+		out_summary->avg  = sum / frames;
+		out_summary->last = history_value (entry, frames, frames - 1);
+	}
+	if (entry->type == METRIC_TYPE_HISTOGRAM) {
+		u64 buckets[METRICS_HISTOGRAM_BUCKETS];
+		u64 samples = 0;
+		for (u32 i = 0; i < METRICS_HISTOGRAM_BUCKETS; ++i) {
+			buckets[i] = sf_atomic_load_u64_relaxed (&entry->buckets[i]);
+			samples += buckets[i];
+		}
+		out_summary->sample_count = samples;
+		if (samples) {
+			out_summary->p50 = histogram_percentile (buckets, samples, 50);
+			out_summary->p95 = histogram_percentile (buckets, samples, 95);
+			out_summary->p99 = histogram_percentile (buckets, samples, 99);
+		}
+	}
+	return TRUE;
+}
+
+u32 metrics_get_history (u32 id, f64 *out_values, u32 max_count) {
+	metric *entry = get_metric (id);
+	if (!entry) { return 0; }
+	u32 frames = history_frames (entry);
+	u32 count  = frames < max_count ? frames : max_count;
+	// Keep the most recent ones when out_values is too small.
+	for (u32 i = 0; i < count; ++i) {
+		out_values[i] = history_value (entry, frames, frames - count + i);
+	}
+	return count;
+}
+
+b8 metrics_write_csv (const char *path) {
+	if (!pState) { return FALSE; }
+	file_handle file;
+	if (!filesystem_open (path, FILE_MODE_WRITE, FALSE, &file)) {
+		SF_ERROR ("Failed to open '%s' for the metrics dump.", path);
+		return FALSE;
+	}
+	char line[METRICS_CSV_LINE_LENGTH];
+	u32 count  = metrics_count ();
+	u32 frames = pState->history_count;
+	u64 length = snprintf (line, sizeof (line), "frame");
+	for (u32 i = 0; i < count && length < sizeof (line); ++i) {
+		length += snprintf (line + length, sizeof (line) - length, ",%s",
+							pState->metrics[i].name);
+	}
+	b8 success = filesystem_write_line (&file, line);
+
+	u64 first_frame = sf_atomic_load_u64 (&pState->frame_number) - frames;
+	for (u32 frame = 0; frame < frames && success; ++frame) {
+		length = snprintf (line, sizeof (line), "%llu", first_frame + frame);
+		for (u32 i = 0; i < count && length < sizeof (line); ++i) {
+			const metric *entry = &pState->metrics[i];
+			// Frames before the metric existed are left empty.
+			if (first_frame + frame < entry->first_frame) {
+				length += snprintf (line + length, sizeof (line) - length, ",");
+				continue;
+			}
+			length +=
+				snprintf (line + length, sizeof (line) - length, ",%.15g",
+						  history_value (entry, frames, frame));
+		}
+		success = filesystem_write_line (&file, line);
+	}
+	filesystem_close (&file);
+	if (!success) { SF_ERROR ("Failed to write the metrics to '%s'.", path); }
+	return success;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "defines.h"
+
+// Named per-frame work counts. Metrics are registered once by name and
+// updated with atomics from any thread. metrics_frame_end snapshots every
+// metric into a ring of the last METRICS_HISTORY_FRAMES frames, which game
+// code can query or dump as CSV.
+
+// Distinct metrics the registry holds.
+#define METRICS_MAX 64
+// Threads with their own counter slots, later threads share one atomic.
+#define METRICS_MAX_THREADS 64
+// Frames of history kept per metric.
+#define METRICS_HISTORY_FRAMES 256
+// Histograms bucket samples by bit length, bucket i holds [2^(i-1), 2^i).
+#define METRICS_HISTOGRAM_BUCKETS 65
+
+typedef enum metric_type {
+	// Summed during a frame, the history holds the per-frame sum.
+	METRIC_TYPE_COUNTER,
+	// Last value set, the history holds its value at the end of each frame.
+	METRIC_TYPE_GAUGE,
+	// Distribution of samples. The history holds the per-frame sum of the
+	// samples, so a histogram of sizes doubles as a per-frame total.
+	METRIC_TYPE_HISTOGRAM,
+	METRIC_TYPE_MAX
+} metric_type;
+
+typedef struct metric_summary {
+	const char* name;
+	metric_type type;
+	// Frames in the history the values below are computed from.
+	u32 frame_count;
+	f64 last;
+	f64 min;
+	f64 avg;
+	f64 max;
+	// Lifetime sum for counters and histograms, current value for gauges.
+	f64 total;
+	// Histograms only: lifetime sample count and percentiles, as the upper
+	// bound of the bucket the percentile falls into.
+	u64 sample_count;
+	u64 p50;
+	u64 p95;
+	u64 p99;
+} metric_summary;
+
+/**
+* @brief Initializes the metrics registry. If memory is NULL, will populate mem_size.
+* @param mem_size Holds the required memory size of the internal state.
+* @param memory NULL if requesting memory size, otherwise allocated block of memory.
+* @return TRUE on success; otherwise FALSE.
+*/
+b8 metrics_initialize (u64* mem_size, void* memory);
+
+/**
+* @brief Shuts the registry down. Updates made afterwards are ignored.
+* @param memory Pointer to the memory
+*/
+void metrics_shutdown (void* memory);
+
+/**
+* @brief Registers a metric, or finds it if the name is already registered with the same type. Takes a lock, resolve ids once rather than per update.
+* @param name A string literal, only the pointer is stored.
+* @param type The kind of metric.
+* @return The id of the metric, INVALID_ID if the registry is full, not initialized or the name is registered with another type.
+*/
+SAPI u32 metrics_register (const char* name, metric_type type);
+
+/**
+* @return The id of a registered metric, INVALID_ID if there is none.
+*/
+SAPI u32 metrics_find (const char* name);
+
+/**
+* @brief Adds to a counter. Lock-free, callable from any thread. Adds go to the calling thread's slot and are summed by metrics_frame_end. Ignores INVALID_ID.
+*/
+SAPI void metrics_add (u32 id, u64 amount);
+
+/**
+* @brief Sets a gauge. Lock-free, callable from any thread. Ignores INVALID_ID.
+*/
+SAPI void metrics_set (u32 id, f64 value);
+
+/**
+* @brief Records a histogram sample. Lock-free, callable from any thread. Ignores INVALID_ID.
+*/
+SAPI void metrics_observe (u32 id, u64 value);
+
+/**
+* @brief Moves the values of the current frame into the history. Called by the application once per frame; the query functions must run on the same thread.
+*/
+SAPI void metrics_frame_end ();
+
+/**
+* @return The number of registered metrics, ids are 0 to the count minus one.
+*/
+SAPI u32 metrics_count ();
+
+/**
+* @return The name a metric was registered with, NULL if id is invalid.
+*/
+SAPI const char* metrics_get_name (u32 id);
+
+/**
+* @brief Summarizes a metric over the frames in its history.
+* @param id The metric.
+* @param out_summary Receives the summary, zeroed if id is invalid.
+* @return TRUE if id names a metric; otherwise FALSE.
+*/
+SAPI b8 metrics_get_summary (u32 id, metric_summary* out_summary);
+
+/**
+* @brief Copies the most recent per-frame values of a metric, oldest first.
+* @param id The metric.
+* @param out_values Receives the values.
+* @param max_count Capacity of out_values.
+* @return The number of values written.
+*/
+SAPI u32 metrics_get_history (u32 id, f64* out_values, u32 max_count);
+
+/**
+* @brief Writes the history of every metric as CSV, one row per frame and one column per metric.
+* @param path The file to write.
+* @return TRUE on success; otherwise FALSE.
+*/
+SAPI b8 metrics_write_csv (const char* path);
+
+// Resolves the id once per call site and thread, then updates lock-free.
+#define SF_METRIC_UPDATE(update, name, type, value)                            \
+	do {                                                                       \
+		static _Thread_local u32 sf_metric_id = INVALID_ID;                    \
+		if (sf_metric_id == INVALID_ID) {                                      \
+			sf_metric_id = metrics_register (name, type);                      \
+		}                                                                      \
+		update (sf_metric_id, value);                                          \
+	} while (0)
+
+#define SF_METRIC_COUNT(name, amount)                                          \
+	SF_METRIC_UPDATE (metrics_add, name, METRIC_TYPE_COUNTER, amount)
+#define SF_METRIC_GAUGE(name, value)                                           \
+	SF_METRIC_UPDATE (metrics_set, name, METRIC_TYPE_GAUGE, value)
+#define SF_METRIC_OBSERVE(name, value)                                         \
+	SF_METRIC_UPDATE (metrics_observe, name, METRIC_TYPE_HISTOGRAM, value)
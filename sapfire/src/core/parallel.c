@@ -0,0 +1,113 @@
+#include "parallel.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+
+typedef struct parallel_chunk {
+	u64 begin;
+	u64 end;
+	PFN_parallel_for fn;
+	PFN_parallel_reduce reduce;
+	void *context;
+	void *partial;
+} parallel_chunk;
+
+// One partial per cache line, so chunks on different cores don't fight over
+// the lines they write their results to.
+typedef struct parallel_partial {
+	_Alignas (PARALLEL_MAX_RESULT_SIZE) u8 data[PARALLEL_MAX_RESULT_SIZE];
+} parallel_partial;
+
+static u64 pick_grain (u64 count, u64 grain) {
+	if (grain == 0) {
+		u64 target	  = (u64)job_worker_count () * PARALLEL_CHUNKS_PER_WORKER;
+		grain		  = (count + target - 1) / target;
+		u64 remainder = grain % PARALLEL_GRAIN_ALIGNMENT;
+		if (remainder) { grain += PARALLEL_GRAIN_ALIGNMENT - remainder; }
+	}
+	u64 min_grain = (count + PARALLEL_MAX_CHUNKS - 1) / PARALLEL_MAX_CHUNKS;
+	if (grain < min_grain) { grain = min_grain; }
+	return grain ? grain : 1;
+}
+
+static void run_chunk (void *params) {
+	parallel_chunk *chunk = params;
+	if (chunk->fn) {
+		chunk->fn (chunk->begin, chunk->end, chunk->context);
+	} else {
+		chunk->reduce (chunk->begin, chunk->end, chunk->context,
+					   chunk->partial);
+	}
+}
+
+// Kicks every chunk but the first, runs that one here and waits for the rest.
+static void run_chunks (parallel_chunk *chunks, u32 chunk_count) {
+	job_decl jobs[PARALLEL_MAX_CHUNKS];
+	for (u32 i = 1; i < chunk_count; ++i) {
+		jobs[i].entry	 = run_chunk;
+		jobs[i].params	 = &chunks[i];
+		jobs[i].name	 = "parallel_chunk";
+		jobs[i].waitable = FALSE;
+	}
+	job_counter counter = {0};
+	job_run (&jobs[1], chunk_count - 1, &counter);
+	run_chunk (&chunks[0]);
+	job_wait_for_counter (&counter, 0);
+}
+
+static u32 split (u64 count, u64 grain, parallel_chunk *chunks,
+				  PFN_parallel_for fn, PFN_parallel_reduce reduce,
+				  void *context) {
+	u32 chunk_count = 0;
+	for (u64 begin = 0; begin < count; begin += grain) {
+		parallel_chunk *chunk = &chunks[chunk_count++];
+		chunk->begin		  = begin;
+		chunk->end			  = begin + grain < count ? begin + grain : count;
+		chunk->fn			  = fn;
+		chunk->reduce		  = reduce;
+		chunk->context		  = context;
+		chunk->partial		  = SF_NULL;
+	}
+	return chunk_count;
+}
+
+void parallel_for (u64 count, u64 grain, PFN_parallel_for fn, void *context) {
+	if (count == 0) { return; }
+	grain = pick_grain (count, grain);
+	if (grain >= count || job_worker_count () == 1) {
+		fn (0, count, context);
+		return;
+	}
+	parallel_chunk chunks[PARALLEL_MAX_CHUNKS];
+	u32 chunk_count = split (count, grain, chunks, fn, SF_NULL, context);
+	run_chunks (chunks, chunk_count);
+}
+
+b8 parallel_reduce (u64 count, u64 grain, PFN_parallel_reduce reduce,
+					PFN_parallel_combine combine, void *context,
+					u64 result_size, const void *identity, void *out_result) {
+	if (result_size > PARALLEL_MAX_RESULT_SIZE) {
+		SF_ERROR ("parallel_reduce results are limited to %u bytes.",
+				  PARALLEL_MAX_RESULT_SIZE);
+		return FALSE;
+	}
+	sfmemcpy (out_result, identity, result_size);
+	if (count == 0) { return TRUE; }
+	grain = pick_grain (count, grain);
+	if (grain >= count || job_worker_count () == 1) {
+		reduce (0, count, context, out_result);
+		return TRUE;
+	}
+	parallel_chunk chunks[PARALLEL_MAX_CHUNKS];
+	parallel_partial partials[PARALLEL_MAX_CHUNKS];
+	u32 chunk_count = split (count, grain, chunks, SF_NULL, reduce, context);
+	for (u32 i = 0; i < chunk_count; ++i) {
+		sfmemcpy (partials[i].data, identity, result_size);
+		chunks[i].partial = partials[i].data;
+	}
+	run_chunks (chunks, chunk_count);
+	for (u32 i = 0; i < chunk_count; ++i) {
+		combine (out_result, partials[i].data, context);
+	}
+	return TRUE;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "defines.h"
+
+// Data-parallel loops over index ranges, run as jobs on the job system. The
+// range is cut into chunks of grain indices; the calling thread runs the
+// first chunk and helps with the rest until all are done. Without a running
+// job system, or from a thread outside it, everything runs on the caller.
+
+// Chunks a loop is cut into at most, larger grains are used beyond that.
+// The chunk bookkeeping lives on the caller's stack, which may be a fiber's.
+#define PARALLEL_MAX_CHUNKS 64
+// Chunks per worker when the grain is picked automatically, enough for
+// stealing to even out uneven chunks.
+#define PARALLEL_CHUNKS_PER_WORKER 4
+// Automatic grains are a multiple of this, so chunks of arrays of 4-byte or
+// larger elements start on a fresh cache line and don't share one.
+#define PARALLEL_GRAIN_ALIGNMENT 16
+// Largest partial result parallel_reduce handles, one cache line.
+#define PARALLEL_MAX_RESULT_SIZE 64
+
+// Processes indices [begin, end).
+typedef void (*PFN_parallel_for) (u64 begin, u64 end, void* context);
+
+// Reduces indices [begin, end) into out_partial, which starts as a copy of
+// the identity.
+typedef void (*PFN_parallel_reduce) (u64 begin, u64 end, void* context,
+									 void* out_partial);
+
+// Folds partial into accumulator.
+typedef void (*PFN_parallel_combine) (void* accumulator, const void* partial,
+									  void* context);
+
+/**
+* @brief Calls fn over [0, count) in parallel chunks and returns once all of them ran.
+* @param count Number of indices.
+* @param grain Indices per chunk, 0 to pick one from the worker count. Pass one when items are cheap enough that a few thousand are needed to pay for a job.
+* @param fn Called once per chunk, from any worker.
+* @param context Passed as-is to fn.
+*/
+SAPI void parallel_for (u64 count, u64 grain, PFN_parallel_for fn,
+						void* context);
+
+/**
+* @brief Reduces [0, count) in parallel chunks. Partials are combined in index order, so the result is the same on every run for any combine.
+* @param count Number of indices.
+* @param grain Indices per chunk, 0 to pick one from the worker count.
+* @param reduce Called once per chunk, from any worker.
+* @param combine Called on the calling thread to fold each partial into the result.
+* @param context Passed as-is to reduce and combine.
+* @param result_size Size of a result, at most PARALLEL_MAX_RESULT_SIZE.
+* @param identity The value every partial and the result start from.
+* @param out_result Receives the result.
+* @return FALSE if result_size is too large; otherwise TRUE.
+*/
+SAPI b8 parallel_reduce (u64 count, u64 grain, PFN_parallel_reduce reduce,
+						 PFN_parallel_combine combine, void* context,
+						 u64 result_size, const void* identity,
+						 void* out_result);
@@ -0,0 +1,534 @@
+#include "profiler.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "platform/atomic.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "platform/thread.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define PROFILER_WRITE_CHUNK (64 * 1024)
+
+// Written only by its owning thread. write_pos is published with release
+// so the exporter can read the ring without locking.
+typedef struct profiler_thread_buffer {
+	struct profiler_thread_buffer *next;
+	u32 thread_index;
+	_Atomic u64 write_pos;
+	profiler_event events[PROFILER_EVENTS_PER_THREAD];
+} profiler_thread_buffer;
+
+typedef struct profiler_counter_zone {
+	profiler_counter_stats stats;
+	// Accumulated by every thread until the next frame mark.
+	sf_atomic_u64 frame_calls;
+	sf_atomic_u64 frame[PERF_COUNTER_MAX];
+} profiler_counter_zone;
+
+typedef struct profiler_counter_scope {
+	u32 zone;
+	perf_counter_sample start;
+} profiler_counter_scope;
+
+// Hardware counters are per thread, each thread opens its own group the first
+// time it enters an SF_PROFILE_COUNTERS zone. Only the owner reads the group
+// and the stack.
+typedef struct profiler_thread_counters {
+	struct profiler_thread_counters *next;
+	perf_counter_group group;
+	u32 depth;
+	profiler_counter_scope stack[PROFILER_MAX_COUNTER_DEPTH];
+} profiler_thread_counters;
+
+typedef struct profiler_state {
+	// Bumped on every initialize so buffers cached by threads from an
+	// earlier run are not reused.
+	u32 generation;
+	u64 start_time_ns;
+	_Atomic u32 thread_count;
+	_Atomic(profiler_thread_buffer *) buffers;
+
+	// Counter zones are shared by all threads, each adds its deltas to the
+	// zone's frame totals. The thread that initialized the profiler rolls
+	// them over on its frame marks and is the only one reading stats.
+	u64 counter_thread_id;
+	// Counters the initializing thread could open, 0 disables them on all
+	// threads.
+	u32 counters_available;
+	sf_atomic_ptr thread_counters;
+	// Taken to add a zone, lookups only load counter_zone_count.
+	sf_mutex counter_zone_lock;
+	sf_atomic_u32 counter_zone_count;
+	profiler_counter_zone counter_zones[PROFILER_MAX_COUNTER_ZONES];
+} profiler_state;
+
+static profiler_state *pState;
+static u32 next_generation = 1;
+
+static _Thread_local profiler_thread_buffer *thread_buffer;
+static _Thread_local u32 thread_generation;
+static _Thread_local profiler_thread_counters *thread_counters;
+static _Thread_local u32 thread_counters_generation;
+
+static profiler_thread_counters *get_thread_counters () {
+	if (thread_counters && thread_counters_generation == pState->generation) {
+		return thread_counters;
+	}
+	profiler_thread_counters *counters =
+		sfalloc (sizeof (profiler_thread_counters), MEMORY_TAG_PROFILER);
+	sfmemset (counters, 0, sizeof (profiler_thread_counters));
+	// Failing to open leaves internal_data NULL, the thread's counter zones
+	// are plain zones then.
+	platform_perf_counters_open (&counters->group);
+	void *head = sf_atomic_load_ptr (&pState->thread_counters);
+	do {
+		counters->next = head;
+	} while (!sf_atomic_compare_exchange_ptr (&pState->thread_counters, &head,
+											  counters));
+	thread_counters			   = counters;
+	thread_counters_generation = pState->generation;
+	return counters;
+}
+
+b8 profiler_initialize (u64 *mem_size, void *memory) {
+	*mem_size = sizeof (profiler_state);
+	if (memory == SF_NULL) { return FALSE; }
+	profiler_state *state = memory;
+	sfmemset (state, 0, sizeof (profiler_state));
+	state->generation	 = next_generation++;
+	state->start_time_ns = platform_get_absolute_time_ns ();
+	atomic_init (&state->thread_count, 0);
+	atomic_init (&state->buffers, SF_NULL);
+	state->counter_thread_id = platform_thread_current_id ();
+	sf_atomic_init_ptr (&state->thread_counters, SF_NULL);
+	sf_atomic_init_u32 (&state->counter_zone_count, 0);
+	platform_mutex_create (&state->counter_zone_lock);
+	pState = state;
+	// Failing to open the counters only disables SF_PROFILE_COUNTERS.
+	state->counters_available = get_thread_counters ()->group.available_mask;
+	SF_INFO ("Profiler initialized successfully.");
+	return TRUE;
+}
+
+static void log_counter_stats () {
+	u32 zone_count = sf_atomic_load_u32 (&pState->counter_zone_count);
+	for (u32 i = 0; i < zone_count; ++i) {
+		const profiler_counter_stats *stats = &pState->counter_zones[i].stats;
+		if (stats->frames == 0) { continue; }
+		const u64 *totals	  = stats->totals;
+		f64 instructions	  = totals[PERF_COUNTER_INSTRUCTIONS];
+		f64 kilo_instructions = instructions / 1000.0;
+		SF_INFO ("%s: %.1f calls and %.0f instructions per frame, IPC %.2f, "
+				 "%.2f cache and %.2f branch misses per 1k instructions.",
+				 stats->name, (f64)stats->calls / stats->frames,
+				 instructions / stats->frames,
+				 totals[PERF_COUNTER_CYCLES]
+					 ? instructions / totals[PERF_COUNTER_CYCLES]
+					 : 0,
+				 kilo_instructions
+					 ? totals[PERF_COUNTER_CACHE_MISSES] / kilo_instructions
+					 : 0,
+				 kilo_instructions
+					 ? totals[PERF_COUNTER_BRANCH_MISSES] / kilo_instructions
+					 : 0);
+	}
+}
+
+void profiler_shutdown (void *memory) {
+	if (!pState) { return; }
+	if (pState->counters_available) { log_counter_stats (); }
+	platform_mutex_destroy (&pState->counter_zone_lock);
+	// Threads that entered a counter zone may be gone by now, closing the
+	// counters only needs their file descriptors.
+	profiler_thread_counters *counters =
+		sf_atomic_load_ptr (&pState->thread_counters);
+	while (counters) {
+		profiler_thread_counters *next = counters->next;
+		platform_perf_counters_close (&counters->group);
+		sffree (counters, sizeof (profiler_thread_counters),
+				MEMORY_TAG_PROFILER);
+		counters = next;
+	}
+	profiler_thread_buffer *buffer = atomic_load (&pState->buffers);
+	pState						   = SF_NULL;
+	while (buffer) {
+		profiler_thread_buffer *next = buffer->next;
+		sffree (buffer, sizeof (profiler_thread_buffer), MEMORY_TAG_PROFILER);
+		buffer = next;
+	}
+}
+
+static profiler_thread_buffer *get_thread_buffer () {
+	if (thread_buffer && thread_generation == pState->generation) {
+		return thread_buffer;
+	}
+	profiler_thread_buffer *buffer =
+		sfalloc (sizeof (profiler_thread_buffer), MEMORY_TAG_PROFILER);
+	buffer->thread_index = atomic_fetch_add (&pState->thread_count, 1);
+	atomic_init (&buffer->write_pos, 0);
+	// Push onto the list of buffers, exporters only ever walk it.
+	profiler_thread_buffer *head = atomic_load (&pState->buffers);
+	do {
+		buffer->next = head;
+	} while (!atomic_compare_exchange_weak (&pState->buffers, &head, buffer));
+	thread_buffer	  = buffer;
+	thread_generation = pState->generation;
+	return buffer;
+}
+
+static void record (const char *name, profiler_event_type type, f64 value) {
+	if (!pState) { return; }
+	profiler_thread_buffer *buffer = get_thread_buffer ();
+	u64 pos = atomic_load_explicit (&buffer->write_pos, memory_order_relaxed);
+	profiler_event *event =
+		&buffer->events[pos & (PROFILER_EVENTS_PER_THREAD - 1)];
+	event->name			= name;
+	event->timestamp_ns = platform_get_absolute_time_ns ();
+	event->value		= value;
+	event->type			= type;
+	atomic_store_explicit (&buffer->write_pos, pos + 1, memory_order_release);
+}
+
+u8 profiler_zone_begin (const char *name) {
+	record (name, PROFILER_EVENT_BEGIN, 0);
+	return 0;
+}
+
+void profiler_zone_end () { record (SF_NULL, PROFILER_EVENT_END, 0); }
+
+void profiler_value (const char *name, f64 value) {
+	record (name, PROFILER_EVENT_VALUE, value);
+}
+
+void profiler_zone_cleanup (u8 *zone) { profiler_zone_end (); }
+
+// Zones entered by other threads during the frame are counted in the frame
+// they end in.
+static void roll_counter_frame () {
+	u32 zone_count = sf_atomic_load_u32 (&pState->counter_zone_count);
+	for (u32 i = 0; i < zone_count; ++i) {
+		profiler_counter_zone *zone = &pState->counter_zones[i];
+		u64 calls = sf_atomic_exchange_u64 (&zone->frame_calls, 0);
+		if (calls == 0) { continue; }
+		profiler_counter_stats *stats = &zone->stats;
+		++stats->frames;
+		stats->calls += calls;
+		stats->last_frame_calls = calls;
+		for (u32 j = 0; j < PERF_COUNTER_MAX; ++j) {
+			u64 value = sf_atomic_exchange_u64 (&zone->frame[j], 0);
+			stats->totals[j] += value;
+			stats->last_frame[j] = value;
+		}
+	}
+}
+
+void profiler_frame_mark () {
+	record ("Frame", PROFILER_EVENT_FRAME, 0);
+	if (pState && pState->counters_available &&
+		platform_thread_current_id () == pState->counter_thread_id) {
+		roll_counter_frame ();
+	}
+}
+
+static u32 scan_counter_zones (const char *name, u32 begin, u32 end) {
+	for (u32 i = begin; i < end; ++i) {
+		const char *zone_name = pState->counter_zones[i].stats.name;
+		if (zone_name == name || sfstreq (zone_name, name)) { return i; }
+	}
+	return INVALID_ID;
+}
+
+static u32 find_counter_zone (const char *name) {
+	u32 count = sf_atomic_load_u32 (&pState->counter_zone_count);
+	u32 index = scan_counter_zones (name, 0, count);
+	if (index != INVALID_ID) { return index; }
+	platform_mutex_lock (&pState->counter_zone_lock);
+	// Another thread may have added it since.
+	u32 locked_count = sf_atomic_load_u32 (&pState->counter_zone_count);
+	index			 = scan_counter_zones (name, count, locked_count);
+	if (index == INVALID_ID && locked_count < PROFILER_MAX_COUNTER_ZONES) {
+		index									= locked_count;
+		pState->counter_zones[index].stats.name = name;
+		// Publishes the name to lookups on other threads.
+		sf_atomic_store_u32 (&pState->counter_zone_count, locked_count + 1);
+	}
+	platform_mutex_unlock (&pState->counter_zone_lock);
+	return index;
+}
+
+u8 profiler_counter_zone_begin (const char *name) {
+	profiler_zone_begin (name);
+	if (!pState || !pState->counters_available) { return 0; }
+	profiler_thread_counters *counters = get_thread_counters ();
+	if (!counters->group.internal_data ||
+		counters->depth == PROFILER_MAX_COUNTER_DEPTH) {
+		return 0;
+	}
+	profiler_counter_scope *scope = &counters->stack[counters->depth++];
+	scope->zone					  = find_counter_zone (name);
+	// Read last so the bookkeeping above isn't counted.
+	platform_perf_counters_read (&counters->group, &scope->start);
+	return 1;
+}
+
+void profiler_counter_zone_cleanup (u8 *zone) {
+	profiler_thread_counters *counters = thread_counters;
+	if (*zone && pState && counters && counters->depth) {
+		perf_counter_sample end;
+		platform_perf_counters_read (&counters->group, &end);
+		profiler_counter_scope *scope = &counters->stack[--counters->depth];
+		if (scope->zone != INVALID_ID) {
+			profiler_counter_zone *counter =
+				&pState->counter_zones[scope->zone];
+			sf_atomic_fetch_add_u64_relaxed (&counter->frame_calls, 1);
+			for (u32 i = 0; i < PERF_COUNTER_MAX; ++i) {
+				sf_atomic_fetch_add_u64_relaxed (
+					&counter->frame[i], end.values[i] - scope->start.values[i]);
+			}
+		}
+	}
+	profiler_zone_end ();
+}
+
+u32 profiler_counters_available () {
+	return pState ? pState->counters_available : 0;
+}
+
+u32 profiler_get_counter_stats (profiler_counter_stats *out_stats,
+								u32 max_count) {
+	if (!pState || !pState->counters_available) { return 0; }
+	u32 zone_count = sf_atomic_load_u32 (&pState->counter_zone_count);
+	u32 count	   = 0;
+	for (u32 i = 0; i < zone_count && count < max_count; ++i) {
+		out_stats[count++] = pState->counter_zones[i].stats;
+	}
+	return count;
+}
+
+typedef struct trace_writer {
+	file_handle file;
+	char buffer[PROFILER_WRITE_CHUNK];
+	u64 length;
+	b8 first_event;
+	b8 failed;
+} trace_writer;
+
+static void writer_flush (trace_writer *writer) {
+	u64 written = 0;
+	if (writer->length &&
+		!filesystem_write (&writer->file, writer->length, writer->buffer,
+						   &written)) {
+		writer->failed = TRUE;
+	}
+	writer->length = 0;
+}
+
+// Formats into the chunk, flushing first if the entry might not fit.
+#define WRITER_APPEND(writer, ...)                                             \
+	do {                                                                       \
+		if ((writer)->length + 512 > PROFILER_WRITE_CHUNK) {                   \
+			writer_flush (writer);                                             \
+		}                                                                      \
+		(writer)->length += snprintf ((writer)->buffer + (writer)->length,    \
+									  PROFILER_WRITE_CHUNK - (writer)->length, \
+									  __VA_ARGS__);                            \
+	} while (0)
+
+static void write_event (trace_writer *writer, const profiler_event *event,
+						 const char *name, u32 tid) {
+	static const char phases[] = {'B', 'E', 'i', 'C'};
+	f64 ts_us = (event->timestamp_ns - pState->start_time_ns) / 1000.0;
+	WRITER_APPEND (writer, "%s{\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+				   writer->first_event ? "\n" : ",\n", phases[event->type],
+				   ts_us, tid);
+	writer->first_event = FALSE;
+	if (event->type == PROFILER_EVENT_FRAME) {
+		WRITER_APPEND (writer, ",\"s\":\"g\"");
+	}
+	if (name) {
+		WRITER_APPEND (writer, ",\"name\":\"");
+		// Names are literals, but keep the JSON valid whatever they are.
+		for (const char *c = name;
+			 *c && writer->length + 8 < PROFILER_WRITE_CHUNK; ++c) {
+			if (*c == '"' || *c == '\\') {
+				writer->buffer[writer->length++] = '\\';
+			}
+			writer->buffer[writer->length++] = (u8)*c < 0x20 ? ' ' : *c;
+		}
+		WRITER_APPEND (writer, "\"");
+	}
+	if (event->type == PROFILER_EVENT_VALUE) {
+		WRITER_APPEND (writer, ",\"args\":{\"value\":%.17g}", event->value);
+	}
+	WRITER_APPEND (writer, "}");
+}
+
+b8 profiler_export_chrome_trace (const char *path) {
+	if (!pState) { return FALSE; }
+	trace_writer *writer =
+		sfalloc (sizeof (trace_writer), MEMORY_TAG_PROFILER);
+	if (!filesystem_open (path, FILE_MODE_WRITE, FALSE, &writer->file)) {
+		SF_ERROR ("Failed to open '%s' for the profiler capture.", path);
+		sffree (writer, sizeof (trace_writer), MEMORY_TAG_PROFILER);
+		return FALSE;
+	}
+	writer->first_event = TRUE;
+	WRITER_APPEND (writer, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	u64 event_count = 0;
+	for (profiler_thread_buffer *buffer = atomic_load (&pState->buffers);
+		 buffer; buffer = buffer->next) {
+		u32 tid = buffer->thread_index + 1;
+		WRITER_APPEND (writer,
+					   "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+					   "\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+					   writer->first_event ? "\n" : ",\n", tid, tid);
+		writer->first_event = FALSE;
+
+		u64 end =
+			atomic_load_explicit (&buffer->write_pos, memory_order_acquire);
+		u64 begin = end > PROFILER_EVENTS_PER_THREAD
+						? end - PROFILER_EVENTS_PER_THREAD
+						: 0;
+		// End events are written without a name; pair them up with their
+		// begin so the output reads well, and drop ends whose begin was
+		// already overwritten.
+		const char *stack[64];
+		u32 depth = 0;
+		for (u64 pos = begin; pos < end; ++pos) {
+			profiler_event event =
+				buffer->events[pos & (PROFILER_EVENTS_PER_THREAD - 1)];
+			// The owner may have lapped us while copying, skip what it
+			// overwrote.
+			atomic_thread_fence (memory_order_acquire);
+			u64 now = atomic_load_explicit (&buffer->write_pos,
+											memory_order_relaxed);
+			if (now - pos >= PROFILER_EVENTS_PER_THREAD) { continue; }
+			const char *name = event.name;
+			if (event.type == PROFILER_EVENT_BEGIN) {
+				if (depth < 64) { stack[depth] = event.name; }
+				++depth;
+			} else if (event.type == PROFILER_EVENT_END) {
+				if (depth == 0) { continue; }
+				--depth;
+				name = depth < 64 ? stack[depth] : SF_NULL;
+			}
+			write_event (writer, &event, name, tid);
+			++event_count;
+		}
+	}
+	WRITER_APPEND (writer, "\n]}\n");
+	writer_flush (writer);
+	filesystem_close (&writer->file);
+	b8 success = !writer->failed;
+	sffree (writer, sizeof (trace_writer), MEMORY_TAG_PROFILER);
+	if (success) {
+		SF_INFO ("Wrote %llu profiler events to '%s'.", event_count, path);
+	} else {
+		SF_ERROR ("Failed to write the profiler capture to '%s'.", path);
+	}
+	return success;
+}
+
+static void add_zone_sample (profiler_zone_stats *stats, u32 *count,
+							 u32 max_count, const char *name, u64 duration) {
+	profiler_zone_stats *zone = SF_NULL;
+	for (u32 i = 0; i < *count; ++i) {
+		// The same literal can live at different addresses per translation
+		// unit.
+		if (stats[i].name == name || sfstreq (stats[i].name, name)) {
+			zone = &stats[i];
+			break;
+		}
+	}
+	if (!zone) {
+		if (*count == max_count) { return; }
+		zone				 = &stats[(*count)++];
+		zone->name			 = name;
+		zone->count			 = 0;
+		zone->total_ns		 = 0;
+		zone->min_ns		 = duration;
+		zone->max_ns		 = duration;
+		zone->sum_squares_ns = 0;
+	}
+	++zone->count;
+	zone->total_ns += duration;
+	zone->sum_squares_ns += (f64)duration * duration;
+	if (duration < zone->min_ns) { zone->min_ns = duration; }
+	if (duration > zone->max_ns) { zone->max_ns = duration; }
+}
+
+u32 profiler_get_zone_stats (profiler_zone_stats *out_stats, u32 max_count) {
+	if (!pState) { return 0; }
+	u32 count = 0;
+	for (profiler_thread_buffer *buffer = atomic_load (&pState->buffers);
+		 buffer; buffer = buffer->next) {
+		u64 end =
+			atomic_load_explicit (&buffer->write_pos, memory_order_acquire);
+		u64 begin = end > PROFILER_EVENTS_PER_THREAD
+						? end - PROFILER_EVENTS_PER_THREAD
+						: 0;
+		profiler_event stack[64];
+		u32 depth = 0;
+		for (u64 pos = begin; pos < end; ++pos) {
+			profiler_event event =
+				buffer->events[pos & (PROFILER_EVENTS_PER_THREAD - 1)];
+			// Same as the export, skip what the owner overwrote meanwhile.
+			atomic_thread_fence (memory_order_acquire);
+			u64 now = atomic_load_explicit (&buffer->write_pos,
+											memory_order_relaxed);
+			if (now - pos >= PROFILER_EVENTS_PER_THREAD) { continue; }
+			if (event.type == PROFILER_EVENT_BEGIN) {
+				if (depth < 64) { stack[depth] = event; }
+				++depth;
+			} else if (event.type == PROFILER_EVENT_END) {
+				if (depth == 0) { continue; }
+				--depth;
+				if (depth >= 64) { continue; }
+				add_zone_sample (
+					out_stats, &count, max_count, stack[depth].name,
+					event.timestamp_ns - stack[depth].timestamp_ns);
+			}
+		}
+	}
+	return count;
+}
+
+u64 profiler_stream_events (profiler_stream_cursor *cursor,
+							PFN_profiler_event_sink sink, void *user_data) {
+	if (!pState) { return 0; }
+	u64 delivered = 0;
+	for (profiler_thread_buffer *buffer = atomic_load (&pState->buffers);
+		 buffer; buffer = buffer->next) {
+		u32 thread = buffer->thread_index;
+		if (thread >= PROFILER_STREAM_MAX_THREADS) { continue; }
+		u64 end =
+			atomic_load_explicit (&buffer->write_pos, memory_order_acquire);
+		u64 pos = cursor->read_pos[thread];
+		if (end - pos > PROFILER_EVENTS_PER_THREAD) {
+			// A thread seen for the first time just starts at its oldest
+			// event, otherwise the reader fell behind.
+			if (pos) {
+				cursor->dropped += end - PROFILER_EVENTS_PER_THREAD - pos;
+			}
+			pos = end - PROFILER_EVENTS_PER_THREAD;
+		}
+		for (; pos < end; ++pos) {
+			profiler_event event =
+				buffer->events[pos & (PROFILER_EVENTS_PER_THREAD - 1)];
+			atomic_thread_fence (memory_order_acquire);
+			u64 now = atomic_load_explicit (&buffer->write_pos,
+											memory_order_relaxed);
+			if (now - pos >= PROFILER_EVENTS_PER_THREAD) {
+				++cursor->dropped;
+				continue;
+			}
+			sink (thread, &event, user_data);
+			++delivered;
+		}
+		cursor->read_pos[thread] = end;
+	}
+	return delivered;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/perf_counters.h"
+
+// CPU instrumentation. Zones are recorded into per-thread ring buffers and
+// exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev). All
+// macros compile to nothing unless SF_PROFILING_ENABLED is defined
+// (premake5 --profile).
+
+// Events kept per thread, older ones are overwritten.
+#define PROFILER_EVENTS_PER_THREAD (64 * 1024)
+// Distinct names SF_PROFILE_COUNTERS zones can use, and how deep they nest.
+#define PROFILER_MAX_COUNTER_ZONES 32
+#define PROFILER_MAX_COUNTER_DEPTH 16
+
+typedef enum profiler_event_type {
+	PROFILER_EVENT_BEGIN,
+	PROFILER_EVENT_END,
+	PROFILER_EVENT_FRAME,
+	// A sampled value, e.g. memory in use, drawn as a counter track.
+	PROFILER_EVENT_VALUE
+} profiler_event_type;
+
+typedef struct profiler_event {
+	// NULL for PROFILER_EVENT_END, ends pair with the innermost begin.
+	const char* name;
+	u64 timestamp_ns;
+	// Only set for PROFILER_EVENT_VALUE.
+	f64 value;
+	u8 type;
+} profiler_event;
+
+/**
+* @brief Initializes the profiler. If memory is NULL, will populate mem_size.
+* @param mem_size Holds the required memory size of the internal state.
+* @param memory NULL if requesting memory size, otherwise allocated block of memory.
+* @return TRUE on success; otherwise FALSE.
+*/
+b8 profiler_initialize (u64* mem_size, void* memory);
+
+/**
+* @brief Frees every thread buffer. Threads must not record zones while or after this runs.
+* @param memory Pointer to the memory
+*/
+void profiler_shutdown (void* memory);
+
+/**
+* @brief Records the start of a zone on the calling thread. Use the macros instead.
+* @param name A string literal, only the pointer is stored.
+* @return Always 0, lets SF_PROFILE_ZONE hold a scope guard.
+*/
+SAPI u8 profiler_zone_begin (const char* name);
+
+/**
+* @brief Records the end of the innermost zone on the calling thread.
+*/
+SAPI void profiler_zone_end ();
+
+// Cleanup handler for SF_PROFILE_ZONE.
+SAPI void profiler_zone_cleanup (u8* zone);
+
+/**
+* @brief Records a frame boundary.
+*/
+SAPI void profiler_frame_mark ();
+
+/**
+* @brief Writes what is currently in the thread buffers as a Chrome trace JSON file. Safe to call while other threads keep recording; events overwritten during the export are left out.
+* @param path The file to write.
+* @return TRUE on success; otherwise FALSE.
+*/
+SAPI b8 profiler_export_chrome_trace (const char* path);
+
+/**
+* @brief Records a sampled value on the calling thread. Use SF_PROFILE_VALUE instead.
+* @param name A string literal, only the pointer is stored.
+* @param value The value at this point in time.
+*/
+SAPI void profiler_value (const char* name, f64 value);
+
+// Threads profiler_stream_events tracks, later ones are skipped.
+#define PROFILER_STREAM_MAX_THREADS 64
+
+// Where a streaming reader left off in every thread buffer. Zero it before
+// the first read.
+typedef struct profiler_stream_cursor {
+	u64 read_pos[PROFILER_STREAM_MAX_THREADS];
+	// Events overwritten before the reader got to them.
+	u64 dropped;
+} profiler_stream_cursor;
+
+typedef void (*PFN_profiler_event_sink) (u32 thread_index,
+										 const profiler_event* event,
+										 void* user_data);
+
+/**
+* @brief Passes every event recorded since the last call with the same cursor to sink, thread by thread in recording order. Lock-free like the export, safe to call from another thread while the engine keeps recording. A new cursor starts at the oldest event still buffered.
+* @param cursor The reader position, updated.
+* @param sink Called for each event.
+* @param user_data Passed as-is to sink.
+* @return The number of events passed to sink.
+*/
+SAPI u64 profiler_stream_events (profiler_stream_cursor* cursor,
+								 PFN_profiler_event_sink sink,
+								 void* user_data);
+
+typedef struct profiler_zone_stats {
+	const char* name;
+	u64 count;
+	u64 total_ns;
+	u64 min_ns;
+	u64 max_ns;
+	// Sum of the squared durations, for the variance.
+	f64 sum_squares_ns;
+} profiler_zone_stats;
+
+/**
+* @brief Aggregates the zones still held in the thread buffers by name, across all threads. Zones whose begin was already overwritten are left out, so this covers about the last PROFILER_EVENTS_PER_THREAD events of each thread.
+* @param out_stats Receives the zones in order of first appearance.
+* @param max_count Capacity of out_stats, zones beyond it are dropped.
+* @return The number of zones written, 0 if the profiler isn't running.
+*/
+SAPI u32 profiler_get_zone_stats (profiler_zone_stats* out_stats,
+								  u32 max_count);
+
+typedef struct profiler_counter_stats {
+	const char* name;
+	// Frames the zone ran in, and how many times it ran in them.
+	u64 frames;
+	u64 calls;
+	// Summed over those frames, indexed by perf_counter_type.
+	u64 totals[PERF_COUNTER_MAX];
+	// Only the last frame the zone ran in.
+	u64 last_frame_calls;
+	u64 last_frame[PERF_COUNTER_MAX];
+} profiler_counter_stats;
+
+/**
+* @brief Starts a zone that also reads the hardware counters. Use SF_PROFILE_COUNTERS instead. Each thread opens its own counters on first use, and the deltas of all threads add up in the zone. The zone must end on the thread it began on.
+* @param name A string literal, only the pointer is stored.
+* @return 1 if the counters were read, for profiler_counter_zone_cleanup.
+*/
+SAPI u8 profiler_counter_zone_begin (const char* name);
+
+// Cleanup handler for SF_PROFILE_COUNTERS.
+SAPI void profiler_counter_zone_cleanup (u8* zone);
+
+/**
+* @return A bit (1 << perf_counter_type) for every hardware counter being read, 0 if there are none.
+*/
+SAPI u32 profiler_counters_available ();
+
+/**
+* @brief Copies the counter totals of every SF_PROFILE_COUNTERS zone. Frames are delimited by SF_PROFILE_FRAME_MARK. Must be called on the thread that initialized the profiler.
+* @param out_stats Receives the zones in order of first appearance.
+* @param max_count Capacity of out_stats.
+* @return The number of zones written, 0 if no counters are available.
+*/
+SAPI u32 profiler_get_counter_stats (profiler_counter_stats* out_stats,
+									 u32 max_count);
+
+#ifdef SF_PROFILING_ENABLED
+
+#define SF_PROFILE_CONCAT_INNER(a, b) a##b
+#define SF_PROFILE_CONCAT(a, b)		  SF_PROFILE_CONCAT_INNER (a, b)
+
+// Profiles from here to the end of the enclosing scope.
+#define SF_PROFILE_ZONE(name)                                                  \
+	u8 SF_PROFILE_CONCAT (sf_profile_zone_, __LINE__)                          \
+		__attribute__ ((cleanup (profiler_zone_cleanup), unused)) =            \
+			profiler_zone_begin (name)
+// Like SF_PROFILE_ZONE, and counts cycles, instructions, cache and branch
+// misses of the zone per frame. Costs a syscall on entry and exit, keep it
+// off tiny hot functions.
+#define SF_PROFILE_COUNTERS(name)                                              \
+	u8 SF_PROFILE_CONCAT (sf_profile_counters_, __LINE__)                      \
+		__attribute__ ((cleanup (profiler_counter_zone_cleanup), unused)) =    \
+			profiler_counter_zone_begin (name)
+#define SF_PROFILE_BEGIN(name)	profiler_zone_begin (name)
+#define SF_PROFILE_END()		profiler_zone_end ()
+#define SF_PROFILE_FRAME_MARK() profiler_frame_mark ()
+// Adds a sample to the counter track called name.
+#define SF_PROFILE_VALUE(name, value) profiler_value (name, value)
+
+#else
+
+#define SF_PROFILE_ZONE(name)
+#define SF_PROFILE_COUNTERS(name)
+#define SF_PROFILE_BEGIN(name)
+#define SF_PROFILE_END()
+#define SF_PROFILE_FRAME_MARK()
+#define SF_PROFILE_VALUE(name, value)
+
+#endif
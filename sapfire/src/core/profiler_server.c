@@ -0,0 +1,236 @@
+#include "profiler_server.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "core/thread_pinning.h"
+#include "platform/atomic.h"
+#include "platform/platform.h"
+#include "platform/socket.h"
+#include "platform/thread.h"
+
+// Distinct zone and value names sent per connection, must be a power of 2.
+#define PROFILER_SERVER_NAME_SLOTS 4096
+#define PROFILER_SERVER_MAX_NAME   255
+// Largest record: a name followed by the value event using it.
+#define PROFILER_SERVER_MAX_RECORD (PROFILER_SERVER_MAX_NAME + 40)
+#define PROFILER_SERVER_ACCEPT_MS  100
+
+typedef struct profiler_server_state {
+	sf_socket listener;
+	sf_socket client;
+	sf_thread thread;
+	// Signalled to stop waiting for the next flush.
+	sf_semaphore wake;
+	sf_atomic_u32 running;
+
+	profiler_stream_cursor cursor;
+	u64 reported_dropped;
+	// Open addressing on the name pointer, the slot is the name id.
+	const char *names[PROFILER_SERVER_NAME_SLOTS];
+	u32 batch_length;
+	u32 batch_records;
+	u8 batch[PROFILER_SERVER_BATCH_SIZE];
+
+	u64 events_sent;
+	u64 bytes_sent;
+	u64 batches_sent;
+	u64 busy_ns;
+} profiler_server_state;
+
+static profiler_server_state *pServer;
+
+#define BATCH_HEADER_SIZE (sizeof (u32) * 2)
+
+#define BATCH_WRITE(state, value)                                              \
+	do {                                                                       \
+		sfmemcpy ((state)->batch + (state)->batch_length, &(value),            \
+				  sizeof (value));                                             \
+		(state)->batch_length += sizeof (value);                               \
+	} while (0)
+
+static void disconnect (profiler_server_state *state) {
+	platform_socket_close (&state->client);
+	SF_INFO ("Profiler viewer disconnected.");
+}
+
+static void flush_batch (profiler_server_state *state) {
+	if (state->batch_records && state->client.is_valid) {
+		u32 payload = state->batch_length - BATCH_HEADER_SIZE;
+		sfmemcpy (state->batch, &payload, sizeof (u32));
+		sfmemcpy (state->batch + sizeof (u32), &state->batch_records,
+				  sizeof (u32));
+		if (platform_socket_send (&state->client, state->batch,
+								  state->batch_length)) {
+			state->bytes_sent += state->batch_length;
+			++state->batches_sent;
+		} else {
+			disconnect (state);
+		}
+	}
+	state->batch_length	 = BATCH_HEADER_SIZE;
+	state->batch_records = 0;
+}
+
+static void reserve_record (profiler_server_state *state) {
+	if (state->batch_length + PROFILER_SERVER_MAX_RECORD >
+		PROFILER_SERVER_BATCH_SIZE) {
+		flush_batch (state);
+	}
+}
+
+// Returns the id of name, sending it first if the viewer hasn't seen it.
+static u32 name_id (profiler_server_state *state, const char *name) {
+	if (!name) { return INVALID_ID; }
+	u32 slot = (u32)(((u64)name >> 3) * 0x9E3779B97F4A7C15ull >> 52) &
+			   (PROFILER_SERVER_NAME_SLOTS - 1);
+	for (u32 probe = 0; probe < PROFILER_SERVER_NAME_SLOTS; ++probe) {
+		if (state->names[slot] == name) { return slot; }
+		if (!state->names[slot]) { break; }
+		slot = (slot + 1) & (PROFILER_SERVER_NAME_SLOTS - 1);
+	}
+	if (state->names[slot]) { return INVALID_ID; }
+	state->names[slot] = name;
+
+	u64 length = sfstrlen (name);
+	if (length > PROFILER_SERVER_MAX_NAME) {
+		length = PROFILER_SERVER_MAX_NAME;
+	}
+	u8 type			= PROFILER_SERVER_RECORD_NAME;
+	u16 name_length = (u16)length;
+	BATCH_WRITE (state, type);
+	BATCH_WRITE (state, slot);
+	BATCH_WRITE (state, name_length);
+	sfmemcpy (state->batch + state->batch_length, name, length);
+	state->batch_length += length;
+	++state->batch_records;
+	return slot;
+}
+
+static void write_event (u32 thread_index, const profiler_event *event,
+						 void *user_data) {
+	profiler_server_state *state = user_data;
+	reserve_record (state);
+	u32 id	  = name_id (state, event->name);
+	u8 type	  = PROFILER_SERVER_RECORD_BEGIN + event->type;
+	u8 thread = (u8)thread_index;
+	BATCH_WRITE (state, type);
+	BATCH_WRITE (state, thread);
+	BATCH_WRITE (state, id);
+	BATCH_WRITE (state, event->timestamp_ns);
+	if (event->type == PROFILER_EVENT_VALUE) {
+		BATCH_WRITE (state, event->value);
+	}
+	++state->batch_records;
+	++state->events_sent;
+}
+
+static void stream (profiler_server_state *state) {
+	u64 start = platform_get_absolute_time_ns ();
+	profiler_stream_events (&state->cursor, write_event, state);
+	u64 dropped = state->cursor.dropped - state->reported_dropped;
+	if (dropped) {
+		reserve_record (state);
+		u8 type = PROFILER_SERVER_RECORD_DROPPED;
+		BATCH_WRITE (state, type);
+		BATCH_WRITE (state, dropped);
+		++state->batch_records;
+		state->reported_dropped = state->cursor.dropped;
+	}
+	flush_batch (state);
+	state->busy_ns += platform_get_absolute_time_ns () - start;
+}
+
+static b8 accept_viewer (profiler_server_state *state) {
+	if (!platform_socket_accept (&state->listener, PROFILER_SERVER_ACCEPT_MS,
+								 &state->client)) {
+		return FALSE;
+	}
+	// Every connection starts from scratch: the buffered history, and
+	// names sent again.
+	sfmemset (&state->cursor, 0, sizeof (profiler_stream_cursor));
+	sfmemset (state->names, 0, sizeof (state->names));
+	state->reported_dropped = 0;
+	state->batch_length		= BATCH_HEADER_SIZE;
+	state->batch_records	= 0;
+
+	u32 header[2]	  = {PROFILER_SERVER_MAGIC, PROFILER_SERVER_VERSION};
+	u64 ticks_per_sec = 1000000000ull;
+	u8 handshake[16];
+	sfmemcpy (handshake, header, sizeof (header));
+	sfmemcpy (handshake + sizeof (header), &ticks_per_sec, sizeof (u64));
+	if (!platform_socket_send (&state->client, handshake,
+							   sizeof (handshake))) {
+		platform_socket_close (&state->client);
+		return FALSE;
+	}
+	SF_INFO ("Profiler viewer connected.");
+	return TRUE;
+}
+
+static u32 server_thread (void *params) {
+	profiler_server_state *state = params;
+	thread_pinning_apply (THREAD_ROLE_IO, 0);
+	while (sf_atomic_load_u32 (&state->running)) {
+		if (!state->client.is_valid) {
+			accept_viewer (state);
+			continue;
+		}
+		stream (state);
+		platform_semaphore_wait_timeout (&state->wake,
+										 PROFILER_SERVER_FLUSH_MS);
+	}
+	// Send what was recorded up to the stop.
+	if (state->client.is_valid) {
+		stream (state);
+		platform_socket_close (&state->client);
+	}
+	return 0;
+}
+
+b8 profiler_server_start (u16 port) {
+	if (pServer) { return TRUE; }
+	profiler_server_state *state =
+		sfalloc (sizeof (profiler_server_state), MEMORY_TAG_PROFILER);
+	sfmemset (state, 0, sizeof (profiler_server_state));
+	if (!platform_socket_listen_loopback (port, &state->listener)) {
+		sffree (state, sizeof (profiler_server_state), MEMORY_TAG_PROFILER);
+		return FALSE;
+	}
+	if (!platform_semaphore_create (0, &state->wake)) {
+		platform_socket_close (&state->listener);
+		sffree (state, sizeof (profiler_server_state), MEMORY_TAG_PROFILER);
+		return FALSE;
+	}
+	sf_atomic_init_u32 (&state->running, TRUE);
+	if (!platform_thread_create (server_thread, state, &state->thread)) {
+		SF_ERROR ("Failed to start the profiler server thread.");
+		platform_semaphore_destroy (&state->wake);
+		platform_socket_close (&state->listener);
+		sffree (state, sizeof (profiler_server_state), MEMORY_TAG_PROFILER);
+		return FALSE;
+	}
+	pServer = state;
+	SF_INFO ("Profiler server listening on 127.0.0.1:%u.",
+			 platform_socket_port (&state->listener));
+	return TRUE;
+}
+
+void profiler_server_stop () {
+	if (!pServer) { return; }
+	profiler_server_state *state = pServer;
+	pServer						 = SF_NULL;
+	sf_atomic_store_u32 (&state->running, FALSE);
+	platform_semaphore_signal (&state->wake);
+	platform_thread_join (&state->thread);
+	platform_semaphore_destroy (&state->wake);
+	platform_socket_close (&state->listener);
+	if (state->batches_sent) {
+		SF_INFO ("Profiler server streamed %llu events in %llu batches "
+				 "(%.1f KiB), %llu dropped, %.2f ms busy.",
+				 state->events_sent, state->batches_sent,
+				 state->bytes_sent / 1024.0, state->cursor.dropped,
+				 state->busy_ns * 1e-6);
+	}
+	sffree (state, sizeof (profiler_server_state), MEMORY_TAG_PROFILER);
+}
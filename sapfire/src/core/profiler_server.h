@@ -0,0 +1,46 @@
+#pragma once
+
+#include "defines.h"
+
+// Streams profiler events to a viewer over a loopback TCP connection while
+// the engine runs. A server thread drains the thread buffers with
+// profiler_stream_events every PROFILER_SERVER_FLUSH_MS and sends what it
+// found as one batch, so recording threads never touch the socket and a
+// slow viewer only costs dropped events. One viewer at a time.
+//
+// Wire format, native byte order (little-endian on every target), packed:
+//   On connect:  u32 magic 'SFPS', u32 version, u64 ticks per second.
+//   Then batches: u32 payload bytes, u32 record count, records.
+//   Records start with a u8 profiler_server_record:
+//     NAME      u32 id, u16 length, name bytes. Precedes the first use.
+//     BEGIN/END/FRAME  u8 thread, u32 name id, u64 timestamp.
+//     VALUE     u8 thread, u32 name id, u64 timestamp, f64 value.
+//     DROPPED   u64 events lost since the previous DROPPED record.
+// END records carry INVALID_ID as name, they close the innermost BEGIN of
+// their thread.
+
+#define PROFILER_SERVER_MAGIC	   0x53504653
+#define PROFILER_SERVER_VERSION	   1
+#define PROFILER_SERVER_FLUSH_MS   10
+#define PROFILER_SERVER_BATCH_SIZE (64 * 1024)
+
+typedef enum profiler_server_record {
+	PROFILER_SERVER_RECORD_NAME,
+	PROFILER_SERVER_RECORD_BEGIN,
+	PROFILER_SERVER_RECORD_END,
+	PROFILER_SERVER_RECORD_FRAME,
+	PROFILER_SERVER_RECORD_VALUE,
+	PROFILER_SERVER_RECORD_DROPPED
+} profiler_server_record;
+
+/**
+* @brief Starts listening on 127.0.0.1 and streaming to whoever connects. The profiler must be initialized and outlive the server.
+* @param port The port to listen on, 0 lets the OS pick one (it is logged).
+* @return TRUE on success; otherwise FALSE.
+*/
+SAPI b8 profiler_server_start (u16 port);
+
+/**
+* @brief Flushes what is left to the viewer, disconnects and joins the server thread. Does nothing if the server isn't running.
+*/
+SAPI void profiler_server_stop ();
@@ -1,35 +1,58 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_MEMORY
+
 #include <stdio.h>
 #include <string.h>
 
 #include "core/logger.h"
 #include "core/sfstring.h"
+#include "platform/atomic.h"
 #include "platform/platform.h"
 #include "sfmemory.h"
 
-struct mem_stats {
-	u64 total;
-	u64 tagged[MEMORY_TAG_MAX];
-};
-
 static const char *tagged_strings[MEMORY_TAG_MAX] = {
-	"UNKNOWN    ", "LIN_ALLOC  ", "GAME       ", "VECTOR     ",
-	"RENDERER   ", "STRING     ", "APP        ", "TEXTURE    ",
+	"UNKNOWN",
+	"LIN_ALLOC",
+	"GAME",
+	"VECTOR",
+	"RENDERER",
+	"STRING",
+	"APP",
+	"TEXTURE",
+	"PROFILER",
 };
-static struct mem_stats stats;
+
+// Mirrors memory_stats. sfalloc and sffree run on worker threads too, so the
+// counters are relaxed atomics; memory_get_stats is a best-effort snapshot.
+typedef struct memory_stats_atomic {
+	sf_atomic_u64 total;
+	sf_atomic_u64 peak_total;
+	sf_atomic_u64 allocation_count;
+	sf_atomic_u64 free_count;
+	sf_atomic_u64 tagged[MEMORY_TAG_MAX];
+	sf_atomic_u64 tagged_peak[MEMORY_TAG_MAX];
+	sf_atomic_u64 tagged_allocation_count[MEMORY_TAG_MAX];
+} memory_stats_atomic;
+
+static memory_stats_atomic stats;
 
 void memory_initialize () {
 	platform_set_memory (&stats, 0, sizeof (stats));
 	SF_INFO ("Memory subsystem initialized successfully.");
 }
 
-void memory_shutdown () { SF_DEBUG (get_mem_usage_str ()); }
+void memory_shutdown () { SF_DEBUG ("%s", get_mem_usage_str ()); }
 
 void *sfalloc (u64 size, memory_tag tag) {
 	if (tag == MEMORY_TAG_UNKNOWN) {
 		SF_WARNING ("sfalloc called with MEMORY_TAG_UNKNOWN");
 	}
-	stats.total += size;
-	stats.tagged[tag] += size;
+	u64 total  = sf_atomic_fetch_add_u64_relaxed (&stats.total, size) + size;
+	u64 tagged = sf_atomic_fetch_add_u64_relaxed (&stats.tagged[tag], size) +
+				 size;
+	sf_atomic_fetch_add_u64_relaxed (&stats.allocation_count, 1);
+	sf_atomic_fetch_add_u64_relaxed (&stats.tagged_allocation_count[tag], 1);
+	sf_atomic_max_u64 (&stats.peak_total, total);
+	sf_atomic_max_u64 (&stats.tagged_peak[tag], tagged);
 	void *block = platform_allocate (size, FALSE);
 	platform_set_memory (block, 0, size);
 	return block;
@@ -39,8 +62,9 @@ void sffree (void *block, u64 size, memory_tag tag) {
 	if (tag == MEMORY_TAG_UNKNOWN) {
 		SF_WARNING ("sffree called with MEMORY_TAG_UNKNOWN");
 	}
-	stats.total -= size;
-	stats.tagged[tag] -= size;
+	sf_atomic_fetch_sub_u64_relaxed (&stats.total, size);
+	sf_atomic_fetch_sub_u64_relaxed (&stats.tagged[tag], size);
+	sf_atomic_fetch_add_u64_relaxed (&stats.free_count, 1);
 	platform_free (block, FALSE);
 	block = SF_NULL;
 }
@@ -49,10 +73,33 @@ void *sfmemcpy (void *dest, const void *src, u64 size) {
 	return platform_copy_memory (dest, src, size);
 }
 
+void *sfmemmove (void *dest, const void *src, u64 size) {
+	return platform_move_memory (dest, src, size);
+}
+
 void *sfmemset (void *dest, i32 val, u64 size) {
 	return platform_set_memory (dest, val, size);
 }
 
+void memory_get_stats (memory_stats *out_stats) {
+	out_stats->total	  = sf_atomic_load_u64_relaxed (&stats.total);
+	out_stats->peak_total = sf_atomic_load_u64_relaxed (&stats.peak_total);
+	out_stats->free_count = sf_atomic_load_u64_relaxed (&stats.free_count);
+	out_stats->allocation_count =
+		sf_atomic_load_u64_relaxed (&stats.allocation_count);
+	for (u32 i = 0; i < MEMORY_TAG_MAX; ++i) {
+		out_stats->tagged[i] = sf_atomic_load_u64_relaxed (&stats.tagged[i]);
+		out_stats->tagged_peak[i] =
+			sf_atomic_load_u64_relaxed (&stats.tagged_peak[i]);
+		out_stats->tagged_allocation_count[i] =
+			sf_atomic_load_u64_relaxed (&stats.tagged_allocation_count[i]);
+	}
+}
+
+const char *memory_tag_name (memory_tag tag) {
+	return tag < MEMORY_TAG_MAX ? tagged_strings[tag] : "INVALID";
+}
+
 char *get_mem_usage_str () {
 	const u64 gib = 1024 * 1024 * 1024;
 	const u64 mib = 1024 * 1024;
@@ -63,21 +110,22 @@ char *get_mem_usage_str () {
 	for (u16 i = 0; i < MEMORY_TAG_MAX; ++i) {
 		char unit[4] = "XiB";
 		float amount = 1.0f;
-		if (stats.tagged[i] >= gib) {
+		u64 tagged	 = sf_atomic_load_u64_relaxed (&stats.tagged[i]);
+		if (tagged >= gib) {
 			unit[0] = 'G';
-			amount	= stats.tagged[i] / (float)gib;
-		} else if (stats.tagged[i] >= mib) {
+			amount	= tagged / (float)gib;
+		} else if (tagged >= mib) {
 			unit[0] = 'M';
-			amount	= stats.tagged[i] / (float)mib;
-		} else if (stats.tagged[i] > kib) {
+			amount	= tagged / (float)mib;
+		} else if (tagged > kib) {
 			unit[0] = 'K';
-			amount	= stats.tagged[i] / (float)kib;
+			amount	= tagged / (float)kib;
 		} else {
 			unit[0] = 'B';
 			unit[1] = 0;
-			amount	= (float)stats.tagged[i];
+			amount	= (float)tagged;
 		}
-		offset += snprintf (buffer + offset, 8000, "  %s: %.2f%s\n",
+		offset += snprintf (buffer + offset, 8000, "  %-11s: %.2f%s\n",
 							tagged_strings[i], amount, unit);
 	}
 	char *out_string = sfstrdup (buffer);
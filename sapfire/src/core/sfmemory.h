@@ -11,10 +11,23 @@ typedef enum memory_tag {
 	MEMORY_TAG_STRING,
 	MEMORY_TAG_APPLICATION,
     MEMORY_TAG_TEXTURE,
+	MEMORY_TAG_PROFILER,
 
 	MEMORY_TAG_MAX
 } memory_tag;
 
+typedef struct memory_stats {
+	// Bytes currently allocated.
+	u64 total;
+	u64 peak_total;
+	u64 allocation_count;
+	u64 free_count;
+	u64 tagged[MEMORY_TAG_MAX];
+	// Highest value tagged[tag] reached.
+	u64 tagged_peak[MEMORY_TAG_MAX];
+	u64 tagged_allocation_count[MEMORY_TAG_MAX];
+} memory_stats;
+
 /**
 * @brief \ brief Initializes memory subsystem This function is called at boot time to initialize the memory subsystem. \ return
 */
@@ -48,6 +61,14 @@ SAPI void sffree (void* block, u64 size, memory_tag tag);
 */
 SAPI void* sfmemcpy (void* dest, const void* src, u64 size);
 
+/**
+* @brief Copy memory between regions that may overlap. This is a wrapper around platform_move_memory ().
+* @param dest The address to copy to.
+* @param src The address to copy from.
+* @param size The size in bytes of the memory region to copy
+*/
+SAPI void* sfmemmove (void* dest, const void* src, u64 size);
+
 /**
 * @brief Set memory to a value. This is a wrapper around platform_set_memory to avoid having to worry having to include platform code.
 * @param dest A pointer to the memory to be set
@@ -56,6 +77,19 @@ SAPI void* sfmemcpy (void* dest, const void* src, u64 size);
 */
 SAPI void* sfmemset (void* dest, i32 val, u64 size);
 
+/**
+* @brief Copies the allocation statistics gathered since memory_initialize.
+* @param out_stats Receives the statistics.
+*/
+SAPI void memory_get_stats (memory_stats* out_stats);
+
+/**
+* @brief Get the name of a memory tag, e.g. "TEXTURE".
+* @param tag The tag.
+* @return A static string.
+*/
+SAPI const char* memory_tag_name (memory_tag tag);
+
 /**
 * @brief Get memory usage as a string. This is used to display information about the process memory usage in a human readable format.
 * @return pointer to string containing memory usage in a null - terminated string. Must be freed by the caller using
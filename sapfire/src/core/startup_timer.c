@@ -0,0 +1,58 @@
+#include "startup_timer.h"
+#include "core/logger.h"
+#include "platform/atomic.h"
+#include "platform/platform.h"
+#include "platform/thread.h"
+
+// Zero initialized, so phases can be timed before anything else is up.
+static startup_phase phases[STARTUP_MAX_PHASES];
+static sf_atomic_u32 phase_count;
+static u64 origin_ns;
+static u64 main_thread_id;
+static _Thread_local u32 open_depth;
+
+u32 startup_timer_begin (const char *name) {
+	u64 now	  = platform_get_absolute_time_ns ();
+	u32 index = sf_atomic_fetch_add_u32 (&phase_count, 1);
+	if (index >= STARTUP_MAX_PHASES) {
+		sf_atomic_fetch_sub_u32 (&phase_count, 1);
+		return INVALID_ID;
+	}
+	// The first phase begins before any other thread is started.
+	if (index == 0) {
+		origin_ns	   = now;
+		main_thread_id = platform_thread_current_id ();
+	}
+	startup_phase *phase = &phases[index];
+	phase->name			 = name;
+	phase->depth		 = open_depth++;
+	phase->start_ns		 = now - origin_ns;
+	phase->duration_ns	 = 0;
+	phase->main_thread	 = platform_thread_current_id () == main_thread_id;
+	return index;
+}
+
+void startup_timer_end (u32 phase) {
+	if (phase >= STARTUP_MAX_PHASES) { return; }
+	u64 now					  = platform_get_absolute_time_ns () - origin_ns;
+	phases[phase].duration_ns = now - phases[phase].start_ns;
+	--open_depth;
+}
+
+u32 startup_timer_get_phases (startup_phase *out_phases, u32 max_count) {
+	u32 count = sf_atomic_load_u32 (&phase_count);
+	if (count > max_count) { count = max_count; }
+	for (u32 i = 0; i < count; ++i) { out_phases[i] = phases[i]; }
+	return count;
+}
+
+void startup_timer_log_report () {
+	u32 count = sf_atomic_load_u32 (&phase_count);
+	SF_INFO ("Startup phases, start and duration in ms:");
+	for (u32 i = 0; i < count; ++i) {
+		const startup_phase *phase = &phases[i];
+		SF_INFO ("%9.2f %9.2f  %*s%s%s", phase->start_ns / 1e6,
+				 phase->duration_ns / 1e6, (i32)(phase->depth * 2), "",
+				 phase->name, phase->main_thread ? "" : " (job)");
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "defines.h"
+
+// Wall time of the phases engine startup goes through, kept from the first
+// phase on without any setup so it also covers the systems that come up
+// before the allocators and the logger. Phases nest per thread and may run
+// on job workers, overlapping ones show up side by side in the report.
+
+// Phases recorded at most, later ones are dropped.
+#define STARTUP_MAX_PHASES 64
+
+typedef struct startup_phase {
+	// A string literal.
+	const char* name;
+	// Phases open on the same thread when this one began.
+	u32 depth;
+	// Since the first phase began.
+	u64 start_ns;
+	// 0 while the phase is still running.
+	u64 duration_ns;
+	// FALSE for phases run on another thread than the first phase.
+	b8 main_thread;
+} startup_phase;
+
+/**
+* @brief Starts timing a phase, nested under the phases still open on the calling thread.
+* @param name A string literal.
+* @return The phase to pass to startup_timer_end, INVALID_ID if STARTUP_MAX_PHASES were recorded.
+*/
+SAPI u32 startup_timer_begin (const char* name);
+
+/**
+* @brief Stops timing a phase, on the thread that began it.
+* @param phase What startup_timer_begin returned.
+*/
+SAPI void startup_timer_end (u32 phase);
+
+/**
+* @brief Copies the recorded phases in the order they began.
+* @param out_phases Receives up to max_count phases.
+* @param max_count Size of out_phases.
+* @return Number of phases copied.
+*/
+SAPI u32 startup_timer_get_phases (startup_phase* out_phases, u32 max_count);
+
+/**
+* @brief Logs every phase as an indented tree with start offsets and durations.
+*/
+SAPI void startup_timer_log_report ();
@@ -0,0 +1,183 @@
+#include "task_graph.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/sfmemory.h"
+#include "platform/platform.h"
+
+static b8 conflicts (const task_desc *a, const task_desc *b) {
+	return (a->writes & (b->reads | b->writes)) || (a->reads & b->writes);
+}
+
+// Links every task to the earlier tasks it conflicts with, leaving out the
+// ones already reached through another dependency.
+static void compile (task_graph *graph) {
+	u64 ancestors[TASK_GRAPH_MAX_TASKS];
+	u32 edge_count = 0;
+	for (u32 i = 0; i < graph->task_count; ++i) {
+		graph->tasks[i].predecessors = 0;
+		graph->tasks[i].successors	 = 0;
+	}
+	for (u32 i = 0; i < graph->task_count; ++i) {
+		task_graph_task *task = &graph->tasks[i];
+		u64 conflicting		  = 0;
+		for (u32 j = 0; j < i; ++j) {
+			if (conflicts (&task->desc, &graph->tasks[j].desc)) {
+				conflicting |= 1ull << j;
+			}
+		}
+		u64 implied = 0;
+		for (u64 rest = conflicting; rest; rest &= rest - 1) {
+			implied |= ancestors[__builtin_ctzll (rest)];
+		}
+		ancestors[i]	   = conflicting | implied;
+		task->predecessors = conflicting & ~implied;
+		for (u64 rest = task->predecessors; rest; rest &= rest - 1) {
+			graph->tasks[__builtin_ctzll (rest)].successors |= 1ull << i;
+			++edge_count;
+		}
+	}
+	graph->compiled = TRUE;
+	SF_DEBUG ("Task graph compiled: %u tasks, %u dependencies.",
+			  graph->task_count, edge_count);
+}
+
+static void task_job (void *params);
+
+static void run_task (task_graph_task *task) {
+	task_graph *graph = task->graph;
+	task->start_ns	  = platform_get_absolute_time_ns ();
+	SF_PROFILE_BEGIN (task->desc.name ? task->desc.name : "task");
+	task->desc.entry (task->desc.params);
+	SF_PROFILE_END ();
+	task->end_ns = platform_get_absolute_time_ns ();
+	// Successors are queued before this task counts as done, so remaining
+	// can't reach zero while any are left unqueued.
+	for (u64 rest = task->successors; rest; rest &= rest - 1) {
+		task_graph_task *next = &graph->tasks[__builtin_ctzll (rest)];
+		if (sf_atomic_fetch_sub_u32 (&next->pending, 1) != 1 ||
+			next->desc.main_thread) {
+			continue;
+		}
+		job_decl job = {task_job, next, next->desc.name, FALSE};
+		job_run (&job, 1, SF_NULL);
+	}
+	sf_atomic_fetch_sub_u32 (&graph->remaining, 1);
+}
+
+static void task_job (void *params) { run_task (params); }
+
+// Main thread tasks are only taken by the thread running the graph.
+static task_graph_task *next_main_task (task_graph *graph) {
+	for (u32 i = 0; i < graph->task_count; ++i) {
+		task_graph_task *task = &graph->tasks[i];
+		if (task->desc.main_thread && !task->ran &&
+			sf_atomic_load_u32 (&task->pending) == 0) {
+			return task;
+		}
+	}
+	return SF_NULL;
+}
+
+static b8 main_task_or_done (void *data) {
+	task_graph *graph = data;
+	return sf_atomic_load_u32 (&graph->remaining) == 0 ||
+		   next_main_task (graph) != SF_NULL;
+}
+
+// Longest path through the dependencies by measured task time. Tasks are
+// stored in an order where predecessors come first.
+static void find_critical_path (task_graph *graph, u64 run_ns) {
+	u64 finish[TASK_GRAPH_MAX_TASKS];
+	u32 via[TASK_GRAPH_MAX_TASKS];
+	u32 last = INVALID_ID;
+	for (u32 i = 0; i < graph->task_count; ++i) {
+		task_graph_task *task = &graph->tasks[i];
+		u64 start			  = 0;
+		via[i]				  = INVALID_ID;
+		for (u64 rest = task->predecessors; rest; rest &= rest - 1) {
+			u32 p = __builtin_ctzll (rest);
+			if (via[i] == INVALID_ID || finish[p] > start) {
+				start  = finish[p];
+				via[i] = p;
+			}
+		}
+		finish[i] = start + (task->end_ns - task->start_ns);
+		if (last == INVALID_ID || finish[i] > finish[last]) { last = i; }
+	}
+
+	u32 length = 0;
+	for (u32 i = last; i != INVALID_ID; i = via[i]) { ++length; }
+	task_graph_path *path = &graph->critical_path;
+	path->count			  = length;
+	path->duration_ns	  = last == INVALID_ID ? 0 : finish[last];
+	path->run_ns		  = run_ns;
+	// Walked from the end, filled back to front.
+	for (u32 i = last; i != INVALID_ID; i = via[i]) {
+		task_graph_task *task = &graph->tasks[i];
+		--length;
+		path->tasks[length]	  = i;
+		path->task_ns[length] = task->end_ns - task->start_ns;
+	}
+}
+
+void task_graph_create (task_graph *out_graph) {
+	sfmemset (out_graph, 0, sizeof (task_graph));
+	sf_atomic_init_u32 (&out_graph->remaining, 0);
+}
+
+u32 task_graph_add (task_graph *graph, const task_desc *desc) {
+	if (graph->task_count == TASK_GRAPH_MAX_TASKS) {
+		SF_ERROR ("Task graph is full, '%s' was not added.", desc->name);
+		return INVALID_ID;
+	}
+	u32 id				  = graph->task_count++;
+	task_graph_task *task = &graph->tasks[id];
+	sfmemset (task, 0, sizeof (task_graph_task));
+	task->desc		= *desc;
+	task->graph		= graph;
+	graph->compiled = FALSE;
+	return id;
+}
+
+void task_graph_run (task_graph *graph) {
+	if (graph->task_count == 0) { return; }
+	if (!graph->compiled) { compile (graph); }
+	u64 start_ns = platform_get_absolute_time_ns ();
+	for (u32 i = 0; i < graph->task_count; ++i) {
+		task_graph_task *task = &graph->tasks[i];
+		task->ran			  = FALSE;
+		sf_atomic_store_u32 (&task->pending,
+							 __builtin_popcountll (task->predecessors));
+	}
+	sf_atomic_store_u32 (&graph->remaining, graph->task_count);
+
+	job_decl jobs[TASK_GRAPH_MAX_TASKS];
+	u32 job_count = 0;
+	for (u32 i = 0; i < graph->task_count; ++i) {
+		task_graph_task *task = &graph->tasks[i];
+		if (task->predecessors || task->desc.main_thread) { continue; }
+		job_decl job	  = {task_job, task, task->desc.name, FALSE};
+		jobs[job_count++] = job;
+	}
+	job_run (jobs, job_count, SF_NULL);
+
+	while (sf_atomic_load_u32 (&graph->remaining)) {
+		job_yield_until (main_task_or_done, graph);
+		task_graph_task *task = next_main_task (graph);
+		if (task) {
+			task->ran = TRUE;
+			run_task (task);
+		}
+	}
+	find_critical_path (graph, platform_get_absolute_time_ns () - start_ns);
+}
+
+void task_graph_get_critical_path (const task_graph *graph,
+								   task_graph_path *out_path) {
+	*out_path = graph->critical_path;
+}
+
+const char *task_graph_get_name (const task_graph *graph, u32 id) {
+	return id < graph->task_count ? graph->tasks[id].desc.name : SF_NULL;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/atomic.h"
+
+// Runs a fixed set of tasks once per call, as jobs, in dependency order.
+// Tasks declare the resources they read and write when they are added; a
+// task runs after every earlier-added task it conflicts with (either writes
+// what the other touches), and in parallel with everything else. Adding
+// tasks in the order a serial loop would call them keeps its behaviour.
+// Every run measures the tasks and keeps the critical path, the chain of
+// dependent tasks that bounds how short the run can get.
+
+// Tasks a graph holds at most, dependencies are kept as bit masks.
+#define TASK_GRAPH_MAX_TASKS 64
+
+// Resources are bits 0 to 63 of the read and write masks, what each bit
+// stands for is up to whoever adds the tasks.
+#define TASK_RESOURCE(index) (1ull << (index))
+
+typedef void (*PFN_task) (void* params);
+
+typedef struct task_desc {
+	// A string literal, used as the profiler zone name.
+	const char* name;
+	PFN_task entry;
+	// Passed as-is to entry.
+	void* params;
+	u64 reads;
+	u64 writes;
+	// Run on the thread calling task_graph_run instead of a job worker, for
+	// work that touches the window or other main thread only state.
+	b8 main_thread;
+} task_desc;
+
+typedef struct task_graph_task {
+	task_desc desc;
+	struct task_graph* graph;
+	// Direct dependencies only, ones implied through another are dropped.
+	u64 predecessors;
+	u64 successors;
+	// Predecessors that haven't finished in the current run.
+	sf_atomic_u32 pending;
+	// Set by the calling thread once it ran a main thread task.
+	b8 ran;
+	u64 start_ns;
+	u64 end_ns;
+} task_graph_task;
+
+typedef struct task_graph_path {
+	u32 count;
+	// Task ids, in the order they ran, and how long each took.
+	u32 tasks[TASK_GRAPH_MAX_TASKS];
+	u64 task_ns[TASK_GRAPH_MAX_TASKS];
+	// Time spent in the tasks on the path.
+	u64 duration_ns;
+	// Wall time of the whole run, the gap to duration_ns is time lost to
+	// scheduling or to tasks waiting for a free worker.
+	u64 run_ns;
+} task_graph_path;
+
+typedef struct task_graph {
+	u32 task_count;
+	task_graph_task tasks[TASK_GRAPH_MAX_TASKS];
+	// Dependencies are resolved again on the first run after a task is added.
+	b8 compiled;
+	// Tasks of the current run still to finish.
+	sf_atomic_u32 remaining;
+	task_graph_path critical_path;
+} task_graph;
+
+/**
+* @brief Sets up an empty graph.
+* @param out_graph The graph to initialize.
+*/
+SAPI void task_graph_create (task_graph* out_graph);
+
+/**
+* @brief Adds a task, to run after every task added before it that it conflicts with. Not allowed during task_graph_run.
+* @param graph The graph.
+* @param desc The task, copied.
+* @return The id of the task, INVALID_ID if the graph is full.
+*/
+SAPI u32 task_graph_add (task_graph* graph, const task_desc* desc);
+
+/**
+* @brief Runs every task once and returns when all finished. The calling thread runs the main thread tasks and helps with the others in between. Call from the main thread, or from a thread registered with the job system for the others to run in parallel.
+* @param graph The graph.
+*/
+SAPI void task_graph_run (task_graph* graph);
+
+/**
+* @brief Returns the longest chain of dependent tasks of the last run, weighted by how long each task took.
+* @param graph The graph.
+* @param out_path Receives the path, empty before the first run.
+*/
+SAPI void task_graph_get_critical_path (const task_graph* graph,
+										task_graph_path* out_path);
+
+/**
+* @return The name of the task, NULL if id is out of range.
+*/
+SAPI const char* task_graph_get_name (const task_graph* graph, u32 id);
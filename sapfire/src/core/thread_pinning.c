@@ -0,0 +1,151 @@
+#include "thread_pinning.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include "platform/cpu_topology.h"
+#include "platform/thread.h"
+
+typedef struct thread_pinning_state {
+	thread_pinning_config config;
+	// Processors in the order workers take them: the first hardware thread
+	// of every usable core, package by package, then the SMT siblings.
+	u32 worker_cpus[SF_MAX_CPUS];
+	u32 worker_cpu_count;
+	// Leading entries of worker_cpus that are whole cores.
+	u32 worker_core_count;
+	sf_cpu_set render_cpus;
+	sf_cpu_set io_cpus;
+} thread_pinning_state;
+
+static thread_pinning_state *pState;
+
+// Marks the processors the policy may use, returns how many.
+static u32 select_usable (const sf_cpu_topology *topology,
+						  thread_pin_policy policy, b8 *usable) {
+	sf_cpu_set allowed;
+	b8 restricted = platform_thread_get_current_affinity (&allowed);
+	u32 package	  = INVALID_ID;
+	u32 count	  = 0;
+	for (u32 i = 0; i < topology->logical_count; ++i) {
+		const sf_cpu_info *info = &topology->cpus[i];
+		usable[i]				= FALSE;
+		if (restricted && !sf_cpu_set_has (&allowed, info->id)) { continue; }
+		if (policy == THREAD_PIN_SINGLE_PACKAGE) {
+			if (package == INVALID_ID) { package = info->package; }
+			if (info->package != package) { continue; }
+		}
+		usable[i] = TRUE;
+		++count;
+	}
+	return count;
+}
+
+// Takes the highest usable core out of usable for the render thread.
+static void reserve_render_core (const sf_cpu_topology *topology,
+								 b8 *usable) {
+	u32 core	   = INVALID_ID;
+	u32 core_count = 0;
+	for (u32 i = 0; i < topology->logical_count; ++i) {
+		if (!usable[i] || topology->cpus[i].smt_index != 0) { continue; }
+		core = topology->cpus[i].core;
+		++core_count;
+	}
+	if (core_count < 2) { return; }
+	for (u32 i = 0; i < topology->logical_count; ++i) {
+		if (usable[i] && topology->cpus[i].core == core) {
+			sf_cpu_set_add (&pState->render_cpus, topology->cpus[i].id);
+			usable[i] = FALSE;
+		}
+	}
+}
+
+static void order_worker_cpus (const sf_cpu_topology *topology,
+							   const b8 *usable) {
+	for (u32 smt = 0;; ++smt) {
+		u32 added = 0;
+		for (u32 package = 0; package < topology->package_count; ++package) {
+			for (u32 i = 0; i < topology->logical_count; ++i) {
+				const sf_cpu_info *info = &topology->cpus[i];
+				if (!usable[i] || info->smt_index != smt ||
+					info->package != package) {
+					continue;
+				}
+				pState->worker_cpus[pState->worker_cpu_count++] = info->id;
+				++added;
+			}
+		}
+		if (added == 0) { break; }
+		if (smt == 0) { pState->worker_core_count = added; }
+	}
+}
+
+b8 thread_pinning_initialize (u64 *mem_size, void *memory,
+							  const thread_pinning_config *config) {
+	*mem_size = sizeof (thread_pinning_state);
+	if (memory == SF_NULL) { return FALSE; }
+	sfmemset (memory, 0, sizeof (thread_pinning_state));
+	pState		   = memory;
+	pState->config = *config;
+	if (config->policy == THREAD_PIN_NONE) { return TRUE; }
+
+	sf_cpu_topology topology;
+	if (!platform_cpu_topology_query (&topology)) {
+		SF_WARNING ("CPU topology unavailable, treating every logical "
+					"processor as a core.");
+	}
+	b8 usable[SF_MAX_CPUS];
+	if (select_usable (&topology, config->policy, usable) == 0) {
+		SF_WARNING ("No processors left to pin threads to, pinning is off.");
+		pState->config.policy = THREAD_PIN_NONE;
+		return TRUE;
+	}
+	if (config->isolate_render) { reserve_render_core (&topology, usable); }
+	order_worker_cpus (&topology, usable);
+	// Without a core of its own the render thread floats over the workers'.
+	b8 render_isolated = !sf_cpu_set_is_empty (&pState->render_cpus);
+	if (!render_isolated) {
+		for (u32 i = 0; i < pState->worker_cpu_count; ++i) {
+			sf_cpu_set_add (&pState->render_cpus, pState->worker_cpus[i]);
+		}
+	}
+	// I/O threads get the SMT siblings when there are any, the workers'
+	// processors otherwise.
+	u32 io_first = pState->worker_core_count < pState->worker_cpu_count
+					   ? pState->worker_core_count
+					   : 0;
+	for (u32 i = io_first; i < pState->worker_cpu_count; ++i) {
+		sf_cpu_set_add (&pState->io_cpus, pState->worker_cpus[i]);
+	}
+
+	SF_INFO ("CPU topology: %u packages, %u cores, %u logical processors, "
+			 "%u last-level cache groups.",
+			 topology.package_count, topology.core_count,
+			 topology.logical_count, topology.llc_group_count);
+	SF_INFO ("Pinning threads to %u cores for workers%s.",
+			 pState->worker_core_count,
+			 render_isolated ? " and one for the render thread" : "");
+	return TRUE;
+}
+
+void thread_pinning_shutdown (void *memory) { pState = SF_NULL; }
+
+b8 thread_pinning_apply (thread_role role, u32 index) {
+	if (!pState || pState->config.policy == THREAD_PIN_NONE) { return FALSE; }
+	sf_cpu_set cpus;
+	if (role == THREAD_ROLE_RENDER) {
+		cpus = pState->render_cpus;
+	} else if (role == THREAD_ROLE_IO) {
+		cpus = pState->io_cpus;
+	} else {
+		// The main thread is worker 0.
+		u32 slot = role == THREAD_ROLE_WORKER ? index : 0;
+		sf_cpu_set_clear (&cpus);
+		sf_cpu_set_add (&cpus,
+						pState->worker_cpus[slot % pState->worker_cpu_count]);
+	}
+	return platform_thread_set_current_affinity (&cpus);
+}
+
+u32 thread_pinning_worker_core_count () {
+	if (!pState || pState->config.policy == THREAD_PIN_NONE) { return 0; }
+	return pState->worker_core_count;
+}
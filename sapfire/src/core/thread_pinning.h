@@ -0,0 +1,66 @@
+#pragma once
+
+#include "defines.h"
+
+// Pins engine threads to processors by role, following the policy picked at
+// startup. Unpinned threads migrate between cores, and on machines with more
+// than one package between caches, which shows up as frame time noise.
+// Threads call thread_pinning_apply on themselves when they start; before
+// thread_pinning_initialize, or with THREAD_PIN_NONE, that does nothing.
+
+typedef enum thread_pin_policy {
+	// Leave placement to the OS scheduler.
+	THREAD_PIN_NONE,
+	// The main thread and workers each get a physical core of their own,
+	// filling one package before the next. SMT siblings are only used once
+	// every core has a worker.
+	THREAD_PIN_SPREAD,
+	// Same as THREAD_PIN_SPREAD, limited to the first package the process
+	// may run on so no engine thread talks across the socket interconnect.
+	THREAD_PIN_SINGLE_PACKAGE,
+} thread_pin_policy;
+
+typedef enum thread_role {
+	THREAD_ROLE_MAIN,
+	// Indexed by job worker, 0 being the main thread.
+	THREAD_ROLE_WORKER,
+	THREAD_ROLE_RENDER,
+	// Log writer, profiler server and other mostly sleeping threads.
+	THREAD_ROLE_IO,
+} thread_role;
+
+typedef struct thread_pinning_config {
+	thread_pin_policy policy;
+	// Keep a physical core for the render thread alone, workers and I/O
+	// threads stay off it. Ignored with THREAD_PIN_NONE or a single core.
+	b8 isolate_render;
+} thread_pinning_config;
+
+/**
+* @brief Reads the processor layout and plans where each role runs. If memory is NULL, will populate mem_size.
+* @param mem_size Holds the required memory size of the internal state.
+* @param memory NULL if requesting memory size, otherwise allocated block of memory.
+* @param config The policy; may be NULL when only querying the size.
+* @return TRUE on success; otherwise FALSE.
+*/
+b8 thread_pinning_initialize (u64* mem_size, void* memory,
+							  const thread_pinning_config* config);
+
+/**
+* @brief Stops pinning threads that start from here on; running threads keep their affinity.
+* @param memory Pointer to the memory
+*/
+void thread_pinning_shutdown (void* memory);
+
+/**
+* @brief Pins the calling thread to the processors planned for its role.
+* @param role What the thread does.
+* @param index The job worker index for THREAD_ROLE_WORKER, ignored otherwise.
+* @return TRUE if the thread was pinned; FALSE if pinning is off or the OS refused.
+*/
+SAPI b8 thread_pinning_apply (thread_role role, u32 index);
+
+/**
+* @return Physical cores left for the main thread and workers, the job system's default size when pinning. 0 if pinning is off.
+*/
+SAPI u32 thread_pinning_worker_core_count ();
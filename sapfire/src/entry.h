@@ -43,10 +43,9 @@ int start () {
 		return -1;
 	}
 	char* str = get_mem_usage_str ();
-	SF_DEBUG (str);
+	SF_DEBUG ("%s", str);
 	free (str);
-	application_run (&game_instance);
-	return 0;
+	return application_run (&game_instance);
 }
 #else
 
@@ -72,9 +71,8 @@ int main () {
 		return -1;
 	}
 	char* str = get_mem_usage_str ();
-	SF_DEBUG (str);
+	SF_DEBUG ("%s", str);
 	free (str);
-	application_run (&game_instance);
-	return 0;
+	return application_run (&game_instance);
 }
 #endif
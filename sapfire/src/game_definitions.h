@@ -6,8 +6,18 @@ typedef struct game {
 	application_config app_config;
 
 	b8 (*initialize) (struct game* instance);
+	// Runs on the main thread, which is job worker 0. Jobs kicked with
+	// job_run should be waited on before returning.
 	b8 (*update) (struct game* instance, f32 deltaTime);
-	b8 (*render) (struct game* instance, f32 deltaTime);
+	// bundle->alpha is how far the frame lies between the last two updates.
+	// Runs on the main thread; the bundle goes to the render thread once
+	// this returns, so frame N+1 simulates while frame N is recorded.
+	b8 (*render) (struct game* instance, struct render_bundle* bundle);
+	// Optional. Adds the game's own frame tasks, such as culling, after
+	// initialize. They go between the fixed updates and render, and run in
+	// parallel with anything they don't conflict with, see frame_resource.
+	void (*register_frame_tasks) (struct game* instance,
+								  struct task_graph* graph);
 
 	void* state;
 
@@ -1,6 +0,0 @@
-#include <stdio.h>
-
-int main() {
-    printf("hello\n");
-    return 0;
-}
@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_MEMORY
+
 #include "lin_alloc.h"
 #include "core/logger.h"
 #include "core/sfmemory.h"
@@ -43,7 +45,7 @@ void *linear_allocator_alloc (linear_allocator *allocator, u64 size) {
 				remaining, size);
 			return SF_NULL;
 		}
-		void *block = (u64 *)allocator->mem_block + allocator->allocated;
+		void *block = (u8 *)allocator->mem_block + allocator->allocated;
 		allocator->allocated += size;
 		return block;
 	}
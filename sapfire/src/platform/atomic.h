@@ -0,0 +1,128 @@
+#pragma once
+
+#include "defines.h"
+#include <stdatomic.h>
+
+// Thin wrappers over C11 atomics so engine code doesn't depend on
+// <stdatomic.h> directly (MSVC only has it in C11 mode with extra flags).
+// Loads are acquire and stores release; read-modify-writes are sequentially
+// consistent. The _relaxed variants are for statistics and counters that
+// don't order other memory.
+
+typedef struct sf_atomic_u32 {
+	_Atomic u32 value;
+} sf_atomic_u32;
+
+typedef struct sf_atomic_u64 {
+	_Atomic u64 value;
+} sf_atomic_u64;
+
+typedef struct sf_atomic_ptr {
+	_Atomic (void*) value;
+} sf_atomic_ptr;
+
+static inline void sf_atomic_init_u32 (sf_atomic_u32* a, u32 value) {
+	atomic_init (&a->value, value);
+}
+static inline u32 sf_atomic_load_u32 (sf_atomic_u32* a) {
+	return atomic_load_explicit (&a->value, memory_order_acquire);
+}
+static inline u32 sf_atomic_load_u32_relaxed (sf_atomic_u32* a) {
+	return atomic_load_explicit (&a->value, memory_order_relaxed);
+}
+static inline void sf_atomic_store_u32 (sf_atomic_u32* a, u32 value) {
+	atomic_store_explicit (&a->value, value, memory_order_release);
+}
+static inline u32 sf_atomic_fetch_add_u32 (sf_atomic_u32* a, u32 value) {
+	return atomic_fetch_add (&a->value, value);
+}
+static inline u32 sf_atomic_fetch_sub_u32 (sf_atomic_u32* a, u32 value) {
+	return atomic_fetch_sub (&a->value, value);
+}
+static inline u32 sf_atomic_exchange_u32 (sf_atomic_u32* a, u32 value) {
+	return atomic_exchange (&a->value, value);
+}
+// On failure *expected receives the current value.
+static inline b8 sf_atomic_compare_exchange_u32 (sf_atomic_u32* a,
+												 u32* expected, u32 desired) {
+	return atomic_compare_exchange_strong (&a->value, expected, desired);
+}
+
+static inline void sf_atomic_init_u64 (sf_atomic_u64* a, u64 value) {
+	atomic_init (&a->value, value);
+}
+static inline u64 sf_atomic_load_u64 (sf_atomic_u64* a) {
+	return atomic_load_explicit (&a->value, memory_order_acquire);
+}
+static inline u64 sf_atomic_load_u64_relaxed (sf_atomic_u64* a) {
+	return atomic_load_explicit (&a->value, memory_order_relaxed);
+}
+static inline void sf_atomic_store_u64 (sf_atomic_u64* a, u64 value) {
+	atomic_store_explicit (&a->value, value, memory_order_release);
+}
+static inline void sf_atomic_store_u64_relaxed (sf_atomic_u64* a, u64 value) {
+	atomic_store_explicit (&a->value, value, memory_order_relaxed);
+}
+static inline u64 sf_atomic_fetch_add_u64 (sf_atomic_u64* a, u64 value) {
+	return atomic_fetch_add (&a->value, value);
+}
+static inline u64 sf_atomic_fetch_add_u64_relaxed (sf_atomic_u64* a,
+												   u64 value) {
+	return atomic_fetch_add_explicit (&a->value, value, memory_order_relaxed);
+}
+static inline u64 sf_atomic_fetch_sub_u64 (sf_atomic_u64* a, u64 value) {
+	return atomic_fetch_sub (&a->value, value);
+}
+static inline u64 sf_atomic_fetch_sub_u64_relaxed (sf_atomic_u64* a,
+												   u64 value) {
+	return atomic_fetch_sub_explicit (&a->value, value, memory_order_relaxed);
+}
+static inline u64 sf_atomic_exchange_u64 (sf_atomic_u64* a, u64 value) {
+	return atomic_exchange (&a->value, value);
+}
+static inline u64 sf_atomic_exchange_u64_relaxed (sf_atomic_u64* a,
+												  u64 value) {
+	return atomic_exchange_explicit (&a->value, value, memory_order_relaxed);
+}
+static inline b8 sf_atomic_compare_exchange_u64 (sf_atomic_u64* a,
+												 u64* expected, u64 desired) {
+	return atomic_compare_exchange_strong (&a->value, expected, desired);
+}
+// Raises a to value if it is lower, for peaks and high-water marks.
+static inline void sf_atomic_max_u64 (sf_atomic_u64* a, u64 value) {
+	u64 current = atomic_load_explicit (&a->value, memory_order_relaxed);
+	while (current < value &&
+		   !atomic_compare_exchange_weak_explicit (&a->value, &current, value,
+												   memory_order_relaxed,
+												   memory_order_relaxed)) {}
+}
+
+static inline void sf_atomic_init_ptr (sf_atomic_ptr* a, void* value) {
+	atomic_init (&a->value, value);
+}
+static inline void* sf_atomic_load_ptr (sf_atomic_ptr* a) {
+	return atomic_load_explicit (&a->value, memory_order_acquire);
+}
+static inline void sf_atomic_store_ptr (sf_atomic_ptr* a, void* value) {
+	atomic_store_explicit (&a->value, value, memory_order_release);
+}
+static inline void* sf_atomic_exchange_ptr (sf_atomic_ptr* a, void* value) {
+	return atomic_exchange (&a->value, value);
+}
+static inline b8 sf_atomic_compare_exchange_ptr (sf_atomic_ptr* a,
+												 void** expected,
+												 void* desired) {
+	return atomic_compare_exchange_strong (&a->value, expected, desired);
+}
+
+// Full barrier, and a hint for spin-wait loops.
+static inline void sf_atomic_thread_fence () {
+	atomic_thread_fence (memory_order_seq_cst);
+}
+static inline void sf_cpu_relax () {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause ();
+#elif defined(__aarch64__)
+	__asm__ volatile ("yield");
+#endif
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+
+// Processor layout as the OS reports it: which logical processors are SMT
+// siblings on one physical core, which share caches and which package they
+// sit in. Only Linux reads the real layout, from /sys; elsewhere, and when
+// /sys is missing, every logical processor is reported as a core of its own
+// in a single package.
+
+// Logical processors the topology and affinity sets cover.
+#define SF_MAX_CPUS 256
+
+// A set of logical processors, bit n is processor n.
+typedef struct sf_cpu_set {
+	u64 bits[SF_MAX_CPUS / 64];
+} sf_cpu_set;
+
+typedef struct sf_cpu_info {
+	// Logical processor id, as used in affinity sets.
+	u32 id;
+	// Dense indices, numbered in order of the lowest processor id in each.
+	u32 package;
+	u32 core;
+	// Processors sharing the L2 and the last-level cache.
+	u32 l2_group;
+	u32 llc_group;
+	// 0 for the first hardware thread of its core, 1 for its SMT sibling.
+	u32 smt_index;
+} sf_cpu_info;
+
+typedef struct sf_cpu_topology {
+	u32 logical_count;
+	u32 core_count;
+	u32 package_count;
+	u32 l2_group_count;
+	u32 llc_group_count;
+	// Online processors, sorted by id.
+	sf_cpu_info cpus[SF_MAX_CPUS];
+} sf_cpu_topology;
+
+static inline void sf_cpu_set_clear (sf_cpu_set* set) {
+	for (u32 i = 0; i < SF_MAX_CPUS / 64; ++i) { set->bits[i] = 0; }
+}
+static inline void sf_cpu_set_add (sf_cpu_set* set, u32 cpu) {
+	if (cpu < SF_MAX_CPUS) { set->bits[cpu / 64] |= 1ull << (cpu % 64); }
+}
+static inline b8 sf_cpu_set_has (const sf_cpu_set* set, u32 cpu) {
+	return cpu < SF_MAX_CPUS && (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+static inline b8 sf_cpu_set_is_empty (const sf_cpu_set* set) {
+	for (u32 i = 0; i < SF_MAX_CPUS / 64; ++i) {
+		if (set->bits[i]) { return FALSE; }
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Reads the processor layout. Takes a few hundred small file reads on Linux, query once at startup.
+ * @param out_topology Receives the layout, filled with the fallback when this returns FALSE.
+ * @return TRUE if the layout came from the OS; FALSE if it is the one-core-per-processor fallback.
+ */
+SAPI b8 platform_cpu_topology_query (sf_cpu_topology* out_topology);
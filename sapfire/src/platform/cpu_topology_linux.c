@@ -0,0 +1,164 @@
+#include "cpu_topology.h"
+
+#if SPLATFORM_LINUX
+
+#include "core/sfmemory.h"
+#include "core/sfstring.h"
+#include "platform/thread.h"
+#include <stdio.h>
+
+// Cache descriptions looked at per processor, index0 to index7 in /sys.
+#define MAX_CACHE_INDICES 8
+
+// Set on group keys that stand in for a missing cache description, so they
+// can't collide with a real group's lowest processor id.
+#define FALLBACK_GROUP_KEY (1ull << 63)
+
+static FILE *open_cpu_file (u32 cpu, const char *file) {
+	char path[128];
+	sfstrfmt (path, "/sys/devices/system/cpu/cpu%u/%s", cpu, file);
+	return fopen (path, "r");
+}
+
+static b8 read_cpu_value (u32 cpu, const char *file, i32 *out_value) {
+	FILE *f = open_cpu_file (cpu, file);
+	if (!f) { return FALSE; }
+	b8 result = fscanf (f, "%d", out_value) == 1;
+	fclose (f);
+	return result;
+}
+
+// Parses a processor list such as "0-3,8-11".
+static b8 read_cpu_list (FILE *f, sf_cpu_set *out_set) {
+	sf_cpu_set_clear (out_set);
+	b8 any = FALSE;
+	u32 first;
+	while (fscanf (f, "%u", &first) == 1) {
+		u32 last = first;
+		i32 c	 = fgetc (f);
+		if (c == '-') {
+			if (fscanf (f, "%u", &last) != 1) { return FALSE; }
+			c = fgetc (f);
+		}
+		for (u32 cpu = first; cpu <= last && cpu < SF_MAX_CPUS; ++cpu) {
+			sf_cpu_set_add (out_set, cpu);
+		}
+		any = TRUE;
+		if (c != ',') { break; }
+	}
+	return any;
+}
+
+static u32 first_cpu (const sf_cpu_set *set) {
+	for (u32 cpu = 0; cpu < SF_MAX_CPUS; ++cpu) {
+		if (sf_cpu_set_has (set, cpu)) { return cpu; }
+	}
+	return INVALID_ID;
+}
+
+// Finds the L2 and last-level cache groups of cpu, keyed by the lowest
+// processor sharing each. Leaves the keys alone if /sys has no caches.
+static void read_cache_groups (u32 cpu, u64 *l2_key, u64 *llc_key) {
+	i32 llc_level = 0;
+	for (u32 index = 0; index < MAX_CACHE_INDICES; ++index) {
+		char file[64];
+		i32 level;
+		sfstrfmt (file, "cache/index%u/level", index);
+		if (!read_cpu_value (cpu, file, &level)) { break; }
+		sfstrfmt (file, "cache/index%u/type", index);
+		FILE *f = open_cpu_file (cpu, file);
+		if (!f) { continue; }
+		char type[32] = {0};
+		b8 is_instruction =
+			fscanf (f, "%31s", type) == 1 && sfstreq (type, "Instruction");
+		fclose (f);
+		if (is_instruction) { continue; }
+
+		sfstrfmt (file, "cache/index%u/shared_cpu_list", index);
+		f = open_cpu_file (cpu, file);
+		if (!f) { continue; }
+		sf_cpu_set shared;
+		b8 listed = read_cpu_list (f, &shared);
+		fclose (f);
+		if (!listed) { continue; }
+		if (level == 2) { *l2_key = first_cpu (&shared); }
+		if (level >= llc_level) {
+			llc_level = level;
+			*llc_key  = first_cpu (&shared);
+		}
+	}
+}
+
+// Returns the index of key in keys, appending it if it is new.
+static u32 dense_index (u64 *keys, u32 *count, u64 key) {
+	for (u32 i = 0; i < *count; ++i) {
+		if (keys[i] == key) { return i; }
+	}
+	keys[*count] = key;
+	return (*count)++;
+}
+
+static void fill_fallback (sf_cpu_topology *topology) {
+	u32 count = platform_processor_count ();
+	if (count > SF_MAX_CPUS) { count = SF_MAX_CPUS; }
+	sfmemset (topology, 0, sizeof (sf_cpu_topology));
+	topology->logical_count	  = count;
+	topology->core_count	  = count;
+	topology->package_count	  = 1;
+	topology->l2_group_count  = count;
+	topology->llc_group_count = 1;
+	for (u32 i = 0; i < count; ++i) {
+		topology->cpus[i].id	   = i;
+		topology->cpus[i].core	   = i;
+		topology->cpus[i].l2_group = i;
+	}
+}
+
+b8 platform_cpu_topology_query (sf_cpu_topology *out_topology) {
+	sf_cpu_set online;
+	FILE *f	  = fopen ("/sys/devices/system/cpu/online", "r");
+	b8 listed = f && read_cpu_list (f, &online);
+	if (f) { fclose (f); }
+	if (!listed) {
+		fill_fallback (out_topology);
+		return FALSE;
+	}
+
+	sfmemset (out_topology, 0, sizeof (sf_cpu_topology));
+	u64 package_keys[SF_MAX_CPUS];
+	u64 core_keys[SF_MAX_CPUS];
+	u64 l2_keys[SF_MAX_CPUS];
+	u64 llc_keys[SF_MAX_CPUS];
+	u32 core_threads[SF_MAX_CPUS] = {0};
+	for (u32 cpu = 0; cpu < SF_MAX_CPUS; ++cpu) {
+		if (!sf_cpu_set_has (&online, cpu)) { continue; }
+		i32 package, core;
+		if (!read_cpu_value (cpu, "topology/physical_package_id", &package) ||
+			!read_cpu_value (cpu, "topology/core_id", &core)) {
+			fill_fallback (out_topology);
+			return FALSE;
+		}
+		sf_cpu_info *info = &out_topology->cpus[out_topology->logical_count++];
+		info->id		  = cpu;
+		info->package	  = dense_index (package_keys,
+										 &out_topology->package_count,
+										 (u32)package);
+		// Core ids repeat per package.
+		info->core = dense_index (core_keys, &out_topology->core_count,
+								  ((u64)info->package << 32) | (u32)core);
+		info->smt_index = core_threads[info->core]++;
+
+		// Without cache descriptions, assume a private L2 per core and a
+		// last-level cache per package.
+		u64 l2_key	= FALLBACK_GROUP_KEY | info->core;
+		u64 llc_key = FALLBACK_GROUP_KEY | info->package;
+		read_cache_groups (cpu, &l2_key, &llc_key);
+		info->l2_group =
+			dense_index (l2_keys, &out_topology->l2_group_count, l2_key);
+		info->llc_group =
+			dense_index (llc_keys, &out_topology->llc_group_count, llc_key);
+	}
+	return TRUE;
+}
+
+#endif
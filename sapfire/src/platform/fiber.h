@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+
+// User-mode context switching. A fiber runs on its own stack until it
+// switches to another context explicitly, the OS never preempts one fiber for
+// another. Only x86-64 Linux has an implementation; elsewhere
+// platform_fiber_supported returns FALSE and callers run their work on the
+// thread instead.
+
+// Never returns, a fiber ends by switching away for the last time.
+typedef void (*PFN_fiber_entry) (void* params);
+
+// Saved state of a suspended context. A context that was never initialized
+// can still be switched away from, which saves the calling thread into it.
+typedef struct sf_fiber_context {
+	void* stack_pointer;
+} sf_fiber_context;
+
+/**
+ * @return TRUE if fibers can be created on this platform.
+ */
+SAPI b8 platform_fiber_supported ();
+
+/**
+ * @brief Reserves count stacks in a single mapping, each with an inaccessible guard page below it so an overflow faults instead of corrupting the neighbour. Pages are only committed when touched.
+ * @param count Number of stacks.
+ * @param stack_size Usable bytes per stack, rounded up to the page size.
+ * @param out_stacks Receives the lowest usable address of each stack.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_fiber_stacks_allocate (u32 count, u64 stack_size,
+										void** out_stacks);
+
+/**
+ * @brief Releases stacks from platform_fiber_stacks_allocate, with the same count and size.
+ */
+SAPI void platform_fiber_stacks_free (void** stacks, u32 count,
+									  u64 stack_size);
+
+/**
+ * @brief Prepares a context that calls entry (params) on the given stack the first time it is switched to.
+ * @param stack Lowest address of the stack.
+ * @param stack_size Size of the stack in bytes.
+ * @param entry Must never return.
+ * @param out_context The context to initialize.
+ */
+SAPI void platform_fiber_context_init (void* stack, u64 stack_size,
+									   PFN_fiber_entry entry, void* params,
+									   sf_fiber_context* out_context);
+
+/**
+ * @brief Saves the running context into from and continues to. Returns when something switches back to from, possibly on another thread.
+ */
+SAPI void platform_fiber_switch (sf_fiber_context* from, sf_fiber_context* to);
@@ -0,0 +1,138 @@
+#include "fiber.h"
+
+#if SPLATFORM_LINUX
+
+#include "core/logger.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+
+// MXCSR and x87 control word a new fiber starts with, the ABI defaults.
+#define FIBER_INITIAL_MXCSR 0x1F80
+#define FIBER_INITIAL_FPUCW 0x037F
+
+// Switches by saving the callee-saved registers and the floating point
+// control words on the current stack and loading them from the target
+// stack. Everything else is caller-saved in the System V ABI, so the
+// compiler already spilled it around the call. Much cheaper than
+// swapcontext, which also saves the signal mask with a syscall.
+void sf_fiber_switch_x64 (void** from_stack_pointer, void* to_stack_pointer);
+void sf_fiber_start_x64 ();
+
+__asm__ (".pushsection .text\n"
+		 ".globl sf_fiber_switch_x64\n"
+		 ".hidden sf_fiber_switch_x64\n"
+		 ".type sf_fiber_switch_x64, @function\n"
+		 "sf_fiber_switch_x64:\n"
+		 "	pushq %rbp\n"
+		 "	pushq %rbx\n"
+		 "	pushq %r12\n"
+		 "	pushq %r13\n"
+		 "	pushq %r14\n"
+		 "	pushq %r15\n"
+		 "	subq $8, %rsp\n"
+		 "	stmxcsr (%rsp)\n"
+		 "	fnstcw 4(%rsp)\n"
+		 "	movq %rsp, (%rdi)\n"
+		 "	movq %rsi, %rsp\n"
+		 "	ldmxcsr (%rsp)\n"
+		 "	fldcw 4(%rsp)\n"
+		 "	addq $8, %rsp\n"
+		 "	popq %r15\n"
+		 "	popq %r14\n"
+		 "	popq %r13\n"
+		 "	popq %r12\n"
+		 "	popq %rbx\n"
+		 "	popq %rbp\n"
+		 "	ret\n"
+		 ".size sf_fiber_switch_x64, .-sf_fiber_switch_x64\n"
+		 // First return of a new fiber lands here, with the entry in r12
+		 // and its params in r13.
+		 ".globl sf_fiber_start_x64\n"
+		 ".hidden sf_fiber_start_x64\n"
+		 ".type sf_fiber_start_x64, @function\n"
+		 "sf_fiber_start_x64:\n"
+		 "	movq %r13, %rdi\n"
+		 "	callq *%r12\n"
+		 "	ud2\n"
+		 ".size sf_fiber_start_x64, .-sf_fiber_start_x64\n"
+		 ".popsection\n");
+
+b8 platform_fiber_supported () { return TRUE; }
+
+void platform_fiber_context_init (void *stack, u64 stack_size,
+								  PFN_fiber_entry entry, void *params,
+								  sf_fiber_context *out_context) {
+	// The frame sf_fiber_switch_x64 pops: control words, r15, r14, r13,
+	// r12, rbx, rbp and the return address. It leaves the stack 16-byte
+	// aligned at sf_fiber_start_x64, as the call into entry expects.
+	u64 top	   = ((u64)stack + stack_size) & ~(u64)15;
+	u64 *frame = (u64 *)(top - 80);
+	memset (frame, 0, 80);
+	frame[0] = FIBER_INITIAL_MXCSR | ((u64)FIBER_INITIAL_FPUCW << 32);
+	frame[3] = (u64)params;
+	frame[4] = (u64)entry;
+	frame[7] = (u64)sf_fiber_start_x64;
+	out_context->stack_pointer = frame;
+}
+
+void platform_fiber_switch (sf_fiber_context *from, sf_fiber_context *to) {
+	sf_fiber_switch_x64 (&from->stack_pointer, to->stack_pointer);
+}
+
+#else
+
+b8 platform_fiber_supported () { return FALSE; }
+
+void platform_fiber_context_init (void *stack, u64 stack_size,
+								  PFN_fiber_entry entry, void *params,
+								  sf_fiber_context *out_context) {
+	out_context->stack_pointer = SF_NULL;
+}
+
+void platform_fiber_switch (sf_fiber_context *from, sf_fiber_context *to) {
+	SF_ERROR ("Fibers aren't supported on this architecture.");
+}
+
+#endif
+
+static u64 stack_stride (u64 stack_size, u64 *out_page_size) {
+	u64 page	   = (u64)sysconf (_SC_PAGESIZE);
+	*out_page_size = page;
+	return ((stack_size + page - 1) & ~(page - 1)) + page;
+}
+
+b8 platform_fiber_stacks_allocate (u32 count, u64 stack_size,
+								   void **out_stacks) {
+	u64 page;
+	u64 stride = stack_stride (stack_size, &page);
+	u8 *base   = mmap (SF_NULL, stride * count, PROT_READ | PROT_WRITE,
+					   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+					   -1, 0);
+	if (base == MAP_FAILED) {
+		SF_ERROR ("Failed to map %u fiber stacks: %s.", count,
+				  strerror (errno));
+		return FALSE;
+	}
+	for (u32 i = 0; i < count; ++i) {
+		u8 *guard = base + stride * i;
+		if (mprotect (guard, page, PROT_NONE) != 0) {
+			SF_WARNING ("Failed to protect a fiber stack guard page: %s.",
+						strerror (errno));
+		}
+		out_stacks[i] = guard + page;
+	}
+	return TRUE;
+}
+
+void platform_fiber_stacks_free (void **stacks, u32 count, u64 stack_size) {
+	if (count == 0 || !stacks[0]) { return; }
+	u64 page;
+	u64 stride = stack_stride (stack_size, &page);
+	munmap ((u8 *)stacks[0] - page, stride * count);
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "perf_counters.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+
+static const char *counter_names[PERF_COUNTER_MAX] = {
+	"cycles", "instructions", "cache_misses", "branch_misses"};
+
+const char *platform_perf_counter_name (perf_counter_type type) {
+	return type < PERF_COUNTER_MAX ? counter_names[type] : "unknown";
+}
+
+#if SPLATFORM_LINUX
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+typedef struct perf_counters_internal {
+	i32 leader_fd;
+	i32 fds[PERF_COUNTER_MAX];
+	// Position of each counter in the group read, INVALID_ID if not open.
+	u32 slots[PERF_COUNTER_MAX];
+	u32 open_count;
+} perf_counters_internal;
+
+// Layout of a PERF_FORMAT_GROUP read with both times enabled.
+typedef struct perf_group_read {
+	u64 count;
+	u64 time_enabled;
+	u64 time_running;
+	u64 values[PERF_COUNTER_MAX];
+} perf_group_read;
+
+static const u64 counter_configs[PERF_COUNTER_MAX] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+static i32 open_counter (u64 config, i32 group_fd) {
+	struct perf_event_attr attr;
+	memset (&attr, 0, sizeof (attr));
+	attr.size			= sizeof (attr);
+	attr.type			= PERF_TYPE_HARDWARE;
+	attr.config			= config;
+	attr.disabled		= group_fd == -1;
+	attr.exclude_kernel	= 1;
+	attr.exclude_hv		= 1;
+
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+					   PERF_FORMAT_TOTAL_TIME_RUNNING;
+	// This thread only, on whatever CPU it runs.
+	return (i32)syscall (SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static i32 read_paranoid_level () {
+	FILE *file = fopen ("/proc/sys/kernel/perf_event_paranoid", "r");
+	if (!file) { return -1; }
+	i32 level = -1;
+	if (fscanf (file, "%d", &level) != 1) { level = -1; }
+	fclose (file);
+	return level;
+}
+
+b8 platform_perf_counters_open (perf_counter_group *out_group) {
+	sfmemset (out_group, 0, sizeof (perf_counter_group));
+	perf_counters_internal *internal =
+		sfalloc (sizeof (perf_counters_internal), MEMORY_TAG_PROFILER);
+	internal->leader_fd	= -1;
+	i32 first_error		= 0;
+	for (u32 i = 0; i < PERF_COUNTER_MAX; ++i) {
+		internal->fds[i]   = -1;
+		internal->slots[i] = INVALID_ID;
+		// The first counter that opens leads the group, the rest are
+		// scheduled together with it.
+		i32 fd = open_counter (counter_configs[i], internal->leader_fd);
+		if (fd < 0) {
+			if (!first_error) { first_error = errno; }
+			continue;
+		}
+		internal->fds[i] = fd;
+		if (internal->leader_fd == -1) { internal->leader_fd = fd; }
+		internal->slots[i] = internal->open_count++;
+		out_group->available_mask |= 1u << i;
+	}
+
+	if (internal->leader_fd == -1) {
+		// Containers and VMs often expose no PMU at all, and most distros
+		// restrict perf to root above paranoid level 2.
+		i32 paranoid = read_paranoid_level ();
+		SF_WARNING ("Hardware counters are unavailable: %s "
+					"(perf_event_paranoid %d).",
+					strerror (first_error), paranoid);
+		sffree (internal, sizeof (perf_counters_internal),
+				MEMORY_TAG_PROFILER);
+		return FALSE;
+	}
+	for (u32 i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (internal->slots[i] == INVALID_ID) {
+			SF_WARNING ("The %s counter is unavailable, it reads as 0.",
+						counter_names[i]);
+		}
+	}
+	ioctl (internal->leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl (internal->leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	out_group->internal_data = internal;
+	return TRUE;
+}
+
+void platform_perf_counters_close (perf_counter_group *group) {
+	perf_counters_internal *internal = group->internal_data;
+	if (!internal) { return; }
+	ioctl (internal->leader_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	for (u32 i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (internal->fds[i] >= 0) { close (internal->fds[i]); }
+	}
+	sffree (internal, sizeof (perf_counters_internal), MEMORY_TAG_PROFILER);
+	sfmemset (group, 0, sizeof (perf_counter_group));
+}
+
+b8 platform_perf_counters_read (perf_counter_group *group,
+								perf_counter_sample *out_sample) {
+	sfmemset (out_sample, 0, sizeof (perf_counter_sample));
+	perf_counters_internal *internal = group->internal_data;
+	if (!internal) { return FALSE; }
+	perf_group_read data;
+	if (read (internal->leader_fd, &data, sizeof (data)) <= 0) {
+		return FALSE;
+	}
+	// With more counters than the PMU has, the kernel time-slices the group
+	// and the counts only cover time_running.
+	f64 scale = 1.0;
+	if (data.time_running && data.time_running < data.time_enabled) {
+		scale = (f64)data.time_enabled / data.time_running;
+	}
+	for (u32 i = 0; i < PERF_COUNTER_MAX; ++i) {
+		u32 slot = internal->slots[i];
+		if (slot != INVALID_ID && slot < data.count) {
+			out_sample->values[i] = (u64)(data.values[slot] * scale);
+		}
+	}
+	return TRUE;
+}
+
+#else
+
+b8 platform_perf_counters_open (perf_counter_group *out_group) {
+	sfmemset (out_group, 0, sizeof (perf_counter_group));
+	SF_WARNING ("Hardware counters are only supported on Linux.");
+	return FALSE;
+}
+
+void platform_perf_counters_close (perf_counter_group *group) {}
+
+b8 platform_perf_counters_read (perf_counter_group *group,
+								perf_counter_sample *out_sample) {
+	sfmemset (out_sample, 0, sizeof (perf_counter_sample));
+	return FALSE;
+}
+
+#endif
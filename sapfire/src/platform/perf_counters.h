@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+
+typedef enum perf_counter_type {
+	PERF_COUNTER_CYCLES,
+	PERF_COUNTER_INSTRUCTIONS,
+	PERF_COUNTER_CACHE_MISSES,
+	PERF_COUNTER_BRANCH_MISSES,
+	PERF_COUNTER_MAX
+} perf_counter_type;
+
+// Holds the hardware counters of one thread.
+typedef struct perf_counter_group {
+	// Opaque handle to the internal counters.
+	void* internal_data;
+	// Bit (1 << perf_counter_type) set for every counter that could be
+	// opened, the others always read 0.
+	u32 available_mask;
+} perf_counter_group;
+
+typedef struct perf_counter_sample {
+	u64 values[PERF_COUNTER_MAX];
+} perf_counter_sample;
+
+/**
+ * @brief Starts counting cycles, instructions, cache misses and branch misses of the calling thread in user space. Needs perf_event_paranoid <= 2 on Linux, fails elsewhere.
+ * @param out_group A pointer to a perf_counter_group which holds the handle.
+ * @return TRUE if at least one counter could be opened; otherwise FALSE.
+ */
+SAPI b8 platform_perf_counters_open (perf_counter_group* out_group);
+
+/**
+ * @brief Stops counting and releases the counters.
+ */
+SAPI void platform_perf_counters_close (perf_counter_group* group);
+
+/**
+ * @brief Reads the current values, counted since the group was opened. Must be called on the thread that opened it. Values are scaled up if the kernel had to multiplex the counters.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_perf_counters_read (perf_counter_group* group,
+									 perf_counter_sample* out_sample);
+
+/**
+ * @return A short name for the counter, e.g. "cycles".
+ */
+SAPI const char* platform_perf_counter_name (perf_counter_type type);
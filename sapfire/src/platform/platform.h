@@ -16,10 +16,11 @@ typedef struct platform_state {
 * @param width Width of the window to display in screen coordinates
 * @param height Height of the window to display in screen coordinates
 * @param render_api Render API to use for rendering.
+* @param headless Use SDL's offscreen (or dummy) video driver and a VK_EXT_headless_surface instead of a visible window.
 * @return TRUE on success FALSE on failure ( in which case SF_FATAL is called ). Note that SDL_CreateWindow does not return a value
 */
 b8 platform_init (platform_state *plat_state, const char *app_name, i32 x,
-				  i32 y, i32 width, i32 height, u8 render_api);
+				  i32 y, i32 width, i32 height, u8 render_api, b8 headless);
 
 /**
 * @brief Shut down the platform. This is called at shutdown time to clean up resources that were allocated by platform_init
@@ -64,6 +65,14 @@ void *platform_set_memory (void *dest, i32 value, u64 size);
 */
 void *platform_copy_memory (void *dest, const void *source, u64 size);
 
+/**
+* @brief Copy memory between regions that may overlap. This is a wrapper around memmove.
+* @param dest The address to copy to.
+* @param source The address to copy from.
+* @param size The size of the memory to copy in bytes
+*/
+void *platform_move_memory (void *dest, const void *source, u64 size);
+
 /**
 * @brief Write a message to the console. This is a wrapper around SDL_LogInfo / SDL_LogWarn / platform_console_write_error
 * @param message * The message to write.
@@ -91,10 +100,22 @@ extent2d platform_get_drawable_extent (platform_state *state);
 */
 u64 platform_get_absolute_time ();
 
+/**
+* @brief Get a monotonic timestamp in nanoseconds. Unaffected by wall clock changes and precise enough for frame timing.
+* @return Nanoseconds since an unspecified point in time.
+*/
+u64 platform_get_absolute_time_ns ();
+
 f64 platform_get_delta_time ();
 
 /**
 * @brief Sleep for a number of milliseconds. This is a wrapper for SDL_Delay (). The difference between this function and platform_sleep () is that it doesn't take into account the delay in the case of an interrupt.
 * @param ms The number of milliseconds to sleep for. A value of 0 means to sleep indefinitely
 */
-void platform_sleep (u32 ms);
\ No newline at end of file
+void platform_sleep (u32 ms);
+
+/**
+* @brief Sleep for at least ns nanoseconds using the most precise sleep the OS offers. Wake-up is still subject to scheduler latency, callers that need to hit a deadline should spin for the last stretch.
+* @param ns The number of nanoseconds to sleep for.
+*/
+void platform_sleep_ns (u64 ns);
\ No newline at end of file
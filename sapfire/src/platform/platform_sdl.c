@@ -5,12 +5,15 @@
 #include <SDL_mouse.h>
 #include <SDL_timer.h>
 #include <SDL_video.h>
+#include <errno.h>
 #include <string.h>
+#include <time.h>
 
 #include "containers/vector.h"
 #include "core/event.h"
 #include "core/input.h"
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "defines.h"
 #include "platform.h"
 #include "renderer/vulkan/vulkan_types.h"
@@ -18,12 +21,45 @@
 typedef struct internal_state {
 	SDL_Window *window;
 	SDL_Surface *surface;
+	b8 headless;
 } internal_state;
 
+static b8 init_headless_video () {
+	// Leave SDL_VIDEODRIVER alone if the user picked one.
+	SDL_setenv ("SDL_VIDEODRIVER", "offscreen", 0);
+	if (SDL_Init (SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS) == 0) {
+		return TRUE;
+	}
+	// The offscreen driver is compiled out of some SDL builds.
+	SF_WARNING ("Failed to initialize SDL video driver '%s' (%s), trying "
+				"'dummy'.",
+				SDL_getenv ("SDL_VIDEODRIVER"), SDL_GetError ());
+	SDL_setenv ("SDL_VIDEODRIVER", "dummy", 1);
+	return SDL_Init (SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS) == 0;
+}
+
 b8 platform_init (platform_state *plat_state, const char *app_name, i32 x,
-				  i32 y, i32 width, i32 height, u8 render_api) {
+				  i32 y, i32 width, i32 height, u8 render_api, b8 headless) {
 	plat_state->internal_state = malloc (sizeof (internal_state));
 	internal_state *state	   = (internal_state *)plat_state->internal_state;
+	state->surface			   = SF_NULL;
+	state->headless			   = headless;
+	if (headless) {
+		if (!init_headless_video ()) {
+			SF_FATAL ("Failed to initialize SDL without a display!");
+			return FALSE;
+		}
+		// Neither driver knows Vulkan, the renderer presents to a
+		// VK_EXT_headless_surface instead.
+		state->window = SDL_CreateWindow (app_name, SDL_WINDOWPOS_UNDEFINED,
+										  SDL_WINDOWPOS_UNDEFINED, width,
+										  height, SDL_WINDOW_HIDDEN);
+		if (!state->window) {
+			SF_FATAL ("Failed to initialize window!");
+			return FALSE;
+		}
+		return TRUE;
+	}
 	if (SDL_Init (SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS) < 0) {
 		SF_FATAL ("Failed to initialize SDL!");
 		return FALSE;
@@ -51,6 +87,12 @@ void platform_get_required_extension_names (struct platform_state *plat_state,
 	internal_state *state  = (internal_state *)plat_state->internal_state;
 	u32 ext_count		   = 0;
 	const char **ext_names = SF_NULL;
+	if (state->headless) {
+		vector_push (*names_vec, (const char *)VK_KHR_SURFACE_EXTENSION_NAME);
+		vector_push (*names_vec,
+					 (const char *)VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+		return;
+	}
 	SDL_Vulkan_GetInstanceExtensions (state->window, &ext_count, SF_NULL);
 	ext_names = platform_allocate (sizeof (const char *) * ext_count, FALSE);
 	SDL_Vulkan_GetInstanceExtensions (state->window, &ext_count, ext_names);
@@ -63,11 +105,26 @@ void platform_get_required_extension_names (struct platform_state *plat_state,
 b8 platform_create_vulkan_surface (platform_state *plat_state,
 								   struct vulkan_context *context) {
 	internal_state *state = (internal_state *)plat_state->internal_state;
+	if (state->headless) {
+		PFN_vkCreateHeadlessSurfaceEXT create_surface =
+			(PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr (
+				context->instance, "vkCreateHeadlessSurfaceEXT");
+		if (!create_surface) {
+			SF_ERROR ("VK_EXT_headless_surface is not available.");
+			return FALSE;
+		}
+		VkHeadlessSurfaceCreateInfoEXT create_info = {
+			VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT};
+		return create_surface (context->instance, &create_info,
+							   context->allocator,
+							   &context->surface) == VK_SUCCESS;
+	}
 	return SDL_Vulkan_CreateSurface (state->window, context->instance,
 									 &context->surface);
 }
 
 b8 platform_update_internal_state (platform_state *plat_state) {
+	SF_PROFILE_ZONE ("platform_update_internal_state");
 	internal_state *state = (internal_state *)plat_state->internal_state;
 	SDL_Event e;
 	event_context context;
@@ -91,7 +148,7 @@ b8 platform_update_internal_state (platform_state *plat_state) {
 			case SDL_MOUSEMOTION:
 				input_process_mouse_move (e.motion.x, e.motion.y);
 				break;
-			case SDL_MOUSEWHEEL_NORMAL:
+			case SDL_MOUSEWHEEL:
 				input_process_mouse_wheel (e.wheel.y);
 				break;
 			case SDL_WINDOWEVENT:
@@ -121,6 +178,10 @@ void *platform_copy_memory (void *dest, const void *source, u64 size) {
 	return memcpy (dest, source, size);
 }
 
+void *platform_move_memory (void *dest, const void *source, u64 size) {
+	return memmove (dest, source, size);
+}
+
 void platform_console_write (const char *message, log_level level) {
 	switch (level) {
 		case LOG_LEVEL_DEBUG:
@@ -152,12 +213,35 @@ void platform_console_write_error (const char *message, b8 fatal) {
 
 u64 platform_get_absolute_time () { return SDL_GetTicks64 (); }
 
+u64 platform_get_absolute_time_ns () {
+	static u64 frequency = 0;
+	if (frequency == 0) { frequency = SDL_GetPerformanceFrequency (); }
+	u64 counter = SDL_GetPerformanceCounter ();
+	// Split to avoid overflowing counter * 1e9.
+	return (counter / frequency) * 1000000000ull +
+		   (counter % frequency) * 1000000000ull / frequency;
+}
+
 void platform_sleep (u32 ms) { SDL_Delay (ms); }
 
+void platform_sleep_ns (u64 ns) {
+#if SPLATFORM_LINUX
+	struct timespec remaining = {(time_t)(ns / 1000000000ull),
+								 (long)(ns % 1000000000ull)};
+	while (nanosleep (&remaining, &remaining) != 0 && errno == EINTR) {}
+#else
+	SDL_Delay ((u32)(ns / 1000000ull));
+#endif
+}
+
 extent2d platform_get_drawable_extent (platform_state *plat_state) {
 	internal_state *state = (internal_state *)plat_state->internal_state;
 	int height, width = 0;
-	SDL_Vulkan_GetDrawableSize (state->window, &width, &height);
+	if (state->headless) {
+		SDL_GetWindowSize (state->window, &width, &height);
+	} else {
+		SDL_Vulkan_GetDrawableSize (state->window, &width, &height);
+	}
 	extent2d extent = {};
 	extent.w		= (f32)width;
 	extent.h		= (f32)height;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "defines.h"
+
+// Holds a handle to a TCP socket.
+typedef struct sf_socket {
+	// Opaque handle to the internal socket.
+	u64 handle;
+	b8 is_valid;
+} sf_socket;
+
+/**
+ * @brief Starts listening for TCP connections on 127.0.0.1, never on other interfaces.
+ * @param port The port to listen on, 0 lets the OS pick one.
+ * @param out_socket A pointer to a sf_socket which holds the listening socket.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_socket_listen_loopback (u16 port, sf_socket* out_socket);
+
+/**
+ * @return The local port a socket is bound to, 0 on failure.
+ */
+SAPI u16 platform_socket_port (sf_socket* socket);
+
+/**
+ * @brief Waits up to timeout_ms for a connection on a listening socket.
+ * @param listener The listening socket.
+ * @param timeout_ms How long to wait.
+ * @param out_client A pointer to a sf_socket which holds the connection.
+ * @return TRUE if a client connected; FALSE on timeout or failure.
+ */
+SAPI b8 platform_socket_accept (sf_socket* listener, u64 timeout_ms,
+								sf_socket* out_client);
+
+/**
+ * @brief Blocks until all of data is sent.
+ * @return TRUE on success, FALSE if the peer went away.
+ */
+SAPI b8 platform_socket_send (sf_socket* socket, const void* data, u64 size);
+
+/**
+ * @brief Closes the socket and invalidates the handle.
+ */
+SAPI void platform_socket_close (sf_socket* socket);
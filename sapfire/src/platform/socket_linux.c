@@ -0,0 +1,91 @@
+#include "socket.h"
+
+#if SPLATFORM_LINUX
+
+#include "core/logger.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+b8 platform_socket_listen_loopback (u16 port, sf_socket *out_socket) {
+	out_socket->is_valid = FALSE;
+	i32 fd				 = socket (AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		SF_ERROR ("Failed to create a socket: %s.", strerror (errno));
+		return FALSE;
+	}
+	// Lets a restarted process take the port back right away.
+	i32 reuse = 1;
+	setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse));
+
+	struct sockaddr_in address;
+	memset (&address, 0, sizeof (address));
+	address.sin_family		= AF_INET;
+	address.sin_port		= htons (port);
+	address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	if (bind (fd, (struct sockaddr *)&address, sizeof (address)) != 0 ||
+		listen (fd, 1) != 0) {
+		SF_ERROR ("Failed to listen on 127.0.0.1:%u: %s.", port,
+				  strerror (errno));
+		close (fd);
+		return FALSE;
+	}
+	out_socket->handle	 = (u64)fd;
+	out_socket->is_valid = TRUE;
+	return TRUE;
+}
+
+u16 platform_socket_port (sf_socket *socket) {
+	if (!socket->is_valid) { return 0; }
+	struct sockaddr_in address;
+	socklen_t length = sizeof (address);
+	if (getsockname ((i32)socket->handle, (struct sockaddr *)&address,
+					 &length) != 0) {
+		return 0;
+	}
+	return ntohs (address.sin_port);
+}
+
+b8 platform_socket_accept (sf_socket *listener, u64 timeout_ms,
+						   sf_socket *out_client) {
+	out_client->is_valid = FALSE;
+	if (!listener->is_valid) { return FALSE; }
+	struct pollfd poll_fd = {.fd = (i32)listener->handle, .events = POLLIN};
+	if (poll (&poll_fd, 1, (i32)timeout_ms) <= 0) { return FALSE; }
+	i32 fd = accept ((i32)listener->handle, SF_NULL, SF_NULL);
+	if (fd < 0) { return FALSE; }
+	fcntl (fd, F_SETFD, FD_CLOEXEC);
+	out_client->handle	 = (u64)fd;
+	out_client->is_valid = TRUE;
+	return TRUE;
+}
+
+b8 platform_socket_send (sf_socket *socket, const void *data, u64 size) {
+	if (!socket->is_valid) { return FALSE; }
+	const u8 *bytes = data;
+	while (size) {
+		// MSG_NOSIGNAL: a viewer closing the connection must not raise
+		// SIGPIPE in the engine.
+		ssize_t sent = send ((i32)socket->handle, bytes, size, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR) { continue; }
+			return FALSE;
+		}
+		bytes += sent;
+		size -= sent;
+	}
+	return TRUE;
+}
+
+void platform_socket_close (sf_socket *socket) {
+	if (!socket->is_valid) { return; }
+	close ((i32)socket->handle);
+	socket->is_valid = FALSE;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/atomic.h"
+#include "platform/cpu_topology.h"
+
+typedef u32 (*PFN_thread_start) (void* params);
+
+// Holds a handle to an OS thread.
+typedef struct sf_thread {
+	// Opaque handle to the internal thread handle.
+	void* internal_data;
+	u64 id;
+} sf_thread;
+
+// Futex-backed counting semaphore, no allocation behind it.
+typedef struct sf_semaphore {
+	sf_atomic_u32 count;
+	sf_atomic_u32 waiters;
+} sf_semaphore;
+
+// Futex-backed mutex, spins briefly before sleeping. Not recursive.
+typedef struct sf_mutex {
+	// 0 unlocked, 1 locked, 2 locked with waiters.
+	sf_atomic_u32 state;
+} sf_mutex;
+
+// Condition variable for use with sf_mutex. Wakeups can be spurious, wait
+// in a loop on the actual condition.
+typedef struct sf_condition {
+	sf_atomic_u32 sequence;
+} sf_condition;
+
+// Holds a dynamically allocated thread-local storage slot.
+typedef struct sf_tls_key {
+	u32 handle;
+	b8 is_valid;
+} sf_tls_key;
+
+/**
+ * @brief Creates and immediately starts a thread.
+ * @param start_fn The function to run on the new thread.
+ * @param params Passed as-is to start_fn.
+ * @param out_thread A pointer to a sf_thread which holds the handle.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_thread_create (PFN_thread_start start_fn, void* params,
+								sf_thread* out_thread);
+
+/**
+ * @brief Same as platform_thread_create, and names the thread for debuggers and profilers before start_fn runs.
+ * @param name Up to 15 characters are kept on Linux.
+ */
+SAPI b8 platform_thread_create_named (PFN_thread_start start_fn, void* params,
+									  const char* name, sf_thread* out_thread);
+
+/**
+ * @brief Blocks until the thread finished and releases its handle.
+ * @param thread The thread to join.
+ */
+SAPI void platform_thread_join (sf_thread* thread);
+
+/**
+ * @return An identifier of the calling thread.
+ */
+SAPI u64 platform_thread_current_id ();
+
+/**
+ * @brief Names the calling thread.
+ */
+SAPI void platform_thread_set_current_name (const char* name);
+
+/**
+ * @brief Restricts a thread to the logical processors in cpus.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_thread_set_affinity (sf_thread* thread,
+									  const sf_cpu_set* cpus);
+
+/**
+ * @brief Same as platform_thread_set_affinity for the calling thread.
+ */
+SAPI b8 platform_thread_set_current_affinity (const sf_cpu_set* cpus);
+
+/**
+ * @brief Reads the processors the calling thread may run on, e.g. as narrowed by taskset or a container.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_thread_get_current_affinity (sf_cpu_set* out_cpus);
+
+/**
+ * @brief Gives up the rest of the calling thread's time slice.
+ */
+SAPI void platform_thread_yield ();
+
+/**
+ * @return The number of logical processors online, at least 1.
+ */
+SAPI u32 platform_processor_count ();
+
+/**
+ * @return The number of physical cores online, SMT siblings counted once. Falls back to the logical count if the OS doesn't tell.
+ */
+SAPI u32 platform_physical_core_count ();
+
+/**
+ * @brief Creates a counting semaphore.
+ * @param initial_count The initial count of the semaphore.
+ * @param out_semaphore A pointer to a sf_semaphore which holds the handle.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_semaphore_create (u32 initial_count,
+								   sf_semaphore* out_semaphore);
+SAPI void platform_semaphore_destroy (sf_semaphore* semaphore);
+
+/**
+ * @brief Increments the semaphore, waking one waiter if there is any.
+ */
+SAPI void platform_semaphore_signal (sf_semaphore* semaphore);
+
+/**
+ * @brief Blocks until the semaphore count is above zero, then decrements it.
+ */
+SAPI void platform_semaphore_wait (sf_semaphore* semaphore);
+
+/**
+ * @brief Same as platform_semaphore_wait but gives up after timeout_ms.
+ * @return TRUE if the semaphore was acquired, FALSE on timeout.
+ */
+SAPI b8 platform_semaphore_wait_timeout (sf_semaphore* semaphore,
+										 u64 timeout_ms);
+
+/**
+ * @brief Initializes an unlocked mutex.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_mutex_create (sf_mutex* out_mutex);
+SAPI void platform_mutex_destroy (sf_mutex* mutex);
+SAPI void platform_mutex_lock (sf_mutex* mutex);
+
+/**
+ * @return TRUE if the mutex was free and is now held by the caller.
+ */
+SAPI b8 platform_mutex_try_lock (sf_mutex* mutex);
+SAPI void platform_mutex_unlock (sf_mutex* mutex);
+
+/**
+ * @brief Initializes a condition variable.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_condition_create (sf_condition* out_condition);
+SAPI void platform_condition_destroy (sf_condition* condition);
+
+/**
+ * @brief Unlocks mutex, sleeps until signalled, then locks mutex again. mutex must be held by the caller.
+ */
+SAPI void platform_condition_wait (sf_condition* condition, sf_mutex* mutex);
+
+/**
+ * @brief Same as platform_condition_wait but gives up after timeout_ms. The mutex is held again either way.
+ * @return FALSE on timeout.
+ */
+SAPI b8 platform_condition_wait_timeout (sf_condition* condition,
+										 sf_mutex* mutex, u64 timeout_ms);
+
+/**
+ * @brief Wakes one thread waiting on the condition.
+ */
+SAPI void platform_condition_signal (sf_condition* condition);
+
+/**
+ * @brief Wakes every thread waiting on the condition.
+ */
+SAPI void platform_condition_broadcast (sf_condition* condition);
+
+/**
+ * @brief Allocates a thread-local slot, NULL in every thread until set. Prefer _Thread_local for statics; this is for slots owned by an object.
+ * @return TRUE on success; otherwise FALSE.
+ */
+SAPI b8 platform_tls_create (sf_tls_key* out_key);
+SAPI void platform_tls_destroy (sf_tls_key* key);
+SAPI void* platform_tls_get (sf_tls_key* key);
+SAPI void platform_tls_set (sf_tls_key* key, void* value);
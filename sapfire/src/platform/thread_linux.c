@@ -0,0 +1,323 @@
+// For the cpu_set_t macros and pthread_setaffinity_np.
+#define _GNU_SOURCE
+
+#include "thread.h"
+
+#if SPLATFORM_LINUX
+
+#include "core/logger.h"
+#include "core/sfstring.h"
+#include "platform/platform.h"
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Spins before a contended mutex goes to sleep, critical sections in the
+// engine are short enough that the holder usually releases within this.
+#define MUTEX_SPIN_COUNT 100
+
+// Linux truncates thread names to 15 characters.
+#define THREAD_NAME_LENGTH 16
+
+typedef struct thread_start_data {
+	PFN_thread_start start_fn;
+	void *params;
+	char name[THREAD_NAME_LENGTH];
+} thread_start_data;
+
+static void *thread_trampoline (void *data) {
+	thread_start_data start = *(thread_start_data *)data;
+	platform_free (data, FALSE);
+	if (start.name[0]) { prctl (PR_SET_NAME, start.name, 0, 0, 0); }
+	return (void *)(u64)start.start_fn (start.params);
+}
+
+b8 platform_thread_create_named (PFN_thread_start start_fn, void *params,
+								 const char *name, sf_thread *out_thread) {
+	if (!start_fn) { return FALSE; }
+	thread_start_data *start =
+		platform_allocate (sizeof (thread_start_data), FALSE);
+	start->start_fn = start_fn;
+	start->params	= params;
+	start->name[0]	= 0;
+	if (name) {
+		u64 length = sfstrlen (name);
+		if (length > THREAD_NAME_LENGTH - 1) {
+			length = THREAD_NAME_LENGTH - 1;
+		}
+		platform_copy_memory (start->name, name, length);
+		start->name[length] = 0;
+	}
+	pthread_t *handle = platform_allocate (sizeof (pthread_t), FALSE);
+	i32 result		  = pthread_create (handle, 0, thread_trampoline, start);
+	if (result != 0) {
+		SF_ERROR ("pthread_create failed with error %d.", result);
+		platform_free (start, FALSE);
+		platform_free (handle, FALSE);
+		return FALSE;
+	}
+	out_thread->internal_data = handle;
+	out_thread->id			  = (u64)*handle;
+	return TRUE;
+}
+
+b8 platform_thread_create (PFN_thread_start start_fn, void *params,
+						   sf_thread *out_thread) {
+	return platform_thread_create_named (start_fn, params, SF_NULL,
+										 out_thread);
+}
+
+void platform_thread_join (sf_thread *thread) {
+	if (!thread->internal_data) { return; }
+	pthread_join (*(pthread_t *)thread->internal_data, 0);
+	platform_free (thread->internal_data, FALSE);
+	thread->internal_data = SF_NULL;
+	thread->id			  = 0;
+}
+
+u64 platform_thread_current_id () { return (u64)pthread_self (); }
+
+void platform_thread_set_current_name (const char *name) {
+	char truncated[THREAD_NAME_LENGTH];
+	u64 length = sfstrlen (name);
+	if (length > THREAD_NAME_LENGTH - 1) { length = THREAD_NAME_LENGTH - 1; }
+	platform_copy_memory (truncated, name, length);
+	truncated[length] = 0;
+	prctl (PR_SET_NAME, truncated, 0, 0, 0);
+}
+
+static b8 set_affinity (pthread_t thread, const sf_cpu_set *cpus) {
+	cpu_set_t set;
+	CPU_ZERO (&set);
+	for (u32 i = 0; i < SF_MAX_CPUS && i < CPU_SETSIZE; ++i) {
+		if (sf_cpu_set_has (cpus, i)) { CPU_SET (i, &set); }
+	}
+	i32 result = pthread_setaffinity_np (thread, sizeof (set), &set);
+	if (result != 0) {
+		SF_WARNING ("Failed to set the thread affinity: error %d.", result);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+b8 platform_thread_set_affinity (sf_thread *thread, const sf_cpu_set *cpus) {
+	if (!thread->internal_data) { return FALSE; }
+	return set_affinity (*(pthread_t *)thread->internal_data, cpus);
+}
+
+b8 platform_thread_set_current_affinity (const sf_cpu_set *cpus) {
+	return set_affinity (pthread_self (), cpus);
+}
+
+b8 platform_thread_get_current_affinity (sf_cpu_set *out_cpus) {
+	cpu_set_t set;
+	sf_cpu_set_clear (out_cpus);
+	if (pthread_getaffinity_np (pthread_self (), sizeof (set), &set) != 0) {
+		return FALSE;
+	}
+	for (u32 i = 0; i < SF_MAX_CPUS && i < CPU_SETSIZE; ++i) {
+		if (CPU_ISSET (i, &set)) { sf_cpu_set_add (out_cpus, i); }
+	}
+	return TRUE;
+}
+
+void platform_thread_yield () { sched_yield (); }
+
+u32 platform_processor_count () {
+	long count = sysconf (_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+}
+
+u32 platform_physical_core_count () {
+	sf_cpu_topology topology;
+	platform_cpu_topology_query (&topology);
+	return topology.core_count ? topology.core_count : 1;
+}
+
+// Sleeps while *address == expected, for at most timeout_ns if it isn't 0.
+// Returns FALSE only on timeout; wakeups, signals and a changed value all
+// return TRUE and the caller re-checks.
+static b8 futex_wait (sf_atomic_u32 *address, u32 expected, u64 timeout_ns) {
+	struct timespec timeout;
+	struct timespec *timeout_ptr = SF_NULL;
+	if (timeout_ns) {
+		timeout.tv_sec	= timeout_ns / 1000000000ull;
+		timeout.tv_nsec = timeout_ns % 1000000000ull;
+		timeout_ptr		= &timeout;
+	}
+	// A relative timeout, measured on CLOCK_MONOTONIC.
+	long result = syscall (SYS_futex, &address->value, FUTEX_WAIT_PRIVATE,
+						   expected, timeout_ptr, SF_NULL, 0);
+	return result == 0 || errno != ETIMEDOUT;
+}
+
+static void futex_wake (sf_atomic_u32 *address, i32 count) {
+	syscall (SYS_futex, &address->value, FUTEX_WAKE_PRIVATE, count, SF_NULL,
+			 SF_NULL, 0);
+}
+
+static u64 monotonic_ns () {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+b8 platform_semaphore_create (u32 initial_count, sf_semaphore *out_semaphore) {
+	sf_atomic_init_u32 (&out_semaphore->count, initial_count);
+	sf_atomic_init_u32 (&out_semaphore->waiters, 0);
+	return TRUE;
+}
+
+void platform_semaphore_destroy (sf_semaphore *semaphore) {}
+
+void platform_semaphore_signal (sf_semaphore *semaphore) {
+	sf_atomic_fetch_add_u32 (&semaphore->count, 1);
+	if (sf_atomic_load_u32 (&semaphore->waiters)) {
+		futex_wake (&semaphore->count, 1);
+	}
+}
+
+static b8 semaphore_try_take (sf_semaphore *semaphore) {
+	u32 count = sf_atomic_load_u32_relaxed (&semaphore->count);
+	while (count) {
+		if (sf_atomic_compare_exchange_u32 (&semaphore->count, &count,
+											count - 1)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// timeout_ns 0 waits forever.
+static b8 semaphore_wait (sf_semaphore *semaphore, u64 timeout_ns) {
+	u64 deadline = timeout_ns ? monotonic_ns () + timeout_ns : 0;
+	while (!semaphore_try_take (semaphore)) {
+		u64 remaining = 0;
+		if (deadline) {
+			u64 now = monotonic_ns ();
+			if (now >= deadline) { return FALSE; }
+			remaining = deadline - now;
+		}
+		// Registering first means a signal after this either sees the
+		// waiter or changes count before the futex compares it.
+		sf_atomic_fetch_add_u32 (&semaphore->waiters, 1);
+		futex_wait (&semaphore->count, 0, remaining);
+		sf_atomic_fetch_sub_u32 (&semaphore->waiters, 1);
+	}
+	return TRUE;
+}
+
+void platform_semaphore_wait (sf_semaphore *semaphore) {
+	semaphore_wait (semaphore, 0);
+}
+
+b8 platform_semaphore_wait_timeout (sf_semaphore *semaphore, u64 timeout_ms) {
+	if (timeout_ms == 0) { return semaphore_try_take (semaphore); }
+	return semaphore_wait (semaphore, timeout_ms * 1000000ull);
+}
+
+b8 platform_mutex_create (sf_mutex *out_mutex) {
+	sf_atomic_init_u32 (&out_mutex->state, 0);
+	return TRUE;
+}
+
+void platform_mutex_destroy (sf_mutex *mutex) {}
+
+b8 platform_mutex_try_lock (sf_mutex *mutex) {
+	u32 expected = 0;
+	return sf_atomic_compare_exchange_u32 (&mutex->state, &expected, 1);
+}
+
+// Takes the mutex marking it contended, so the unlock always wakes someone.
+static void mutex_lock_contended (sf_mutex *mutex) {
+	while (sf_atomic_exchange_u32 (&mutex->state, 2) != 0) {
+		futex_wait (&mutex->state, 2, 0);
+	}
+}
+
+void platform_mutex_lock (sf_mutex *mutex) {
+	for (u32 i = 0; i < MUTEX_SPIN_COUNT; ++i) {
+		if (platform_mutex_try_lock (mutex)) { return; }
+		sf_cpu_relax ();
+	}
+	mutex_lock_contended (mutex);
+}
+
+void platform_mutex_unlock (sf_mutex *mutex) {
+	if (sf_atomic_fetch_sub_u32 (&mutex->state, 1) != 1) {
+		sf_atomic_store_u32 (&mutex->state, 0);
+		futex_wake (&mutex->state, 1);
+	}
+}
+
+b8 platform_condition_create (sf_condition *out_condition) {
+	sf_atomic_init_u32 (&out_condition->sequence, 0);
+	return TRUE;
+}
+
+void platform_condition_destroy (sf_condition *condition) {}
+
+static b8 condition_wait (sf_condition *condition, sf_mutex *mutex,
+						  u64 timeout_ns) {
+	// A signal between the unlock and the futex call bumps the sequence,
+	// so the futex returns right away instead of missing it.
+	u32 sequence = sf_atomic_load_u32 (&condition->sequence);
+	platform_mutex_unlock (mutex);
+	b8 woken = futex_wait (&condition->sequence, sequence, timeout_ns);
+	mutex_lock_contended (mutex);
+	return woken;
+}
+
+void platform_condition_wait (sf_condition *condition, sf_mutex *mutex) {
+	condition_wait (condition, mutex, 0);
+}
+
+b8 platform_condition_wait_timeout (sf_condition *condition, sf_mutex *mutex,
+									u64 timeout_ms) {
+	if (timeout_ms == 0) { return FALSE; }
+	return condition_wait (condition, mutex, timeout_ms * 1000000ull);
+}
+
+void platform_condition_signal (sf_condition *condition) {
+	sf_atomic_fetch_add_u32 (&condition->sequence, 1);
+	futex_wake (&condition->sequence, 1);
+}
+
+void platform_condition_broadcast (sf_condition *condition) {
+	sf_atomic_fetch_add_u32 (&condition->sequence, 1);
+	futex_wake (&condition->sequence, INT_MAX);
+}
+
+b8 platform_tls_create (sf_tls_key *out_key) {
+	pthread_key_t key;
+	out_key->is_valid = FALSE;
+	if (pthread_key_create (&key, SF_NULL) != 0) {
+		SF_ERROR ("pthread_key_create failed, out of TLS slots.");
+		return FALSE;
+	}
+	out_key->handle	  = (u32)key;
+	out_key->is_valid = TRUE;
+	return TRUE;
+}
+
+void platform_tls_destroy (sf_tls_key *key) {
+	if (!key->is_valid) { return; }
+	pthread_key_delete ((pthread_key_t)key->handle);
+	key->is_valid = FALSE;
+}
+
+void *platform_tls_get (sf_tls_key *key) {
+	return pthread_getspecific ((pthread_key_t)key->handle);
+}
+
+void platform_tls_set (sf_tls_key *key, void *value) {
+	pthread_setspecific ((pthread_key_t)key->handle, value);
+}
+
+#endif
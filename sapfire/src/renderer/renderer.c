@@ -1,7 +1,17 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_RENDERER
+
+#include "core/job_system.h"
 #include "core/logger.h"
+#include "core/metrics.h"
+#include "core/parallel.h"
+#include "core/profiler.h"
 #include "core/sfmemory.h"
+#include "core/thread_pinning.h"
 #include "defines.h"
 #include "math/sfmath.h"
+#include "platform/atomic.h"
+#include "platform/platform.h"
+#include "platform/thread.h"
 #include "renderer.h"
 #include "renderer/renderer_provider.h"
 #include "renderer/renderer_types.h"
@@ -11,6 +21,31 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "resources/stb_image.h"
 
+// Pixels per chunk of the alpha scan, and between checks whether another
+// chunk already found a translucent one.
+#define ALPHA_SCAN_GRAIN (64 * 1024)
+#define ALPHA_SCAN_BLOCK 4096
+
+typedef struct alpha_scan {
+	const u8 *pixels;
+	sf_atomic_u32 translucent;
+} alpha_scan;
+
+static void scan_alpha (u64 begin, u64 end, void *context) {
+	alpha_scan *scan = context;
+	for (u64 block = begin; block < end; block += ALPHA_SCAN_BLOCK) {
+		if (sf_atomic_load_u32_relaxed (&scan->translucent)) { return; }
+		u64 block_end = block + ALPHA_SCAN_BLOCK;
+		if (block_end > end) { block_end = end; }
+		for (u64 i = block; i < block_end; ++i) {
+			if (scan->pixels[i * 4 + 3] < 255) {
+				sf_atomic_store_u32 (&scan->translucent, 1);
+				return;
+			}
+		}
+	}
+}
+
 // temp
 void prep_texture (texture *t) {
 	sfmemset (t, 0, sizeof (texture));
@@ -18,14 +53,19 @@ void prep_texture (texture *t) {
 }
 
 b8 load_texture (renderer *renderer, const char *name, texture *t) {
+	SF_PROFILE_ZONE ("load_texture");
 	stbi_set_flip_vertically_on_load (TRUE);
 	const i32 channel_count = 4;
 	char *fmt_str			= "assets/textures/%s";
 	char path[512];
 	sfstrfmt (path, fmt_str, name);
 	texture temp;
-	u8 *data	  = stbi_load (path, (i32 *)&temp.width, (i32 *)&temp.height,
-							   (i32 *)&temp.channels, channel_count);
+	u8 *data = SF_NULL;
+	{
+		SF_PROFILE_COUNTERS ("load_texture_decode");
+		data = stbi_load (path, (i32 *)&temp.width, (i32 *)&temp.height,
+						  (i32 *)&temp.channels, channel_count);
+	}
 	temp.channels = channel_count;
 	if (!data) {
 		SF_ERROR ("Failed to load texture at path %s", path);
@@ -39,13 +79,11 @@ b8 load_texture (renderer *renderer, const char *name, texture *t) {
 	u32 current_gen = t->generation;
 	t->generation	= INVALID_ID;
 	u64 total_size	= temp.width * temp.height * temp.channels;
-	b8 opaque		= TRUE;
-	for (u32 i = 0; i < total_size; i += channel_count) {
-		if (data[i + 3] < 255) {
-			opaque = FALSE;
-			break;
-		}
-	}
+	alpha_scan scan = {.pixels = data};
+	sf_atomic_init_u32 (&scan.translucent, 0);
+	parallel_for (total_size / channel_count, ALPHA_SCAN_GRAIN, scan_alpha,
+				  &scan);
+	b8 opaque = !sf_atomic_load_u32 (&scan.translucent);
 	renderer_create_texture (renderer, name, temp.width, temp.height,
 							 channel_count, opaque, data, &temp);
 	texture old = *t;
@@ -59,12 +97,154 @@ b8 load_texture (renderer *renderer, const char *name, texture *t) {
 	stbi_image_free (data);
 	return TRUE;
 }
+// Model of the test mesh, drawn when the game submits no draws.
+static mesh_data default_draw () {
+	// No textures, the shader falls back to its default diffuse.
+	mesh_data draw;
+	sfmemset (&draw, 0, sizeof (mesh_data));
+	quat rotation = quat_from_axis_angle (vec3_forward (), 0.01f, false);
+	draw.model	  = quat_to_rotation_matrix (rotation, vec3_zero ());
+	return draw;
+}
+
+static void free_uploads (render_bundle *bundle) {
+	for (u32 i = 0; i < bundle->upload_count; ++i) {
+		render_upload *upload = &bundle->uploads[i];
+		sffree (upload->pixels, upload->size, MEMORY_TAG_TEXTURE);
+	}
+	bundle->upload_count = 0;
+}
+
+// Done for every packet, drawn or dropped, the game waits on the textures.
+// Each upload stalls the render thread until the GPU finished copying it, so
+// packets are meant to carry a few uploads at most.
+static void upload_textures (renderer_provider *provider,
+							 render_bundle *packet) {
+	for (u32 i = 0; i < packet->upload_count; ++i) {
+		const render_upload *upload = &packet->uploads[i];
+		provider->create_texture (upload->name, upload->width, upload->height,
+								  upload->channels, upload->opaque,
+								  upload->pixels, upload->out_texture);
+	}
+	free_uploads (packet);
+}
+
+// start_ns is when the render thread began waiting for the frame, wait_ns
+// how long it was blocked.
+static b8 render_packet (renderer *renderer, render_bundle *packet,
+						 u64 start_ns, u64 wait_ns) {
+	SF_PROFILE_ZONE ("render_packet");
+	if (renderer->last_draw_ns) {
+		renderer->cpu_frame_ms = (start_ns - renderer->last_draw_ns) / 1e6;
+	}
+	renderer->last_draw_ns		= start_ns;
+	renderer_provider *provider = renderer->renderer_provider;
+	upload_textures (provider, packet);
+
+	b8 result = TRUE;
+	if (provider->begin_frame (provider, packet->deltaTime)) {
+		{
+			// Scene and per draw uniform uploads plus command recording.
+			SF_PROFILE_COUNTERS ("upload_and_record_draws");
+			provider->update_scene_data (packet->camera.projection,
+										 packet->camera.view);
+			provider->draw_objects (packet->draws, packet->draw_count);
+		}
+		// End the renderer provider.
+		if (!provider->end_frame (provider)) {
+			SF_FATAL ("Could not end frame!");
+			result = FALSE;
+		}
+	}
+	renderer->cpu_render_ms =
+		(platform_get_absolute_time_ns () - start_ns) / 1e6;
+	renderer->cpu_wait_ms = wait_ns / 1e6;
+	SF_METRIC_GAUGE ("render_fence_wait_ms", renderer->cpu_wait_ms);
+	SF_METRIC_GAUGE ("render_work_ms",
+					 renderer->cpu_render_ms - renderer->cpu_wait_ms);
+
+	platform_mutex_lock (&renderer->timings_lock);
+	renderer->timings.cpu_frame_ms	  = renderer->cpu_frame_ms;
+	renderer->timings.cpu_render_ms	  = renderer->cpu_render_ms;
+	renderer->timings.cpu_wait_ms	  = renderer->cpu_wait_ms;
+	renderer->timings.packets_skipped = renderer->packets_skipped;
+	if (provider->get_gpu_timings) {
+		provider->get_gpu_timings (&renderer->timings.gpu);
+	}
+	platform_mutex_unlock (&renderer->timings_lock);
+	return result;
+}
+
+// Hands every packet submitted before the newest one back to the game. On
+// entry the thread holds the ready signal of the oldest, on return that of
+// the newest.
+static void skip_stale_packets (renderer *renderer) {
+	while (sf_atomic_load_u64 (&renderer->packets_submitted) >
+		   renderer->packets_consumed + 1) {
+		render_bundle *stale =
+			&renderer->packets[renderer->packets_consumed %
+							   renderer->packet_count];
+		upload_textures (renderer->renderer_provider, stale);
+		++renderer->packets_consumed;
+		++renderer->packets_skipped;
+		platform_semaphore_signal (&renderer->free_packets);
+		// Signalled right after packets_submitted was raised.
+		platform_semaphore_wait (&renderer->ready_packets);
+		SF_METRIC_COUNT ("render_packets_skipped", 1);
+	}
+}
+
+// Records packets in submission order, or only the newest one available
+// with RENDERER_LATENCY_LOW. Each ready signal is one packet, except for the
+// last one renderer_shutdown sends after everything it submitted.
+static u32 render_thread_main (void *params) {
+	renderer *renderer			= params;
+	renderer_provider *provider = renderer->renderer_provider;
+	thread_pinning_apply (THREAD_ROLE_RENDER, 0);
+	// Lets the provider split draw recording across the job workers.
+	job_register_thread ();
+	for (;;) {
+		platform_semaphore_wait (&renderer->ready_packets);
+		u64 submitted = sf_atomic_load_u64 (&renderer->packets_submitted);
+		if (renderer->packets_consumed == submitted) { break; }
+		// Blocks before the packet is picked, so in low latency mode the
+		// game can submit a newer one meanwhile. A failed wait is retried
+		// and reported by begin_frame.
+		u64 start_ns = platform_get_absolute_time_ns ();
+		SF_PROFILE_BEGIN ("wait_for_frame");
+		provider->wait_for_frame (provider);
+		SF_PROFILE_END ();
+		u64 wait_ns = platform_get_absolute_time_ns () - start_ns;
+		if (renderer->latency_mode == RENDERER_LATENCY_LOW) {
+			skip_stale_packets (renderer);
+		}
+		render_bundle *packet =
+			&renderer->packets[renderer->packets_consumed %
+							   renderer->packet_count];
+		if (!render_packet (renderer, packet, start_ns, wait_ns)) {
+			sf_atomic_store_u32 (&renderer->failed, 1);
+		}
+		++renderer->packets_consumed;
+		platform_semaphore_signal (&renderer->free_packets);
+	}
+	return 0;
+}
+
 b8 renderer_initialize (renderer *renderer, renderer_api api,
 						const char *application_name,
-						struct platform_state *plat_state) {
+						struct platform_state *plat_state,
+						renderer_present_mode present_mode, u32 packet_count,
+						u32 frames_in_flight,
+						renderer_latency_mode latency_mode) {
+	if (frames_in_flight == 0) { frames_in_flight = 2; }
+	if (frames_in_flight > RENDER_MAX_FRAMES_IN_FLIGHT) {
+		frames_in_flight = RENDER_MAX_FRAMES_IN_FLIGHT;
+	}
 	renderer->renderer_provider =
 		sfalloc (sizeof (renderer_provider), MEMORY_TAG_RENDERER);
-	renderer->renderer_provider->default_diffuse = &renderer->default_texture;
+	renderer->renderer_provider->present_mode	  = present_mode;
+	renderer->renderer_provider->frames_in_flight = frames_in_flight;
+	renderer->renderer_provider->default_diffuse  = &renderer->default_texture;
 	renderer_provider_create (api, plat_state, renderer->renderer_provider);
 	// Initialize the renderer provider.
 	if (!renderer->renderer_provider->initialize (
@@ -72,46 +252,151 @@ b8 renderer_initialize (renderer *renderer, renderer_api api,
 		SF_FATAL ("Could not initialize renderer provider.");
 		return FALSE;
 	}
-	renderer->near_clip = 0.1f;
-	renderer->far_clip	= 1000.0f;
+	// Created before the render thread starts, so its first frame can
+	// sample it.
+	const u8 white[4] = {255, 255, 255, 255};
+	prep_texture (&renderer->default_texture);
+	renderer->renderer_provider->create_texture (
+		"default_diffuse", 1, 1, 4, TRUE, white, &renderer->default_texture);
+	renderer->near_clip		  = 0.1f;
+	renderer->far_clip		  = 1000.0f;
+	renderer->last_draw_ns	  = 0;
+	renderer->cpu_frame_ms	  = 0;
+	renderer->cpu_render_ms	  = 0;
+	renderer->cpu_wait_ms	  = 0;
+	renderer->latency_mode	  = latency_mode;
+	renderer->packets_skipped = 0;
 	renderer->projection =
 		mat4_perspective (deg_to_rad (45.0f), 800 / 600.0f, renderer->near_clip,
 						  renderer->far_clip);
 
 	renderer->view = mat4_translation ((vec3){0, 0, 30.0f});
 	renderer->view = mat4_inverse (renderer->view);
+
+	if (packet_count < 2) { packet_count = 2; }
+	if (packet_count > RENDER_MAX_PACKETS) {
+		packet_count = RENDER_MAX_PACKETS;
+	}
+	renderer->packet_count	   = packet_count;
+	renderer->packets_consumed = 0;
+	sfmemset (renderer->packets, 0, sizeof (renderer->packets));
+	for (u32 i = 0; i < packet_count; ++i) {
+		render_bundle *packet = &renderer->packets[i];
+		packet->draw_capacity = RENDER_INITIAL_DRAWS;
+		packet->draws =
+			sfalloc (sizeof (mesh_data) * packet->draw_capacity,
+					 MEMORY_TAG_RENDERER);
+	}
+	sfmemset (&renderer->timings, 0, sizeof (renderer_frame_timings));
+	sf_atomic_init_u64 (&renderer->packets_submitted, 0);
+	sf_atomic_init_u32 (&renderer->failed, 0);
+	if (!platform_semaphore_create (packet_count, &renderer->free_packets) ||
+		!platform_semaphore_create (0, &renderer->ready_packets) ||
+		!platform_mutex_create (&renderer->timings_lock)) {
+		SF_FATAL ("Could not create the render thread's sync objects.");
+		return FALSE;
+	}
+	if (!platform_thread_create_named (render_thread_main, renderer,
+									   "sf_render", &renderer->thread)) {
+		SF_FATAL ("Could not start the render thread.");
+		return FALSE;
+	}
 	return TRUE;
 }
 
 void renderer_shutdown (renderer *renderer) {
-	renderer_destroy_texture (renderer, &renderer->default_texture);
-	renderer_destroy_texture (renderer, &renderer->test_diffuse);
+	// Sent after every submitted packet, so the thread drains them first.
+	platform_semaphore_signal (&renderer->ready_packets);
+	platform_thread_join (&renderer->thread);
+	for (u32 i = 0; i < renderer->packet_count; ++i) {
+		free_uploads (&renderer->packets[i]);
+		sffree (renderer->packets[i].draws,
+				sizeof (mesh_data) * renderer->packets[i].draw_capacity,
+				MEMORY_TAG_RENDERER);
+	}
+	platform_mutex_destroy (&renderer->timings_lock);
+	platform_semaphore_destroy (&renderer->ready_packets);
+	platform_semaphore_destroy (&renderer->free_packets);
+
+	renderer->renderer_provider->destroy_texture (&renderer->default_texture);
 	renderer->renderer_provider->shutdown (renderer->renderer_provider);
 	sffree (renderer->renderer_provider, sizeof (renderer_provider),
 			MEMORY_TAG_RENDERER);
 }
 
+render_bundle *renderer_acquire_bundle (renderer *renderer) {
+	SF_PROFILE_ZONE ("renderer_acquire_bundle");
+	platform_semaphore_wait (&renderer->free_packets);
+	u64 submitted = sf_atomic_load_u64_relaxed (&renderer->packets_submitted);
+	render_bundle *bundle =
+		&renderer->packets[submitted % renderer->packet_count];
+	bundle->deltaTime	 = 0;
+	bundle->alpha		 = 0;
+	bundle->draw_count	 = 0;
+	bundle->upload_count = 0;
+	return bundle;
+}
+
 b8 renderer_draw_frame (renderer *renderer, render_bundle *bundle) {
-	// TODO and NOTE: use the actual data.
-	// Begin rendering the frame.
-	if (renderer->renderer_provider->begin_frame (renderer->renderer_provider,
-												  0)) {
-		renderer->renderer_provider->update_scene_data (renderer->projection,
-														renderer->view);
-		static f32 angle = 0.01f;
-		quat rotation	 = quat_from_axis_angle (vec3_forward (), angle, false);
-		mat4 model		 = quat_to_rotation_matrix (rotation, vec3_zero ());
-		renderer->renderer_provider->update_objects_data (model);
-		// End the renderer provider.
-		if (!renderer->renderer_provider->end_frame (
-				renderer->renderer_provider)) {
-			SF_FATAL ("Could not end frame!");
-			return FALSE;
-		}
+	SF_PROFILE_ZONE ("renderer_draw_frame");
+	bundle->camera.projection = renderer->projection;
+	bundle->camera.view		  = renderer->view;
+	if (bundle->draw_count == 0) {
+		bundle->draws[bundle->draw_count++] = default_draw ();
 	}
+	// Publishes the packet, the render thread reads it after the increment.
+	sf_atomic_fetch_add_u64 (&renderer->packets_submitted, 1);
+	platform_semaphore_signal (&renderer->ready_packets);
+	return !sf_atomic_exchange_u32 (&renderer->failed, 0);
+}
+
+b8 render_bundle_add_draw (render_bundle *bundle, const mesh_data *draw) {
+	if (draw->id >= RENDER_MAX_MESHES) { return FALSE; }
+	if (bundle->draw_count == bundle->draw_capacity) {
+		if (bundle->draw_capacity == RENDER_MAX_DRAWS) { return FALSE; }
+		// The render thread doesn't see the bundle until it's submitted, and
+		// the capacity is kept for the next frames drawn with it.
+		u32 capacity = bundle->draw_capacity * 2;
+		if (capacity > RENDER_MAX_DRAWS) { capacity = RENDER_MAX_DRAWS; }
+		mesh_data *draws =
+			sfalloc (sizeof (mesh_data) * capacity, MEMORY_TAG_RENDERER);
+		sfmemcpy (draws, bundle->draws,
+				  sizeof (mesh_data) * bundle->draw_count);
+		sffree (bundle->draws, sizeof (mesh_data) * bundle->draw_capacity,
+				MEMORY_TAG_RENDERER);
+		bundle->draws		  = draws;
+		bundle->draw_capacity = capacity;
+	}
+	bundle->draws[bundle->draw_count++] = *draw;
 	return TRUE;
 }
 
+b8 render_bundle_add_texture_upload (render_bundle *bundle, const char *name,
+									 u32 width, u32 height, u32 channels,
+									 b8 opaque, const u8 *pixels,
+									 texture *out_texture) {
+	if (bundle->upload_count == RENDER_MAX_UPLOADS) { return FALSE; }
+	render_upload *upload = &bundle->uploads[bundle->upload_count++];
+	upload->name		  = name;
+	upload->width		  = width;
+	upload->height		  = height;
+	upload->channels	  = channels;
+	upload->opaque		  = opaque;
+	upload->size		  = (u64)width * height * channels;
+	upload->pixels		  = sfalloc (upload->size, MEMORY_TAG_TEXTURE);
+	upload->out_texture	  = out_texture;
+	sfmemcpy (upload->pixels, pixels, upload->size);
+	return TRUE;
+}
+
+b8 renderer_get_frame_timings (renderer *renderer,
+							   renderer_frame_timings *out_timings) {
+	platform_mutex_lock (&renderer->timings_lock);
+	*out_timings = renderer->timings;
+	platform_mutex_unlock (&renderer->timings_lock);
+	return out_timings->gpu.supported;
+}
+
 void renderer_set_view (renderer *renderer, mat4 view) {
 	renderer->view = view;
 }
@@ -4,29 +4,68 @@
 #include "renderer_types.h"
 
 /**
-* @brief Initialize a renderer. This is the entry point for renderer_create () and renderer_initialize ().
+* @brief Initialize a renderer and start its render thread. This is the entry point for renderer_create () and renderer_initialize ().
 * @param renderer The renderer to initialize. Mustn't be NULL.
 * @param api The API to use for the renderer. Mustn't be NULL.
 * @param application_name The application name to use for the renderer. May be NULL in which case the renderer will default to the application name specified in the platform_
 * @param plat_state
+* @param present_mode How presentation is synchronized with the display.
+* @param packet_count Packets buffered between the game and the render thread, 2 or 3; 2 if 0.
+* @param frames_in_flight Frames recorded while the GPU works on earlier ones, 1 to 3; 2 if 0.
+* @param latency_mode Whether every packet is drawn or only the newest one.
 */
 b8 renderer_initialize (renderer *renderer, renderer_api api,
 						const char *application_name,
-						struct platform_state *plat_state);
+						struct platform_state *plat_state,
+						renderer_present_mode present_mode, u32 packet_count,
+						u32 frames_in_flight,
+						renderer_latency_mode latency_mode);
 
 /**
-* @brief Shut down a renderer. This is called when the renderer is no longer needed but should be called at some point in the meantime to free the memory allocated by renderer_init
+* @brief Shut down a renderer. Lets the render thread finish the packets already submitted, stops it, then frees the memory allocated by renderer_initialize.
 * @param renderer The renderer to shutdown
 */
 void renderer_shutdown (renderer *renderer);
 
 /**
-* @brief Draw a frame. This is the entry point for rendering and frame data. The renderer must be registered with the renderer_register_render () function before calling this function.
-* @param renderer The renderer to draw to. This is a pointer to the renderer that is currently being rendered.
-* @param bundle An optional bundle of data to be used for rendering.
-* @return TRUE on success FALSE on failure. If FALSE is returned you should check the return value to see what went wrong
+* @brief Hands out the next packet for the game thread to fill. Blocks while the render thread still holds every other packet, which is what keeps the game at most packet_count - 1 frames ahead.
+* @param renderer The renderer to build a frame for.
+* @return An empty bundle, to be passed to renderer_draw_frame.
+*/
+render_bundle *renderer_acquire_bundle (renderer *renderer);
+
+/**
+* @brief Submits a bundle from renderer_acquire_bundle to the render thread and returns without waiting for it to be drawn. The bundle mustn't be touched afterwards.
+* @param renderer The renderer to draw to.
+* @param bundle The filled bundle.
+* @return FALSE if the render thread failed to end a frame since the last call; otherwise TRUE.
 */
 b8 renderer_draw_frame (renderer *renderer, render_bundle *bundle);
 
+/**
+* @brief Adds a draw to a bundle being built.
+* @return FALSE if the bundle is full or the draw's id isn't below RENDER_MAX_MESHES.
+*/
+SAPI b8 render_bundle_add_draw (render_bundle *bundle, const mesh_data *draw);
+
+/**
+* @brief Adds a texture for the render thread to create before it draws the bundle. The pixels are copied, out_texture must stay valid until the frame was drawn.
+* @return FALSE if the bundle holds RENDER_MAX_UPLOADS uploads already.
+*/
+SAPI b8 render_bundle_add_texture_upload (render_bundle *bundle,
+										  const char *name, u32 width,
+										  u32 height, u32 channels, b8 opaque,
+										  const u8 *pixels,
+										  struct texture *out_texture);
+
+/**
+* @brief Get the render thread's CPU time of the last frames next to the GPU time of the most recent frame whose timestamps have been read back. GPU results lag the CPU by the number of frames in flight, the readback never waits on the GPU.
+* @param renderer The renderer to query.
+* @param out_timings Receives the timings. CPU timings are always filled in.
+* @return TRUE if GPU timings are available, FALSE if the device can't provide them.
+*/
+SAPI b8 renderer_get_frame_timings (renderer *renderer,
+									renderer_frame_timings *out_timings);
+
 // HACK: this should not be exposed outside the engine.
 SAPI void renderer_set_view (renderer *renderer, mat4 view);
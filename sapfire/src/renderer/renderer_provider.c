@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_RENDERER
+
 #include "renderer_provider.h"
 #include "core/logger.h"
 #include "renderer/renderer_types.h"
@@ -12,15 +14,16 @@ b8 renderer_provider_create (renderer_api api,
 		case RENDERER_API_VULKAN:
 			out_renderer_provider->initialize		 = vulkan_initialize;
 			out_renderer_provider->shutdown			 = vulkan_shutdown;
+			out_renderer_provider->wait_for_frame	 = vulkan_wait_for_frame;
 			out_renderer_provider->begin_frame		 = vulkan_begin_frame;
 			out_renderer_provider->update_scene_data = vulkan_update_scene_data;
-			out_renderer_provider->update_objects_data =
-				vulkan_update_objects_data;
-			out_renderer_provider->end_frame = vulkan_end_frame;
+			out_renderer_provider->draw_objects		 = vulkan_draw_objects;
+			out_renderer_provider->end_frame		 = vulkan_end_frame;
 			out_renderer_provider->create_texture =
 				vulkan_create_texture;
 			out_renderer_provider->destroy_texture =
 				vulkan_destroy_texture;
+			out_renderer_provider->get_gpu_timings = vulkan_get_gpu_timings;
 			return TRUE;
 		default: SF_FATAL ("The rendering API is not supported"); return FALSE;
 	}
@@ -28,12 +31,14 @@ b8 renderer_provider_create (renderer_api api,
 }
 
 void renderer_provider_shutdown (renderer_provider *provider) {
-	provider->initialize		  = SF_NULL;
-	provider->shutdown			  = SF_NULL;
-	provider->begin_frame		  = SF_NULL;
-	provider->update_scene_data	  = SF_NULL;
-	provider->update_objects_data = SF_NULL;
-	provider->end_frame			  = SF_NULL;
-	provider->create_texture	  = SF_NULL;
-	provider->destroy_texture	  = SF_NULL;
+	provider->initialize		= SF_NULL;
+	provider->shutdown			= SF_NULL;
+	provider->wait_for_frame	= SF_NULL;
+	provider->begin_frame		= SF_NULL;
+	provider->update_scene_data = SF_NULL;
+	provider->draw_objects		= SF_NULL;
+	provider->end_frame			= SF_NULL;
+	provider->create_texture	= SF_NULL;
+	provider->destroy_texture	= SF_NULL;
+	provider->get_gpu_timings	= SF_NULL;
 }
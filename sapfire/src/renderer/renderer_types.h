@@ -2,6 +2,7 @@
 
 #include "defines.h"
 #include "math/math_types.h"
+#include "platform/thread.h"
 #include "resources/resource_types.h"
 #include <sys/stat.h>
 
@@ -12,6 +13,25 @@ typedef enum renderer_api {
 
 struct texture;
 
+typedef enum renderer_present_mode {
+	// Lowest latency mode that doesn't tear (mailbox), FIFO if unsupported.
+	RENDERER_PRESENT_MODE_DEFAULT,
+	// Always FIFO, presentation waits for vblank.
+	RENDERER_PRESENT_MODE_VSYNC,
+	// Never waits for vblank (immediate, else mailbox), may tear.
+	RENDERER_PRESENT_MODE_IMMEDIATE
+} renderer_present_mode;
+
+typedef enum renderer_latency_mode {
+	// Every packet the game submits is drawn, in order. Keeps the GPU busy
+	// but what's shown can be packets and frames in flight old.
+	RENDERER_LATENCY_THROUGHPUT,
+	// Once the next frame's resources are free the newest packet is drawn
+	// and older ones are dropped, their texture uploads still happen. Shows
+	// the latest simulation at the cost of simulated frames never shown.
+	RENDERER_LATENCY_LOW
+} renderer_latency_mode;
+
 typedef struct scene_camera {
     mat4 projection;
     mat4 view;
@@ -36,28 +56,141 @@ typedef struct mesh_data{
     struct texture* textures[16];
 } mesh_data;
 
+#define RENDERER_MAX_GPU_SCOPES 32
+
+typedef struct renderer_gpu_scope {
+	const char* name;
+	// Nesting level, 0 for the outermost scope of the frame.
+	u8 depth;
+	f64 duration_ms;
+} renderer_gpu_scope;
+
+typedef struct renderer_gpu_timings {
+	// FALSE when the device can't write timestamps on the graphics queue.
+	b8 supported;
+	// Frame the scopes were recorded in, results lag a few frames behind.
+	u64 frame_number;
+	u32 scope_count;
+	renderer_gpu_scope scopes[RENDERER_MAX_GPU_SCOPES];
+	// Single-use command buffers (texture and buffer uploads).
+	u64 upload_count;
+	f64 last_upload_ms;
+	f64 total_upload_ms;
+} renderer_gpu_timings;
+
+typedef struct renderer_frame_timings {
+	// Time between the starts of the last two frames the render thread
+	// recorded.
+	f64 cpu_frame_ms;
+	// Time the render thread spent on the last frame, fence waits included.
+	f64 cpu_render_ms;
+	// Part of cpu_render_ms spent blocked until the GPU finished the frame
+	// whose resources the last one reused, the rest was recording work.
+	f64 cpu_wait_ms;
+	// Packets dropped without being drawn since startup.
+	u64 packets_skipped;
+	renderer_gpu_timings gpu;
+} renderer_frame_timings;
+
 typedef struct renderer_provider {
 	struct platform_state* plat_state;
+	renderer_present_mode present_mode;
+	// Frames recorded while the GPU works on earlier ones, 1 to 3. Both set
+	// before initialize.
+	u32 frames_in_flight;
     struct texture* default_diffuse;
 	b8 (*initialize) (struct renderer_provider* api, const char* app_name,
 					  struct platform_state* plat_state);
 	void (*shutdown) (struct renderer_provider* api);
+	// Blocks until the GPU finished the last frame that used the next
+	// frame's resources. begin_frame does it when this wasn't called.
+	b8 (*wait_for_frame) (struct renderer_provider* api);
 	b8 (*begin_frame) (struct renderer_provider* api, f64 deltaTime);
 	void (*update_scene_data) (mat4 projection, mat4 view);
-	void (*update_objects_data) (mesh_data data);
+	// Records the frame's draws, once between begin_frame and end_frame.
+	// Long lists are split across job workers.
+	void (*draw_objects) (const mesh_data* draws, u32 count);
 	b8 (*end_frame) (struct renderer_provider* api);
     void (*create_texture)(const char* name, u32 width, u32 height, u32 channels, b8 opaque, const u8* pixels, struct texture* out_texture);
     void (*destroy_texture)(struct texture* texture);
+	void (*get_gpu_timings) (renderer_gpu_timings* out_timings);
 } renderer_provider;
 
+// Draws and texture uploads a render packet holds at most. Draws live on the
+// heap and grow on demand from RENDER_INITIAL_DRAWS, a full packet is about
+// 13 MB.
+#define RENDER_MAX_DRAWS	 65536
+#define RENDER_INITIAL_DRAWS 256
+#define RENDER_MAX_UPLOADS	 16
+// Distinct mesh ids, providers keep uniforms and descriptor sets per id.
+#define RENDER_MAX_MESHES 1024
+// Packets the game and render threads pass between them at most, 3 lets the
+// game run up to two frames ahead of the one being recorded.
+#define RENDER_MAX_PACKETS 3
+// Frames the render thread records ahead of the GPU at most. Each holds its
+// own command buffers, uniforms and descriptor sets until the GPU is done.
+#define RENDER_MAX_FRAMES_IN_FLIGHT 3
+
+// A texture created by the render thread before it records the packet.
+typedef struct render_upload {
+	const char* name;
+	u32 width;
+	u32 height;
+	u32 channels;
+	b8 opaque;
+	// A copy owned by the packet, freed once uploaded.
+	u8* pixels;
+	u64 size;
+	struct texture* out_texture;
+} render_upload;
+
+// Everything the render thread needs for a frame. Built by the game thread
+// between renderer_acquire_bundle and renderer_draw_frame, read-only after
+// that until the render thread hands it back.
 typedef struct render_bundle {
 	f64 deltaTime;
+	// Position of this frame between the previous and the latest fixed
+	// update, in [0, 1). Interpolate simulation state with it.
+	f32 alpha;
+	// Stamped from the renderer's projection and view on submit.
+	scene_camera camera;
+	u32 draw_count;
+	// draw_capacity long, grown by the game thread while it fills the bundle.
+	mesh_data* draws;
+	u32 draw_capacity;
+	u32 upload_count;
+	render_upload uploads[RENDER_MAX_UPLOADS];
 } render_bundle;
 
 typedef struct renderer {
 	struct renderer_provider* renderer_provider;
+	// Game thread state, copied into each packet on submit.
 	mat4 projection;
 	mat4 view;
 	f32 near_clip;
 	f32 far_clip;
+
+	// Render thread state.
+	u64 last_draw_ns;
+	f64 cpu_frame_ms;
+	f64 cpu_render_ms;
+	f64 cpu_wait_ms;
+	u64 packets_consumed;
+	u64 packets_skipped;
+	renderer_latency_mode latency_mode;
+	// Sampled by draws without a texture of their own.
+	struct texture default_texture;
+
+	render_bundle packets[RENDER_MAX_PACKETS];
+	u32 packet_count;
+	// Only written by the game thread.
+	sf_atomic_u64 packets_submitted;
+	sf_semaphore free_packets;
+	sf_semaphore ready_packets;
+	// Set by the render thread when a frame failed to end.
+	sf_atomic_u32 failed;
+	sf_thread thread;
+	// Guards timings, written by the render thread after every frame.
+	sf_mutex timings_lock;
+	renderer_frame_timings timings;
 } renderer;
@@ -1,7 +1,10 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_buffer.h"
 #include "core/logger.h"
 #include "core/sfmemory.h"
 #include "renderer/vulkan/vulkan_command_buffer.h"
+#include "renderer/vulkan/vulkan_device.h"
 #include "renderer/vulkan/vulkan_types.h"
 #include "vulkan/vulkan_core.h"
 
@@ -93,7 +96,7 @@ b8 vulkan_buffer_resize (vulkan_context *context, u64 new_size,
 		"Failed to resize buffer because failed to bind the new buffer.");
 	vulkan_buffer_copy (context, queue, cmd_pool, buffer->handle, 0, new_buffer,
 						0, buffer->size);
-	vkDeviceWaitIdle (context->device.logical_device);
+	vulkan_device_wait_idle (context);
 	if (buffer->device_mem) {
 		vkFreeMemory (context->device.logical_device, buffer->device_mem,
 					  context->allocator);
@@ -113,7 +116,7 @@ b8 vulkan_buffer_resize (vulkan_context *context, u64 new_size,
 void vulkan_buffer_copy (vulkan_context *context, VkQueue queue,
 						 VkCommandPool cmd_pool, VkBuffer src, u64 src_offset,
 						 VkBuffer dest, u64 dest_offset, u64 size) {
-	vkDeviceWaitIdle (context->device.logical_device);
+	vulkan_device_wait_idle (context);
 	vulkan_command_buffer temp;
 	vulkan_command_buffer_alloc_and_begin_single_use (context, cmd_pool, &temp);
 	VkBufferCopy copy_region;
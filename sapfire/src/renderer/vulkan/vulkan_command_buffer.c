@@ -1,5 +1,8 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_command_buffer.h"
 #include "core/sfmemory.h"
+#include "renderer/vulkan/vulkan_gpu_timer.h"
 #include "renderer/vulkan/vulkan_types.h"
 #include <vulkan/vulkan_core.h>
 
@@ -29,24 +32,46 @@ void vulkan_command_buffer_free (vulkan_context *context, VkCommandPool pool,
 	cmd_bfr->state	= COMMAND_BUFFER_STATE_NOT_ALLOCATED;
 }
 
+static void begin (vulkan_command_buffer *cmd_bfr,
+				   VkCommandBufferUsageFlags flags,
+				   const VkCommandBufferInheritanceInfo *inheritance) {
+	VkCommandBufferBeginInfo begin_info = {
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	begin_info.flags			= flags;
+	begin_info.pInheritanceInfo = inheritance;
+	VK_ASSERT_SUCCESS (vkBeginCommandBuffer (cmd_bfr->handle, &begin_info),
+					   "Failed to begin command buffer.");
+	cmd_bfr->state = COMMAND_BUFFER_STATE_RECORDING;
+}
+
 void vulkan_command_buffer_begin (vulkan_command_buffer *cmd_bfr, b8 single_use,
 								  b8 render_pass_continue,
 								  b8 simultaneous_use) {
-	VkCommandBufferBeginInfo begin_info = {
-		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-	begin_info.flags = 0;
-	if (single_use) {
-		begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	}
+	VkCommandBufferUsageFlags flags = 0;
+	if (single_use) { flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; }
 	if (render_pass_continue) {
-		begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 	}
 	if (simultaneous_use) {
-		begin_info.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 	}
-	VK_ASSERT_SUCCESS (vkBeginCommandBuffer (cmd_bfr->handle, &begin_info),
-					   "Failed to begin command buffer.");
-	cmd_bfr->state = COMMAND_BUFFER_STATE_RECORDING;
+	begin (cmd_bfr, flags, SF_NULL);
+}
+
+void vulkan_command_buffer_begin_secondary (vulkan_command_buffer *cmd_bfr,
+											VkRenderPass render_pass,
+											VkFramebuffer framebuffer) {
+	VkCommandBufferInheritanceInfo inheritance = {
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+	inheritance.renderPass	= render_pass;
+	inheritance.subpass		= 0;
+	inheritance.framebuffer = framebuffer;
+	begin (cmd_bfr,
+		   VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+			   VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+		   &inheritance);
+	// Recorded as if inside the pass, which the primary is in when it runs.
+	cmd_bfr->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
 }
 
 void vulkan_command_buffer_end (vulkan_command_buffer *cmd_bfr) {
@@ -55,6 +80,18 @@ void vulkan_command_buffer_end (vulkan_command_buffer *cmd_bfr) {
 	cmd_bfr->state = COMMAND_BUFFER_STATE_RECORDING_FINISHED;
 }
 
+void vulkan_command_buffer_execute (vulkan_command_buffer *primary, u32 count,
+									vulkan_command_buffer *const *secondaries) {
+	VkCommandBuffer handles[VULKAN_MAX_RECORD_CHUNKS];
+	SF_ASSERT (count <= VULKAN_MAX_RECORD_CHUNKS,
+			   "Too many secondary command buffers for one execute.");
+	for (u32 i = 0; i < count; ++i) {
+		handles[i]			  = secondaries[i]->handle;
+		secondaries[i]->state = COMMAND_BUFFER_STATE_SUBMITTED;
+	}
+	vkCmdExecuteCommands (primary->handle, count, handles);
+}
+
 void vulkan_command_buffer_update_submitted (vulkan_command_buffer *cmd_bfr) {
 	// TODO: add more checks
 	cmd_bfr->state = COMMAND_BUFFER_STATE_SUBMITTED;
@@ -70,12 +107,17 @@ void vulkan_command_buffer_alloc_and_begin_single_use (
 	vulkan_command_buffer *out_cmd_bfr) {
 	vulkan_command_buffer_create (context, pool, TRUE, out_cmd_bfr);
 	vulkan_command_buffer_begin (out_cmd_bfr, TRUE, FALSE, FALSE);
+	// Only the graphics queue is known to support timestamps.
+	if (pool == context->device.graphics_command_pool) {
+		vulkan_gpu_timer_begin_upload (&context->gpu_timer, out_cmd_bfr);
+	}
 }
 
 void vulkan_command_buffer_end_single_use (vulkan_context *context,
 										   VkCommandPool pool,
 										   vulkan_command_buffer *cmd_bfr,
 										   VkQueue queue) {
+	vulkan_gpu_timer_end_upload (&context->gpu_timer, cmd_bfr);
 	vulkan_command_buffer_end (cmd_bfr);
 
 	VkSubmitInfo submit_info	   = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
@@ -87,5 +129,31 @@ void vulkan_command_buffer_end_single_use (vulkan_context *context,
 	// TODO: perhaps a fence instead of this.
 	VK_ASSERT_SUCCESS (vkQueueWaitIdle (queue),
 					   "Failed to wait for queue to become idle.");
+	vulkan_gpu_timer_read_upload (context, &context->gpu_timer, cmd_bfr);
 	vulkan_command_buffer_free (context, pool, cmd_bfr);
 }
+
+void vulkan_command_pool_create (vulkan_context *context, u32 queue_family,
+								 b8 transient, VkCommandPool *out_pool) {
+	VkCommandPoolCreateInfo pool_create_info = {
+		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+	pool_create_info.queueFamilyIndex = queue_family;
+	pool_create_info.flags =
+		transient ? VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+				  : VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	VK_ASSERT_SUCCESS (vkCreateCommandPool (context->device.logical_device,
+											&pool_create_info,
+											context->allocator, out_pool),
+					   "Failed to create command pool.");
+}
+
+void vulkan_command_pool_destroy (vulkan_context *context, VkCommandPool pool) {
+	vkDestroyCommandPool (context->device.logical_device, pool,
+						  context->allocator);
+}
+
+void vulkan_command_pool_reset (vulkan_context *context, VkCommandPool pool) {
+	VK_ASSERT_SUCCESS (
+		vkResetCommandPool (context->device.logical_device, pool, 0),
+		"Failed to reset command pool.");
+}
@@ -9,7 +9,19 @@ void vulkan_command_buffer_free (vulkan_context* context, VkCommandPool pool,
 								 vulkan_command_buffer* cmd_bfr);
 void vulkan_command_buffer_begin (vulkan_command_buffer* cmd_bfr, b8 single_use,
 								  b8 render_pass_continue, b8 simultaneous_use);
+
+// Begins a secondary buffer that continues subpass 0 of render_pass inside
+// framebuffer, to be run with vulkan_command_buffer_execute. Viewport,
+// scissor and bindings aren't inherited and have to be set again.
+void vulkan_command_buffer_begin_secondary (vulkan_command_buffer* cmd_bfr,
+											VkRenderPass render_pass,
+											VkFramebuffer framebuffer);
 void vulkan_command_buffer_end (vulkan_command_buffer* cmd_bfr);
+
+// Runs recorded secondary buffers from primary, in order. The primary has to
+// be in a subpass begun with secondary command buffer contents.
+void vulkan_command_buffer_execute (vulkan_command_buffer* primary, u32 count,
+									vulkan_command_buffer* const* secondaries);
 void vulkan_command_buffer_update_submitted (vulkan_command_buffer* cmd_bfr);
 void vulkan_command_buffer_reset (vulkan_command_buffer* cmd_bfr);
 
@@ -23,3 +35,13 @@ void vulkan_command_buffer_end_single_use (vulkan_context* context,
 										   VkCommandPool pool,
 										   vulkan_command_buffer* cmd_bfr,
 										   VkQueue queue);
+
+// Command pools are externally synchronized, each thread recording at the
+// same time needs one of its own. Transient pools are meant to be reset as
+// a whole every frame instead of resetting buffers one by one.
+void vulkan_command_pool_create (vulkan_context* context, u32 queue_family,
+								 b8 transient, VkCommandPool* out_pool);
+void vulkan_command_pool_destroy (vulkan_context* context, VkCommandPool pool);
+// Returns every buffer allocated from pool to the initial state. None of
+// them may still be pending on the GPU.
+void vulkan_command_pool_reset (vulkan_context* context, VkCommandPool pool);
@@ -1,6 +1,9 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_device.h"
 #include "containers/vector.h"
 #include "core/logger.h"
+#include "core/metrics.h"
 #include "core/sfmemory.h"
 #include "core/sfstring.h"
 #include "renderer/vulkan/vulkan_types.h"
@@ -170,6 +173,11 @@ b8 vulkan_device_detect_depth_format (vulkan_device *device) {
 	return FALSE;
 }
 
+VkResult vulkan_device_wait_idle (vulkan_context *context) {
+	SF_METRIC_COUNT ("vk_device_wait_idle", 1);
+	return vkDeviceWaitIdle (context->device.logical_device);
+}
+
 b8 physical_device_meets_requirements (
 	VkPhysicalDevice device, VkSurfaceKHR surface,
 	const VkPhysicalDeviceProperties *properties,
@@ -178,6 +186,119 @@ b8 physical_device_meets_requirements (
 	vulkan_physical_device_queue_family_info *out_queue_family_info,
 	vulkan_swapchain_support_info *out_swapchain_support);
 
+// Selects device if it meets the requirements, when require_discrete is set
+// only a discrete GPU qualifies.
+static b8 select_if_suitable (vulkan_context *context, VkPhysicalDevice device,
+							  b8 require_discrete) {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties (device, &properties);
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures (device, &features);
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+	VkPhysicalDeviceMemoryProperties memory;
+#else
+	VkPhysicalDeviceMemoryProperties memory = {};
+#endif
+	vkGetPhysicalDeviceMemoryProperties (device, &memory);
+	b8 supports_device_local_host_visible = FALSE;
+	for (u32 i = 0; i < memory.memoryTypeCount; ++i) {
+		// Check each memory type to see if its bit is set to 1.
+		VkMemoryPropertyFlags flags = memory.memoryTypes[i].propertyFlags;
+		if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0 &&
+			(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0) {
+			supports_device_local_host_visible = TRUE;
+			break;
+		}
+	}
+	// TODO: make this configurable by the engine
+	vulkan_physical_device_requirements requirements;
+	requirements.graphics = TRUE;
+	requirements.present  = TRUE;
+	requirements.transfer = TRUE;
+	// NOTE: Enable this if compute will be required.
+	// requirements.compute = TRUE;
+	requirements.sampler_anisotropy		= TRUE;
+	requirements.discrete_gpu			= require_discrete;
+	requirements.device_extension_names = vector_create (const char *);
+	vector_push (requirements.device_extension_names,
+				 &VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+	vulkan_physical_device_queue_family_info queue_info;
+#else
+	vulkan_physical_device_queue_family_info queue_info = {};
+#endif
+	b8 result = physical_device_meets_requirements (
+		device, context->surface, &properties, &features, &requirements,
+		&queue_info, &context->device.swapchain_support);
+	vector_destroy (requirements.device_extension_names);
+	if (result) {
+		SF_INFO ("Selected device: '%s'.", properties.deviceName);
+		// GPU type, etc.
+		switch (properties.deviceType) {
+			default:
+			case VK_PHYSICAL_DEVICE_TYPE_OTHER:
+				SF_INFO ("GPU type is Unknown.");
+				break;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+				SF_INFO ("GPU type is Integrated.");
+				break;
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+				SF_INFO ("GPU type is Descrete.");
+				break;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+				SF_INFO ("GPU type is Virtual.");
+				break;
+			case VK_PHYSICAL_DEVICE_TYPE_CPU:
+				SF_INFO ("GPU type is CPU.");
+				break;
+		}
+
+		SF_INFO ("GPU Driver version: %d.%d.%d",
+				 VK_VERSION_MAJOR (properties.driverVersion),
+				 VK_VERSION_MINOR (properties.driverVersion),
+				 VK_VERSION_PATCH (properties.driverVersion));
+
+		// Vulkan API version.
+		SF_INFO ("Vulkan API version: %d.%d.%d",
+				 VK_VERSION_MAJOR (properties.apiVersion),
+				 VK_VERSION_MINOR (properties.apiVersion),
+				 VK_VERSION_PATCH (properties.apiVersion));
+
+		// Memory information
+		for (u32 j = 0; j < memory.memoryHeapCount; ++j) {
+			f32 memory_size_gib = (((f32)memory.memoryHeaps[j].size) /
+								   1024.0f / 1024.0f / 1024.0f);
+			if (memory.memoryHeaps[j].flags &
+				VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+				SF_INFO ("Local GPU memory: %.2f GiB", memory_size_gib);
+			} else {
+				SF_INFO ("Shared System memory: %.2f GiB", memory_size_gib);
+			}
+		}
+
+		context->device.physical_device = device;
+		context->device.graphics_queue_index =
+			queue_info.graphics_family_index;
+		context->device.present_queue_index =
+			queue_info.present_family_index;
+		context->device.transfer_queue_index =
+			queue_info.transfer_family_index;
+		// NOTE: set compute index here if needed.
+
+		// Keep a copy of properties, features and memory info
+		// for later use.
+		context->device.properties = properties;
+		context->device.features   = features;
+		context->device.memory	   = memory;
+		context->device.supports_device_local_host_visible =
+			supports_device_local_host_visible;
+		return TRUE;
+	}
+	return FALSE;
+}
+
 // NOTE: this stuff is copied from Kohi
 b8 select_physical_device (vulkan_context *context) {
 	u32 phys_device_count = 0;
@@ -193,111 +314,14 @@ b8 select_physical_device (vulkan_context *context) {
 						   context->instance, &phys_device_count, phys_devices),
 					   "Failed to enumerate physical devices.");
 
-	for (u32 i = 0; i < phys_device_count; ++i) {
-		VkPhysicalDeviceProperties properties;
-		vkGetPhysicalDeviceProperties (phys_devices[i], &properties);
-		VkPhysicalDeviceFeatures features;
-		vkGetPhysicalDeviceFeatures (phys_devices[i], &features);
-
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
-		VkPhysicalDeviceMemoryProperties memory;
-#else
-		VkPhysicalDeviceMemoryProperties memory				= {};
-#endif
-		vkGetPhysicalDeviceMemoryProperties (phys_devices[i], &memory);
-        b8 supports_device_local_host_visible = FALSE;
-        for (u32 i = 0; i < memory.memoryTypeCount; ++i) {
-            // Check each memory type to see if its bit is set to 1.
-            if (
-                ((memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) &&
-                ((memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0)) {
-                supports_device_local_host_visible = TRUE;
-                break;
-            }
-        }
-		// TODO: make this configurable by the engine
-		vulkan_physical_device_requirements requirements;
-		requirements.graphics = TRUE;
-		requirements.present  = TRUE;
-		requirements.transfer = TRUE;
-		// NOTE: Enable this if compute will be required.
-		// requirements.compute = TRUE;
-		requirements.sampler_anisotropy		= TRUE;
-		requirements.discrete_gpu			= TRUE;
-		requirements.device_extension_names = vector_create (const char *);
-		vector_push (requirements.device_extension_names,
-					 &VK_KHR_SWAPCHAIN_EXTENSION_NAME);
-
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
-		vulkan_physical_device_queue_family_info queue_info;
-#else
-		vulkan_physical_device_queue_family_info queue_info = {};
-#endif
-		b8 result = physical_device_meets_requirements (
-			phys_devices[i], context->surface, &properties, &features,
-			&requirements, &queue_info, &context->device.swapchain_support);
-		vector_destroy (requirements.device_extension_names);
-		if (result) {
-			SF_INFO ("Selected device: '%s'.", properties.deviceName);
-			// GPU type, etc.
-			switch (properties.deviceType) {
-				default:
-				case VK_PHYSICAL_DEVICE_TYPE_OTHER:
-					SF_INFO ("GPU type is Unknown.");
-					break;
-				case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
-					SF_INFO ("GPU type is Integrated.");
-					break;
-				case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
-					SF_INFO ("GPU type is Descrete.");
-					break;
-				case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
-					SF_INFO ("GPU type is Virtual.");
-					break;
-				case VK_PHYSICAL_DEVICE_TYPE_CPU:
-					SF_INFO ("GPU type is CPU.");
-					break;
+	// Prefer a discrete GPU, but take any device that meets the other
+	// requirements (integrated, lavapipe on headless machines) if there
+	// is none.
+	for (u32 pass = 0; pass < 2 && !context->device.physical_device; ++pass) {
+		for (u32 i = 0; i < phys_device_count; ++i) {
+			if (select_if_suitable (context, phys_devices[i], pass == 0)) {
+				break;
 			}
-
-			SF_INFO ("GPU Driver version: %d.%d.%d",
-					 VK_VERSION_MAJOR (properties.driverVersion),
-					 VK_VERSION_MINOR (properties.driverVersion),
-					 VK_VERSION_PATCH (properties.driverVersion));
-
-			// Vulkan API version.
-			SF_INFO ("Vulkan API version: %d.%d.%d",
-					 VK_VERSION_MAJOR (properties.apiVersion),
-					 VK_VERSION_MINOR (properties.apiVersion),
-					 VK_VERSION_PATCH (properties.apiVersion));
-
-			// Memory information
-			for (u32 j = 0; j < memory.memoryHeapCount; ++j) {
-				f32 memory_size_gib = (((f32)memory.memoryHeaps[j].size) /
-									   1024.0f / 1024.0f / 1024.0f);
-				if (memory.memoryHeaps[j].flags &
-					VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
-					SF_INFO ("Local GPU memory: %.2f GiB", memory_size_gib);
-				} else {
-					SF_INFO ("Shared System memory: %.2f GiB", memory_size_gib);
-				}
-			}
-
-			context->device.physical_device = phys_devices[i];
-			context->device.graphics_queue_index =
-				queue_info.graphics_family_index;
-			context->device.present_queue_index =
-				queue_info.present_family_index;
-			context->device.transfer_queue_index =
-				queue_info.transfer_family_index;
-			// NOTE: set compute index here if needed.
-
-			// Keep a copy of properties, features and memory info
-			// for later use.
-			context->device.properties = properties;
-			context->device.features   = features;
-			context->device.memory	   = memory;
-			context->device.supports_device_local_host_visible = supports_device_local_host_visible;
-			break;
 		}
 	}
 
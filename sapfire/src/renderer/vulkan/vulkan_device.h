@@ -10,4 +10,7 @@ void vulkan_device_query_swapchain_support (
 	VkPhysicalDevice physical_device, VkSurfaceKHR surface,
 	vulkan_swapchain_support_info* out_support_info);
 
-b8 vulkan_device_detect_depth_format (vulkan_device* device);
\ No newline at end of file
+b8 vulkan_device_detect_depth_format (vulkan_device* device);
+
+// vkDeviceWaitIdle, counted in the vk_device_wait_idle metric.
+VkResult vulkan_device_wait_idle (vulkan_context* context);
@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_fence.h"
 #include "core/logger.h"
 #include <vulkan/vulkan_core.h>
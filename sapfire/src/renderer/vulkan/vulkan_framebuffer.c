@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_framebuffer.h"
 #include "core/logger.h"
 #include "core/sfmemory.h"
@@ -0,0 +1,226 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
+#include "vulkan_gpu_timer.h"
+#include "core/logger.h"
+#include "core/sfmemory.h"
+#include <vulkan/vulkan_core.h>
+
+#define QUERIES_PER_FRAME (VULKAN_GPU_TIMER_MAX_SCOPES * 2)
+
+static VkQueryPool create_pool (vulkan_context *context, u32 query_count) {
+	VkQueryPoolCreateInfo create_info = {
+		VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	create_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+	create_info.queryCount = query_count;
+	VkQueryPool pool	   = VK_NULL_HANDLE;
+	if (vkCreateQueryPool (context->device.logical_device, &create_info,
+						   context->allocator, &pool) != VK_SUCCESS) {
+		SF_ERROR ("Failed to create timestamp query pool.");
+		return VK_NULL_HANDLE;
+	}
+	return pool;
+}
+
+static f64 ticks_to_ms (vulkan_gpu_timer *timer, u64 begin, u64 end) {
+	u64 ticks = (end - begin) & timer->valid_mask;
+	return ticks * timer->period_ns / 1000000.0;
+}
+
+b8 vulkan_gpu_timer_create (vulkan_context *context, u32 frame_count,
+							vulkan_gpu_timer *out_timer) {
+	sfmemset (out_timer, 0, sizeof (vulkan_gpu_timer));
+
+	u32 family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties (context->device.physical_device,
+											  &family_count, SF_NULL);
+	VkQueueFamilyProperties families[32];
+	if (family_count > 32) { family_count = 32; }
+	vkGetPhysicalDeviceQueueFamilyProperties (context->device.physical_device,
+											  &family_count, families);
+	u32 valid_bits =
+		families[context->device.graphics_queue_index].timestampValidBits;
+	f32 period = context->device.properties.limits.timestampPeriod;
+	if (valid_bits == 0 || period <= 0.0f) {
+		SF_INFO ("The graphics queue doesn't support timestamps, GPU timings "
+				 "are disabled.");
+		return FALSE;
+	}
+
+	if (frame_count > VULKAN_GPU_TIMER_MAX_FRAMES) {
+		SF_WARNING ("Only the first %u of %u frames in flight are timed.",
+					VULKAN_GPU_TIMER_MAX_FRAMES, frame_count);
+		frame_count = VULKAN_GPU_TIMER_MAX_FRAMES;
+	}
+	for (u32 i = 0; i < frame_count; ++i) {
+		out_timer->frames[i].pool = create_pool (context, QUERIES_PER_FRAME);
+		if (!out_timer->frames[i].pool) {
+			vulkan_gpu_timer_destroy (context, out_timer);
+			return FALSE;
+		}
+	}
+	out_timer->upload_pool = create_pool (context, 2);
+	if (!out_timer->upload_pool) {
+		vulkan_gpu_timer_destroy (context, out_timer);
+		return FALSE;
+	}
+
+	out_timer->frame_count = frame_count;
+	out_timer->period_ns   = period;
+	out_timer->valid_mask =
+		valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+	out_timer->enabled			 = TRUE;
+	out_timer->results.supported = TRUE;
+	SF_DEBUG ("GPU timer created: %u valid bits, %.3f ns per tick.",
+			  valid_bits, period);
+	return TRUE;
+}
+
+void vulkan_gpu_timer_destroy (vulkan_context *context,
+							   vulkan_gpu_timer *timer) {
+	for (u32 i = 0; i < VULKAN_GPU_TIMER_MAX_FRAMES; ++i) {
+		if (timer->frames[i].pool) {
+			vkDestroyQueryPool (context->device.logical_device,
+								timer->frames[i].pool, context->allocator);
+		}
+	}
+	if (timer->upload_pool) {
+		vkDestroyQueryPool (context->device.logical_device, timer->upload_pool,
+							context->allocator);
+	}
+	sfmemset (timer, 0, sizeof (vulkan_gpu_timer));
+}
+
+static void read_frame (vulkan_context *context, vulkan_gpu_timer *timer,
+						vulkan_gpu_timer_frame *frame) {
+	frame->pending = FALSE;
+	if (frame->scope_count == 0) { return; }
+	// Value followed by availability for each query. Never ask the driver to
+	// wait, a query that isn't available just drops its scope.
+	u64 data[QUERIES_PER_FRAME * 2];
+	VkResult result = vkGetQueryPoolResults (
+		context->device.logical_device, frame->pool, 0, frame->scope_count * 2,
+		sizeof (data), data, sizeof (u64) * 2,
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS && result != VK_NOT_READY) {
+		SF_WARNING ("Failed to read back GPU timestamps.");
+		return;
+	}
+	renderer_gpu_timings *results = &timer->results;
+	results->frame_number		  = frame->frame_number;
+	results->scope_count		  = 0;
+	for (u32 i = 0; i < frame->scope_count; ++i) {
+		const u64 *begin = &data[i * 4];
+		const u64 *end	 = &data[i * 4 + 2];
+		if (!begin[1] || !end[1]) { continue; }
+		renderer_gpu_scope *scope = &results->scopes[results->scope_count++];
+		scope->name				  = frame->names[i];
+		scope->depth			  = frame->depths[i];
+		scope->duration_ms		  = ticks_to_ms (timer, begin[0], end[0]);
+	}
+}
+
+void vulkan_gpu_timer_begin_frame (vulkan_context *context,
+								   vulkan_gpu_timer *timer,
+								   vulkan_command_buffer *cmd_bfr,
+								   u32 frame_index) {
+	timer->recording	 = SF_NULL;
+	timer->open_count	 = 0;
+	timer->open_overflow = 0;
+	++timer->frame_number;
+	if (!timer->enabled || frame_index >= timer->frame_count) { return; }
+
+	vulkan_gpu_timer_frame *frame = &timer->frames[frame_index];
+	if (frame->pending) { read_frame (context, timer, frame); }
+	vkCmdResetQueryPool (cmd_bfr->handle, frame->pool, 0, QUERIES_PER_FRAME);
+	frame->scope_count	= 0;
+	frame->frame_number = timer->frame_number;
+	timer->recording	= frame;
+}
+
+void vulkan_gpu_timer_end_frame (vulkan_gpu_timer *timer) {
+	if (!timer->recording) { return; }
+	if (timer->open_count || timer->open_overflow) {
+		SF_WARNING ("%u GPU timer scopes were left open at the end of the "
+					"frame.",
+					timer->open_count + timer->open_overflow);
+	}
+	timer->recording->pending = TRUE;
+	timer->recording		  = SF_NULL;
+}
+
+void vulkan_gpu_timer_begin_scope (vulkan_gpu_timer *timer,
+								   vulkan_command_buffer *cmd_bfr,
+								   const char *name) {
+	if (!timer || !timer->recording) { return; }
+	if (timer->open_count == VULKAN_GPU_TIMER_MAX_SCOPES) {
+		++timer->open_overflow;
+		return;
+	}
+	vulkan_gpu_timer_frame *frame = timer->recording;
+	// Scopes past the per-frame limit are still tracked so ends stay
+	// balanced, they just aren't written.
+	u32 index = INVALID_ID;
+	if (frame->scope_count < VULKAN_GPU_TIMER_MAX_SCOPES) {
+		index				 = frame->scope_count++;
+		frame->names[index]	 = name;
+		frame->depths[index] = (u8)timer->open_count;
+		vkCmdWriteTimestamp (cmd_bfr->handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+							 frame->pool, index * 2);
+	}
+	timer->open_scopes[timer->open_count++] = index;
+}
+
+void vulkan_gpu_timer_end_scope (vulkan_gpu_timer *timer,
+								 vulkan_command_buffer *cmd_bfr) {
+	if (!timer || !timer->recording) { return; }
+	if (timer->open_overflow) {
+		--timer->open_overflow;
+		return;
+	}
+	if (timer->open_count == 0) {
+		SF_WARNING ("vulkan_gpu_timer_end_scope called without an open scope.");
+		return;
+	}
+	u32 index = timer->open_scopes[--timer->open_count];
+	if (index == INVALID_ID) { return; }
+	vkCmdWriteTimestamp (cmd_bfr->handle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+						 timer->recording->pool, index * 2 + 1);
+}
+
+void vulkan_gpu_timer_begin_upload (vulkan_gpu_timer *timer,
+									vulkan_command_buffer *cmd_bfr) {
+	// Single-use buffers are waited on before the next one is recorded, so
+	// one pair of queries is enough.
+	if (!timer->enabled || timer->upload_command_buffer) { return; }
+	vkCmdResetQueryPool (cmd_bfr->handle, timer->upload_pool, 0, 2);
+	vkCmdWriteTimestamp (cmd_bfr->handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+						 timer->upload_pool, 0);
+	timer->upload_command_buffer = cmd_bfr->handle;
+}
+
+void vulkan_gpu_timer_end_upload (vulkan_gpu_timer *timer,
+								  vulkan_command_buffer *cmd_bfr) {
+	if (timer->upload_command_buffer != cmd_bfr->handle) { return; }
+	vkCmdWriteTimestamp (cmd_bfr->handle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+						 timer->upload_pool, 1);
+}
+
+void vulkan_gpu_timer_read_upload (vulkan_context *context,
+								   vulkan_gpu_timer *timer,
+								   vulkan_command_buffer *cmd_bfr) {
+	if (!timer->upload_command_buffer ||
+		timer->upload_command_buffer != cmd_bfr->handle) {
+		return;
+	}
+	timer->upload_command_buffer = VK_NULL_HANDLE;
+	u64 data[4];
+	VkResult result = vkGetQueryPoolResults (
+		context->device.logical_device, timer->upload_pool, 0, 2,
+		sizeof (data), data, sizeof (u64) * 2,
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS || !data[1] || !data[3]) { return; }
+	renderer_gpu_timings *results = &timer->results;
+	results->last_upload_ms		  = ticks_to_ms (timer, data[0], data[2]);
+	results->total_upload_ms += results->last_upload_ms;
+	++results->upload_count;
+}
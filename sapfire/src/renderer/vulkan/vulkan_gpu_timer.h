@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+// Returns FALSE and leaves the timer disabled if the graphics queue can't
+// write timestamps. Every other function is a no-op on a disabled timer.
+b8 vulkan_gpu_timer_create (vulkan_context* context, u32 frame_count,
+							vulkan_gpu_timer* out_timer);
+void vulkan_gpu_timer_destroy (vulkan_context* context,
+							   vulkan_gpu_timer* timer);
+
+// Must be called right after the command buffer begins recording, once the
+// fence of frame_index has been waited on. Reads back what that frame
+// recorded last time around and resets its queries.
+void vulkan_gpu_timer_begin_frame (vulkan_context* context,
+								   vulkan_gpu_timer* timer,
+								   vulkan_command_buffer* cmd_bfr,
+								   u32 frame_index);
+void vulkan_gpu_timer_end_frame (vulkan_gpu_timer* timer);
+
+// Scopes nest and must be balanced within a frame. name must outlive the
+// readback, string literals are expected.
+void vulkan_gpu_timer_begin_scope (vulkan_gpu_timer* timer,
+								   vulkan_command_buffer* cmd_bfr,
+								   const char* name);
+void vulkan_gpu_timer_end_scope (vulkan_gpu_timer* timer,
+								 vulkan_command_buffer* cmd_bfr);
+
+// Times a single-use command buffer. The result is read by
+// vulkan_gpu_timer_read_upload once the queue it was submitted to is idle.
+void vulkan_gpu_timer_begin_upload (vulkan_gpu_timer* timer,
+									vulkan_command_buffer* cmd_bfr);
+void vulkan_gpu_timer_end_upload (vulkan_gpu_timer* timer,
+								  vulkan_command_buffer* cmd_bfr);
+void vulkan_gpu_timer_read_upload (vulkan_context* context,
+								   vulkan_gpu_timer* timer,
+								   vulkan_command_buffer* cmd_bfr);
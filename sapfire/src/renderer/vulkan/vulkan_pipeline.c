@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_pipeline.h"
 #include "core/sfmemory.h"
 #include "math/math_types.h"
@@ -1,11 +1,19 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "containers/vector.h"
 #include "core/asserts.h"
 #include "core/event.h"
+#include "core/job_system.h"
 #include "core/logger.h"
+#include "core/metrics.h"
+#include "core/parallel.h"
+#include "core/profiler.h"
 #include "core/sfmemory.h"
 #include "core/sfstring.h"
+#include "core/startup_timer.h"
 #include "defines.h"
 #include "math/math_types.h"
+#include "platform/atomic.h"
 #include "platform/platform.h"
 #include "renderer/renderer_types.h"
 #include "renderer/vulkan/vulkan_buffer.h"
@@ -13,6 +21,7 @@
 #include "renderer/vulkan/vulkan_device.h"
 #include "renderer/vulkan/vulkan_fence.h"
 #include "renderer/vulkan/vulkan_framebuffer.h"
+#include "renderer/vulkan/vulkan_gpu_timer.h"
 #include "renderer/vulkan/vulkan_image.h"
 #include "renderer/vulkan/vulkan_render_pass.h"
 #include "renderer/vulkan/vulkan_shader.h"
@@ -25,10 +34,19 @@
 #include <vulkan/vk_platform.h>
 #include <vulkan/vulkan_core.h>
 #define DEBUG
+
+// Draws per secondary command buffer at least. Shorter lists are recorded
+// inline, a job and a vkCmdExecuteCommands cost more than they save there.
+#define MIN_DRAWS_PER_CHUNK 512
+
 // TODO: really think about singletons...
 static vulkan_context context;
 static u32 cached_window_width	= 0;
 static u32 cached_window_height = 0;
+// Latest window size as width << 32 | height, 0 if unchanged. Resize events
+// arrive on the main thread, the render thread owns the swapchain and
+// recreates it at the start of its next frame.
+static sf_atomic_u64 pending_window_extent;
 
 i32 find_memory_index (u32 type_filter, u32 property_flags);
 
@@ -45,17 +63,60 @@ b8 window_resized (u16 code, void *sender, void *listener_list,
 
 b8 recreate_swapchain ();
 
-void create_command_buffers ();
+void create_frames ();
+
+void destroy_frames ();
 
 b8 create_buffers (vulkan_context *context); // TODO: remove this
 
 void upload_data (vulkan_context *context, VkCommandPool pool, VkQueue queue,
 				  vulkan_buffer *buffer, u64 size, u64 offset, void *data);
 
+// The built-in shader is read and built on jobs while vulkan_initialize sets
+// up everything that doesn't depend on it.
+typedef struct shader_startup {
+	vulkan_shader_source sources[SHADER_STAGE_COUNT];
+	texture *default_diffuse;
+	b8 loaded;
+	b8 created;
+} shader_startup;
+
+static shader_startup startup_shader;
+
+// Only needs the file system, overlaps instance and device creation.
+static void load_shader_sources (void *params) {
+	shader_startup *startup = params;
+	u32 phase				= startup_timer_begin ("read_spirv");
+	startup->loaded			= vulkan_shader_load_sources (startup->sources);
+	startup_timer_end (phase);
+}
+
+// Modules, descriptors and the pipeline, which only need the device, the
+// swapchain image count and the render pass.
+static void create_shader (void *params) {
+	shader_startup *startup = params;
+	if (!startup->loaded) { return; }
+	u32 phase = startup_timer_begin ("shader_pipeline");
+	startup->created = vulkan_shader_create (&context, startup->default_diffuse,
+											 startup->sources, &context.shader);
+	vulkan_shader_free_sources (startup->sources);
+	startup_timer_end (phase);
+}
+
 b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 					  struct platform_state *plat_state) {
+	job_counter shader_counter	   = {0};
+	startup_shader.default_diffuse = api->default_diffuse;
+	job_decl load_job = {load_shader_sources, &startup_shader, "read_spirv",
+						 FALSE};
+	job_run (&load_job, 1, &shader_counter);
+
+	u32 phase = startup_timer_begin ("vulkan_instance");
 	event_register (EVENT_CODE_WINDOW_RESIZED, &context, window_resized);
 	context.find_memory_index = find_memory_index;
+	context.present_mode	  = api->present_mode;
+	context.frame_count		  = CLAMP (api->frames_in_flight, 1,
+									   RENDER_MAX_FRAMES_IN_FLIGHT);
 	// TODO: config
 	extent2d extent_window	   = platform_get_drawable_extent (plat_state);
 	context.framebuffer_width  = extent_window.w;
@@ -75,7 +136,7 @@ b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 	SF_DEBUG ("Required extensions:");
 	u32 length = vector_len (ext_names);
 	for (u32 i = 0; i < length; ++i) {
-		SF_DEBUG (ext_names[i]);
+		SF_DEBUG ("%s", ext_names[i]);
 	}
 #endif
 	u32 ext_count			 = vector_len (ext_names);
@@ -131,9 +192,19 @@ b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 #if defined(DEBUG)
 	i32 log_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
 					   VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-	// | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT // This feeds out ALL
-	// the info | VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT // SUPER
-	// verbose, use at your own risk
+	// Info feeds out ALL the info and verbose is SUPER verbose, so only ask
+	// the layers for them when the vulkan category was explicitly turned up
+	// (e.g. SF_LOG_LEVELS=vulkan=trace), never at the TRACE debug default.
+	if (logging_category_level_set (LOG_CATEGORY_VULKAN)) {
+		log_level vulkan_level =
+			logging_get_category_level (LOG_CATEGORY_VULKAN);
+		if (vulkan_level >= LOG_LEVEL_INFO) {
+			log_severity |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+		}
+		if (vulkan_level >= LOG_LEVEL_TRACE) {
+			log_severity |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+		}
+	}
 	VkDebugUtilsMessengerCreateInfoEXT debug_create_info = {
 		VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT};
 	debug_create_info.messageSeverity = log_severity;
@@ -152,6 +223,8 @@ b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 	SF_DEBUG ("Vulkan debugger created.");
 
 #endif
+	startup_timer_end (phase);
+	phase = startup_timer_begin ("vulkan_device");
 	if (!platform_create_vulkan_surface (plat_state, &context)) {
 		SF_FATAL ("Failed to create vulkan surface.");
 		return FALSE;
@@ -161,7 +234,9 @@ b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 		SF_FATAL ("Failed to create vulkan devices.");
 		return FALSE;
 	}
+	startup_timer_end (phase);
 
+	phase = startup_timer_begin ("vulkan_swapchain");
 	vulkan_swapchain_create (&context, context.framebuffer_width,
 							 context.framebuffer_height, &context.swapchain,
 							 SF_NULL);
@@ -171,41 +246,27 @@ b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 					   context.framebuffer_height};
 	vulkan_render_pass_create (&context, color, extent_window, 1.0f, 0,
 							   &context.main_render_pass);
+	context.main_render_pass.name = "main_pass";
+	startup_timer_end (phase);
+
+	// Everything the shader needs exists now, build it while the frame
+	// resources below are created.
+	job_wait_for_counter (&shader_counter, 0);
+	job_decl shader_job = {create_shader, &startup_shader, "shader_pipeline",
+						   FALSE};
+	job_run (&shader_job, 1, &shader_counter);
+
+	phase = startup_timer_begin ("vulkan_frame_resources");
 
 	context.swapchain.framebuffers =
 		vector_reserve (vulkan_framebuffer, context.swapchain.image_count);
 	recreate_frambuffers (&context.swapchain, &context.main_render_pass);
 
-	create_command_buffers ();
+	create_frames ();
 
-	context.image_available_semaphores =
-		vector_reserve (VkSemaphore, context.swapchain.max_frames_in_flight);
-	context.queue_complete_semaphores =
-		vector_reserve (VkSemaphore, context.swapchain.max_frames_in_flight);
-	context.in_flight_fences =
-		vector_reserve (VkFence, context.swapchain.max_frames_in_flight);
-
-	for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
-		VkSemaphoreCreateInfo sem_create_info = {
-			VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-		vkCreateSemaphore (context.device.logical_device, &sem_create_info,
-						   context.allocator,
-						   &context.image_available_semaphores[i]);
-		vkCreateSemaphore (context.device.logical_device, &sem_create_info,
-						   context.allocator,
-						   &context.queue_complete_semaphores[i]);
-		vulkan_fence_create (&context, TRUE, &context.in_flight_fences[i]);
-	}
-
-	context.images_in_flight =
-		vector_reserve (VkFence, context.swapchain.image_count);
-	SF_INFO ("Fences and semaphores created.");
-
-	if (!vulkan_shader_create (&context, api->default_diffuse,
-							   &context.shader)) {
-		SF_ERROR ("Failed to load built-in shader.");
-		return FALSE;
-	}
+	// Not fatal, the renderer just reports no GPU timings.
+	vulkan_gpu_timer_create (&context, context.frame_count,
+							 &context.gpu_timer);
 
 	if (!create_buffers (&context)) {
 		SF_FATAL ("Failed to create buffers.")
@@ -235,33 +296,25 @@ b8 vulkan_initialize (renderer_provider *api, const char *app_name,
 	upload_data (&context, context.device.graphics_command_pool,
 				 context.device.graphics_queue, &context.IBO, sizeof (u32) * 6,
 				 0, indices);
+	startup_timer_end (phase);
 
 	SF_INFO ("Successfully created buffers.");
+	job_wait_for_counter (&shader_counter, 0);
+	if (!startup_shader.created) {
+		SF_ERROR ("Failed to load built-in shader.");
+		return FALSE;
+	}
 	SF_INFO ("Vulkan renderer provider initialized successfully.");
 	return TRUE;
 }
 
 void vulkan_shutdown (renderer_provider *api) {
 	SF_DEBUG ("Waiting for idle...");
-	vkDeviceWaitIdle (context.device.logical_device);
-	SF_DEBUG ("Destroying sync objects.");
-	for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
-		if (context.image_available_semaphores[i]) {
-			vkDestroySemaphore (context.device.logical_device,
-								context.image_available_semaphores[i],
-								context.allocator);
-		}
-		if (context.queue_complete_semaphores[i]) {
-			vkDestroySemaphore (context.device.logical_device,
-								context.queue_complete_semaphores[i],
-								context.allocator);
-		}
-		vulkan_fence_destroy (&context, &context.in_flight_fences[i]);
-	}
-	vector_destroy (context.image_available_semaphores);
-	vector_destroy (context.queue_complete_semaphores);
-	vector_destroy (context.in_flight_fences);
-	vector_destroy (context.images_in_flight);
+	vulkan_device_wait_idle (&context);
+	SF_DEBUG ("Destroying frame resources.");
+	destroy_frames ();
+	SF_DEBUG ("Destroying GPU timer.");
+	vulkan_gpu_timer_destroy (&context, &context.gpu_timer);
 #if defined(DEBUG)
 	SF_DEBUG ("Destroying vulkan debugger.");
 	if (context.debug_messenger) {
@@ -282,13 +335,6 @@ void vulkan_shutdown (renderer_provider *api) {
 	vulkan_swapchain_destroy (&context, &context.swapchain);
 	SF_DEBUG ("Destroying vulkan surface");
 	vkDestroySurfaceKHR (context.instance, context.surface, context.allocator);
-	SF_DEBUG ("Destroying graphics command pool.");
-	for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-		vulkan_command_buffer_free (&context,
-									context.device.graphics_command_pool,
-									&context.graphics_command_buffers[i]);
-	}
-	vector_destroy (context.graphics_command_buffers);
 	SF_DEBUG ("Destroying framebuffers.");
 	for (u32 i = 0; i < context.swapchain.image_count; ++i) {
 		vulkan_framebuffer_destroy (&context,
@@ -302,10 +348,25 @@ void vulkan_shutdown (renderer_provider *api) {
 	event_unregister (EVENT_CODE_WINDOW_RESIZED, &context, window_resized);
 }
 
+b8 vulkan_wait_for_frame (struct renderer_provider *api) {
+	if (context.frame_waited) { return TRUE; }
+	SF_PROFILE_ZONE ("vulkan_wait_for_frame");
+	context.frame_waited = vulkan_fence_wait (
+		&context, &context.frames[context.current_frame].in_flight,
+		UINT64_MAX);
+	return context.frame_waited;
+}
+
 b8 vulkan_begin_frame (struct renderer_provider *api, f64 deltaTime) {
-	// TODO: handle resizing from SDL side
+	SF_PROFILE_ZONE ("vulkan_begin_frame");
+	u64 extent = sf_atomic_exchange_u64 (&pending_window_extent, 0);
+	if (extent) {
+		cached_window_width	 = (u32)(extent >> 32);
+		cached_window_height = (u32)extent;
+		if (!recreate_swapchain ()) { return FALSE; }
+	}
 	if (context.recreating_swapchain) {
-		if (vkDeviceWaitIdle (context.device.logical_device) != VK_SUCCESS) {
+		if (vulkan_device_wait_idle (&context) != VK_SUCCESS) {
 			SF_ERROR ("Failed to wait for device idle.");
 			return FALSE;
 		}
@@ -313,24 +374,28 @@ b8 vulkan_begin_frame (struct renderer_provider *api, f64 deltaTime) {
 		return FALSE;
 	}
 
-	if (!vulkan_fence_wait (&context,
-							&context.in_flight_fences[context.current_frame],
-							UINT64_MAX)) {
+	if (!vulkan_wait_for_frame (api)) {
 		SF_WARNING ("Could not wait for in-flight fence.");
 		return FALSE;
 	}
 
+	vulkan_frame *frame = &context.frames[context.current_frame];
 	if (!vulkan_swapchain_get_next_image_index (
-			&context, &context.swapchain, UINT64_MAX,
-			context.image_available_semaphores[context.current_frame], SF_NULL,
-			&context.image_index)) {
+			&context, &context.swapchain, UINT64_MAX, frame->image_available,
+			SF_NULL, &context.image_index)) {
 		return FALSE;
 	}
 
-	vulkan_command_buffer *command_buffer =
-		&context.graphics_command_buffers[context.image_index];
+	// Nothing the GPU still reads is recorded in the frame's pool.
+	vulkan_command_buffer *command_buffer = &frame->command_buffer;
+	vulkan_command_pool_reset (&context, frame->command_pool);
 	vulkan_command_buffer_reset (command_buffer);
 	vulkan_command_buffer_begin (command_buffer, FALSE, FALSE, FALSE);
+	// The in-flight fence was waited on above, so the timestamps this frame
+	// slot wrote last time around are ready to be read.
+	vulkan_gpu_timer_begin_frame (&context, &context.gpu_timer, command_buffer,
+								  context.current_frame);
+	vulkan_gpu_timer_begin_scope (&context.gpu_timer, command_buffer, "frame");
 
 	VkViewport viewport;
 	viewport.x		  = 0.0f;
@@ -351,41 +416,42 @@ b8 vulkan_begin_frame (struct renderer_provider *api, f64 deltaTime) {
 
 	context.main_render_pass.extent.w = context.framebuffer_width;
 	context.main_render_pass.extent.h = context.framebuffer_height;
-
-	vulkan_render_pass_begin (
-		&context.main_render_pass, command_buffer,
-		context.swapchain.framebuffers[context.image_index].handle);
+	context.main_pass_begun			  = FALSE;
 
 	return TRUE;
 }
 
-b8 vulkan_end_frame (struct renderer_provider *api) {
-	vulkan_render_pass_end (
+// The main pass is begun by the frame's draws, or by vulkan_end_frame when
+// there were none, since contents can't change within its only subpass.
+static void begin_main_pass (VkSubpassContents contents) {
+	if (context.main_pass_begun) { return; }
+	vulkan_render_pass_begin (
 		&context.main_render_pass,
-		&context.graphics_command_buffers[context.image_index]);
-	vulkan_command_buffer_end (
-		&context.graphics_command_buffers[context.image_index]);
-	if (context.images_in_flight[context.image_index] != VK_NULL_HANDLE) {
-		vulkan_fence_wait (&context,
-						   context.images_in_flight[context.image_index],
-						   UINT64_MAX);
-	}
-
-	context.images_in_flight[context.image_index] =
-		&context.in_flight_fences[context.current_frame];
-	vulkan_fence_reset (&context,
-						&context.in_flight_fences[context.current_frame]);
+		&context.frames[context.current_frame].command_buffer,
+		context.swapchain.framebuffers[context.image_index].handle, contents);
+	context.main_pass_begun = TRUE;
+}
 
-	VkSubmitInfo submit_info	   = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers =
-		&context.graphics_command_buffers[context.image_index].handle;
+b8 vulkan_end_frame (struct renderer_provider *api) {
+	SF_PROFILE_ZONE ("vulkan_end_frame");
+	vulkan_frame *frame = &context.frames[context.current_frame];
+	begin_main_pass (VK_SUBPASS_CONTENTS_INLINE);
+	vulkan_render_pass_end (&context.main_render_pass, &frame->command_buffer);
+	vulkan_gpu_timer_end_scope (&context.gpu_timer, &frame->command_buffer);
+	vulkan_gpu_timer_end_frame (&context.gpu_timer);
+	vulkan_command_buffer_end (&frame->command_buffer);
+	// The image's previous frame only wrote it on the GPU, the acquire
+	// semaphore orders that, so the frame's own fence is all that's waited.
+	vulkan_fence_reset (&context, &frame->in_flight);
+	context.frame_waited = FALSE;
+
+	VkSubmitInfo submit_info		 = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submit_info.commandBufferCount	 = 1;
+	submit_info.pCommandBuffers		 = &frame->command_buffer.handle;
 	submit_info.signalSemaphoreCount = 1;
-	submit_info.pSignalSemaphores =
-		&context.queue_complete_semaphores[context.current_frame];
-	submit_info.waitSemaphoreCount = 1;
-	submit_info.pWaitSemaphores =
-		&context.image_available_semaphores[context.current_frame];
+	submit_info.pSignalSemaphores	 = &frame->queue_complete;
+	submit_info.waitSemaphoreCount	 = 1;
+	submit_info.pWaitSemaphores		 = &frame->image_available;
 
 	// prevents subsequent color attachment writes from executing until
 	// semaphore signals
@@ -393,21 +459,18 @@ b8 vulkan_end_frame (struct renderer_provider *api) {
 		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 	submit_info.pWaitDstStageMask = flags;
 	if (vkQueueSubmit (context.device.graphics_queue, 1, &submit_info,
-					   context.in_flight_fences[context.current_frame]) !=
-		VK_SUCCESS) {
+					   frame->in_flight) != VK_SUCCESS) {
 		SF_ERROR ("vkQueueSubmit failed.");
 		return FALSE;
 	}
 
-	vulkan_command_buffer_update_submitted (
-		&context.graphics_command_buffers[context.image_index]);
-
-	vulkan_swapchain_present (
-		&context, &context.swapchain, context.device.graphics_queue,
-		context.device.present_queue,
-		context.queue_complete_semaphores[context.current_frame],
-		context.image_index);
+	vulkan_command_buffer_update_submitted (&frame->command_buffer);
 
+	vulkan_swapchain_present (&context, &context.swapchain,
+							  context.device.graphics_queue,
+							  context.device.present_queue,
+							  frame->queue_complete, context.image_index);
+	context.current_frame = (context.current_frame + 1) % context.frame_count;
 	return TRUE;
 }
 
@@ -418,16 +481,16 @@ vk_debug_callback (VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
 				   void *user_data) {
 	switch (message_severity) {
 		case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-			SF_ERROR (callback_data->pMessage);
+			SF_ERROR ("%s", callback_data->pMessage);
 			break;
 		case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-			SF_WARNING (callback_data->pMessage);
+			SF_WARNING ("%s", callback_data->pMessage);
 			break;
 		case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-			SF_INFO (callback_data->pMessage);
+			SF_INFO ("%s", callback_data->pMessage);
 			break;
 		case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-			SF_TRACE (callback_data->pMessage);
+			SF_TRACE ("%s", callback_data->pMessage);
 			break;
 		default: break;
 	}
@@ -448,24 +511,55 @@ i32 find_memory_index (u32 type_filter, u32 property_flags) {
 	return -1;
 }
 
-void create_command_buffers () {
-	if (!context.graphics_command_buffers) {
-		context.graphics_command_buffers = vector_reserve (
-			vulkan_command_buffer, context.swapchain.image_count);
+void create_frames () {
+	VkSemaphoreCreateInfo sem_create_info = {
+		VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+	for (u32 i = 0; i < context.frame_count; ++i) {
+		vulkan_frame *frame = &context.frames[i];
+		sfmemset (frame, 0, sizeof (vulkan_frame));
+		vulkan_command_pool_create (&context,
+									context.device.graphics_queue_index, TRUE,
+									&frame->command_pool);
+		vulkan_command_buffer_create (&context, frame->command_pool, TRUE,
+									  &frame->command_buffer);
+		for (u32 j = 0; j < VULKAN_MAX_RECORD_CHUNKS; ++j) {
+			vulkan_record_chunk *chunk = &frame->record_chunks[j];
+			vulkan_command_pool_create (&context,
+										context.device.graphics_queue_index,
+										TRUE, &chunk->pool);
+			vulkan_command_buffer_create (&context, chunk->pool, FALSE,
+										  &chunk->secondary);
+		}
+		vkCreateSemaphore (context.device.logical_device, &sem_create_info,
+						   context.allocator, &frame->image_available);
+		vkCreateSemaphore (context.device.logical_device, &sem_create_info,
+						   context.allocator, &frame->queue_complete);
+		// Signalled, so the first wait on each frame returns right away.
+		vulkan_fence_create (&context, TRUE, &frame->in_flight);
 	}
-	for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-		if (context.graphics_command_buffers[i].handle) {
-			vulkan_command_buffer_free (&context,
-										context.device.graphics_command_pool,
-										&context.graphics_command_buffers[i]);
+	context.current_frame = 0;
+	context.frame_waited  = FALSE;
+	SF_INFO ("Created %u frames in flight.", context.frame_count);
+}
+
+void destroy_frames () {
+	for (u32 i = 0; i < context.frame_count; ++i) {
+		vulkan_frame *frame = &context.frames[i];
+		for (u32 j = 0; j < VULKAN_MAX_RECORD_CHUNKS; ++j) {
+			vulkan_record_chunk *chunk = &frame->record_chunks[j];
+			vulkan_command_buffer_free (&context, chunk->pool,
+										&chunk->secondary);
+			vulkan_command_pool_destroy (&context, chunk->pool);
 		}
-		sfmemset (&context.graphics_command_buffers[i], 0,
-				  sizeof (vulkan_command_buffer));
-		vulkan_command_buffer_create (
-			&context, context.device.graphics_command_pool, TRUE,
-			&context.graphics_command_buffers[i]);
+		vulkan_command_buffer_free (&context, frame->command_pool,
+									&frame->command_buffer);
+		vulkan_command_pool_destroy (&context, frame->command_pool);
+		vkDestroySemaphore (context.device.logical_device,
+							frame->image_available, context.allocator);
+		vkDestroySemaphore (context.device.logical_device,
+							frame->queue_complete, context.allocator);
+		vulkan_fence_destroy (&context, &frame->in_flight);
 	}
-	SF_INFO ("Command buffers created.");
 }
 
 void recreate_frambuffers (vulkan_swapchain *swapchain,
@@ -486,14 +580,8 @@ void recreate_frambuffers (vulkan_swapchain *swapchain,
 
 b8 window_resized (u16 code, void *sender, void *listener_list,
 				   event_context data) {
-	cached_window_width	 = data.data.u32[0];
-	cached_window_height = data.data.u32[1];
-	if (vkDeviceWaitIdle (context.device.logical_device) != VK_SUCCESS) {
-		SF_ERROR ("vulkan_begin_frame: failed to wait for idle.");
-		return FALSE;
-	}
-
-	if (!recreate_swapchain ()) { return FALSE; }
+	u64 extent = ((u64)data.data.u32[0] << 32) | data.data.u32[1];
+	sf_atomic_store_u64 (&pending_window_extent, extent);
 	return TRUE;
 }
 
@@ -511,10 +599,7 @@ b8 recreate_swapchain () {
 	}
 
 	context.recreating_swapchain = TRUE;
-	vkDeviceWaitIdle (context.device.logical_device);
-	for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-		context.images_in_flight[i] = SF_NULL;
-	}
+	vulkan_device_wait_idle (&context);
 	vulkan_device_query_swapchain_support (context.device.physical_device,
 										   context.surface,
 										   &context.device.swapchain_support);
@@ -529,9 +614,6 @@ b8 recreate_swapchain () {
 	cached_window_height			  = 0;
 
 	for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-		vulkan_command_buffer_free (&context,
-									context.device.graphics_command_pool,
-									&context.graphics_command_buffers[i]);
 		vulkan_framebuffer_destroy (&context,
 									&context.swapchain.framebuffers[i]);
 	}
@@ -541,7 +623,6 @@ b8 recreate_swapchain () {
 	context.main_render_pass.extent.w = context.framebuffer_width;
 	context.main_render_pass.extent.h = context.framebuffer_height;
 	recreate_frambuffers (&context.swapchain, &context.main_render_pass);
-	create_command_buffers ();
 	context.recreating_swapchain = FALSE;
 	return TRUE;
 }
@@ -550,6 +631,7 @@ b8 recreate_swapchain () {
 // NOTE: temporary
 void upload_data (vulkan_context *context, VkCommandPool pool, VkQueue queue,
 				  vulkan_buffer *buffer, u64 size, u64 offset, void *data) {
+	SF_PROFILE_ZONE ("upload_data");
 	VkBufferUsageFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 							   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 	vulkan_buffer staging;
@@ -558,6 +640,7 @@ void upload_data (vulkan_context *context, VkCommandPool pool, VkQueue queue,
 	vulkan_buffer_bind (context, &staging, 0);
 
 	vulkan_buffer_load_data (context, &staging, size, 0, flags, data);
+	SF_METRIC_OBSERVE ("staging_upload_bytes", size);
 
 	vulkan_buffer_copy (context, queue, pool, staging.handle, 0, buffer->handle,
 						offset, size);
@@ -594,8 +677,6 @@ b8 create_buffers (vulkan_context *context) {
 }
 
 void vulkan_update_scene_data (mat4 projection, mat4 view) {
-	vulkan_command_buffer *cmd_buffer =
-		&context.graphics_command_buffers[context.image_index];
 	vulkan_shader_bind (&context, &context.shader);
 	context.scene_data.projection = projection;
 	context.scene_data.view		  = view;
@@ -603,20 +684,113 @@ void vulkan_update_scene_data (mat4 projection, mat4 view) {
 										 &context.scene_data);
 }
 
-void vulkan_update_objects_data (mesh_data data) {
-	vulkan_command_buffer *cmd_buffer =
-		&context.graphics_command_buffers[context.image_index];
-	vulkan_shader_update_model (&context, &context.shader, data);
-	// TODO: remove this temp code
-	vulkan_shader_bind (&context, &context.shader);
+// Records draws[begin, end) and writes their uniforms.
+static void record_draws (VkCommandBuffer command_buffer,
+						  const mesh_data *draws, u32 begin, u32 end) {
 	VkDeviceSize offsets[1] = {0};
-	vkCmdBindVertexBuffers (cmd_buffer->handle, 0, 1, &context.VBO.handle,
+	vkCmdBindVertexBuffers (command_buffer, 0, 1, &context.VBO.handle,
 							(VkDeviceSize *)offsets);
-	vkCmdBindIndexBuffer (cmd_buffer->handle, context.IBO.handle, 0,
+	vkCmdBindIndexBuffer (command_buffer, context.IBO.handle, 0,
 						  VK_INDEX_TYPE_UINT32);
-	vkCmdDrawIndexed (cmd_buffer->handle, 6, 1, 0, 0, 0);
+	u32 frame_index = context.current_frame;
+	for (u32 i = begin; i < end; ++i) {
+		vulkan_shader_write_model (&context.shader, frame_index, i, &draws[i]);
+		vulkan_shader_bind_model (&context.shader, command_buffer, frame_index,
+								  &draws[i]);
+		vkCmdDrawIndexed (command_buffer, 6, 1, 0, 0, 0);
+	}
+}
+
+typedef struct draw_recording {
+	const mesh_data *draws;
+	u64 grain;
+	vulkan_record_chunk *chunks;
+} draw_recording;
+
+// Records one chunk of the draw list into its own secondary buffer, from
+// whichever worker picked it up.
+static void record_chunk (u64 begin, u64 end, void *params) {
+	SF_PROFILE_ZONE ("vulkan_record_chunk");
+	draw_recording *recording  = params;
+	vulkan_record_chunk *chunk = &recording->chunks[begin / recording->grain];
+	vulkan_command_buffer *cmd = &chunk->secondary;
+	// The frame's fence was waited on, nothing from this pool is pending.
+	vulkan_command_pool_reset (&context, chunk->pool);
+	vulkan_command_buffer_begin_secondary (
+		cmd, context.main_render_pass.handle,
+		context.swapchain.framebuffers[context.image_index].handle);
+
+	VkViewport viewport;
+	viewport.x		  = 0.0f;
+	viewport.y		  = (f32)context.framebuffer_height;
+	viewport.width	  = (f32)context.framebuffer_width;
+	viewport.height	  = -(f32)context.framebuffer_height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor;
+	scissor.offset.x	  = 0;
+	scissor.offset.y	  = 0;
+	scissor.extent.width  = context.framebuffer_width;
+	scissor.extent.height = context.framebuffer_height;
+
+	vkCmdSetViewport (cmd->handle, 0, 1, &viewport);
+	vkCmdSetScissor (cmd->handle, 0, 1, &scissor);
+	vulkan_shader_bind_secondary (&context, &context.shader, cmd);
+	record_draws (cmd->handle, recording->draws, (u32)begin, (u32)end);
+	vulkan_command_buffer_end (cmd);
+}
+
+void vulkan_draw_objects (const mesh_data *draws, u32 count) {
+	SF_ASSERT (!context.main_pass_begun,
+			   "vulkan_draw_objects called twice in one frame.");
+	vulkan_command_buffer *cmd_buffer =
+		&context.frames[context.current_frame].command_buffer;
+	// Descriptor sets can't be written once they're bound, so the writes
+	// happen here before recording starts. Uniforms are written by the
+	// recording jobs into the mapped buffer.
+	vulkan_shader_update_models (&context, &context.shader, draws, count);
+	SF_METRIC_COUNT ("draw_calls", count);
+
+	u32 workers = job_worker_count ();
+	if (workers > VULKAN_MAX_RECORD_CHUNKS) {
+		workers = VULKAN_MAX_RECORD_CHUNKS;
+	}
+	u64 grain = workers ? (count + workers - 1) / workers : count;
+	if (grain < MIN_DRAWS_PER_CHUNK) { grain = MIN_DRAWS_PER_CHUNK; }
+	u32 chunk_count = (u32)((count + grain - 1) / grain);
+	if (chunk_count < 2) {
+		begin_main_pass (VK_SUBPASS_CONTENTS_INLINE);
+		vulkan_gpu_timer_begin_scope (&context.gpu_timer, cmd_buffer, "draw");
+		vulkan_shader_bind (&context, &context.shader);
+		record_draws (cmd_buffer->handle, draws, 0, count);
+		vulkan_gpu_timer_end_scope (&context.gpu_timer, cmd_buffer);
+		return;
+	}
+
+	begin_main_pass (VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	draw_recording recording;
+	recording.draws	 = draws;
+	recording.grain	 = grain;
+	recording.chunks = context.frames[context.current_frame].record_chunks;
+	parallel_for (count, grain, record_chunk, &recording);
+
+	// Timestamps can't go inside a subpass that only executes secondaries,
+	// so these draws are timed as part of the frame scope alone.
+	vulkan_command_buffer *secondaries[VULKAN_MAX_RECORD_CHUNKS];
+	for (u32 i = 0; i < chunk_count; ++i) {
+		secondaries[i] = &recording.chunks[i].secondary;
+	}
+	vulkan_command_buffer_execute (cmd_buffer, chunk_count, secondaries);
+}
+
+void vulkan_get_gpu_timings (renderer_gpu_timings *out_timings) {
+	*out_timings = context.gpu_timer.results;
 }
 
+// Copies through a single-use command buffer and waits for the graphics queue
+// to go idle before returning, so every texture stalls the calling thread
+// for a full round trip to the GPU.
 void vulkan_create_texture (const char *name, u32 width, u32 height,
 							u32 channels, b8 opaque, const u8 *pixels,
 							texture *out_texture) {
@@ -643,7 +817,8 @@ void vulkan_create_texture (const char *name, u32 width, u32 height,
 	vulkan_buffer_create (&context, image_size, usage, memory_prop_flags,
 						  &staging);
 	vulkan_buffer_bind (&context, &staging, 0);
-	vulkan_buffer_load_data (&context, &staging, 0, image_size, 0, pixels);
+	vulkan_buffer_load_data (&context, &staging, image_size, 0, 0, pixels);
+	SF_METRIC_OBSERVE ("staging_upload_bytes", image_size);
 	vulkan_image_info info;
 	info.width	= width;
 	info.height = height;
@@ -709,7 +884,7 @@ void vulkan_create_texture (const char *name, u32 width, u32 height,
 }
 
 void vulkan_destroy_texture (texture *texture) {
-	vkDeviceWaitIdle (context.device.logical_device);
+	vulkan_device_wait_idle (&context);
 	vulkan_texture_data *data = (vulkan_texture_data *)texture->data;
 	if (data) {
 		vulkan_image_destroy (&context, &data->image);
@@ -1,6 +1,9 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_render_pass.h"
 #include "core/logger.h"
 #include "core/sfmemory.h"
+#include "renderer/vulkan/vulkan_gpu_timer.h"
 #include "renderer/vulkan/vulkan_types.h"
 #include <vulkan/vulkan_core.h>
 
@@ -11,6 +14,8 @@ void vulkan_render_pass_create (vulkan_context *context, color color,
 	out_render_pass->stencil = stencil;
 	out_render_pass->color	 = color;
 	out_render_pass->extent	 = extent;
+	out_render_pass->name	 = SF_NULL;
+	out_render_pass->timer	 = &context->gpu_timer;
 
 	VkAttachmentDescription color_attachment;
 	color_attachment.format =
@@ -97,7 +102,8 @@ void vulkan_render_pass_destroy (vulkan_context *context,
 
 void vulkan_render_pass_begin (vulkan_render_pass *render_pass,
 							   vulkan_command_buffer *command_buffer,
-							   VkFramebuffer target_framebuffer) {
+							   VkFramebuffer target_framebuffer,
+							   VkSubpassContents contents) {
 	VkClearValue clear_vals[2];
 	sfmemset (clear_vals, 0, sizeof (VkClearValue) * 2);
 	clear_vals[0].color.float32[0] = render_pass->color.r;
@@ -119,9 +125,12 @@ void vulkan_render_pass_begin (vulkan_render_pass *render_pass,
 	begin_info.clearValueCount			= 2;
 	begin_info.pClearValues				= clear_vals;
 
+	if (render_pass->name) {
+		vulkan_gpu_timer_begin_scope (render_pass->timer, command_buffer,
+									  render_pass->name);
+	}
 	// SF_DEBUG("HAI1");
-	vkCmdBeginRenderPass (command_buffer->handle, &begin_info,
-						  VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass (command_buffer->handle, &begin_info, contents);
 	// SF_DEBUG("HAI2");
 	command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
 }
@@ -130,4 +139,7 @@ void vulkan_render_pass_end (vulkan_render_pass *render_pass,
 							 vulkan_command_buffer *command_buffer) {
 	vkCmdEndRenderPass (command_buffer->handle);
 	command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
+	if (render_pass->name) {
+		vulkan_gpu_timer_end_scope (render_pass->timer, command_buffer);
+	}
 }
@@ -8,8 +8,11 @@ void vulkan_render_pass_create (vulkan_context* context, color color,
 								vulkan_render_pass* out_render_pass);
 void vulkan_render_pass_destroy (vulkan_context* context,
 								 vulkan_render_pass* render_pass);
+// contents is VK_SUBPASS_CONTENTS_INLINE, or _SECONDARY_COMMAND_BUFFERS when
+// the pass is only filled by vulkan_command_buffer_execute.
 void vulkan_render_pass_begin (vulkan_render_pass* render_pass,
 							   vulkan_command_buffer* command_buffer,
-							   VkFramebuffer target_framebuffer);
+							   VkFramebuffer target_framebuffer,
+							   VkSubpassContents contents);
 void vulkan_render_pass_end (vulkan_render_pass* render_pass,
 							 vulkan_command_buffer* command_buffer);
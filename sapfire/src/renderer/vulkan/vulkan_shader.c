@@ -1,4 +1,7 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "core/logger.h"
+#include "core/metrics.h"
 #include "core/sfmemory.h"
 #include "defines.h"
 #include "math/math_types.h"
@@ -13,19 +16,38 @@
 #include "vulkan_shader.h"
 
 #define BUILTIN_SHADER_NAME "shader_builtin"
+
+static const char stage_type_strs[SHADER_STAGE_COUNT][5] = {"vert", "frag"};
+
+static const VkShaderStageFlagBits stage_types[SHADER_STAGE_COUNT] = {
+	VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
+
+b8 vulkan_shader_load_sources (vulkan_shader_source* out_sources) {
+	for (u32 i = 0; i < SHADER_STAGE_COUNT; ++i) {
+		if (!vulkan_shader_source_load (BUILTIN_SHADER_NAME, stage_type_strs[i],
+										&out_sources[i])) {
+			while (i--) { vulkan_shader_source_free (&out_sources[i]); }
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+void vulkan_shader_free_sources (vulkan_shader_source* sources) {
+	for (u32 i = 0; i < SHADER_STAGE_COUNT; ++i) {
+		vulkan_shader_source_free (&sources[i]);
+	}
+}
+
 b8 vulkan_shader_create (vulkan_context* context, texture* default_diffuse,
+						 const vulkan_shader_source* sources,
 						 vulkan_shader* out_shader) {
 	// Take a copy of the default texture pointers.
 	out_shader->default_diffuse = default_diffuse;
 
 	// Shader module init per stage.
-	char stage_type_strs[SHADER_STAGE_COUNT][5]			  = {"vert", "frag"};
-	VkShaderStageFlagBits stage_types[SHADER_STAGE_COUNT] = {
-		VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
-
 	for (u32 i = 0; i < SHADER_STAGE_COUNT; ++i) {
-		if (!create_shader_module (context, BUILTIN_SHADER_NAME,
-								   stage_type_strs[i], stage_types[i], i,
+		if (!create_shader_module (context, &sources[i], stage_types[i], i,
 								   out_shader->stages)) {
 			SF_ERROR ("Unable to create %s shader module for '%s'.",
 					  stage_type_strs[i], BUILTIN_SHADER_NAME);
@@ -55,13 +77,13 @@ b8 vulkan_shader_create (vulkan_context* context, texture* default_diffuse,
 	// Global descriptor pool: Used for global items such as view/projection matrix.
 	VkDescriptorPoolSize global_pool_size;
 	global_pool_size.type			 = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	global_pool_size.descriptorCount = context->swapchain.image_count;
+	global_pool_size.descriptorCount = context->frame_count;
 
 	VkDescriptorPoolCreateInfo global_pool_info = {
 		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
 	pool_ci.poolSizeCount = 1;
 	pool_ci.pPoolSizes	  = &pool_size;
-	pool_ci.maxSets		  = context->swapchain.image_count;
+	pool_ci.maxSets		  = context->frame_count;
 	VK_ASSERT_SUCCESS (
 		vkCreateDescriptorPool (context->device.logical_device, &pool_ci,
 								context->allocator,
@@ -159,7 +181,10 @@ b8 vulkan_shader_create (vulkan_context* context, texture* default_diffuse,
 		stage_create_infos[i] = out_shader->stages[i].shader_stage_create_info;
 	}
 
-	if (!vulkan_buffer_create (context, sizeof (scene_data),
+	// A range per frame in flight. scene_uniform is padded to 256 bytes, the
+	// largest offset alignment a device may ask for.
+	if (!vulkan_buffer_create (context,
+							   sizeof (scene_uniform) * context->frame_count,
 							   VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
 								   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 							   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
@@ -170,6 +195,25 @@ b8 vulkan_shader_create (vulkan_context* context, texture* default_diffuse,
 		return FALSE;
 	}
 	vulkan_buffer_bind (context, &out_shader->scene_uniform_buffer, 0);
+
+	// VULKAN_MAX_MESH_COUNT uniforms per frame in flight. Kept mapped so
+	// recording jobs write them directly, the memory is host coherent.
+	u64 mesh_buffer_size =
+		sizeof (mesh_uniform) * VULKAN_MAX_MESH_COUNT * context->frame_count;
+	if (!vulkan_buffer_create (context, mesh_buffer_size,
+							   VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+								   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+							   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+								   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+								   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+							   &out_shader->mesh_uniform_buffer)) {
+		SF_FATAL ("Failed to create mesh uniform buffer.");
+		return FALSE;
+	}
+	vulkan_buffer_bind (context, &out_shader->mesh_uniform_buffer, 0);
+	out_shader->mesh_uniforms = vulkan_buffer_map (
+		context, &out_shader->mesh_uniform_buffer, mesh_buffer_size, 0, 0);
+	out_shader->mesh_uniform_buffer.is_mapped = TRUE;
 	// for allocation
 	VkDescriptorSetLayout layouts_alloc[8] = {
 		out_shader->scene_descriptor_set_layout,
@@ -195,7 +239,7 @@ b8 vulkan_shader_create (vulkan_context* context, texture* default_diffuse,
 	VkDescriptorSetAllocateInfo alloc_info = {
 		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
 	desc_alloc_info.descriptorPool	   = out_shader->scene_descriptor_pool;
-	desc_alloc_info.descriptorSetCount = context->swapchain.image_count;
+	desc_alloc_info.descriptorSetCount = context->frame_count;
 	desc_alloc_info.pSetLayouts		   = layouts_alloc;
 	VK_ASSERT_SUCCESS (vkAllocateDescriptorSets (
 						   context->device.logical_device, &desc_alloc_info,
@@ -221,6 +265,9 @@ b8 vulkan_shader_create (vulkan_context* context, texture* default_diffuse,
 
 void vulkan_shader_destroy (vulkan_context *context, vulkan_shader *shader) {
 	vulkan_buffer_destroy (context, &shader->scene_uniform_buffer);
+	vulkan_buffer_unmap (context, &shader->mesh_uniform_buffer);
+	shader->mesh_uniforms = SF_NULL;
+	vulkan_buffer_destroy (context, &shader->mesh_uniform_buffer);
 	vulkan_pipeline_destroy (context, &shader->pipeline);
 	vkDestroyDescriptorPool (context->device.logical_device,
 							 shader->scene_descriptor_pool, context->allocator);
@@ -237,13 +284,13 @@ void vulkan_shader_destroy (vulkan_context *context, vulkan_shader *shader) {
 void vulkan_shader_update_scene_uniforms (vulkan_context *context,
 										  vulkan_shader *shader,
 										  scene_data *data) {
-	i32 img_index = context->image_index;
+	u32 frame_index = context->current_frame;
 	VkCommandBuffer cmd_bfr =
-		context->graphics_command_buffers[img_index].handle;
-	VkDescriptorSet descr_set = shader->scene_descriptor_sets[img_index];
+		context->frames[frame_index].command_buffer.handle;
+	VkDescriptorSet descr_set = shader->scene_descriptor_sets[frame_index];
 
 	u32 size   = sizeof (scene_uniform);
-	u64 offset = 0;
+	u64 offset = (u64)size * frame_index;
 	vulkan_buffer_load_data (context, &shader->scene_uniform_buffer, size,
 							 offset, 0, data);
 	VkDescriptorBufferInfo descr_info;
@@ -256,7 +303,7 @@ void vulkan_shader_update_scene_uniforms (vulkan_context *context,
 	write_descr.descriptorType		 = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	write_descr.dstBinding			 = 0;
 	write_descr.dstArrayElement		 = 0;
-	write_descr.dstSet				 = shader->scene_descriptor_sets[img_index];
+	write_descr.dstSet				 = descr_set;
 	write_descr.pBufferInfo			 = &descr_info;
 	vkUpdateDescriptorSets (context->device.logical_device, 1, &write_descr, 0,
 							0);
@@ -265,8 +312,10 @@ void vulkan_shader_update_scene_uniforms (vulkan_context *context,
 							 SF_NULL);
 }
 
-void vulkan_shader_update_model (vulkan_context* context, vulkan_shader* shader,
-								 mesh_data data) {
+// Only writes the descriptors that changed since the frame's sets were last
+// used, and picks the draw that writes each mesh's uniforms.
+static void update_model (vulkan_context* context, vulkan_shader* shader,
+						  u32 draw_index, const mesh_data* data) {
 	/* i32 img_index = context->image_index; */
 	/* VkCommandBuffer cmd_bfr = */
 	/* 	context->graphics_command_buffers[img_index].handle; */
@@ -348,45 +397,37 @@ void vulkan_shader_update_model (vulkan_context* context, vulkan_shader* shader,
 	/* 						 shader->pipeline.layout, 1, 1, */
 	/* 						 &mesh_descriptor_set, 0, SF_NULL); */
 
-	u32 image_index = context->image_index;
-	VkCommandBuffer command_buffer =
-		context->graphics_command_buffers[image_index].handle;
-
-	vkCmdPushConstants (command_buffer, shader->pipeline.layout,
-						VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof (mat4),
-						&data.model);
+	// Written while earlier frames may still be read by the GPU, so every
+	// frame has its own descriptor sets and uniform range.
+	u32 frame_index = context->current_frame;
 
 	// Obtain material data.
-	vulkan_shader_mesh_state* object_state = &shader->mesh_states[data.id];
+	SF_ASSERT (data->id < VULKAN_MAX_MESH_COUNT, "Mesh id out of range.");
+	vulkan_shader_mesh_state* object_state = &shader->mesh_states[data->id];
 	VkDescriptorSet object_descriptor_set =
-		object_state->descriptor_sets[image_index];
+		object_state->descriptor_sets[frame_index];
+
+	// The first draw of a mesh writes its uniforms, later draws of the same
+	// mesh may be recorded by other jobs at the same time.
+	if (object_state->update_serial != shader->update_serial) {
+		object_state->update_serial = shader->update_serial;
+		object_state->uniform_draw	= draw_index;
+	}
 
-	// TODO: if needs update
 	VkWriteDescriptorSet descriptor_writes[VULKAN_SHADER_DESCRIPTOR_COUNT];
 	sfmemset (descriptor_writes, 0,
 			  sizeof (VkWriteDescriptorSet) * VULKAN_SHADER_DESCRIPTOR_COUNT);
 	u32 descriptor_count = 0;
 	u32 descriptor_index = 0;
 
-	// Descriptor 0 - Uniform buffer
+	// Descriptor 0 - Uniform buffer, written by vulkan_shader_write_model.
 	u32 range = sizeof (mesh_uniform);
-	u64 offset =
-		sizeof (mesh_uniform) * data.id; // also the index into the array.
-	mesh_uniform obo;
-
-	// TODO: get diffuse colour from a material.
-	static f32 accumulator = 0.0f;
-	accumulator += 0.01f;
-	f32 s = (sfsin (accumulator) + 1.0f) / 2.0f; // scale from -1, 1 to 0, 1
-	obo.diffuse_color = vec4_create (s, s, s, 1.0f);
-
-	// Load the data into the buffer.
-	vulkan_buffer_load_data (context, &shader->mesh_uniform_buffer, offset,
-							 range, 0, &obo);
+	u64 offset = sizeof (mesh_uniform) *
+				 (VULKAN_MAX_MESH_COUNT * frame_index + data->id);
 
 	// Only do this if the descriptor has not yet been updated.
 	if (object_state->descriptor_states[descriptor_index]
-			.generations[image_index] == INVALID_ID) {
+			.generations[frame_index] == INVALID_ID) {
 		VkDescriptorBufferInfo buffer_info;
 		buffer_info.buffer = shader->mesh_uniform_buffer.handle;
 		buffer_info.offset = offset;
@@ -405,7 +446,7 @@ void vulkan_shader_update_model (vulkan_context* context, vulkan_shader* shader,
 
 		// Update the frame generation. In this case it is only needed once since this is a buffer.
 		object_state->descriptor_states[descriptor_index]
-			.generations[image_index] = 1;
+			.generations[frame_index] = 1;
 	}
 	descriptor_index++;
 
@@ -414,23 +455,23 @@ void vulkan_shader_update_model (vulkan_context* context, vulkan_shader* shader,
 	VkDescriptorImageInfo image_infos[1];
 	for (u32 sampler_index = 0; sampler_index < sampler_count;
 		 ++sampler_index) {
-		texture* t = data.textures[sampler_index];
+		texture* t = data->textures[sampler_index];
+		vulkan_descriptor_state* descriptor_state =
+			&object_state->descriptor_states[descriptor_index];
 		u32* descriptor_generation =
-			&object_state->descriptor_states[descriptor_index]
-				 .generations[image_index];
+			&descriptor_state->generations[frame_index];
+		texture** descriptor_texture = &descriptor_state->textures[frame_index];
 
-		// If the texture hasn't been loaded yet, use the default.
+		// If the draw has no texture or it hasn't been loaded yet, use the
+		// default.
 		// TODO: Determine which use the texture has and pull appropriate default based on that.
-		if (t->generation == INVALID_ID) {
-			t = shader->default_diffuse;
+		if (!t || t->generation == INVALID_ID) { t = shader->default_diffuse; }
 
-			// Reset the descriptor generation if using the default texture.
-			*descriptor_generation = INVALID_ID;
-		}
-
-		// Check if the descriptor needs updating first.
-		if (t && (*descriptor_generation != t->generation ||
-				  *descriptor_generation == INVALID_ID)) {
+		// Check if the descriptor needs updating first. Comparing the texture
+		// too rewrites it once the real texture replaces the default.
+		if (t && t->data &&
+			(*descriptor_texture != t ||
+			 *descriptor_generation != t->generation)) {
 			vulkan_texture_data* internal_data = (vulkan_texture_data*)t->data;
 
 			// Assign view and sampler.
@@ -451,10 +492,10 @@ void vulkan_shader_update_model (vulkan_context* context, vulkan_shader* shader,
 			descriptor_writes[descriptor_count] = descriptor;
 			descriptor_count++;
 
-			// Sync frame generation if not using a default texture.
-			if (t->generation != INVALID_ID) {
-				*descriptor_generation = t->generation;
-			}
+			// Sync frame generation, so it isn't written again until it
+			// changes.
+			*descriptor_texture	   = t;
+			*descriptor_generation = t->generation;
 			descriptor_index++;
 		}
 	}
@@ -462,31 +503,80 @@ void vulkan_shader_update_model (vulkan_context* context, vulkan_shader* shader,
 	if (descriptor_count > 0) {
 		vkUpdateDescriptorSets (context->device.logical_device,
 								descriptor_count, descriptor_writes, 0, 0);
+		SF_METRIC_COUNT ("descriptor_writes", descriptor_count);
 	}
+}
+
+void vulkan_shader_update_models (vulkan_context* context,
+								  vulkan_shader* shader, const mesh_data* draws,
+								  u32 count) {
+	++shader->update_serial;
+
+	// TODO: get diffuse colour from a material.
+	shader->diffuse_accumulator += 0.01f;
+	// scale from -1, 1 to 0, 1
+	f32 s = (sfsin (shader->diffuse_accumulator) + 1.0f) / 2.0f;
 
+	shader->diffuse_color = vec4_create (s, s, s, 1.0f);
+
+	for (u32 i = 0; i < count; ++i) {
+		update_model (context, shader, i, &draws[i]);
+	}
+}
+
+void vulkan_shader_write_model (vulkan_shader* shader, u32 frame_index,
+								u32 draw_index, const mesh_data* data) {
+	if (shader->mesh_states[data->id].uniform_draw != draw_index) { return; }
+	mesh_uniform* obo =
+		&shader->mesh_uniforms[VULKAN_MAX_MESH_COUNT * frame_index + data->id];
+	obo->diffuse_color = shader->diffuse_color;
+}
+
+void vulkan_shader_bind_model (vulkan_shader* shader,
+							   VkCommandBuffer command_buffer, u32 frame_index,
+							   const mesh_data* data) {
+	vkCmdPushConstants (command_buffer, shader->pipeline.layout,
+						VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof (mat4),
+						&data->model);
 	// Bind the descriptor set to be updated, or in case the shader changed.
+	VkDescriptorSet object_descriptor_set =
+		shader->mesh_states[data->id].descriptor_sets[frame_index];
 	vkCmdBindDescriptorSets (command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 							 shader->pipeline.layout, 1, 1,
 							 &object_descriptor_set, 0, 0);
 }
 
 void vulkan_shader_bind (vulkan_context* context, vulkan_shader* shader) {
-	u32 img_index = context->image_index;
-	vulkan_pipeline_bind (&context->graphics_command_buffers[img_index],
+	vulkan_frame* frame = &context->frames[context->current_frame];
+	vulkan_pipeline_bind (&frame->command_buffer,
 						  VK_PIPELINE_BIND_POINT_GRAPHICS, &shader->pipeline);
 }
 
+void vulkan_shader_bind_secondary (vulkan_context* context,
+								   vulkan_shader* shader,
+								   vulkan_command_buffer* command_buffer) {
+	VkDescriptorSet scene_set =
+		shader->scene_descriptor_sets[context->current_frame];
+	vulkan_pipeline_bind (command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+						  &shader->pipeline);
+	vkCmdBindDescriptorSets (command_buffer->handle,
+							 VK_PIPELINE_BIND_POINT_GRAPHICS,
+							 shader->pipeline.layout, 0, 1, &scene_set, 0,
+							 SF_NULL);
+}
+
 b8 vulkan_shader_alloc (vulkan_context* context, vulkan_shader* shader,
 						u32* out_id) {
 	// TODO: potentially ref count
 	*out_id = shader->mesh_uniform_buffer_index;
 	shader->mesh_uniform_buffer_index++;
 	u32 id							= *out_id;
-	u8 sets_count					= context->swapchain.image_count;
+	u8 sets_count					= context->frame_count;
 	vulkan_shader_mesh_state* state = &shader->mesh_states[id];
 	for (u32 i = 0; i < VULKAN_SHADER_DESCRIPTOR_COUNT; ++i) {
 		for (u32 j = 0; j < sets_count; ++j) {
 			state->descriptor_states[i].generations[j] = INVALID_ID;
+			state->descriptor_states[i].textures[j]	   = SF_NULL;
 		}
 	}
 	VkDescriptorSetLayout layouts[8] = {
@@ -510,7 +600,7 @@ b8 vulkan_shader_alloc (vulkan_context* context, vulkan_shader* shader,
 void vulkan_shader_free (vulkan_context* context, vulkan_shader* shader,
 						 u32 id) {
 	vulkan_shader_mesh_state* state = &shader->mesh_states[id];
-	u32 sets_count					= context->swapchain.image_count;
+	u32 sets_count					= context->frame_count;
 	VK_ASSERT_SUCCESS (vkFreeDescriptorSets (context->device.logical_device,
 											 shader->mesh_descriptor_pool,
 											 sets_count,
@@ -519,6 +609,7 @@ void vulkan_shader_free (vulkan_context* context, vulkan_shader* shader,
 	for (u32 i = 0; i < VULKAN_SHADER_DESCRIPTOR_COUNT; ++i) {
 		for (u32 j = 0; j < sets_count; ++j) {
 			state->descriptor_states[i].generations[j] = INVALID_ID;
+			state->descriptor_states[i].textures[j]	   = SF_NULL;
 		}
 	}
 	// TODO: ref counting stuff
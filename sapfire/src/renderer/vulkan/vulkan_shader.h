@@ -1,15 +1,40 @@
 #pragma once
 
 #include "renderer/renderer_types.h"
+#include "vulkan_shader_module.h"
 #include "vulkan_types.h"
 
-b8 vulkan_shader_create (vulkan_context *context, struct texture* default_diffuse, vulkan_shader *out_shader);
+// Reads the SPIR-V of every stage of the built-in shader, safe to call from a
+// job. Nothing is left to free when this fails.
+b8 vulkan_shader_load_sources (vulkan_shader_source *out_sources);
+void vulkan_shader_free_sources (vulkan_shader_source *sources);
+// sources holds SHADER_STAGE_COUNT stages from vulkan_shader_load_sources,
+// still owned by the caller. Only creates objects, so it can run on a job
+// while the calling thread sets up the rest of the context.
+b8 vulkan_shader_create (vulkan_context *context, struct texture* default_diffuse, const vulkan_shader_source *sources, vulkan_shader *out_shader);
 void vulkan_shader_destroy (vulkan_context *context, vulkan_shader *shader);
 void vulkan_shader_update_scene_uniforms (vulkan_context *context,
 										  vulkan_shader *shader,
 										  scene_data *scene_data);
-void vulkan_shader_update_model (vulkan_context *context, vulkan_shader *shader,
-								 mesh_data data);
+// Writes the descriptors of every draw for the current frame, where they
+// changed. Not thread safe, call before recording any of the draws.
+void vulkan_shader_update_models (vulkan_context *context,
+								  vulkan_shader *shader, const mesh_data *draws,
+								  u32 count);
+// Writes the uniforms of draws[draw_index] from the last update_models call
+// into the mapped buffer. Safe to call from the recording jobs.
+void vulkan_shader_write_model (vulkan_shader *shader, u32 frame_index,
+								u32 draw_index, const mesh_data *data);
+// Records the model's push constants and descriptor set into command_buffer,
+// safe to call from several threads into different buffers.
+void vulkan_shader_bind_model (vulkan_shader *shader,
+							   VkCommandBuffer command_buffer, u32 frame_index,
+							   const mesh_data *data);
 void vulkan_shader_bind (vulkan_context *context, vulkan_shader *shader);
+// Binds the pipeline and scene descriptor set into a secondary buffer, which
+// doesn't inherit them from the primary.
+void vulkan_shader_bind_secondary (vulkan_context *context,
+								   vulkan_shader *shader,
+								   vulkan_command_buffer *command_buffer);
 b8 vulkan_shader_alloc(vulkan_context *context, vulkan_shader* shader, u32* out_id);
 void vulkan_shader_free(vulkan_context* context, vulkan_shader* shader, u32 id);
@@ -1,37 +1,57 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_shader_module.h"
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/sfmemory.h"
 #include "core/sfstring.h"
 #include "platform/filesystem.h"
 #include "renderer/vulkan/vulkan_types.h"
 #include "vulkan/vulkan_core.h"
 
-b8 create_shader_module (vulkan_context *context, const char *name,
-						 const char *type_str,
-						 VkShaderStageFlagBits stage_flags, u32 stage,
-						 vulkan_shader_stage *shader_stages) {
+b8 vulkan_shader_source_load (const char *name, const char *type_str,
+							  vulkan_shader_source *out_source) {
+	SF_PROFILE_ZONE ("vulkan_shader_source_load");
 	char file_name[256];
 	sfstrfmt (file_name, "assets/shaders/%s.%s.spv", name, type_str);
-	sfmemset (&shader_stages[stage].create_info, 0,
-			  sizeof (VkShaderModuleCreateInfo));
-	sfmemset (&shader_stages[stage].shader_stage_create_info, 0,
-			  sizeof (VkPipelineShaderStageCreateInfo));
-	shader_stages[stage].create_info.sType =
-		VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	out_source->code = SF_NULL;
+	out_source->size = 0;
 	file_handle handle;
 	if (!filesystem_open (file_name, FILE_MODE_READ, TRUE, &handle)) {
 		SF_ERROR ("Unable to read shader module %s", file_name);
 		return FALSE;
 	}
-	u64 size = 0;
-	u8 *buf	 = SF_NULL;
-	if (!filesystem_read_all_bytes (&handle, &buf, &size)) {
+	if (!filesystem_read_all_bytes (&handle, &out_source->code,
+									&out_source->size)) {
 		SF_ERROR ("Unable to read (binary) module: %s", file_name);
+		filesystem_close (&handle);
 		return FALSE;
 	}
-	shader_stages[stage].create_info.codeSize = size;
-	shader_stages[stage].create_info.pCode	  = (u32 *)buf;
 	filesystem_close (&handle);
+	return TRUE;
+}
+
+void vulkan_shader_source_free (vulkan_shader_source *source) {
+	if (source->code) {
+		sffree (source->code, sizeof (u8) * source->size, MEMORY_TAG_STRING);
+		source->code = SF_NULL;
+	}
+	source->size = 0;
+}
+
+b8 create_shader_module (vulkan_context *context,
+						 const vulkan_shader_source *source,
+						 VkShaderStageFlagBits stage_flags, u32 stage,
+						 vulkan_shader_stage *shader_stages) {
+	SF_PROFILE_ZONE ("create_shader_module");
+	sfmemset (&shader_stages[stage].create_info, 0,
+			  sizeof (VkShaderModuleCreateInfo));
+	sfmemset (&shader_stages[stage].shader_stage_create_info, 0,
+			  sizeof (VkPipelineShaderStageCreateInfo));
+	shader_stages[stage].create_info.sType =
+		VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_stages[stage].create_info.codeSize = source->size;
+	shader_stages[stage].create_info.pCode	  = (u32 *)source->code;
 	VK_ASSERT_SUCCESS (vkCreateShaderModule (context->device.logical_device,
 											 &shader_stages[stage].create_info,
 											 context->allocator,
@@ -43,9 +63,5 @@ b8 create_shader_module (vulkan_context *context, const char *name,
 	shader_stages[stage].shader_stage_create_info.stage = stage_flags;
 	shader_stages[stage].shader_stage_create_info.module =
 		shader_stages[stage].handle;
-	if (buf) {
-		sffree (buf, sizeof (u8) * size, MEMORY_TAG_STRING);
-		buf = SF_NULL;
-	}
 	return TRUE;
-}
\ No newline at end of file
+}
@@ -2,6 +2,19 @@
 
 #include "vulkan_types.h"
 
-b8 create_shader_module (vulkan_context *context, const char *name,
-						 const char *type_str, VkShaderStageFlagBits flag_bits,
-						 u32 stage, vulkan_shader_stage *shader_stages);
\ No newline at end of file
+// A SPIR-V binary, read apart from creating its module so the file reads can
+// run while the device is still being set up.
+typedef struct vulkan_shader_source {
+	u8 *code;
+	u64 size;
+} vulkan_shader_source;
+
+// Reads assets/shaders/<name>.<type_str>.spv, free it once the module exists.
+b8 vulkan_shader_source_load (const char *name, const char *type_str,
+							  vulkan_shader_source *out_source);
+void vulkan_shader_source_free (vulkan_shader_source *source);
+
+b8 create_shader_module (vulkan_context *context,
+						 const vulkan_shader_source *source,
+						 VkShaderStageFlagBits flag_bits, u32 stage,
+						 vulkan_shader_stage *shader_stages);
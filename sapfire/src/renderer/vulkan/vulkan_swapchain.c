@@ -1,3 +1,5 @@
+#define SF_LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_swapchain.h"
 #include "core/logger.h"
 #include "core/sfmemory.h"
@@ -37,15 +39,22 @@ void vulkan_swapchain_create (vulkan_context *context, u32 width, u32 height,
 	VkPresentModeKHR present_mode =
 		VK_PRESENT_MODE_FIFO_KHR; // this is guaranteed to exist.
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPresentModeKHR.html
-	for (u32 i = 0; i < context->device.swapchain_support.present_mode_count;
-		 ++i) {
-		VkPresentModeKHR mode =
-			context->device.swapchain_support.present_modes[i];
-		// By default enables tripple buffering. Use most current image,
-		// discard the others.
-		if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-			present_mode = mode;
-			break;
+	// By default enables tripple buffering. Use most current image, discard
+	// the others. Uncapped rendering prefers immediate, which never waits.
+	VkPresentModeKHR preferred =
+		context->present_mode == RENDERER_PRESENT_MODE_IMMEDIATE
+			? VK_PRESENT_MODE_IMMEDIATE_KHR
+			: VK_PRESENT_MODE_MAILBOX_KHR;
+	if (context->present_mode != RENDERER_PRESENT_MODE_VSYNC) {
+		for (u32 i = 0;
+			 i < context->device.swapchain_support.present_mode_count; ++i) {
+			VkPresentModeKHR mode =
+				context->device.swapchain_support.present_modes[i];
+			if (mode == preferred) {
+				present_mode = mode;
+				break;
+			}
+			if (mode == VK_PRESENT_MODE_MAILBOX_KHR) { present_mode = mode; }
 		}
 	}
 
@@ -80,7 +89,6 @@ void vulkan_swapchain_create (vulkan_context *context, u32 width, u32 height,
 			context->device.swapchain_support.capabilities.maxImageCount;
 	}
     image_count = image_count > 3 ? 3 : image_count;
-	out_swapchain->max_frames_in_flight			   = image_count - 1;
 	VkSwapchainCreateInfoKHR swapchain_create_info = {
 		VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
 	swapchain_create_info.imageUsage	= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
@@ -117,7 +125,6 @@ void vulkan_swapchain_create (vulkan_context *context, u32 width, u32 height,
 											 &out_swapchain->handle),
 					   "Failed to create swapchain.");
 	SF_INFO ("Swapchain handle created.");
-	context->current_frame	   = 0;
 	out_swapchain->image_count = 0;
 	VK_ASSERT_SUCCESS (vkGetSwapchainImagesKHR (context->device.logical_device,
 												out_swapchain->handle,
@@ -180,7 +187,7 @@ void vulkan_swapchain_create (vulkan_context *context, u32 width, u32 height,
 
 void vulkan_swapchain_destroy (vulkan_context *context,
 							   vulkan_swapchain *swapchain) {
-	vkDeviceWaitIdle (context->device.logical_device);
+	vulkan_device_wait_idle (context);
 	vulkan_image_destroy (context, &swapchain->depth_attachment);
 	// NOTE: this is due to the fact that when swapchain is created, images
 	// are created with it and are automatically destroyed when the owning
@@ -250,6 +257,4 @@ void vulkan_swapchain_present (vulkan_context *context,
 	} else if (result != VK_SUCCESS) {
 		SF_ERROR ("Failed to present swapchain image.");
 	}
-	context->current_frame =
-		(context->current_frame) % swapchain->max_frames_in_flight;
 }
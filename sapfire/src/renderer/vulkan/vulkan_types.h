@@ -47,7 +47,7 @@ typedef struct vulkan_pipeline {
 
 #define SHADER_STAGE_COUNT 2
 #define VULKAN_SHADER_DESCRIPTOR_COUNT 2
-#define VULKAN_MAX_MESH_COUNT 1024
+#define VULKAN_MAX_MESH_COUNT RENDER_MAX_MESHES
 
 typedef struct vulkan_shader_stage {
 	VkShaderModuleCreateInfo create_info;
@@ -57,11 +57,16 @@ typedef struct vulkan_shader_stage {
 
 typedef struct vulkan_descriptor_state {
     u32 generations[8];
+    // Texture the generation belongs to, for samplers.
+    struct texture* textures[8];
 } vulkan_descriptor_state;
 
 typedef struct vulkan_shader_mesh_state {
     VkDescriptorSet descriptor_sets[8];
     vulkan_descriptor_state descriptor_states[VULKAN_SHADER_DESCRIPTOR_COUNT];
+    // Last update the mesh was drawn in, and the draw writing its uniforms.
+    u64 update_serial;
+    u32 uniform_draw;
 } vulkan_shader_mesh_state;
 
 typedef struct vulkan_shader {
@@ -69,8 +74,20 @@ typedef struct vulkan_shader {
 	vulkan_pipeline pipeline;
 	VkDescriptorPool scene_descriptor_pool;
 	VkDescriptorSetLayout scene_descriptor_set_layout;
-	VkDescriptorSet scene_descriptor_sets[3];
+	VkDescriptorSet scene_descriptor_sets[RENDER_MAX_FRAMES_IN_FLIGHT];
 	vulkan_buffer scene_uniform_buffer;
+	VkDescriptorPool mesh_descriptor_pool;
+	VkDescriptorSetLayout mesh_descriptor_set_layout;
+	vulkan_buffer mesh_uniform_buffer;
+	// mesh_uniform_buffer, mapped for the lifetime of the shader.
+	mesh_uniform* mesh_uniforms;
+	u32 mesh_uniform_buffer_index;
+	vulkan_shader_mesh_state mesh_states[VULKAN_MAX_MESH_COUNT];
+	struct texture* default_diffuse;
+	// Counts vulkan_shader_update_models calls.
+	u64 update_serial;
+	f32 diffuse_accumulator;
+	vec4 diffuse_color;
 } vulkan_shader;
 
 typedef enum vulkan_render_pass_state {
@@ -89,6 +106,9 @@ typedef struct vulkan_render_pass {
 	extent2d extent;
 	u32 stencil;
 	vulkan_render_pass_state state;
+	// Scope name the pass is timed under, not timed when NULL.
+	const char *name;
+	struct vulkan_gpu_timer *timer;
 } vulkan_render_pass;
 
 typedef struct vulkan_framebuffer {
@@ -108,7 +128,6 @@ typedef struct vulkan_swapchain_support_info {
 
 typedef struct vulkan_swapchain {
 	VkSurfaceFormatKHR surface_format;
-	u8 max_frames_in_flight;
 	VkSwapchainKHR handle;
 	u32 image_count;
 	VkImage *images;
@@ -131,6 +150,31 @@ typedef struct vulkan_command_buffer {
 	vulkan_command_buffer_state state;
 } vulkan_command_buffer;
 
+// Secondary command buffers a draw list is split into at most.
+#define VULKAN_MAX_RECORD_CHUNKS 16
+
+// Pool and secondary buffer one chunk of a draw list is recorded into, one
+// set per frame in flight. Only the job recording the chunk touches them,
+// so workers never share a pool.
+typedef struct vulkan_record_chunk {
+	VkCommandPool pool;
+	vulkan_command_buffer secondary;
+} vulkan_record_chunk;
+
+// Everything the CPU writes while recording a frame, owned by the frame
+// until its fence signals. The next frames use the other sets meanwhile,
+// swapchain images are only touched by the GPU and need no fence of their
+// own. Uniform ranges and descriptor sets are indexed by the frame as well.
+typedef struct vulkan_frame {
+	// Transient, reset as a whole once the fence signalled.
+	VkCommandPool command_pool;
+	vulkan_command_buffer command_buffer;
+	vulkan_record_chunk record_chunks[VULKAN_MAX_RECORD_CHUNKS];
+	VkSemaphore image_available;
+	VkSemaphore queue_complete;
+	VkFence in_flight;
+} vulkan_frame;
+
 typedef struct vulkan_device {
 	VkPhysicalDevice physical_device;
 	VkDevice logical_device;
@@ -153,6 +197,40 @@ typedef struct vulkan_device {
 	VkFormat depth_format;
 } vulkan_device;
 
+#define VULKAN_GPU_TIMER_MAX_SCOPES 32
+#define VULKAN_GPU_TIMER_MAX_FRAMES 8
+
+// Timestamps written while recording one frame in flight. Read back once
+// that frame's fence has been waited on, so reading never stalls.
+typedef struct vulkan_gpu_timer_frame {
+	VkQueryPool pool;
+	u32 scope_count;
+	const char *names[VULKAN_GPU_TIMER_MAX_SCOPES];
+	u8 depths[VULKAN_GPU_TIMER_MAX_SCOPES];
+	u64 frame_number;
+	b8 pending;
+} vulkan_gpu_timer_frame;
+
+typedef struct vulkan_gpu_timer {
+	b8 enabled;
+	// Nanoseconds per timestamp tick.
+	f64 period_ns;
+	u64 valid_mask;
+	u32 frame_count;
+	vulkan_gpu_timer_frame frames[VULKAN_GPU_TIMER_MAX_FRAMES];
+	// Frame being recorded, NULL outside of a frame.
+	vulkan_gpu_timer_frame *recording;
+	u32 open_scopes[VULKAN_GPU_TIMER_MAX_SCOPES];
+	u32 open_count;
+	// Scopes opened past the end of open_scopes.
+	u32 open_overflow;
+	u64 frame_number;
+	// Timestamps around single-use (upload) command buffers.
+	VkQueryPool upload_pool;
+	VkCommandBuffer upload_command_buffer;
+	renderer_gpu_timings results;
+} vulkan_gpu_timer;
+
 typedef struct vulkan_context {
 	VkInstance instance;
 	VkAllocationCallbacks *allocator;
@@ -160,22 +238,22 @@ typedef struct vulkan_context {
 	vulkan_device device;
 	vulkan_swapchain swapchain;
 	vulkan_render_pass main_render_pass;
+	vulkan_gpu_timer gpu_timer;
 
-	// vec
-	vulkan_command_buffer *graphics_command_buffers;
-
-	// vec
-	VkSemaphore *image_available_semaphores;
-
-	// vec
-	VkSemaphore *queue_complete_semaphores;
-
-	u32 in_flight_fences_count;
-	VkFence *in_flight_fences;
-	VkFence **images_in_flight;
+	// frame_count of them are used, set at initialize and kept across
+	// swapchain recreation.
+	vulkan_frame frames[RENDER_MAX_FRAMES_IN_FLIGHT];
+	u32 frame_count;
+	u32 current_frame;
+	// The current frame's fence was waited on, by wait_for_frame or
+	// begin_frame, and not yet reset for the next submit.
+	b8 frame_waited;
+	// The main pass begins with the first draws of a frame, which decide
+	// whether it's recorded inline or from secondary buffers.
+	b8 main_pass_begun;
 
 	u32 image_index;
-	u32 current_frame;
+	renderer_present_mode present_mode;
 	b8 recreating_swapchain;
 	u32 framebuffer_width, framebuffer_height;
 
@@ -0,0 +1,134 @@
+#include "core/log_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Turns a logs.bin written in LOG_MODE_BINARY back into text.
+// Usage: SapfireLogDecoder [logs.bin] [output.log]
+
+#define MAX_FORMATS	   4096
+#define MAX_TEXT_SIZE  4096
+
+static const char *level_string[6] = {"[FATAL]:	", "[ERROR]:	",
+									  "[WARNING]:	", "[INFO]:	",
+									  "[DEBUG]:	", "[TRACE]:	"};
+
+typedef struct reader {
+	const u8 *data;
+	u64 size;
+	u64 offset;
+} reader;
+
+static b8 read_bytes (reader *r, void *out, u64 size) {
+	if (r->offset + size > r->size) { return FALSE; }
+	memcpy (out, r->data + r->offset, size);
+	r->offset += size;
+	return TRUE;
+}
+
+static u8 *read_file (const char *path, u64 *out_size) {
+	FILE *file = fopen (path, "rb");
+	if (!file) { return NULL; }
+	fseek (file, 0, SEEK_END);
+	long size = ftell (file);
+	fseek (file, 0, SEEK_SET);
+	u8 *data = malloc (size > 0 ? size : 1);
+	*out_size = fread (data, 1, size, file);
+	fclose (file);
+	return data;
+}
+
+int main (int argc, char **argv) {
+	const char *input_path = argc > 1 ? argv[1] : "logs.bin";
+	FILE *out			   = stdout;
+	if (argc > 2 && !(out = fopen (argv[2], "w"))) {
+		fprintf (stderr, "Failed to open %s for writing.\n", argv[2]);
+		return 1;
+	}
+
+	reader r = {0};
+	u8 *data = read_file (input_path, &r.size);
+	if (!data) {
+		fprintf (stderr, "Failed to open %s.\n", input_path);
+		return 1;
+	}
+	r.data = data;
+
+	log_binary_header header;
+	if (!read_bytes (&r, &header, sizeof (header)) ||
+		header.magic != LOG_BINARY_MAGIC) {
+		fprintf (stderr, "%s is not a binary log.\n", input_path);
+		free (data);
+		return 1;
+	}
+	if (header.version != LOG_BINARY_VERSION) {
+		fprintf (stderr, "Unsupported binary log version %u.\n",
+				 header.version);
+		free (data);
+		return 1;
+	}
+	f64 frequency = header.timestamp_frequency ? header.timestamp_frequency : 1;
+
+	char *formats[MAX_FORMATS] = {0};
+	char text[MAX_TEXT_SIZE];
+	u64 message_count = 0;
+	b8 truncated	  = FALSE;
+	while (r.offset < r.size) {
+		u8 type;
+		u32 id;
+		if (!read_bytes (&r, &type, 1) || !read_bytes (&r, &id, 4)) {
+			truncated = TRUE;
+			break;
+		}
+		if (type == LOG_BINARY_ENTRY_FORMAT) {
+			u16 length;
+			if (!read_bytes (&r, &length, 2) || r.offset + length > r.size) {
+				truncated = TRUE;
+				break;
+			}
+			if (id < MAX_FORMATS) {
+				free (formats[id]);
+				formats[id] = malloc (length + 1);
+				memcpy (formats[id], r.data + r.offset, length);
+				formats[id][length] = 0;
+			}
+			r.offset += length;
+		} else if (type == LOG_BINARY_ENTRY_MESSAGE) {
+			u8 level;
+			u64 timestamp;
+			u16 size;
+			if (!read_bytes (&r, &level, 1) ||
+				!read_bytes (&r, &timestamp, 8) || !read_bytes (&r, &size, 2) ||
+				r.offset + size > r.size) {
+				truncated = TRUE;
+				break;
+			}
+			const char *format = id < MAX_FORMATS ? formats[id] : NULL;
+			if (format) {
+				log_format_decode (format, r.data + r.offset, size, text,
+								   MAX_TEXT_SIZE);
+			} else {
+				snprintf (text, MAX_TEXT_SIZE, "<unknown format %u>", id);
+			}
+			fprintf (out, "[%12.6f] %s%s\n", (f64)timestamp / frequency,
+					 level < 6 ? level_string[level] : "[?]:	", text);
+			r.offset += size;
+			++message_count;
+		} else {
+			fprintf (stderr, "Unknown entry type %u at offset %llu.\n", type,
+					 (unsigned long long)(r.offset - 5));
+			truncated = TRUE;
+			break;
+		}
+	}
+	if (truncated) {
+		fprintf (stderr, "%s ends with an incomplete entry.\n", input_path);
+	}
+	fprintf (stderr, "Decoded %llu messages.\n",
+			 (unsigned long long)message_count);
+
+	for (u32 i = 0; i < MAX_FORMATS; ++i) { free (formats[i]); }
+	free (data);
+	if (out != stdout) { fclose (out); }
+	return 0;
+}
@@ -0,0 +1,20 @@
+
+project "SapfireLogDecoder"
+   kind "ConsoleApp"
+   language "C"
+   cdialect "gnu11"
+   targetdir "bin/%{cfg.buildcfg}"
+   toolset "clang"
+
+   -- Only shares the format codec with the engine, no need to link Sapfire.
+   files { "log_decoder/**.c", "../sapfire/src/core/log_format.c" }
+
+   includedirs { "../sapfire/src" }
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"